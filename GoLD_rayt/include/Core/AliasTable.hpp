@@ -0,0 +1,213 @@
+#pragma once
+
+/**
+ * @file AliasTable.hpp
+ * @brief O(1) sampling of piecewise-constant 2D distributions with Walker's alias method.
+ * * Distribution2D inverts CDFs with two binary searches, one over the marginal and
+ * one over a row, and every step of each is a dependent load; on a large HDRI
+ * that is ~25 cache misses per sample. An alias table (Walker 1977, built with
+ * Vose's O(n) method) splits every bin into at most two outcomes, itself with
+ * probability q or one "alias" bin otherwise, so drawing a bin is one index
+ * computation and one read.
+ * * AliasTable2D samples the same density as Distribution2D (marginal over rows,
+ * conditional within the row, each bin uniform inside) and reports the same
+ * pdf. Each random number picks a bin and the part of it left over after the
+ * q test is remapped to [0, 1) for the position inside the bin. All row tables
+ * live back to back in one array, and each bin also stores its own density,
+ * so sample() and pdf() each read one marginal bin and one row bin (plus the
+ * alias target's when the q test fails).
+ * * The mapping from random numbers to positions is not monotonic, so
+ * stratification of u is not preserved the way the CDF inversion preserves it.
+ * * The bins are plain data, so a table can also view bins written earlier
+ * (io::AssetCache maps them from disk) instead of building its own.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Core/Parallel.hpp"
+#include "Core/Types.hpp"
+
+namespace rayt {
+
+    /**
+     * @brief One bin of an alias table.
+     */
+    struct AliasBin {
+        float q;        ///< Probability of keeping this bin once it is drawn.
+        uint32_t alias; ///< Bin taken otherwise.
+        float pdf;      ///< Density of this bin over [0, 1] (its weight / mean weight).
+    };
+
+    /**
+     * @struct AliasTable2D
+     * @brief Alias-method counterpart of Distribution2D with flat storage.
+     */
+    struct AliasTable2D {
+        /**
+         * @brief Builds the tables from row-major data (same arguments as Distribution2D).
+         */
+        AliasTable2D(const float* data, int width, int height)
+            : m_width(width), m_height(height), m_ownedBins(size_t(width) * size_t(height)), m_ownedRows(height),
+              m_bins(m_ownedBins.data()), m_rows(m_ownedRows.data()) {
+            // Row tables are independent: built in parallel, one workspace per chunk
+            std::vector<double> rowSums(height);
+            parallelFor(height, ROW_GRAIN, [&](int begin, int end) {
+                Workspace ws;
+                for (int v = begin; v < end; ++v)
+                    rowSums[v] = build(&data[size_t(v) * width], width, &m_ownedBins[size_t(v) * width], ws);
+                });
+
+            std::vector<float> marginal(rowSums.begin(), rowSums.end());
+            Workspace ws;
+            m_uniform = build(marginal.data(), height, m_ownedRows.data(), ws) == 0.0;
+        }
+
+        /**
+         * @brief Views the bins of a width x height table written earlier (see bins() and rows()).
+         *
+         * @param bins width * height row bins.
+         * @param rows height marginal bins.
+         * @param uniform The uniform() of the table that wrote them.
+         * @param backing Owner of the memory, held while this table lives.
+         */
+        AliasTable2D(const AliasBin* bins, const AliasBin* rows, int width, int height, bool uniform,
+            std::shared_ptr<const void> backing)
+            : m_width(width), m_height(height), m_bins(bins), m_rows(rows), m_backing(std::move(backing)),
+              m_uniform(uniform) {}
+
+        AliasTable2D(const AliasTable2D&) = delete;
+        AliasTable2D& operator=(const AliasTable2D&) = delete;
+
+        /**
+         * @brief Samples a continuous 2D coordinate (same contract as Distribution2D::sampleContinuous).
+         */
+        void sampleContinuous(const Point2& u, Point2& uv, float& pdf) const {
+            float dv, du;
+            const int v = pick(m_rows, m_height, u.y, dv);
+            const AliasBin* row = &m_bins[size_t(v) * m_width];
+            const int x = pick(row, m_width, u.x, du);
+
+            uv = Point2(binCoord(x, du, m_width), binCoord(v, dv, m_height));
+            pdf = m_rows[v].pdf * row[x].pdf;
+        }
+
+        /**
+         * @brief Density at uv (same contract as Distribution2D::pdf).
+         */
+        float pdf(const Point2& uv) const {
+            if (m_uniform) return 1.0f;
+            const int v = std::clamp(int(uv.y * m_height), 0, m_height - 1);
+            const int u = std::clamp(int(uv.x * m_width), 0, m_width - 1);
+            const float pv = m_rows[v].pdf;
+            if (pv == 0.0f) return 0.0f;
+            return pv * m_bins[size_t(v) * m_width + u].pdf;
+        }
+
+        /// Bytes held by the tables.
+        size_t memoryBytes() const { return (size_t(m_width) * m_height + m_height) * sizeof(AliasBin); }
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+
+        /// Row tables (width * height bins, row-major) and marginal (height bins), for storing in a cache.
+        const AliasBin* bins() const { return m_bins; }
+        const AliasBin* rows() const { return m_rows; }
+
+        /// All weights were zero (sampling is uniform).
+        bool uniform() const { return m_uniform; }
+
+    private:
+        static constexpr int ROW_GRAIN = 16; ///< Rows per parallel build task.
+
+        struct Workspace {
+            std::vector<double> p;
+            std::vector<uint32_t> small, large;
+        };
+
+        /**
+         * @brief Vose's construction over n weights; returns their mean.
+         * * An all-zero row becomes uniform with density 1, like Distribution1D;
+         * the marginal gives such rows zero probability anyway.
+         */
+        static double build(const float* w, int n, AliasBin* bins, Workspace& ws) {
+            double sum = 0;
+            for (int i = 0; i < n; ++i) sum += std::max(w[i], 0.0f);
+
+            if (sum == 0.0) {
+                for (int i = 0; i < n; ++i) bins[i] = { 1.0f, uint32_t(i), 1.0f };
+                return 0.0;
+            }
+
+            // Scaled probabilities: 1 is the mean, and also the density of the bin
+            ws.p.resize(n);
+            ws.small.clear();
+            ws.large.clear();
+            for (int i = 0; i < n; ++i) {
+                ws.p[i] = std::max(w[i], 0.0f) * n / sum;
+                bins[i].pdf = float(ws.p[i]);
+                (ws.p[i] < 1.0 ? ws.small : ws.large).push_back(uint32_t(i));
+            }
+
+            while (!ws.small.empty() && !ws.large.empty()) {
+                const uint32_t s = ws.small.back();
+                const uint32_t l = ws.large.back();
+                ws.small.pop_back();
+                bins[s].q = float(ws.p[s]);
+                bins[s].alias = l;
+
+                ws.p[l] = (ws.p[l] + ws.p[s]) - 1.0;
+                if (ws.p[l] < 1.0) {
+                    ws.large.pop_back();
+                    ws.small.push_back(l);
+                }
+            }
+            // Leftovers are 1 up to rounding
+            for (const auto* list : { &ws.large, &ws.small })
+                for (uint32_t i : *list) {
+                    bins[i].q = 1.0f;
+                    bins[i].alias = i;
+                }
+            return sum / n;
+        }
+
+        /**
+         * @brief Draws a bin index with u and returns the leftover of u, rescaled to [0, 1).
+         */
+        static int pick(const AliasBin* bins, int n, float u, float& rest) {
+            const double x = double(u) * n;
+            const int i = std::min(int(x), n - 1);
+            const double f = x - i;
+            const AliasBin& b = bins[i];
+            if (f < b.q) {
+                rest = float(std::min(f / b.q, 0.99999994));
+                return i;
+            }
+            rest = float(std::min((f - b.q) / (1.0 - b.q), 0.99999994));
+            return int(b.alias);
+        }
+
+        /**
+         * @brief (i + d) / n in float, kept inside bin i as pdf() will locate it.
+         * * Near the top of a wide row i + d rounds up to i + 1 in float; without the
+         * nudge the sample would carry bin i's pdf while pdf() reads bin i + 1.
+         */
+        static float binCoord(int i, float d, int n) {
+            float c = float((i + double(d)) / n);
+            if (int(c * n) > i) c = std::nextafter(c, 0.0f);
+            return c;
+        }
+
+        int m_width, m_height;
+        std::vector<AliasBin> m_ownedBins, m_ownedRows; ///< Built tables, if this one owns them.
+        const AliasBin* m_bins;                         ///< Row tables, row-major.
+        const AliasBin* m_rows;                         ///< Marginal over rows.
+        std::shared_ptr<const void> m_backing;          ///< Keeps viewed bins alive.
+        bool m_uniform = false;                         ///< All weights zero: uniform, as Distribution2D.
+    };
+
+} // namespace rayt
@@ -9,13 +9,22 @@
  * a marginal distribution p(v) and conditional distributions p(u|v).
  * * It is commonly used for importance sampling of environment maps,
  * but can be applied to any 2D tabulated data.
+ * * All tables live in one cache-line aligned arena: the marginal first, then
+ * one block per row holding its function values followed by its CDF, so a
+ * sample or pdf() lookup touches one contiguous row instead of two separate
+ * heap blocks. Rows are independent and are built in parallel.
+ * * The arena is plain data, so a distribution can also view one written
+ * earlier (io::AssetCache maps it from disk) instead of building its own.
  */
 
-#include <vector>
-#include <memory>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
 
-#include "Distribution1D.hpp"
+#include "Core/Parallel.hpp"
 #include "Core/Types.hpp"
 
 namespace rayt {
@@ -27,11 +36,10 @@ namespace rayt {
      * It decomposes the 2D distribution p(u, v) into a marginal distribution p(v)
      * and conditional distributions p(u|v).
      * Typically used for sampling directions from an environment map (IBL).
+     * Sampling and densities are bit-identical to a marginal Distribution1D over
+     * per-row Distribution1Ds.
      */
     struct Distribution2D {
-        std::vector<std::unique_ptr<Distribution1D>> pConditionalV; ///< Conditional distributions p(u|v) for each row.
-        std::unique_ptr<Distribution1D> pMarginal;                  ///< Marginal distribution p(v) for selecting rows.
-
         /**
          * @brief Constructs a 2D distribution from raw floating-point data.
          *
@@ -39,21 +47,44 @@ namespace rayt {
          * @param width The width of the 2D data.
          * @param height The height of the 2D data.
          */
-        Distribution2D(const float* data, int width, int height) {
-            // 1. Build conditional distributions p(u|v) for each row v.
-            for (int v = 0; v < height; ++v) {
-                pConditionalV.emplace_back(std::make_unique<Distribution1D>(&data[v * width], width));
-            }
-
-            // 2. Compute the marginal integrals to build p(v).
-            // Each element of marginalFunc represents the integral of one row.
-            std::vector<float> marginalFunc;
-            for (int v = 0; v < height; ++v) {
-                marginalFunc.push_back(pConditionalV[v]->funcInt);
-            }
-            pMarginal = std::make_unique<Distribution1D>(marginalFunc.data(), height);
+        Distribution2D(const float* data, int width, int height)
+            : m_width(width), m_height(height),
+              m_rowStride(roundUpToLine(2 * size_t(width) + 1)),
+              m_marginalStride(roundUpToLine(2 * size_t(height) + 1)) {
+            const size_t floats = m_marginalStride + m_rowStride * size_t(height);
+            m_arena.reset(static_cast<float*>(::operator new[](floats * sizeof(float), std::align_val_t(CACHE_LINE))));
+            m_tables = m_arena.get();
+
+            // 1. Conditional distributions p(u|v), one row block each.
+            // Row integrals are written straight into the marginal's function values.
+            float* marginalFunc = m_arena.get();
+            parallelFor(height, ROW_GRAIN, [&](int begin, int end) {
+                for (int v = begin; v < end; ++v) {
+                    float* func = m_arena.get() + rowOffset(v);
+                    marginalFunc[v] = build1D(&data[size_t(v) * width], width, func, func + width);
+                }
+                });
+
+            // 2. Marginal p(v) from the row integrals
+            m_marginalInt = build1D(marginalFunc, height, marginalFunc, marginalFunc + height);
         }
 
+        /**
+         * @brief Views the arena of a width x height distribution written earlier (see tables()).
+         *
+         * @param tables memoryBytes() bytes, 64-byte aligned, as returned by tables().
+         * @param integral The integral() of the distribution that wrote them.
+         * @param backing Owner of the memory, held while this distribution lives.
+         */
+        Distribution2D(const float* tables, int width, int height, float integral, std::shared_ptr<const void> backing)
+            : m_width(width), m_height(height),
+              m_rowStride(roundUpToLine(2 * size_t(width) + 1)),
+              m_marginalStride(roundUpToLine(2 * size_t(height) + 1)),
+              m_marginalInt(integral), m_tables(tables), m_backing(std::move(backing)) {}
+
+        Distribution2D(const Distribution2D&) = delete;
+        Distribution2D& operator=(const Distribution2D&) = delete;
+
         /**
          * @brief Samples a continuous 2D coordinate based on the distribution.
          *
@@ -69,15 +100,16 @@ namespace rayt {
             int vOff, uOff;
 
             // 1. Sample v from p(v)
-            float v = pMarginal->sampleContinuous(u.y, pdfV, vOff);
+            const float* marginalFunc = m_tables;
+            float v = sample1D(marginalFunc, marginalFunc + m_height, m_height, m_marginalInt, u.y, pdfV, vOff);
 
-            // 2. Sample u from p(u|v)
-            float x = pConditionalV[vOff]->sampleContinuous(u.x, pdfU, uOff);
+            // 2. Sample u from p(u|v); the row integral is the marginal's function value
+            float x = sample1D(rowFunc(vOff), rowCdf(vOff), m_width, marginalFunc[vOff], u.x, pdfU, uOff);
 
             uv = Point2(x, v);
 
             // Joint PDF: p(u, v) = p(u|v) * p(v)
-            pdf = pdfU * pdfV;   
+            pdf = pdfU * pdfV;
         }
 
         /**
@@ -87,28 +119,110 @@ namespace rayt {
          * @return The probability density value.
          */
         float pdf(const Point2& uv) const {
-            // Note: Assuming pMarginal and pConditionalV are valid and match the dimensions.
-            int height = (int)pMarginal->func.size();
-            int width = (int)pConditionalV[0]->func.size();
-
             // Clamp coordinates to valid range indices
-            int v = std::clamp(int(uv.y * height), 0, height - 1);
-            int u = std::clamp(int(uv.x * width), 0, width - 1);
+            int v = std::clamp(int(uv.y * m_height), 0, m_height - 1);
+            int u = std::clamp(int(uv.x * m_width), 0, m_width - 1);
 
             // Handle edge case where the entire image is black (integral is 0)
-            if (pMarginal->funcInt == 0.0f) return 1.0f; // Return uniform PDF
-            if (pConditionalV[v]->funcInt == 0.0f) return 0.0f;
+            if (m_marginalInt == 0.0f) return 1.0f; // Return uniform PDF
+            const float rowInt = m_tables[v];
+            if (rowInt == 0.0f) return 0.0f;
 
             // Compute p(v) and p(u|v)
-            // Since Distribution1D::funcInt is the integral (sum / N),
-            // func[i] / funcInt directly gives the probability density.
-            float pv = pMarginal->func[v] / pMarginal->funcInt;                 
-            float puv = pConditionalV[v]->func[u] / pConditionalV[v]->funcInt;   
+            // Since each integral is sum / N, func[i] / integral directly gives the probability density.
+            float pv = rowInt / m_marginalInt;
+            float puv = rowFunc(v)[u] / rowInt;
 
             return pv * puv;
         }
 
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+
+        /// The whole arena (memoryBytes() bytes of plain data), for storing in a cache.
+        const float* tables() const { return m_tables; }
+
+        /// Integral of the marginal, which a viewing distribution needs along with tables().
+        float integral() const { return m_marginalInt; }
+
+        /**
+         * @brief Bytes held by the arena (padding included).
+         */
+        size_t memoryBytes() const {
+            return (m_marginalStride + m_rowStride * size_t(m_height)) * sizeof(float);
+        }
+
+    private:
+        static constexpr size_t CACHE_LINE = 64;
+        static constexpr size_t LINE_FLOATS = CACHE_LINE / sizeof(float);
+        static constexpr int ROW_GRAIN = 16; ///< Rows per parallel build task.
+
+        struct AlignedDelete {
+            void operator()(float* p) const { ::operator delete[](p, std::align_val_t(CACHE_LINE)); }
+        };
+
+        static size_t roundUpToLine(size_t floats) {
+            return (floats + LINE_FLOATS - 1) / LINE_FLOATS * LINE_FLOATS;
+        }
+
+        size_t rowOffset(int v) const { return m_marginalStride + m_rowStride * size_t(v); }
+        const float* rowFunc(int v) const { return m_tables + rowOffset(v); }
+        const float* rowCdf(int v) const { return rowFunc(v) + m_width; }
+
+        /**
+         * @brief Writes the function values and normalized CDF of n bins over [0, 1]; returns the integral.
+         * * Same arithmetic as Distribution1D; func may alias f.
+         */
+        static float build1D(const float* f, int n, float* func, float* cdf) {
+            if (func != f) std::copy(f, f + n, func);
+
+            float sum = 0;
+            cdf[0] = 0;
+            for (int i = 0; i < n; ++i) {
+                sum += func[i] / float(n);
+                cdf[i + 1] = sum;
+            }
+
+            const float funcInt = sum;
+
+            // Normalize CDF
+            if (funcInt == 0) {
+                for (int i = 1; i < n + 1; ++i) cdf[i] = float(i) / float(n);
+            }
+            else {
+                for (int i = 1; i < n + 1; ++i) cdf[i] /= funcInt;
+            }
+            return funcInt;
+        }
+
+        /**
+         * @brief Inverse CDF sampling of one table (same contract as Distribution1D::sampleContinuous).
+         */
+        static float sample1D(const float* func, const float* cdf, int n, float funcInt, float u, float& pdf, int& off) {
+            // Handle edge case u=1.0 slightly inside to avoid out of bounds
+            u = std::min(u, 0.99999994f);
+
+            // Find the index such that cdf[offset] <= u < cdf[offset+1]
+            const float* ptr = std::upper_bound(cdf, cdf + n + 1, u);
+            int offset = std::clamp(static_cast<int>(ptr - cdf) - 1, 0, n - 1);
+            off = offset;
+
+            pdf = funcInt > 0.0f ? func[offset] / funcInt : 1.0f;
+
+            // Position inside the bin, mapped back to [0, 1]
+            float du = u - cdf[offset];
+            float denom = cdf[offset + 1] - cdf[offset];
+            du = denom > 0.0f ? du / denom : 0.0f;
+            return (offset + du) / float(n);
+        }
+
+        int m_width, m_height;
+        size_t m_rowStride;      ///< Floats per row block: func[width], cdf[width + 1], padding.
+        size_t m_marginalStride; ///< Floats before the first row: marginal func[height], cdf[height + 1], padding.
+        float m_marginalInt = 0.0f;
+        std::unique_ptr<float[], AlignedDelete> m_arena; ///< Built tables, if this distribution owns them.
+        const float* m_tables = nullptr;                 ///< The arena in use: m_arena, or a viewed one.
+        std::shared_ptr<const void> m_backing;           ///< Keeps a viewed arena alive.
     };
 
 } // namespace rayt
-
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file EqualAreaMapping.hpp
+ * @brief Equal-area octahedral mapping between the unit square and the unit sphere.
+ * * Clarberg, "Fast Equal-Area Mapping of the (Hemi)Sphere using SIMD" (2008), as
+ * used by pbrt-v4's image infinite lights. The sphere is folded onto an
+ * octahedron and unfolded into [0, 1]^2: the upper hemisphere (+Y, the sky)
+ * fills the inner diamond, the lower one the four corners. Every region of
+ * the square covers the same solid angle, so a density p over the square is
+ * p / (4 pi) per steradian with no sin(theta) Jacobian, and both directions
+ * of the mapping are a handful of arithmetic operations and one square root.
+ * * The two angular pieces are polynomials rather than library calls: sin/cos
+ * on [-pi/4, pi/4] as Taylor series, and atan(b) * 2 / pi on [0, 1] as a
+ * degree-8 fit in b^2. Both are accurate to ~1e-9, well below the float
+ * precision of the texture coordinates they produce or consume.
+ * * Edge texels wrap by mirroring: the point (0, v) is the same direction as
+ * (0, 1 - v), and likewise on the other three edges.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Core/Types.hpp"
+#include "Core/Constants.hpp"
+
+namespace rayt {
+
+    /**
+     * @brief Maps a point of [0, 1]^2 to a unit direction (Y up).
+     */
+    inline Vector3 equalAreaSquareToSphere(Real u, Real v) {
+        const Real x = Real(2) * u - Real(1), y = Real(2) * v - Real(1);
+        const Real ax = std::abs(x), ay = std::abs(y);
+
+        // Distance from the diamond's edge: positive inside (upper hemisphere)
+        const Real signedDistance = Real(1) - (ax + ay);
+        const Real r = Real(1) - std::abs(signedDistance);
+
+        // phi = pi/4 * (1 + t) in the first quadrant; sin and cos of a = t * pi/4
+        const Real t = r == Real(0) ? Real(0) : (ay - ax) / r;
+        const Real a = t * (constants::PI / Real(4));
+        const Real a2 = a * a;
+        const Real sinA = a * (Real(1) + a2 * (Real(-1) / 6 + a2 * (Real(1) / 120 + a2 * (Real(-1) / 5040 + a2 * (Real(1) / 362880)))));
+        const Real cosA = Real(1) + a2 * (Real(-1) / 2 + a2 * (Real(1) / 24 + a2 * (Real(-1) / 720 + a2 * (Real(1) / 40320 + a2 * (Real(-1) / 3628800)))));
+        constexpr Real INV_SQRT2 = Real(0.70710678118654752440);
+        const Real cosPhi = std::copysign((cosA - sinA) * INV_SQRT2, x);
+        const Real sinPhi = std::copysign((cosA + sinA) * INV_SQRT2, y);
+
+        const Real k = r * std::sqrt(std::max(Real(0), Real(2) - r * r));
+        return Vector3(cosPhi * k, std::copysign(Real(1) - r * r, signedDistance), sinPhi * k);
+    }
+
+    /**
+     * @brief Inverse of equalAreaSquareToSphere; d must be normalized.
+     */
+    inline void equalAreaSphereToSquare(const Vector3& d, Real& u, Real& v) {
+        const Real ax = std::abs(d.x), az = std::abs(d.z);
+        const Real r = std::sqrt(std::max(Real(0), Real(1) - std::abs(d.y)));
+
+        // atan(b) * 2 / pi for b = min / max in [0, 1]
+        const Real hi = std::max(ax, az);
+        const Real b = hi == Real(0) ? Real(0) : std::min(ax, az) / hi;
+        const Real s = b * b;
+        Real phi = b * (0.63661976077387938 + s * (-0.21220470242190057 + s * (0.12727221020469376 +
+            s * (-0.090385988006319223 + s * (0.067598647013863589 + s * (-0.047471812301012051 +
+            s * (0.026825644440678944 + s * (-0.010014824302440198 + s * 0.0017610707908614939))))))));
+        if (ax < az) phi = Real(1) - phi;
+
+        // Upper hemisphere: |x| + |y| = r; the lower one is folded out to the corners
+        Real y = phi * r;
+        Real x = r - y;
+        if (d.y < Real(0)) {
+            std::swap(x, y);
+            x = Real(1) - x;
+            y = Real(1) - y;
+        }
+        u = (std::copysign(x, d.x) + Real(1)) * Real(0.5);
+        v = (std::copysign(y, d.z) + Real(1)) * Real(0.5);
+    }
+
+    /**
+     * @brief Folds a texel coordinate one step outside an n x n equal-area map back inside.
+     * * Texel -1 of a row is texel 0 of the mirrored row; the boundary rule for
+     * TiledImage aprons and any other filter that reads past the edge.
+     */
+    inline void equalAreaWrapTexel(int n, int& x, int& y) {
+        if (x < 0) { x = -x - 1; y = n - 1 - y; }
+        else if (x >= n) { x = 2 * n - 1 - x; y = n - 1 - y; }
+        if (y < 0) { y = -y - 1; x = n - 1 - x; }
+        else if (y >= n) { y = 2 * n - 1 - y; x = n - 1 - x; }
+    }
+
+} // namespace rayt
@@ -12,6 +12,7 @@
 #include "Core/Forward.hpp"
 #include "Core/Constants.hpp"   // Include the constants header if available
 #include "Core/Math.hpp"
+#include "Core/SampledSpectrum.hpp"
 
 namespace rayt::fresnel {
 
@@ -72,6 +73,35 @@ namespace rayt::fresnel {
         return Real(0.5) * (Rs + Rp);
     }
 
+    /**
+     * @brief Conductor Fresnel reflectance at a path's sampled wavelengths, all lanes at once.
+     * * Same formula as the RGB overload; used in spectral mode with measured n, k.
+     * @param cosThetaI Cosine of the incident angle.
+     * @param eta       n at each sampled wavelength.
+     * @param k         k at each sampled wavelength.
+     */
+    inline SampledSpectrum fresnelConductor(Real cosThetaI, const SampledSpectrum& eta, const SampledSpectrum& k) {
+        cosThetaI = rayt::math::saturate(cosThetaI);
+        const Real cosThetaI2 = cosThetaI * cosThetaI;
+        const Real sinThetaI2 = Real(1.0) - cosThetaI2;
+
+        const SampledSpectrum eta2 = eta * eta;
+        const SampledSpectrum k2 = k * k;
+
+        const SampledSpectrum t0 = eta2 - k2 - sinThetaI2;
+        const SampledSpectrum a2plusb2 = sqrt(t0 * t0 + Real(4.0) * eta2 * k2);
+        const SampledSpectrum t1 = a2plusb2 + cosThetaI2;
+        const SampledSpectrum a = sqrt(Real(0.5) * (a2plusb2 + t0));
+        const SampledSpectrum t2 = Real(2.0) * cosThetaI * a;
+        const SampledSpectrum Rs = (t1 - t2) / (t1 + t2);
+
+        const SampledSpectrum t3 = cosThetaI2 * a2plusb2 + sinThetaI2 * sinThetaI2;
+        const SampledSpectrum t4 = t2 * sinThetaI2;
+        const SampledSpectrum Rp = Rs * (t3 - t4) / (t3 + t4);
+
+        return Real(0.5) * (Rs + Rp);
+    }
+
     // -------------------------------------------------------------------------
     // Fresnel Equations (Dielectric)
     // -------------------------------------------------------------------------
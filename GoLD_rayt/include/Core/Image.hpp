@@ -4,6 +4,7 @@
 
 #include "Core/Types.hpp"
 #include "Core/Constants.hpp"
+#include "Core/PixelFormat.hpp"
 
 namespace rayt{
 
@@ -11,8 +12,10 @@ namespace rayt{
 	 * @class Image
 	 * @brief A class representing a 2D image buffer.
 	 *
-	 * This class stores image data as a flat vector of Vector3 pixels (typically RGB).
-	 * It provides methods to access pixels using 2D coordinates (x, y).
+	 * Pixels (linear RGB) are stored row-major in a compact PixelFormat and
+	 * decoded to Vector3 on every read; see PixelFormat.hpp for the precision
+	 * of each format. Float3 (the default) holds what the loaders produce
+	 * without loss; RGBE and RGB9E5 cut an environment map to a third of that.
 	 */
 	class Image {
 	public:
@@ -21,27 +24,43 @@ namespace rayt{
 		 */
 		Image() = default;
 
+		/**
+		 * @brief Constructs a black image with specific dimensions.
+		 *
+		 * @param w The width of the image.
+		 * @param h The height of the image.
+		 * @param format The storage format of the pixels.
+		 */
+		Image(int w, int h, PixelFormat format = PixelFormat::Float3)
+			:m_width(w), m_height(h), m_format(format),
+			m_data(static_cast<size_t>(w) * h * bytesPerPixel(format), uint8_t(0)) {}
+
 		/**
 		 * @brief Constructs an image with specific dimensions and pixel data.
 		 *
 		 * @param w The width of the image.
 		 * @param h The height of the image.
 		 * @param pixels A vector containing the pixel data. Its size must be w * h.
+		 * @param format The storage format the pixels are encoded into.
 		 */
-		Image(int w, int h, std::vector<Vector3> pixels)
-			:m_width(w), m_height(h), m_pixels(std::move(pixels)){}
+		Image(int w, int h, const std::vector<Vector3>& pixels, PixelFormat format = PixelFormat::Float3)
+			:Image(w, h, format) {
+			if (pixels.size() != static_cast<size_t>(w) * h) { m_data.clear(); return; }
+			for (size_t i = 0; i < pixels.size(); ++i)
+				pixel::encode(m_format, pixels[i], m_data.data() + i * bytesPerPixel(m_format));
+		}
 
 		/**
 		 * @brief Checks if the image data is valid.
 		 *
-		 * Verifies that the dimensions are positive and that the number of pixels
+		 * Verifies that the dimensions are positive and that the pixel storage
 		 * matches the expected size (width * height).
 		 *
 		 * @return True if the image is valid, false otherwise.
 		 */
 		bool isValid() const {
 			return m_width > 0 && m_height > 0 &&
-				static_cast<int>(m_pixels.size()) == m_width * m_height;
+				m_data.size() == static_cast<size_t>(m_width) * m_height * bytesPerPixel(m_format);
 		}
 
 		/**
@@ -57,48 +76,71 @@ namespace rayt{
 		int height() const { return m_height; }
 
 		/**
-		 * @brief Accesses the pixel at the specified coordinates (read-only).
+		 * @brief Gets the storage format of the pixels.
+		 */
+		PixelFormat format() const { return m_format; }
+
+		/**
+		 * @brief Gets the size of the pixel storage in bytes.
+		 */
+		size_t memoryBytes() const { return m_data.size(); }
+
+		/**
+		 * @brief Raw pixel storage: height rows of width * bytesPerPixel(format()) bytes.
+		 *
+		 * Lets loaders decode straight into the image instead of going through set().
+		 */
+		uint8_t* data() { return m_data.data(); }
+		const uint8_t* data() const { return m_data.data(); }
+
+		/**
+		 * @brief Reads the pixel at the specified coordinates.
 		 *
-		 * The coordinates are mapped to the 1D vector index using: y * width + x.
+		 * The coordinates are mapped to the 1D index using: y * width + x.
 		 * No bounds checking is performed for performance reasons.
 		 *
 		 * @param x The x-coordinate (column).
 		 * @param y The y-coordinate (row).
-		 * @return A const reference to the pixel at (x, y).
+		 * @return The decoded pixel at (x, y).
 		 */
-		const Vector3& at(int x, int y) const {
-			return m_pixels[y * m_width + x];
+		Vector3 at(int x, int y) const {
+			const size_t bpp = bytesPerPixel(m_format);
+			return pixel::decode(m_format, m_data.data() + (static_cast<size_t>(y) * m_width + x) * bpp);
 		}
 
 		/**
-		 * @brief Accesses the pixel at the specified coordinates (modifiable).
+		 * @brief Writes the pixel at the specified coordinates.
 		 *
-		 * The coordinates are mapped to the 1D vector index using: y * width + x.
-		 * No bounds checking is performed for performance reasons.
+		 * The value is rounded to the storage format (out-of-range values are clamped).
 		 *
 		 * @param x The x-coordinate (column).
 		 * @param y The y-coordinate (row).
-		 * @return A reference to the pixel at (x, y).
+		 * @param rgb The new pixel value.
 		 */
-		Vector3& at(int x, int y) {
-			return m_pixels[y * m_width + x];
+		void set(int x, int y, const Vector3& rgb) {
+			const size_t bpp = bytesPerPixel(m_format);
+			pixel::encode(m_format, rgb, m_data.data() + (static_cast<size_t>(y) * m_width + x) * bpp);
 		}
 
 		/**
-		 * @brief Gets the raw pixel data (read-only).
-		 * @return A const reference to the vector of pixels.
-		 */
-		const std::vector<Vector3>& pixels() const { return m_pixels; }
-
-		/**
-		 * @brief Gets the raw pixel data (modifiable).
-		 * @return A reference to the vector of pixels.
+		 * @brief Returns a copy of this image re-encoded in another format.
+		 *
+		 * @param format The target storage format.
+		 * @return The converted image (a plain copy if the format is unchanged).
 		 */
-		std::vector<Vector3>& pixels() { return m_pixels; }
+		Image converted(PixelFormat format) const {
+			if (format == m_format) return *this;
+			Image out(m_width, m_height, format);
+			for (int y = 0; y < m_height; ++y)
+				for (int x = 0; x < m_width; ++x)
+					out.set(x, y, at(x, y));
+			return out;
+		}
 
 	private:
 		int m_width = 0;
 		int m_height = 0;
-		std::vector<Vector3> m_pixels;
+		PixelFormat m_format = PixelFormat::Float3;
+		std::vector<uint8_t> m_data;
 	};
 }
\ No newline at end of file
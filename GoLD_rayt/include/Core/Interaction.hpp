@@ -7,6 +7,10 @@
 
 #include "Core/Core.hpp"
 #include "Core/Math.hpp"
+#include "Core/Ray.hpp"
+#include "Geometry/Frame.hpp"
+
+#include <cstdint>
 
 namespace rayt {
 
@@ -14,6 +18,12 @@ namespace rayt {
     // Note: Already declared in Core/Forward.hpp, but listed here for clarity.
     class Material;
 
+    /// Index of a built-in material in the Scene's MaterialTable.
+    using MaterialId = uint32_t;
+
+    /// Sentinel for hits whose material is only reachable through matPtr.
+    inline constexpr MaterialId INVALID_MATERIAL_ID = ~MaterialId(0);
+
     /**
      * @brief SurfaceInteraction stores all geometric and shading information at an intersection point.
      * It acts as a bridge between the geometry (Shapes) and the shading (Materials/BSDFs).
@@ -26,6 +36,7 @@ namespace rayt {
         Real t;             // Distance along the ray (parametric distance).
 
         const Material* matPtr = nullptr; // Pointer to the material property at hit point
+        MaterialId materialId = INVALID_MATERIAL_ID; // Entry in the scene's MaterialTable (takes precedence over matPtr)
 
         // ---------------------------------------------------------------------
         // Differential Geometry (For Normal Mapping / Anisotropy)
@@ -35,6 +46,15 @@ namespace rayt {
         Vector3 dpdv;       // Bitangent vector: partial derivative of position with respect to 'v'.
         Vector3 gn;         // Geometric normal: the true perpendicular vector of the underlying geometry.
 
+        // ---------------------------------------------------------------------
+        // Screen-Space Footprint (For Texture Filtering)
+        // ---------------------------------------------------------------------
+        // Change of p and uv for a one-pixel step on the film; filled by computeDifferentials().
+        Vector3 dpdx = Vector3(0.0);
+        Vector3 dpdy = Vector3(0.0);
+        Real dudx = 0, dvdx = 0;
+        Real dudy = 0, dvdy = 0;
+
         // ---------------------------------------------------------------------
         // Methods
         // ---------------------------------------------------------------------
@@ -57,8 +77,73 @@ namespace rayt {
             n = gn; // Initially, the shading normal matches the geometric normal.
         }
 
-        // TODO: Implement coordinate system construction for tangent space.
-        // Required for Normal Mapping, Anisotropy, and Microfacet distributions.
+        /**
+         * @brief Estimates the pixel footprint at the hit (dpdx/dpdy) and maps it to uv.
+         * * With ray differentials the offset rays are intersected with the tangent
+         * plane (PBRT 3rd ed. 10.1.1). Without them (secondary bounces) a ray-cone
+         * footprint is used: an isotropic disk of diameter coneWidth on the tangent
+         * plane. The uv derivatives come from the least-squares solve of
+         * dp = dpdu * du + dpdv * dv; degenerate parameterizations give zero.
+         * * @param ray       The ray that produced this hit.
+         * @param coneWidth Footprint width to fall back on when the ray has no differentials.
+         */
+        void computeDifferentials(const RayDifferential& ray, Real coneWidth) {
+            const Real dRx = ray.hasDifferentials ? glm::dot(gn, ray.rxDirection) : Real(0);
+            const Real dRy = ray.hasDifferentials ? glm::dot(gn, ray.ryDirection) : Real(0);
+
+            if (dRx != 0 && dRy != 0) {
+                // Plane through p with normal gn: dot(gn, x) = dot(gn, p)
+                const Real d = glm::dot(gn, p);
+                const Real tx = (d - glm::dot(gn, ray.rxOrigin)) / dRx;
+                const Real ty = (d - glm::dot(gn, ray.ryOrigin)) / dRy;
+                dpdx = ray.rxOrigin + tx * ray.rxDirection - p;
+                dpdy = ray.ryOrigin + ty * ray.ryDirection - p;
+            }
+            else {
+                Vector3 s, t;
+                frame::makeOrthonormalBasis(gn, s, t);
+                dpdx = s * coneWidth;
+                dpdy = t * coneWidth;
+            }
+
+            // Least squares: [dpdu dpdv] (du, dv)^T = dp
+            const Real ata00 = glm::dot(dpdu, dpdu);
+            const Real ata01 = glm::dot(dpdu, dpdv);
+            const Real ata11 = glm::dot(dpdv, dpdv);
+            const Real det = ata00 * ata11 - ata01 * ata01;
+            if (!(std::abs(det) > Real(1e-20))) {
+                dudx = dvdx = dudy = dvdy = 0;
+                return;
+            }
+            const Real invDet = Real(1.0) / det;
+
+            const Real atbx0 = glm::dot(dpdu, dpdx), atbx1 = glm::dot(dpdv, dpdx);
+            const Real atby0 = glm::dot(dpdu, dpdy), atby1 = glm::dot(dpdv, dpdy);
+
+            dudx = (ata11 * atbx0 - ata01 * atbx1) * invDet;
+            dvdx = (ata00 * atbx1 - ata01 * atbx0) * invDet;
+            dudy = (ata11 * atby0 - ata01 * atby1) * invDet;
+            dvdy = (ata00 * atby1 - ata01 * atby0) * invDet;
+
+            // Huge derivatives at grazing angles only blur; clamp them to the whole texture
+            dudx = std::clamp(dudx, Real(-1e8), Real(1e8));
+            dvdx = std::clamp(dvdx, Real(-1e8), Real(1e8));
+            dudy = std::clamp(dudy, Real(-1e8), Real(1e8));
+            dvdy = std::clamp(dvdy, Real(-1e8), Real(1e8));
+        }
+
+        /**
+         * @brief Replaces the shading normal by a tangent-space normal (x along dpdu).
+         * * Falls back to the current normal when the tangent is degenerate or the
+         * result would face away from the geometric normal.
+         * @param nTangent Unit normal in the (dpdu, bitangent, n) frame.
+         */
+        void applyTangentSpaceNormal(const Vector3& nTangent) {
+            frame::Frame f;
+            f.buildFromNormalAndTangent(n, dpdu);
+            const Vector3 ns = glm::normalize(f.localToWorld(nTangent));
+            if (glm::dot(ns, gn) > 0) n = ns;
+        }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file Parallel.hpp
+ * @brief Minimal fork-join loop for build-time work (tables, distributions).
+ * * parallelFor splits [0, count) into chunks of `grain` indices and hands them
+ * out through an atomic counter to all hardware threads, the calling thread
+ * included; it returns once every chunk is done. Threads are started per call,
+ * which costs tens of microseconds, so it is meant for loops that run once per
+ * asset rather than per sample.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace rayt {
+
+    /// Threads parallelFor uses (at least 1).
+    inline int hardwareThreads() {
+        return int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    /**
+     * @brief Calls body(begin, end) over chunks of [0, count), concurrently.
+     * * Chunks are disjoint and at most `grain` long; body must be safe to run on
+     * different chunks at the same time. Runs inline when there is a single
+     * chunk or a single hardware thread.
+     */
+    template <typename Body>
+    void parallelFor(int count, int grain, Body&& body) {
+        if (count <= 0) return;
+        grain = std::max(grain, 1);
+        const int chunks = (count + grain - 1) / grain;
+        const int threadCount = std::min(hardwareThreads(), chunks);
+        if (threadCount == 1) {
+            body(0, count);
+            return;
+        }
+
+        std::atomic<int> next{ 0 };
+        auto worker = [&] {
+            for (int c; (c = next.fetch_add(1)) < chunks; )
+                body(c * grain, std::min(count, (c + 1) * grain));
+        };
+        std::vector<std::thread> threads(threadCount - 1);
+        for (std::thread& t : threads) t = std::thread(worker);
+        worker();
+        for (std::thread& t : threads) t.join();
+    }
+
+} // namespace rayt
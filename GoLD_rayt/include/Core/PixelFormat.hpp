@@ -0,0 +1,257 @@
+#pragma once
+
+/**
+ * @file PixelFormat.hpp
+ * @brief Storage formats for HDR pixels, and their encoders/decoders.
+ * * An HDR image held as three doubles per pixel costs 24 bytes; a 16k x 8k
+ * environment is 3 GiB before any sampling table is built. Image keeps its
+ * pixels in one of these formats instead and decodes on every read:
+ *
+ * | Format | Bytes | Decoded precision                                             | Range            |
+ * |--------|-------|---------------------------------------------------------------|------------------|
+ * | Float3 |  12   | exact float (24-bit significand)                              | float            |
+ * | Half3  |   6   | 11-bit significand per channel: relative error <= 2^-11       | 6.1e-5 .. 65504  |
+ * | RGBE   |   4   | 8-bit mantissas, shared exponent: error <= 2^-8 of the        | 2^-136 .. 2^127  |
+ * |        |       | largest channel (dim channels of a saturated color lose more) |                  |
+ * | RGB9E5 |   4   | 9-bit mantissas, shared exponent: error <= 2^-9 of the        | 3.1e-5 .. 65408  |
+ * |        |       | largest channel                                               |                  |
+ *
+ * Below the listed range precision degrades gradually (half subnormals, a
+ * clamped shared exponent); above it values are clamped.
+ *
+ * RGBE decodes exactly as stb_image reads Radiance .hdr files (mantissa *
+ * 2^(e - 136), no half-step offset), and encodes to the nearest such value, so
+ * a .hdr loaded through stb and stored as RGBE round-trips bit-exactly: it
+ * costs nothing over Float3 for the maps we actually load. (Such values have
+ * at most 8 significant bits, so Half3 and RGB9E5 usually hold them exactly
+ * too, within their ranges.) Half3 and RGB9E5 clamp out-of-range values (a
+ * sun can exceed 65504) instead of producing Inf. Negative and NaN inputs
+ * encode as 0 in the shared-exponent formats.
+ *
+ * Decoding Half3 uses F16C when the build targets it (-mf16c, /arch:AVX2) and
+ * SSE2 otherwise. A random bilinear lookup on a 4k map then costs about the
+ * same as Float3 with F16C and about 1.2x with SSE2 (2.3x with scalar
+ * conversion).
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Core/Simd.hpp"
+#include "Core/Types.hpp"
+
+// F16C (half -> float in hardware): GCC/Clang with -mf16c or -march=haswell and later, MSVC with /arch:AVX2
+#if RAYT_SIMD_SSE2 && (defined(__F16C__) || defined(__AVX2__))
+#define RAYT_F16C 1
+#include <immintrin.h>
+#else
+#define RAYT_F16C 0
+#endif
+
+namespace rayt {
+
+    enum class PixelFormat : uint8_t {
+        Float3, ///< 3 x float.
+        Half3,  ///< 3 x IEEE half.
+        RGBE,   ///< Radiance shared exponent: 3 x 8-bit mantissa + 8-bit exponent.
+        RGB9E5  ///< 3 x 9-bit mantissa + 5-bit exponent (GL_RGB9_E5).
+    };
+
+    /// Bytes one pixel occupies in format f.
+    constexpr size_t bytesPerPixel(PixelFormat f) {
+        switch (f) {
+        case PixelFormat::Float3: return 12;
+        case PixelFormat::Half3: return 6;
+        default: return 4;
+        }
+    }
+
+    namespace pixel {
+
+        // ---------------------------------------------------------------------
+        // Half (F. Giesen's branch-light conversions, round to nearest even)
+        // ---------------------------------------------------------------------
+
+        inline uint16_t floatToHalf(float f) {
+            constexpr float HALF_MAX = 65504.0f;
+            if (!(std::abs(f) <= HALF_MAX)) f = std::isnan(f) ? 0.0f : std::copysign(HALF_MAX, f);
+
+            uint32_t u = std::bit_cast<uint32_t>(f);
+            const uint32_t sign = u & 0x80000000u;
+            u ^= sign;
+
+            uint16_t h;
+            if (u < (113u << 23)) {
+                // Subnormal half (or zero): let the FPU round by adding 0.5
+                const float magic = std::bit_cast<float>(126u << 23);
+                h = uint16_t(std::bit_cast<uint32_t>(std::bit_cast<float>(u) + magic) - std::bit_cast<uint32_t>(magic));
+            }
+            else {
+                const uint32_t mantOdd = (u >> 13) & 1u;
+                u += (uint32_t(15 - 127) << 23) + 0xFFFu; // rebias, round half up
+                u += mantOdd;                              // ... to even
+                h = uint16_t(u >> 13);
+            }
+            return uint16_t(h | (sign >> 16));
+        }
+
+        inline float halfToFloat(uint16_t h) {
+            constexpr uint32_t SHIFTED_EXP = 0x7C00u << 13;
+            uint32_t o = (uint32_t(h) & 0x7FFFu) << 13;
+            const uint32_t exp = o & SHIFTED_EXP;
+            o += uint32_t(127 - 15) << 23;
+
+            if (exp == SHIFTED_EXP) o += uint32_t(128 - 16) << 23; // Inf / NaN
+            else if (exp == 0) {                                     // zero / subnormal: renormalize
+                o += 1u << 23;
+                o = std::bit_cast<uint32_t>(std::bit_cast<float>(o) - std::bit_cast<float>(113u << 23));
+            }
+            return std::bit_cast<float>(o | ((uint32_t(h) & 0x8000u) << 16));
+        }
+
+        /**
+         * @brief The three halves at src (6 bytes, any alignment) as floats.
+         * * A texel fetch decodes 12 halves, and a scalar halfToFloat per channel made a
+         * bilinear Half3 lookup on a 4k map take about 2.5x the Float3 one: the extra
+         * instructions keep the next lookup's cache misses from overlapping. F16C (when
+         * the build targets it) or the same conversion on SSE2 lanes brings it back.
+         */
+        inline Vector3 decodeHalf3(const uint8_t* src) {
+#if RAYT_SIMD_SSE2
+            uint32_t rg;
+            uint16_t b;
+            std::memcpy(&rg, src, 4);
+            std::memcpy(&b, src + 4, 2);
+            const __m128i h16 = _mm_insert_epi16(_mm_cvtsi32_si128(int(rg)), b, 2);
+#if RAYT_F16C
+            const __m128 v = _mm_cvtph_ps(h16);
+#else
+            // halfToFloat on 4 lanes: shift into float position and rescale by 2^112
+            // (subnormals come out right too), then restore Inf / NaN and the sign
+            const __m128i h = _mm_unpacklo_epi16(h16, _mm_setzero_si128());
+            const __m128i expMant = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+            const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)),
+                _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+            const __m128 infNan = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7BFF))),
+                _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+            const __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_xor_si128(h, expMant), 16));
+            const __m128 v = _mm_or_ps(scaled, _mm_or_ps(sign, infNan));
+#endif
+            return Vector3(_mm_cvtss_f32(v), _mm_cvtss_f32(_mm_shuffle_ps(v, v, 1)), _mm_cvtss_f32(_mm_shuffle_ps(v, v, 2)));
+#else
+            uint16_t v[3];
+            std::memcpy(v, src, sizeof(v));
+            return Vector3(halfToFloat(v[0]), halfToFloat(v[1]), halfToFloat(v[2]));
+#endif
+        }
+
+        // ---------------------------------------------------------------------
+        // RGBE (Radiance)
+        // ---------------------------------------------------------------------
+
+        inline void encodeRGBE(float r, float g, float b, uint8_t out[4]) {
+            // Double arithmetic: the scale for float subnormals does not fit in a float
+            auto clampChannel = [](float c) { return c > 0.0f ? double(std::min(c, FLT_MAX)) : 0.0; }; // NaN -> 0
+            const double rd = clampChannel(r), gd = clampChannel(g), bd = clampChannel(b);
+            const double v = std::max(rd, std::max(gd, bd));
+
+            int e;
+            std::frexp(v, &e); // v = f * 2^e, f in [0.5, 1)
+            double scale = std::ldexp(256.0, -e);
+            // Rounding the largest channel can reach 256: move to the next exponent
+            if (v * scale + 0.5 >= 256.0) { ++e; scale *= 0.5; }
+            if (v == 0.0 || e < -127) { out[0] = out[1] = out[2] = out[3] = 0; return; }
+            if (e > 127) { e = 127; scale = std::ldexp(256.0, -e); }
+            out[0] = uint8_t(std::min(rd * scale + 0.5, 255.0));
+            out[1] = uint8_t(std::min(gd * scale + 0.5, 255.0));
+            out[2] = uint8_t(std::min(bd * scale + 0.5, 255.0));
+            out[3] = uint8_t(e + 128);
+        }
+
+        inline Vector3 decodeRGBE(const uint8_t in[4]) {
+            if (in[3] == 0) return Vector3(0.0);
+            const float f = std::ldexp(1.0f, int(in[3]) - (128 + 8));
+            return Vector3(in[0] * f, in[1] * f, in[2] * f);
+        }
+
+        // ---------------------------------------------------------------------
+        // RGB9E5 (EXT_texture_shared_exponent)
+        // ---------------------------------------------------------------------
+
+        inline uint32_t encodeRGB9E5(float r, float g, float b) {
+            constexpr int BIAS = 15, MANT = 9, EMAX = 31;
+            constexpr float MAX_VALUE = float((1 << MANT) - 1) / (1 << MANT) * float(1 << (EMAX - BIAS));
+            auto clampChannel = [&](float c) { return c > 0.0f ? std::min(c, MAX_VALUE) : 0.0f; }; // NaN -> 0
+            r = clampChannel(r); g = clampChannel(g); b = clampChannel(b);
+            const float v = std::max(r, std::max(g, b));
+
+            int e = std::max(-BIAS - 1, int(std::floor(std::log2(std::max(v, 1e-30f))))) + 1 + BIAS;
+            float scale = std::ldexp(1.0f, MANT - (e - BIAS));
+            if (int(v * scale + 0.5f) == (1 << MANT)) { ++e; scale *= 0.5f; }
+
+            const uint32_t rm = uint32_t(r * scale + 0.5f), gm = uint32_t(g * scale + 0.5f), bm = uint32_t(b * scale + 0.5f);
+            return rm | (gm << 9) | (bm << 18) | (uint32_t(e) << 27);
+        }
+
+        inline Vector3 decodeRGB9E5(uint32_t p) {
+            const float f = std::ldexp(1.0f, int(p >> 27) - 15 - 9);
+            return Vector3(float(p & 0x1FFu) * f, float((p >> 9) & 0x1FFu) * f, float((p >> 18) & 0x1FFu) * f);
+        }
+
+        // ---------------------------------------------------------------------
+        // Dispatch
+        // ---------------------------------------------------------------------
+
+        /// Writes rgb into the bytesPerPixel(f) bytes at dst.
+        inline void encode(PixelFormat f, const Vector3& rgb, uint8_t* dst) {
+            const float r = float(rgb.x), g = float(rgb.y), b = float(rgb.z);
+            switch (f) {
+            case PixelFormat::Float3: {
+                const float v[3] = { r, g, b };
+                std::memcpy(dst, v, sizeof(v));
+                break;
+            }
+            case PixelFormat::Half3: {
+                const uint16_t v[3] = { floatToHalf(r), floatToHalf(g), floatToHalf(b) };
+                std::memcpy(dst, v, sizeof(v));
+                break;
+            }
+            case PixelFormat::RGBE:
+                encodeRGBE(r, g, b, dst);
+                break;
+            case PixelFormat::RGB9E5: {
+                const uint32_t v = encodeRGB9E5(r, g, b);
+                std::memcpy(dst, &v, sizeof(v));
+                break;
+            }
+            }
+        }
+
+        /// Reads the pixel at src.
+        inline Vector3 decode(PixelFormat f, const uint8_t* src) {
+            switch (f) {
+            case PixelFormat::Float3: {
+                float v[3];
+                std::memcpy(v, src, sizeof(v));
+                return Vector3(v[0], v[1], v[2]);
+            }
+            case PixelFormat::Half3:
+                return decodeHalf3(src);
+            case PixelFormat::RGBE:
+                return decodeRGBE(src);
+            case PixelFormat::RGB9E5: {
+                uint32_t v;
+                std::memcpy(&v, src, sizeof(v));
+                return decodeRGB9E5(v);
+            }
+            }
+            return Vector3(0.0);
+        }
+
+    } // namespace pixel
+
+} // namespace rayt
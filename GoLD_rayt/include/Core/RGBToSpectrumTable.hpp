@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @file RGBToSpectrumTable.hpp
+ * @brief Precomputed RGB -> smooth reflectance spectrum upsampling (Jakob & Hanika 2019).
+ * * Every RGB input of a spectral render has to become a spectrum at the path's
+ * wavelengths. Jakob & Hanika, "A Low-Dimensional Function Space for Efficient
+ * Spectral Upsampling", represent it as a sigmoid of a quadratic,
+ *     s(lambda) = S(c0 lambda^2 + c1 lambda + c2),  S(x) = 1/2 + x / (2 sqrt(1 + x^2)),
+ * which is smooth, bounded to (0, 1) and reproduces almost all of sRGB. The
+ * three coefficients of a color come from a nonlinear fit, far too slow to run
+ * per lookup, so it runs once over a 3D grid of colors and the render
+ * trilinearly interpolates coefficients: a lookup is one small gather, and each
+ * wavelength costs two FMAs, a square root and a divide.
+ * * Grid layout (as in the paper): colors are grouped by their largest component
+ * l; z = rgb[l] is sampled more densely near 0 and 1, and the other two
+ * components are stored as fractions of z. Coefficients are stored per
+ * wavelength in nm, so evaluation needs no range normalization.
+ * * The grid is produced at build time by tools/rgb2spec_opt.cpp (a custom
+ * build step of the Visual Studio project; fitted and saved on first use when
+ * the file is still missing) and memory mapped at startup.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Simd.hpp"
+#include "IO/MappedFile.hpp"
+
+namespace rayt {
+
+    /**
+     * @brief One fitted spectrum: S(c0 lambda^2 + c1 lambda + c2), lambda in nm.
+     */
+    struct RGBSigmoidPolynomial {
+        float c0 = 0.0f, c1 = 0.0f, c2 = 0.0f;
+
+        float operator()(float lambda) const {
+            const float x = (c0 * lambda + c1) * lambda + c2;
+            return 0.5f + 0.5f * x / std::sqrt(1.0f + x * x);
+        }
+
+        /// Four wavelengths at once.
+        simd::Float4 evaluate(simd::Float4 lambda) const {
+            const simd::Float4 x = (simd::Float4(c0) * lambda + simd::Float4(c1)) * lambda + simd::Float4(c2);
+            return simd::Float4(0.5f) + simd::Float4(0.5f) * x / simd::sqrt(simd::Float4(1.0f) + x * x);
+        }
+
+        /// Batch form: out[i] = s(lambda[i]) for i < count.
+        void evaluate(const float* lambda, size_t count, float* out) const {
+            size_t i = 0;
+            for (; i + simd::LANES <= count; i += simd::LANES)
+                evaluate(simd::Float4::load(lambda + i)).store(out + i);
+            for (; i < count; ++i) out[i] = (*this)(lambda[i]);
+        }
+    };
+
+    class RGBToSpectrumTable {
+    public:
+        /// Grid points per axis; 64 keeps the round-trip error well below 1e-3.
+        static constexpr int DEFAULT_RES = 64;
+        /// Where sRGB() looks for the table (relative to the working directory, like Johnson.csv).
+        static constexpr const char* DEFAULT_FILE = "rgbspectrum_srgb.coeff";
+
+        RGBToSpectrumTable() = default;
+        RGBToSpectrumTable(RGBToSpectrumTable&&) noexcept = default;
+        RGBToSpectrumTable& operator=(RGBToSpectrumTable&&) noexcept = default;
+
+        /**
+         * @brief Fits the coefficient grid for linear sRGB (white balanced as in SampledSpectrum.hpp).
+         * * Gauss-Newton per grid point, each started from its neighbour's solution.
+         * About ten seconds of CPU time at DEFAULT_RES, split over all hardware
+         * threads; meant for tools/rgb2spec_opt.cpp.
+         */
+        static RGBToSpectrumTable fit(int res = DEFAULT_RES);
+
+        /**
+         * @brief Memory maps a table written by save().
+         * @return false if the file is missing, truncated or from another table version.
+         */
+        bool load(const std::string& filename);
+
+        /// Writes the table (to a temporary name first, then renamed).
+        bool save(const std::string& filename) const;
+
+        /**
+         * @brief The process-wide sRGB table.
+         * * Loaded from DEFAULT_FILE on first use; if that is missing or stale the
+         * grid is fitted here instead and written back for the next run.
+         */
+        static const RGBToSpectrumTable& sRGB();
+
+        bool empty() const { return m_coeffs == nullptr; }
+        int resolution() const { return m_res; }
+
+        /**
+         * @brief Coefficients for a linear sRGB color with components in [0, 1].
+         * * Gray inputs are better served by a constant spectrum (see spectral::fromRGB).
+         */
+        RGBSigmoidPolynomial operator()(const Vector3& rgb) const {
+            int l = 0;
+            if (rgb[1] > rgb[l]) l = 1;
+            if (rgb[2] > rgb[l]) l = 2;
+            const float z = float(rgb[l]);
+            if (!(z > 0.0f)) return { 0.0f, 0.0f, -1e6f }; // black
+
+            const float toGrid = float(m_res - 1) / z;
+            const float x = float(rgb[(l + 1) % 3]) * toGrid;
+            const float y = float(rgb[(l + 2) % 3]) * toGrid;
+            const int xi = std::min(int(x), m_res - 2);
+            const int yi = std::min(int(y), m_res - 2);
+            const int zi = findScaleInterval(z);
+            const float dx = x - float(xi), dy = y - float(yi);
+            const float dz = (z - m_scale[zi]) / (m_scale[zi + 1] - m_scale[zi]);
+
+            // Each corner's (c0, c1, c2) is read as one 4-lane load (the 4th lane is
+            // the next entry, or the padding float after the last one) and ignored
+            const size_t sx = 3, sy = sx * size_t(m_res), sz = sy * size_t(m_res);
+            const float* p = m_coeffs + size_t(l) * sz * size_t(m_res) + zi * sz + yi * sy + xi * sx;
+            auto corner = [p](size_t offset) { return simd::Float4::load(p + offset); };
+            auto lerp = [](simd::Float4 t, simd::Float4 a, simd::Float4 b) { return a + t * (b - a); };
+            const simd::Float4 tx(dx), ty(dy), tz(dz);
+            const simd::Float4 c = lerp(tz,
+                lerp(ty, lerp(tx, corner(0), corner(sx)), lerp(tx, corner(sy), corner(sy + sx))),
+                lerp(ty, lerp(tx, corner(sz), corner(sz + sx)), lerp(tx, corner(sz + sy), corner(sz + sy + sx))));
+
+            float out[simd::LANES];
+            c.store(out);
+            return { out[0], out[1], out[2] };
+        }
+
+    private:
+        static constexpr int Z_BUCKETS = 1024;
+
+        /// Largest i < res - 1 with scale[i] <= z, from a uniform bucket index plus a short walk.
+        int findScaleInterval(float z) const {
+            int i = m_zBucket[std::min(int(z * Z_BUCKETS), Z_BUCKETS - 1)];
+            while (i < m_res - 2 && m_scale[i + 1] <= z) ++i;
+            return i;
+        }
+
+        void bind(const float* data, int res);
+
+        int m_res = 0;
+        const float* m_scale = nullptr;   // res z nodes
+        const float* m_coeffs = nullptr;  // [3][res z][res y][res x][3], then one padding float
+        std::array<uint8_t, Z_BUCKETS> m_zBucket{}; // interval containing each bucket's start
+        std::vector<float> m_owned;       // storage when fitted in memory
+        io::MappedFile m_file;            // storage when loaded
+    };
+
+} // namespace rayt
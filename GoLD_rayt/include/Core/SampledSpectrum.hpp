@@ -0,0 +1,300 @@
+#pragma once
+
+/**
+ * @file SampledSpectrum.hpp
+ * @brief Hero-wavelength spectral samples and the conversions around them.
+ * * With RAYT_SPECTRAL=1 every camera path carries NSpectrumSamples
+ * wavelengths in one simd::Float4: a uniformly sampled hero wavelength plus
+ * copies rotated by (LAMBDA_MAX - LAMBDA_MIN) / N (Wilkie et al. 2014,
+ * "Hero Wavelength Spectral Sampling"). Throughput and radiance along the
+ * path are SampledSpectrum values, one lane per wavelength, and the estimate
+ * is projected to CIE XYZ and then to linear sRGB when it reaches the film.
+ * * RGB inputs (albedo, emission, environment map) are lifted to smooth spectra
+ * through the precomputed sigmoid-polynomial table in RGBToSpectrumTable.hpp,
+ * fitted so that a lifted color projects back to the same RGB. The XYZ -> sRGB
+ * conversion is white balanced from the equal-energy illuminant to D65
+ * (Bradford), so RGB white lifts to the constant spectrum 1 and a white
+ * reflector stays white and energy conserving. Materials with measured data
+ * evaluate per wavelength instead.
+ * * In the default RGB mode PathSpectrum is Spectrum and lift()/toFilmRGB()
+ * are identities, so the integrator compiles to the same code as before.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "Core/Types.hpp"
+#include "Core/Simd.hpp"
+#include "Core/RGBToSpectrumTable.hpp"
+
+namespace rayt {
+
+    /// Wavelengths carried per path (one SIMD register).
+    inline constexpr int NSpectrumSamples = simd::LANES;
+
+    /// Sampled wavelength range [nm].
+    inline constexpr Real LAMBDA_MIN = 360.0;
+    inline constexpr Real LAMBDA_MAX = 830.0;
+
+    /**
+     * @brief Values of a spectral quantity at the path's sampled wavelengths.
+     * * Stored as float lanes: the per-lane math is throughput, not accumulation,
+     * and the film sum happens in Real after conversion to RGB.
+     */
+    class SampledSpectrum {
+    public:
+        SampledSpectrum() : m_v(0.0f) {}
+        explicit SampledSpectrum(Real c) : m_v(float(c)) {}
+        explicit SampledSpectrum(simd::Float4 v) : m_v(v) {}
+
+        float operator[](int i) const {
+            float t[NSpectrumSamples];
+            m_v.store(t);
+            return t[i];
+        }
+
+        const simd::Float4& lanes() const { return m_v; }
+
+        Real average() const {
+            float t[NSpectrumSamples];
+            m_v.store(t);
+            return (Real(t[0]) + t[1] + t[2] + t[3]) / NSpectrumSamples;
+        }
+
+        SampledSpectrum& operator+=(const SampledSpectrum& o) { m_v = m_v + o.m_v; return *this; }
+        SampledSpectrum& operator-=(const SampledSpectrum& o) { m_v = m_v - o.m_v; return *this; }
+        SampledSpectrum& operator*=(const SampledSpectrum& o) { m_v = m_v * o.m_v; return *this; }
+        SampledSpectrum& operator/=(const SampledSpectrum& o) { m_v = m_v / o.m_v; return *this; }
+        SampledSpectrum& operator*=(Real s) { m_v = m_v * simd::Float4(float(s)); return *this; }
+        SampledSpectrum& operator/=(Real s) { m_v = m_v * simd::Float4(float(Real(1.0) / s)); return *this; }
+
+        friend SampledSpectrum operator+(SampledSpectrum a, const SampledSpectrum& b) { return a += b; }
+        friend SampledSpectrum operator-(SampledSpectrum a, const SampledSpectrum& b) { return a -= b; }
+        friend SampledSpectrum operator*(SampledSpectrum a, const SampledSpectrum& b) { return a *= b; }
+        friend SampledSpectrum operator/(SampledSpectrum a, const SampledSpectrum& b) { return a /= b; }
+
+        friend SampledSpectrum operator+(SampledSpectrum a, Real s) { return a += SampledSpectrum(s); }
+        friend SampledSpectrum operator-(SampledSpectrum a, Real s) { return a -= SampledSpectrum(s); }
+        friend SampledSpectrum operator*(SampledSpectrum a, Real s) { return a *= s; }
+        friend SampledSpectrum operator*(Real s, SampledSpectrum a) { return a *= s; }
+        friend SampledSpectrum operator/(SampledSpectrum a, Real s) { return a /= s; }
+
+    private:
+        simd::Float4 m_v;
+    };
+
+    inline SampledSpectrum sqrt(const SampledSpectrum& s) { return SampledSpectrum(simd::sqrt(s.lanes())); }
+
+    /// Same contract as the Spectrum overload in SpectrumUtils.hpp.
+    inline bool isBlack(const SampledSpectrum& s) {
+        return !(s.lanes() > simd::Float4(0.0f)).any();
+    }
+
+    /// Same contract as the Spectrum overload in SpectrumUtils.hpp.
+    inline bool HasInvalidValues(const SampledSpectrum& s) {
+        for (int i = 0; i < NSpectrumSamples; ++i)
+            if (!std::isfinite(s[i])) return true;
+        return false;
+    }
+
+    /**
+     * @brief The wavelengths a path carries, with their sampling density.
+     */
+    class SampledWavelengths {
+    public:
+        /**
+         * @brief Hero wavelength at u, the others rotated by an equal stride and wrapped.
+         * * Every lane is marginally uniform over [LAMBDA_MIN, LAMBDA_MAX], so all
+         * lanes share the pdf 1 / (LAMBDA_MAX - LAMBDA_MIN).
+         * @param u Uniform sample in [0, 1).
+         */
+        static SampledWavelengths sampleHero(Real u) {
+            constexpr Real range = LAMBDA_MAX - LAMBDA_MIN;
+            constexpr Real stride = range / NSpectrumSamples;
+            const Real hero = LAMBDA_MIN + u * range;
+
+            float l[NSpectrumSamples];
+            for (int i = 0; i < NSpectrumSamples; ++i) {
+                Real li = hero + i * stride;
+                if (li >= LAMBDA_MAX) li -= range;
+                l[i] = float(li);
+            }
+
+            SampledWavelengths w;
+            w.m_lambda = simd::Float4::load(l);
+            w.m_pdf = Real(1.0) / range;
+            return w;
+        }
+
+        /// Wavelength of lane i [nm].
+        Real operator[](int i) const {
+            float t[NSpectrumSamples];
+            m_lambda.store(t);
+            return t[i];
+        }
+
+        const simd::Float4& lanes() const { return m_lambda; }
+
+        /// Density of each lane's wavelength [1/nm].
+        Real pdf() const { return m_pdf; }
+
+    private:
+        simd::Float4 m_lambda = simd::Float4(float(LAMBDA_MIN));
+        Real m_pdf = 0;
+    };
+
+    namespace spectral {
+
+        using Matrix3 = glm::mat<3, 3, Real, glm::defaultp>;
+
+        /**
+         * @brief CIE 1931 2-degree color matching functions.
+         * * Multi-lobe piecewise Gaussian fit of Wyman, Sloan and Shirley (JCGT 2013);
+         * within a few percent of the tabulated data across the visible range.
+         */
+        inline Vector3 cieXYZ(Real lambda) {
+            auto g = [lambda](Real mu, Real s1, Real s2) {
+                const Real t = (lambda - mu) / (lambda < mu ? s1 : s2);
+                return std::exp(Real(-0.5) * t * t);
+            };
+            return Vector3(
+                1.056 * g(599.8, 37.9, 31.0) + 0.362 * g(442.0, 16.0, 26.7) - 0.065 * g(501.1, 20.4, 26.2),
+                0.821 * g(568.8, 46.9, 40.5) + 0.286 * g(530.9, 16.3, 31.1),
+                1.217 * g(437.0, 11.8, 36.0) + 0.681 * g(459.0, 26.0, 13.8));
+        }
+
+        namespace detail {
+
+            inline Matrix3 rowMajor(Real a, Real b, Real c, Real d, Real e, Real f, Real g, Real h, Real i) {
+                return glm::transpose(Matrix3(a, b, c, d, e, f, g, h, i));
+            }
+
+            /// Conversion matrices and a 1 nm matching-function table, derived once.
+            struct ColorTables {
+                static constexpr int CMF_SIZE = int(LAMBDA_MAX - LAMBDA_MIN) + 1;
+
+                Real yIntegral = 0;   ///< Integral of y-bar over the sampled range.
+                Matrix3 xyzToRGB;     ///< XYZ -> linear sRGB, white balanced from E to D65.
+                std::array<Vector3, CMF_SIZE> cmf; ///< cieXYZ at LAMBDA_MIN + i nm.
+
+                /// cieXYZ(lambda) from the table (linear interpolation, no exp).
+                Vector3 cmfAt(Real lambda) const {
+                    const Real x = std::clamp(lambda - LAMBDA_MIN, Real(0.0), Real(CMF_SIZE - 1));
+                    const int i = std::min(int(x), CMF_SIZE - 2);
+                    const Real t = x - i;
+                    return cmf[i] + t * (cmf[i + 1] - cmf[i]);
+                }
+
+                ColorTables() {
+                    for (int i = 0; i < CMF_SIZE; ++i) cmf[i] = cieXYZ(LAMBDA_MIN + i);
+
+                    // 1 nm midpoint sums over the sampled range
+                    Vector3 white(0.0);
+                    for (Real l = LAMBDA_MIN + 0.5; l < LAMBDA_MAX; l += 1.0) white += cieXYZ(l);
+                    yIntegral = white.y;
+
+                    const Matrix3 sRGB = rowMajor(
+                        3.2404542, -1.5371385, -0.4985314,
+                        -0.9692660, 1.8760108, 0.0415560,
+                        0.0556434, -0.2040259, 1.0572252);
+                    const Matrix3 bradford = rowMajor(
+                        0.8951, 0.2664, -0.1614,
+                        -0.7502, 1.7135, 0.0367,
+                        0.0389, -0.0685, 1.0296);
+
+                    const Vector3 lmsE = bradford * (white / yIntegral);
+                    const Vector3 lmsD65 = bradford * Vector3(0.95047, 1.0, 1.08883);
+                    Matrix3 scale(1.0);
+                    for (int i = 0; i < 3; ++i) scale[i][i] = lmsD65[i] / lmsE[i];
+                    xyzToRGB = sRGB * glm::inverse(bradford) * scale * bradford;
+                }
+            };
+
+            inline const ColorTables& tables() {
+                static const ColorTables t;
+                return t;
+            }
+
+        } // namespace detail
+
+        /**
+         * @brief Monte Carlo estimate of a spectrum's CIE XYZ from its sampled lanes.
+         */
+        inline Vector3 toXYZ(const SampledSpectrum& s, const SampledWavelengths& lambda) {
+            const detail::ColorTables& t = detail::tables();
+            float sv[NSpectrumSamples], lv[NSpectrumSamples];
+            s.lanes().store(sv);
+            lambda.lanes().store(lv);
+
+            Vector3 xyz(0.0);
+            for (int i = 0; i < NSpectrumSamples; ++i)
+                xyz += Real(sv[i]) * t.cmfAt(lv[i]);
+            return xyz / (lambda.pdf() * NSpectrumSamples * t.yIntegral);
+        }
+
+        /**
+         * @brief Linear sRGB of a sampled spectrum (white balanced, see the file comment).
+         */
+        inline Spectrum toRGB(const SampledSpectrum& s, const SampledWavelengths& lambda) {
+            return detail::tables().xyzToRGB * toXYZ(s, lambda);
+        }
+
+        /**
+         * @brief Lifts a linear sRGB value to a spectrum and samples it at lambda.
+         * * Negative components are clamped to zero and grays lift to constants.
+         * Values up to 1 (reflectances) use the table directly and stay within
+         * (0, 1); brighter ones (emission, HDR environment) are fitted at half
+         * intensity, where the table is exact, and scaled back up.
+         */
+        inline SampledSpectrum fromRGB(const Spectrum& rgb, const SampledWavelengths& lambda) {
+            const Vector3 c = glm::max(rgb, Vector3(0.0));
+            if (c.x == c.y && c.y == c.z) return SampledSpectrum(c.x);
+
+            const Real m = std::max(c.x, std::max(c.y, c.z));
+            const Real scale = m > Real(1.0) ? Real(2.0) * m : Real(1.0);
+            const RGBSigmoidPolynomial s = RGBToSpectrumTable::sRGB()(c / scale);
+            return SampledSpectrum(s.evaluate(lambda.lanes())) * scale;
+        }
+
+    } // namespace spectral
+
+    // ---------------------------------------------------------------------
+    // Path quantities (compile-time switch, see RAYT_SPECTRAL in Types.hpp)
+    // ---------------------------------------------------------------------
+
+#if RAYT_SPECTRAL
+    using PathSpectrum = SampledSpectrum;
+#else
+    using PathSpectrum = Spectrum;
+#endif
+
+    namespace spectral {
+
+        /**
+         * @brief An RGB value entering a path (albedo, emission, environment).
+         */
+        inline PathSpectrum lift(const Spectrum& rgb, const SampledWavelengths& lambda) {
+#if RAYT_SPECTRAL
+            return fromRGB(rgb, lambda);
+#else
+            (void)lambda;
+            return rgb;
+#endif
+        }
+
+        /**
+         * @brief A finished path estimate as the RGB the film accumulates.
+         */
+        inline Spectrum toFilmRGB(const PathSpectrum& L, const SampledWavelengths& lambda) {
+#if RAYT_SPECTRAL
+            return toRGB(L, lambda);
+#else
+            (void)lambda;
+            return L;
+#endif
+        }
+
+    } // namespace spectral
+
+} // namespace rayt
@@ -9,6 +9,7 @@
 
 #include <random>
 #include <numbers>
+#include <cstdint>
 #include <algorithm>
 #include <cmath>
 
@@ -31,13 +32,38 @@ namespace rayt::sampling {
      * * Uses the Mersenne Twister engine with 'thread_local' storage to ensure
      * high-performance, thread-safe parallel rendering without mutex contention.
      */
-    inline Real Random() {
-        // static thread_local std::mt19937 generator(std::random_device{}());
+    namespace detail {
+        inline std::mt19937& RandomGenerator() {
+            // static thread_local std::mt19937 generator(std::random_device{}());
+
+            // Fixed seed for deterministic debugging
+            static thread_local std::mt19937 generator(12345);
+            return generator;
+        }
+    }
 
-        // Fixed seed for deterministic debugging
-        static thread_local std::mt19937 generator(12345);
+    inline Real Random() {
         static thread_local std::uniform_real_distribution<Real> distribution(0.0, 1.0);
-        return distribution(generator);
+        return distribution(detail::RandomGenerator());
+    }
+
+    /**
+     * @brief Restarts the calling thread's Random() sequence from a seed.
+     * * Parallel renderers seed per work item (e.g. per film tile) so that the
+     * image does not depend on which thread picked up which item.
+     */
+    inline void SeedRandom(uint32_t seed) {
+        detail::RandomGenerator().seed(seed);
+    }
+
+    /**
+     * @brief Integer hash (lowbias32) for turning indices into decorrelated seeds.
+     */
+    inline uint32_t Hash32(uint32_t x) {
+        x ^= x >> 16; x *= 0x7FEB352Du;
+        x ^= x >> 15; x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
     }
 
     /**
@@ -132,4 +158,29 @@ namespace rayt::sampling {
         Real y = std::sin(phi) * sinTheta; // sin(theta)*sin(phi)
         return Vector3(x, y, z);
     }
+
+    // -------------------------------------------------------------------------
+    // Low-Discrepancy Point Sets
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Base-2 radical inverse (Van der Corput sequence) of i, in [0, 1).
+     */
+    inline Real RadicalInverse2(uint32_t i) {
+        i = (i << 16) | (i >> 16);
+        i = ((i & 0x00FF00FFu) << 8) | ((i & 0xFF00FF00u) >> 8);
+        i = ((i & 0x0F0F0F0Fu) << 4) | ((i & 0xF0F0F0F0u) >> 4);
+        i = ((i & 0x33333333u) << 2) | ((i & 0xCCCCCCCCu) >> 2);
+        i = ((i & 0x55555555u) << 1) | ((i & 0xAAAAAAAAu) >> 1);
+        return Real(i) * Real(2.3283064365386963e-10); // 2^-32
+    }
+
+    /**
+     * @brief Point i of the n-point Hammersley set in [0, 1)^2.
+     * * Deterministic and well stratified: used for precomputed integrals
+     * (split-sum tables, prefiltered environments) that must not be noisy.
+     */
+    inline Point2 Hammersley(uint32_t i, uint32_t n) {
+        return Point2(float((Real(i) + Real(0.5)) / Real(n)), float(RadicalInverse2(i)));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+/**
+ * @file Simd.hpp
+ * @brief Minimal 4-wide float SIMD wrapper used by the batched kernels.
+ * * Float4 / Mask4 wrap SSE2 registers on x86/x64 (always available on x64,
+ * both MSVC and GCC/Clang). On other targets the same interface falls back to
+ * a plain 4-element array, so kernels written against it stay portable; they
+ * just lose the speedup.
+ * * Only what the kernels need is here: arithmetic, compare/select, sqrt, a
+ * polynomial sincos that is accurate to ~1e-6 on any finite input that fits
+ * in an int after scaling by 2/pi, and exp (relative error ~2e-7).
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYT_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define RAYT_SIMD_SSE2 0
+#endif
+
+namespace rayt::simd {
+
+    /// Number of lanes in Float4.
+    inline constexpr int LANES = 4;
+
+    /// Rounds n up to a whole number of lanes.
+    inline constexpr size_t roundUpToLanes(size_t n) {
+        return (n + LANES - 1) / LANES * LANES;
+    }
+
+#if RAYT_SIMD_SSE2
+
+    struct Mask4 {
+        __m128 v;
+        Mask4() = default;
+        explicit Mask4(__m128 m) : v(m) {}
+
+        friend Mask4 operator&(Mask4 a, Mask4 b) { return Mask4(_mm_and_ps(a.v, b.v)); }
+        friend Mask4 operator|(Mask4 a, Mask4 b) { return Mask4(_mm_or_ps(a.v, b.v)); }
+        friend Mask4 operator^(Mask4 a, Mask4 b) { return Mask4(_mm_xor_ps(a.v, b.v)); }
+        bool any() const { return _mm_movemask_ps(v) != 0; }
+        bool all() const { return _mm_movemask_ps(v) == 0xF; }
+    };
+
+    struct Float4 {
+        __m128 v;
+        Float4() = default;
+        Float4(float s) : v(_mm_set1_ps(s)) {}
+        explicit Float4(__m128 x) : v(x) {}
+
+        static Float4 load(const float* p) { return Float4(_mm_loadu_ps(p)); }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+        friend Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+        friend Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+        friend Float4 operator/(Float4 a, Float4 b) { return Float4(_mm_div_ps(a.v, b.v)); }
+        friend Float4 operator-(Float4 a) { return Float4(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+
+        friend Mask4 operator<(Float4 a, Float4 b) { return Mask4(_mm_cmplt_ps(a.v, b.v)); }
+        friend Mask4 operator>(Float4 a, Float4 b) { return Mask4(_mm_cmpgt_ps(a.v, b.v)); }
+        friend Mask4 operator==(Float4 a, Float4 b) { return Mask4(_mm_cmpeq_ps(a.v, b.v)); }
+    };
+
+    inline Float4 sqrt(Float4 a) { return Float4(_mm_sqrt_ps(a.v)); }
+    inline Float4 min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+    inline Float4 max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+    inline Float4 abs(Float4 a) { return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+
+    /// Per lane: m ? a : b
+    inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+        return Float4(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)));
+    }
+
+    /// Rounds to the nearest integer (ties to even), returned as float.
+    inline Float4 round(Float4 a) { return Float4(_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))); }
+
+    /// Lanes whose (integer-valued) a has bit `bit` set.
+    inline Mask4 testBit(Float4 a, int bit) {
+        __m128i i = _mm_cvtps_epi32(a.v);
+        __m128i b = _mm_set1_epi32(1 << bit);
+        return Mask4(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(i, b), b)));
+    }
+
+    /// 2^n for integer-valued n in [-126, 127].
+    inline Float4 pow2i(Float4 n) {
+        const __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+        return Float4(_mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+    }
+
+    /// Splits a positive normal x into m 2^e with m in [1, 2); returns m.
+    inline Float4 splitExponent(Float4 x, Float4& e) {
+        const __m128i i = _mm_castps_si128(x.v);
+        e = Float4(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(i, 23), _mm_set1_epi32(127))));
+        return Float4(_mm_or_ps(_mm_and_ps(x.v, _mm_castsi128_ps(_mm_set1_epi32(0x007FFFFF))), _mm_set1_ps(1.0f)));
+    }
+
+#else // scalar fallback
+
+    struct Mask4 {
+        bool v[4];
+        friend Mask4 operator&(Mask4 a, Mask4 b) { return { a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3] }; }
+        friend Mask4 operator|(Mask4 a, Mask4 b) { return { a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3] }; }
+        friend Mask4 operator^(Mask4 a, Mask4 b) { return { a.v[0] != b.v[0], a.v[1] != b.v[1], a.v[2] != b.v[2], a.v[3] != b.v[3] }; }
+        bool any() const { return v[0] || v[1] || v[2] || v[3]; }
+        bool all() const { return v[0] && v[1] && v[2] && v[3]; }
+    };
+
+    struct Float4 {
+        float v[4];
+        Float4() = default;
+        Float4(float s) : v{ s, s, s, s } {}
+
+        static Float4 load(const float* p) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+        void store(float* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+        template <typename F>
+        static Float4 map(Float4 a, Float4 b, F f) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = f(a.v[i], b.v[i]); return r; }
+        template <typename F>
+        static Mask4 cmp(Float4 a, Float4 b, F f) { Mask4 r; for (int i = 0; i < 4; ++i) r.v[i] = f(a.v[i], b.v[i]); return r; }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x + y; }); }
+        friend Float4 operator-(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x - y; }); }
+        friend Float4 operator*(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x * y; }); }
+        friend Float4 operator/(Float4 a, Float4 b) { return map(a, b, [](float x, float y) { return x / y; }); }
+        friend Float4 operator-(Float4 a) { return Float4(0.0f) - a; }
+
+        friend Mask4 operator<(Float4 a, Float4 b) { return cmp(a, b, [](float x, float y) { return x < y; }); }
+        friend Mask4 operator>(Float4 a, Float4 b) { return cmp(a, b, [](float x, float y) { return x > y; }); }
+        friend Mask4 operator==(Float4 a, Float4 b) { return cmp(a, b, [](float x, float y) { return x == y; }); }
+    };
+
+    inline Float4 sqrt(Float4 a) { return Float4::map(a, a, [](float x, float) { return std::sqrt(x); }); }
+    inline Float4 min(Float4 a, Float4 b) { return Float4::map(a, b, [](float x, float y) { return y < x ? y : x; }); }
+    inline Float4 max(Float4 a, Float4 b) { return Float4::map(a, b, [](float x, float y) { return x < y ? y : x; }); }
+    inline Float4 abs(Float4 a) { return Float4::map(a, a, [](float x, float) { return std::fabs(x); }); }
+
+    inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+        Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = m.v[i] ? a.v[i] : b.v[i]; return r;
+    }
+
+    inline Float4 round(Float4 a) { return Float4::map(a, a, [](float x, float) { return std::nearbyint(x); }); }
+
+    inline Mask4 testBit(Float4 a, int bit) {
+        Mask4 r; for (int i = 0; i < 4; ++i) r.v[i] = ((int32_t(a.v[i]) >> bit) & 1) != 0; return r;
+    }
+
+    inline Float4 pow2i(Float4 n) { return Float4::map(n, n, [](float x, float) { return std::ldexp(1.0f, int(x)); }); }
+
+    inline Float4 splitExponent(Float4 x, Float4& e) {
+        Float4 m;
+        for (int i = 0; i < 4; ++i) {
+            int k;
+            m.v[i] = 2.0f * std::frexp(x.v[i], &k);
+            e.v[i] = float(k - 1);
+        }
+        return m;
+    }
+
+#endif
+
+    /**
+     * @brief e^x for four lanes; x is clamped to [-87, 88] (no denormals, no overflow).
+     * * x = n ln2 + r with |r| <= ln2 / 2 (Cody-Waite), e^r by its degree-6
+     * Taylor polynomial, scaled by 2^n through the exponent bits.
+     */
+    inline Float4 exp(Float4 x) {
+        x = min(max(x, Float4(-87.0f)), Float4(88.0f));
+        const Float4 n = round(x * Float4(1.44269504f));
+        const Float4 r = (x - n * Float4(0.693359375f)) - n * Float4(-2.12194440e-4f);
+        Float4 p = Float4(1.0f / 720.0f);
+        p = p * r + Float4(1.0f / 120.0f);
+        p = p * r + Float4(1.0f / 24.0f);
+        p = p * r + Float4(1.0f / 6.0f);
+        p = p * r + Float4(0.5f);
+        p = p * r + Float4(1.0f);
+        p = p * r + Float4(1.0f);
+        return p * pow2i(n);
+    }
+
+    /**
+     * @brief Computes sin(x) and cos(x) for four lanes.
+     * * Range reduction to [-pi/4, pi/4] by the nearest multiple of pi/2
+     * (two-constant Cody-Waite), then Taylor polynomials of degree 7 (sin) and
+     * 8 (cos); the quadrant picks which result goes where and with what sign.
+     */
+    inline void sincos(Float4 x, Float4& s, Float4& c) {
+        const Float4 q = round(x * Float4(0.636619772f)); // x * 2/pi
+        const Float4 y = (x - q * Float4(1.5703125f)) - q * Float4(4.83826794897e-4f);
+        const Float4 y2 = y * y;
+
+        Float4 ps = Float4(-1.0f / 5040.0f);
+        ps = ps * y2 + Float4(1.0f / 120.0f);
+        ps = ps * y2 + Float4(-1.0f / 6.0f);
+        ps = (ps * y2) * y + y;
+
+        Float4 pc = Float4(1.0f / 40320.0f);
+        pc = pc * y2 + Float4(-1.0f / 720.0f);
+        pc = pc * y2 + Float4(1.0f / 24.0f);
+        pc = pc * y2 + Float4(-0.5f);
+        pc = pc * y2 + Float4(1.0f);
+
+        // Quadrant: 1 and 3 swap sin/cos; sin flips in 2,3 and cos flips in 1,2
+        const Mask4 odd = testBit(q, 0);
+        const Mask4 half = testBit(q, 1);
+        Float4 sr = select(odd, pc, ps);
+        Float4 cr = select(odd, ps, pc);
+        s = select(half, -sr, sr);
+        c = select(odd ^ half, -cr, cr);
+    }
+
+} // namespace rayt::simd
@@ -34,6 +34,13 @@ namespace rayt {
         return !std::isfinite(s.x) || !std::isfinite(s.y) || !std::isfinite(s.z);
     }
 
+    /**
+     * @brief Rec. 709 luminance of a linear RGB spectrum.
+     */
+    inline Real Luminance(const Spectrum& s) {
+        return Real(0.2126) * s.x + Real(0.7152) * s.y + Real(0.0722) * s.z;
+    }
+
     /**
      * @brief Ensures a spectrum is physically valid and numerically safe.
      * Clamps negative values to zero and recovers from NaNs/Infs by returning black.
@@ -0,0 +1,242 @@
+#pragma once
+
+/**
+ * @file TaskGraph.hpp
+ * @brief Startup tasks with explicit dependencies, run concurrently, with a timeline of when each ran.
+ * * Loading is a chain of mostly independent steps (decode an image, parse a
+ * CSV, build sampling tables, assemble the scene), and run one after the other
+ * the slowest ones add up. A TaskGraph takes them as tasks naming the tasks
+ * they need, runs every task whose dependencies are done on a small pool of
+ * workers, and lets the caller wait for exactly the outputs it needs next: a
+ * render can start while tables it does not use are still being built.
+ * * Tasks may use parallelFor themselves (it forks its own threads), so the
+ * pool only has to cover the tasks that can overlap, not the cores. A task
+ * that throws is recorded as failed; the tasks depending on it are skipped,
+ * and wait() rethrows the exception for all of them.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Core/Parallel.hpp"
+
+namespace rayt {
+
+    class TaskGraph {
+    public:
+        using TaskId = int;
+
+        /// One bar of the timeline, in milliseconds since start().
+        struct Span {
+            std::string name;
+            double begin, end;
+            int thread; ///< Worker index, or -1 for the calling thread (runInline).
+        };
+
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /// Waits for every task (exceptions are dropped; wait() on a task to see them).
+        ~TaskGraph() {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_idle.wait(lock, [&] { return m_finished == int(m_tasks.size()) || !m_started; });
+                m_stopping = true;
+            }
+            m_ready.notify_all();
+            for (std::thread& t : m_workers) t.join();
+        }
+
+        /**
+         * @brief Adds a task that runs once all of `dependencies` have finished.
+         * @throws std::logic_error If the graph has started (workers hold references into it) or a
+         * dependency is not an earlier task (which also rules out cycles).
+         */
+        TaskId add(std::string name, std::vector<TaskId> dependencies, std::function<void()> body) {
+            const TaskId id = TaskId(m_tasks.size());
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_started) throw std::logic_error("TaskGraph: task '" + name + "' added after start()");
+            }
+            for (TaskId d : dependencies)
+                if (d < 0 || d >= id) throw std::logic_error("TaskGraph: task '" + name + "' depends on a task not added before it");
+            Task& task = m_tasks.emplace_back();
+            task.name = std::move(name);
+            task.body = std::move(body);
+            task.waiting = int(dependencies.size());
+            for (TaskId d : dependencies) m_tasks[d].dependents.push_back(id);
+            return id;
+        }
+
+        /**
+         * @brief Starts running the tasks on `threads` workers (default: one per hardware thread, at
+         * least two so that a long task does not hold up the others on a single core; never more
+         * than there are tasks).
+         */
+        void start(int threads = 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_started) return;
+            m_started = true;
+            m_clock = std::chrono::steady_clock::now();
+            for (TaskId id = 0; id < TaskId(m_tasks.size()); ++id)
+                if (m_tasks[id].waiting == 0) m_queue.push_back(id);
+            if (threads <= 0) threads = std::max(2, hardwareThreads());
+            threads = std::max(1, std::min(threads, int(m_tasks.size())));
+            for (int i = 0; i < threads; ++i) m_workers.emplace_back([this, i] { work(i); });
+        }
+
+        /**
+         * @brief Blocks until task `id` has run (starting the graph if needed).
+         * @throws std::logic_error If `id` is not a task of this graph; otherwise the exception of the
+         * task, or of the failed task it depended on.
+         */
+        void wait(TaskId id) {
+            if (id < 0 || id >= TaskId(m_tasks.size()))
+                throw std::logic_error("TaskGraph: wait() on unknown task " + std::to_string(id));
+            start();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [&] { return m_tasks[id].state == State::Done; });
+            if (m_tasks[id].error) std::rethrow_exception(m_tasks[id].error);
+        }
+
+        /// Waits for every task; rethrows the first failure in the order tasks were added.
+        void waitAll() {
+            for (TaskId id = 0; id < TaskId(m_tasks.size()); ++id) wait(id);
+        }
+
+        /**
+         * @brief Runs body on the calling thread and records it in the timeline (e.g. the render).
+         */
+        template <class Body>
+        void runInline(const std::string& name, Body&& body) {
+            start();
+            const double begin = now();
+            body();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inline.push_back({ name, begin, now(), -1 });
+        }
+
+        /// Spans of the tasks that ran and of runInline(), in start order.
+        std::vector<Span> timeline() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<Span> spans = m_inline;
+            for (const Task& t : m_tasks)
+                if (t.state == State::Done && t.end > 0) spans.push_back({ t.name, t.begin, t.end, t.thread });
+            std::stable_sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) { return a.begin < b.begin; });
+            return spans;
+        }
+
+        /**
+         * @brief Prints the timeline as one bar per task over `columns` characters.
+         */
+        void printTimeline(std::ostream& out, int columns = 50) const {
+            const std::vector<Span> spans = timeline();
+            double total = 0;
+            size_t nameWidth = 0;
+            for (const Span& s : spans) {
+                total = std::max(total, s.end);
+                nameWidth = std::max(nameWidth, s.name.size());
+            }
+            if (spans.empty() || total <= 0) return;
+
+            out << "[Startup] Timeline (" << total << " ms; worker #, or - for the main thread)\n";
+            for (const Span& s : spans) {
+                const int b = std::min(columns - 1, int(s.begin / total * columns));
+                const int e = std::max(b + 1, int(s.end / total * columns + 0.5));
+                char times[48];
+                std::snprintf(times, sizeof(times), "%8.1f - %8.1f ms ", s.begin, s.end);
+                out << "  " << s.name << std::string(nameWidth - s.name.size(), ' ') << " "
+                    << (s.thread < 0 ? '-' : char('0' + s.thread % 10)) << " " << times << "|"
+                    << std::string(b, ' ') << std::string(e - b, '#') << std::string(std::max(0, columns - e), ' ') << "|\n";
+            }
+        }
+
+    private:
+        enum class State { Pending, Running, Done };
+
+        struct Task {
+            std::string name;
+            std::function<void()> body;
+            std::vector<TaskId> dependents;
+            int waiting = 0;                // dependencies not finished yet
+            State state = State::Pending;
+            std::exception_ptr error;
+            double begin = 0, end = 0;
+            int thread = 0;
+        };
+
+        double now() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_clock).count();
+        }
+
+        void work(int thread) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true) {
+                m_ready.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                const TaskId id = m_queue.front();
+                m_queue.erase(m_queue.begin());
+
+                Task& task = m_tasks[id];
+                task.state = State::Running;
+                task.thread = thread;
+                // A failed dependency fails this task too, without running it
+                std::exception_ptr error = task.error;
+                if (!error) {
+                    lock.unlock();
+                    const double begin = now();
+                    try {
+                        task.body();
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                    const double end = now();
+                    lock.lock();
+                    task.begin = begin;
+                    task.end = end;
+                }
+                finish(id, error);
+            }
+        }
+
+        // With m_mutex held
+        void finish(TaskId id, std::exception_ptr error) {
+            Task& task = m_tasks[id];
+            task.error = error;
+            task.state = State::Done;
+            ++m_finished;
+            for (TaskId d : task.dependents) {
+                Task& dependent = m_tasks[d];
+                if (error && !dependent.error) dependent.error = error;
+                if (--dependent.waiting == 0) m_queue.push_back(d);
+            }
+            m_ready.notify_all();
+            m_idle.notify_all();
+        }
+
+        std::vector<Task> m_tasks;
+        std::vector<std::thread> m_workers;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_ready; // queue changed or stopping
+        std::condition_variable m_idle;  // a task finished
+        std::vector<TaskId> m_queue;
+        std::vector<Span> m_inline;
+        std::chrono::steady_clock::time_point m_clock = std::chrono::steady_clock::now();
+        int m_finished = 0;
+        bool m_started = false;
+        bool m_stopping = false;
+    };
+
+} // namespace rayt
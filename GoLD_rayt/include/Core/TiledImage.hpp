@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * @file TiledImage.hpp
+ * @brief Tiled image storage with a one-texel apron, for bilinear lookups.
+ * * In a row-major Image the two rows of a bilinear footprint are a full row
+ * apart (12 KiB for a 3072-wide RGBE map), and every fetch has to wrap/clamp
+ * its coordinates. Here the image is cut into TILE_SIZE x TILE_SIZE tiles, each
+ * stored contiguously together with one extra row and column taken from its
+ * neighbors (the apron). The grid starts one texel before the image, so every
+ * footprint with x0 in [-1, w-1], y0 in [-1, h-1] lies inside a single tile:
+ * the lookup is one index computation and four fixed offsets, with no wrap
+ * arithmetic and usually one or two cache lines.
+ *
+ * The boundary rule (wrap, clamp, octahedral fold, ...) is applied once, when
+ * the aprons are filled. Memory overhead is ((TILE_SIZE + 1) / TILE_SIZE)^2,
+ * about 13%, plus one row and column of tiles. Texels keep the source
+ * PixelFormat.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Image.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/PixelFormat.hpp"
+
+namespace rayt {
+
+    class TiledImage {
+    public:
+        static constexpr int TILE_LOG2 = 4;
+        static constexpr int TILE_SIZE = 1 << TILE_LOG2;  ///< Texels per tile side, apron excluded.
+        static constexpr int TILE_STRIDE = TILE_SIZE + 1; ///< Texels per stored tile row.
+
+        TiledImage() = default;
+
+        /**
+         * @brief Tiles an image.
+         * @param image The source image.
+         * @param address Boundary rule: address(x, y) maps a coordinate in
+         *        [-1, w] x [-1, h] (int&, in place) to a texel of the image,
+         *        leaving those inside the image unchanged.
+         */
+        template <class Address>
+        TiledImage(const Image& image, Address&& address)
+            : m_width(image.width()), m_height(image.height()), m_format(image.format()) {
+            if (!image.isValid()) { m_width = m_height = 0; return; }
+
+            // Tile coordinates are shifted by one texel: X = x + 1 covers x in [-1, w]
+            m_tilesX = (m_width >> TILE_LOG2) + 1;
+            m_tilesY = (m_height >> TILE_LOG2) + 1;
+            const size_t bpp = bytesPerPixel(m_format);
+            m_data.resize(size_t(m_tilesX) * m_tilesY * TILE_STRIDE * TILE_STRIDE * bpp);
+
+            // Same format on both sides: texels are copied as stored, not decoded and re-encoded
+            parallelFor(m_tilesY, 1, [&](int begin, int end) {
+                for (int ty = begin; ty < end; ++ty)
+                    for (int tx = 0; tx < m_tilesX; ++tx)
+                        for (int j = 0; j < TILE_STRIDE; ++j)
+                            for (int i = 0; i < TILE_STRIDE; ) {
+                                // Texels past the last footprint are never read; clamp them onto it
+                                int x = std::min((tx << TILE_LOG2) + i - 1, m_width);
+                                int y = std::min((ty << TILE_LOG2) + j - 1, m_height);
+                                // Inside the image the run up to the tile or image edge is one copy
+                                int run = 1;
+                                if (x >= 0 && x < m_width && y >= 0 && y < m_height) run = std::min(TILE_STRIDE - i, m_width - x);
+                                else address(x, y);
+                                std::memcpy(m_data.data() + offset(tx, ty, i, j),
+                                    image.data() + (size_t(y) * m_width + x) * bpp, run * bpp);
+                                i += run;
+                            }
+                });
+        }
+
+        bool isValid() const { return m_width > 0 && m_height > 0; }
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        PixelFormat format() const { return m_format; }
+        size_t memoryBytes() const { return m_data.size(); }
+
+        /**
+         * @brief Byte offset of texel (x, y), x in [-1, w - 1], y in [-1, h - 1], in the tile
+         *        whose footprints start there (cache analysis uses this too).
+         */
+        size_t byteOffset(int x, int y) const {
+            const int X = x + 1, Y = y + 1;
+            return offset(X >> TILE_LOG2, Y >> TILE_LOG2, X & (TILE_SIZE - 1), Y & (TILE_SIZE - 1));
+        }
+
+        /// Texel (x, y), x in [-1, w - 1], y in [-1, h - 1] (the apron applies the boundary rule).
+        Vector3 at(int x, int y) const {
+            return pixel::decode(m_format, m_data.data() + byteOffset(x, y));
+        }
+
+        /**
+         * @brief Bilinear lookup at continuous texel coordinates (texel centers at
+         *        integer + 0.5 already subtracted), x in [-1, w), y in [-1, h).
+         */
+        Vector3 bilinear(float x, float y) const {
+            switch (m_format) {
+            case PixelFormat::Half3: return bilinearAs<PixelFormat::Half3>(x, y);
+            case PixelFormat::RGBE: return bilinearAs<PixelFormat::RGBE>(x, y);
+            case PixelFormat::RGB9E5: return bilinearAs<PixelFormat::RGB9E5>(x, y);
+            default: return bilinearAs<PixelFormat::Float3>(x, y);
+            }
+        }
+
+    private:
+        int m_width = 0;
+        int m_height = 0;
+        int m_tilesX = 0;
+        int m_tilesY = 0;
+        PixelFormat m_format = PixelFormat::Float3;
+        std::vector<uint8_t> m_data;
+
+        size_t offset(int tx, int ty, int i, int j) const {
+            const size_t tile = size_t(ty) * m_tilesX + tx;
+            return ((tile * TILE_STRIDE + j) * TILE_STRIDE + i) * bytesPerPixel(m_format);
+        }
+
+        // One switch per lookup instead of one per texel
+        template <PixelFormat F>
+        Vector3 bilinearAs(float x, float y) const {
+            // The clamp only guards memory (NaN, rounding at the far edge)
+            const int x0 = std::clamp(static_cast<int>(std::floor(x)), -1, m_width - 1);
+            const int y0 = std::clamp(static_cast<int>(std::floor(y)), -1, m_height - 1);
+            const float tx = x - std::floor(x);
+            const float ty = y - std::floor(y);
+
+            constexpr size_t bpp = bytesPerPixel(F);
+            const uint8_t* p = m_data.data() + byteOffset(x0, y0);
+            const Vector3 c00 = pixel::decode(F, p);
+            const Vector3 c10 = pixel::decode(F, p + bpp);
+            const Vector3 c01 = pixel::decode(F, p + TILE_STRIDE * bpp);
+            const Vector3 c11 = pixel::decode(F, p + (TILE_STRIDE + 1) * bpp);
+
+            return glm::mix(
+                glm::mix(c00, c10, tx),
+                glm::mix(c01, c11, tx),
+                ty
+            );
+        }
+    };
+
+} // namespace rayt
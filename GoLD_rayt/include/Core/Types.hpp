@@ -11,6 +11,11 @@
 // Include GLM here so all files have access to vector math.
 #include <glm/glm.hpp>
 
+// Compile-time rendering mode: 0 = RGB transport, 1 = hero-wavelength spectral transport.
+#ifndef RAYT_SPECTRAL
+#define RAYT_SPECTRAL 0
+#endif
+
 namespace rayt {
 
     // Global precision toggle: allows easy switching between float and double.
@@ -35,9 +40,9 @@ namespace rayt {
     // Spectral Representation
     // ---------------------------------------------------------------------
 
-    // Currently, we use RGB (vec3) as a placeholder.
-    // TODO: Replace this with a 'SampledSpectrum' class later for full spectral rendering.
-    // e.g., class SampledSpectrum { std::array<Real, 60> values; ... };
+    // Material parameters, textures, lights and the film are RGB (vec3).
+    // Path throughput is RGB too unless RAYT_SPECTRAL is 1, in which case each
+    // path carries hero-sampled wavelengths (see Core/SampledSpectrum.hpp).
     using Spectrum = glm::vec<3, Real, glm::defaultp>;
 
 } //namespace rayt
\ No newline at end of file
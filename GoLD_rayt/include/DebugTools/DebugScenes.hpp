@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Renderer/Camera.hpp"
+#include "Renderer/Scene.hpp"
+
+namespace rayt::debug {
+    /// The main.cpp roughness scene shared by the debug tests: floor + gold at 0.01 / 0.2 / 0.5
+    /// (material ids 0..3). regionNames, if given, receives a name per material id, then "background".
+    Scene makeGoldRoughnessScene(std::vector<std::string>* regionNames = nullptr);
+
+    /// The main.cpp camera for that scene.
+    std::shared_ptr<Camera> makeGoldRoughnessCamera(int width, int height);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// Feature-guided denoiser (Renderer/Denoiser.hpp) on the gold roughness scene: relative MSE
+    /// of 4 / 16 spp renders before and after denoising against a PathIntegrator reference, and
+    /// denoising time per megapixel on a 1920x1080 film.
+    void TestDenoiser(const std::string& hdrPath = "assets/env/grace-new.hdr", int referenceSpp = 512);
+}
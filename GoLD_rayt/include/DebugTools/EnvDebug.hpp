@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// Compares CDF (Distribution2D) and alias-table env sampling: build time, memory,
+    /// per-sample cost and pdf agreement, on a synthetic 8k x 4k map and on an HDRI.
+    void TestEnvSampling(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// Flat Distribution2D against the former per-row Distribution1D layout on a 16k x 8k map:
+    /// construction time, memory, sample/pdf latency, and that both give identical samples.
+    void TestDistributionLayout(int width = 16384, int height = 8192);
+
+    /// Equirectangular against equal-area octahedral EnvMap: conversion time, eval/sample/pdf
+    /// throughput, pdf consistency, and NEE noise for light arriving around the poles.
+    void TestEnvLayout(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// EnvProductSampler on an HDRI: build cost, sample/pdf cost, pdf consistency and
+    /// normalization, and the variance of lobe-weighted radiance against env-only sampling.
+    void TestEnvProductSampling(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// Path tracing the gold roughness scene with and without EnvProductSampler for the same
+    /// wall-clock time: spp reached and relative MSE per region against a plain reference,
+    /// averaged over a few renders, in full and without the worst 0.1% of pixels (fireflies).
+    void TestEnvProductEqualTime(const std::string& hdrPath = "assets/env/grace-new.hdr", int referenceSpp = 2048, double seconds = 5.0);
+
+    /// Image storage formats (Float3 / Half3 / RGBE / RGB9E5) on an HDRI: memory, decode
+    /// error against Float3, and EnvMap eval/sample throughput with each.
+    void TestImageFormats(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// Row-major Image against TiledImage for equirect bilinear lookups (scanline, screen-tile
+    /// and random order): ns per lookup and cache misses per lookup, from hardware counters
+    /// where the platform exposes them and from a cache model of the addresses read.
+    void TestImageLayout(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// Image ingest: loadHDR (mapped, parallel RGBE decode) and loadLDR (sRGB table) against
+    /// stb_image followed by per-pixel conversion, for load time and bit-identical pixels in
+    /// every storage format; a flat-encoded .hdr checks the stb_image fallback.
+    void TestImageIngest(const std::string& hdrPath = "assets/env/grace-new.hdr");
+
+    /// io::AssetCache: EnvMap tables and octahedral resample and the Johnson IOR grid built, stored and
+    /// mapped back (time of each), identical samples from cached tables, and misses on stale entries.
+    void TestAssetCache(const std::string& hdrPath = "assets/env/grace-new.hdr", const std::string& csvPath = "Johnson.csv");
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// Film accumulation per filter: tiles vs direct addSample, constant-field reconstruction,
+    /// splat normalization, and samples/sec of FilmTile::addSample vs atomic Film::addSample.
+    void TestFilmAccumulation();
+
+    /// OpenEXR output of a 1920x1080 film with every AOV: write time and file size per
+    /// pixel type / compression / layout.
+    void TestEXRWriter(const std::string& outputPath = "film_aov_test.exr");
+
+    /// LDR output on a film of log-uniform radiance: time per megapixel of Film::toLDR for every
+    /// tone curve / transfer / dither setting against the old scalar loop, and its 8-bit codes
+    /// against the double-precision pipeline (toneMapReference).
+    void TestToneMapping(int width = 3840, int height = 2160);
+
+    /// PNG output of a synthetic RGB image (gradients, waves and a noisy half): encode time and size
+    /// of io::encodePNG at several levels against stb_image_write, lossless round trip through
+    /// stb_image, and how long Film::saveLDRAsync blocks the caller compared with saveLDR.
+    void TestPngWriter(int width = 3840, int height = 2160);
+
+    /// TiledFilm: the same samples into a Film and into a TiledFilm whose budget forces paging
+    /// (resolved pixels must match), then a width x height render streamed to a tiled EXR
+    /// with its peak resident memory against what a Film of that size would take.
+    void TestTiledFilm(int width = 16384, int height = 8192, const std::string& outputPath = "tiled_film_test.exr");
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace rayt::debug {
+    /// Sweeps ConductorFresnelTable against fresnelConductor for gold and other (n, k) pairs,
+    /// checks maxError() against the bounds in FresnelTable.hpp and times exact vs table lookups.
+    void TestFresnelTable();
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace rayt::debug {
+    /// Checks GGXBatch against GGXDistribution and prints scalar vs SIMD throughput.
+    void TestGGXBatch();
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace rayt::debug {
+    /// Traces the gold roughness scene, then shades every recorded bounce through shared_ptr<Material>
+    /// virtual calls and through MaterialTable / MaterialRef visit: checks that eval / pdf / sample agree
+    /// and prints the shading time per bounce of each.
+    void TestMaterialDispatch();
+}
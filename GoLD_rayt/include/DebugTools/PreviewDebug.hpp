@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// IBL preview (PreviewIntegrator) on the gold roughness scene: table build
+    /// and cache-load time, F82 / split-sum error against exact conductor Fresnel, frame time of the
+    /// interactive and refine passes, and relative MSE and mean bias per region against a PathIntegrator
+    /// reference for both passes (and the refine pass without specular occlusion).
+    void TestPreviewIntegrator(const std::string& hdrPath = "assets/env/grace-new.hdr", int referenceSpp = 1024);
+}
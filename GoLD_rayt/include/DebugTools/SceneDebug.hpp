@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// Scene files: text -> binary -> text round trip of `scenePath` (identical binaries), then a
+    /// generated scene of `instances` spheres written in both forms: time to first ray (load, buildScene
+    /// and one closest hit) from text against the mapped binary, and closest hits through the mapped
+    /// BVH against a linear walk of the same tables.
+    void TestSceneFile(const std::string& scenePath = "assets/scenes/gold_roughness.rscn", int instances = 1000000);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+namespace rayt::debug {
+    /// Checks the RGB <-> spectrum round trip, compares 3-wavelength vs spectral gold
+    /// reflectance from measured n, k, and prints the cost of the spectral path operations.
+    void TestSpectralSampling(const std::string& iorCsv = "Johnson.csv");
+
+    /// Compares SpectralIORTable with IORInterpolator: load time (CSV vs AssetCache hit), error, lookups/s.
+    void TestSpectralIORTable(const std::string& iorCsv = "Johnson.csv");
+
+    /// Fits and maps the RGB -> spectrum table, checks the round trip and times lookups and evaluation.
+    void TestRGBToSpectrumTable();
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace rayt::debug {
+    /// Compares bilinear / trilinear / EWA lookups against a supersampled reference and
+    /// checks the cached tile path and the tile cache budget.
+    void TestTextureFiltering();
+}
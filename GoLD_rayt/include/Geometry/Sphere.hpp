@@ -12,6 +12,8 @@
 #include "Core/Interaction.hpp"
 #include "Core/AABB.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <vector>
 
@@ -33,6 +35,15 @@ namespace rayt {
         Sphere(Point3 center, Real radius, std::shared_ptr<Material> mat)
             : m_center(center), m_radius(radius), m_material(mat) {}
 
+        /**
+         * @brief Constructs a sphere referring to a built-in material.
+         * @param center     Center point of the sphere in world space.
+         * @param radius     Radius of the sphere.
+         * @param materialId Entry in the scene's MaterialTable.
+         */
+        Sphere(Point3 center, Real radius, MaterialId materialId)
+            : m_center(center), m_radius(radius), m_materialId(materialId) {}
+
         /**
          * @brief Performs a ray-sphere intersection test.
          * * Solves the quadratic equation: |(o + td) - c|^2 = R^2.
@@ -43,8 +54,36 @@ namespace rayt {
          * @return True if the ray hits the sphere within the valid interval [tMin, tMax].
          */
         virtual bool hit(const Ray& r, SurfaceInteraction& rec) const override {
+            if (!intersect(m_center, m_radius, r, rec)) return false;
+
+            // Assign the material property
+            rec.matPtr = m_material.get();
+            rec.materialId = m_materialId;
+
+            // 後で消す
+            // Critical: Update the ray's maximum valid distance. 
+            // This ensures subsequent intersection tests in a list or BVH prune farther objects.
+            // r.tMax = rec.t;
+
+            return true;
+        }
+
+        /**
+         * @brief Returns the Axis-Aligned Bounding Box (AABB) of the sphere.
+         * @return AABB spanning from (center - radius) to (center + radius).
+         */
+        AABB bounds() const override {
+            Vector3 rad(m_radius);
+            return AABB(m_center - rad, m_center + rad);
+        }
+
+        /**
+         * @brief Ray-sphere test shared with aggregates that store spheres as plain records.
+         * * Fills everything in rec except the material.
+         */
+        static bool intersect(const Point3& center, Real radius, const Ray& r, SurfaceInteraction& rec) {
             // Vector from sphere center to ray origin
-            Vector3 oc = r.o - m_center;
+            Vector3 oc = r.o - center;
 
             // Quadratic coefficients (using half-b form)
             // a*t^2 + b*t + c = 0
@@ -52,7 +91,7 @@ namespace rayt {
             if (a == Real(0)) return false;  // Prevent division by zero
 
             Real half_b = glm::dot(oc, r.d);
-            Real c = glm::dot(oc, oc) - m_radius * m_radius;
+            Real c = glm::dot(oc, oc) - radius * radius;
             
             // Discriminant check (b^2 - 4ac, but scaled for half_b)
             Real discriminant = half_b * half_b - a * c;
@@ -74,37 +113,38 @@ namespace rayt {
 
             // Calculate the geometric outward normal. 
             // Normalizing by dividing by radius is efficient for unit/uniform spheres.
-            Vector3 outwardNormal = (rec.p - m_center) / m_radius;
+            Vector3 outwardNormal = (rec.p - center) / radius;
 
             // Orient the normal based on whether the ray hit from the outside or inside.
             rec.setFaceNormal(r.d, outwardNormal);
 
-            // Assign the material property
-            rec.matPtr = m_material.get();
-
-            // TODO: Implement spherical UV mapping for texture lookup (e.g., lat/long).
-
-            // 後で消す
-            // Critical: Update the ray's maximum valid distance. 
-            // This ensures subsequent intersection tests in a list or BVH prune farther objects.
-            // r.tMax = rec.t;
-
+            // Spherical (lat/long) parameterization around +y, and its partial derivatives
+            //   u = (atan2(-z, x) + pi) / 2pi,  v = acos(-y) / pi
+            setSphericalUV(outwardNormal, radius, rec);
             return true;
         }
 
+    private:
         /**
-         * @brief Returns the Axis-Aligned Bounding Box (AABB) of the sphere.
-         * @return AABB spanning from (center - radius) to (center + radius).
+         * @brief Fills uv, dpdu and dpdv from the unit outward direction d.
+         * * dp/du = 2pi r (d.z, 0, -d.x), dp/dv = pi r (-d.x d.y / sin, sin, -d.z d.y / sin)
+         * with sin = sin(theta) = sqrt(1 - d.y^2); the poles keep a tiny sin to stay finite.
          */
-        AABB bounds() const override {
-            Vector3 rad(m_radius);
-            return AABB(m_center - rad, m_center + rad);
+        static void setSphericalUV(const Vector3& d, Real radius, SurfaceInteraction& rec) {
+            const Real phi = std::atan2(-d.z, d.x) + constants::PI;
+            const Real theta = std::acos(std::clamp(-d.y, Real(-1.0), Real(1.0)));
+            rec.uv = UV(phi * (Real(0.5) / constants::PI), theta / constants::PI);
+
+            const Real sinTheta = std::max(std::sqrt(std::max(Real(0.0), Real(1.0) - d.y * d.y)), Real(1e-6));
+            rec.dpdu = Real(2.0) * constants::PI * radius * Vector3(d.z, 0.0, -d.x);
+            rec.dpdv = constants::PI * radius *
+                Vector3(-d.x * d.y / sinTheta, sinTheta, -d.z * d.y / sinTheta);
         }
 
-    private:
         Point3 m_center;
         Real m_radius;
         std::shared_ptr<Material> m_material;
+        MaterialId m_materialId = INVALID_MATERIAL_ID;
     };
 
 } // namespace rayt
\ No newline at end of file
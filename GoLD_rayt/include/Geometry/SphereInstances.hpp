@@ -0,0 +1,144 @@
+#pragma once
+
+/**
+ * @file SphereInstances.hpp
+ * @brief Spheres intersected straight from the geometry, instance and BVH tables of a SceneFile.
+ * * A compiled scene is mapped, not unpacked: instead of one Sphere object per
+ * instance, this aggregate walks the InstanceRecords and the SphereRecords they
+ * place, computing each world-space sphere on the fly. Larger scenes are
+ * traversed through the flat BVH stored in the same file, so nothing is
+ * allocated or built per instance on load. The closest-hit logic and the
+ * ray-sphere test are those of HittableList and Sphere, so a scene renders
+ * identically either way.
+ */
+
+#include "Geometry/Hittable.hpp"
+#include "Geometry/Sphere.hpp"
+#include "IO/SceneFile.hpp"
+
+#include <memory>
+
+namespace rayt {
+
+    class SphereInstances : public Hittable {
+    public:
+        /// Up to this many instances are tested linearly; larger sets are traversed through the scene's BVH.
+        static constexpr size_t LINEAR_LIMIT = 8;
+
+        /**
+         * @brief Linear walk over the instances [begin, end).
+         * @param geometry  Sphere table the instances index.
+         * @param instances Instance table.
+         * @param backing   Keeps the tables alive (e.g. SceneFile::keepAlive()).
+         */
+        SphereInstances(const io::SphereRecord* geometry, const io::InstanceRecord* instances,
+            size_t begin, size_t end, std::shared_ptr<const void> backing = nullptr)
+            : m_geometry(geometry), m_instances(instances), m_begin(begin), m_end(end), m_backing(std::move(backing)) {}
+
+        /**
+         * @brief Traversal of a flat BVH over the instance table (see io::BVHNodeRecord).
+         * @param nodes   BVH nodes, root first; must hold at least one node.
+         * @param indices Instance indices referenced by the leaves.
+         */
+        SphereInstances(const io::SphereRecord* geometry, const io::InstanceRecord* instances,
+            const io::BVHNodeRecord* nodes, const uint32_t* indices, std::shared_ptr<const void> backing = nullptr)
+            : m_geometry(geometry), m_instances(instances), m_begin(0), m_end(0),
+            m_nodes(nodes), m_indices(indices), m_backing(std::move(backing)) {}
+
+        /**
+         * @brief Aggregate over all instances of `file`: a linear walk when small, the file's BVH otherwise.
+         */
+        static std::shared_ptr<Hittable> build(const io::SceneFile& file) {
+            if (file.instanceCount() <= LINEAR_LIMIT || file.bvhNodeCount() == 0)
+                return std::make_shared<SphereInstances>(file.geometry(), file.instances(), 0, file.instanceCount(), file.keepAlive());
+            return std::make_shared<SphereInstances>(file.geometry(), file.instances(), file.bvhNodes(), file.bvhIndices(), file.keepAlive());
+        }
+
+        bool hit(const Ray& r, SurfaceInteraction& rec) const override {
+            if (m_nodes) return hitBVH(r, rec);
+
+            bool hitAnything = false;
+            Ray testRay = r;
+            for (size_t i = m_begin; i < m_end; ++i) {
+                if (hitInstance(i, testRay, rec)) {
+                    hitAnything = true;
+                    testRay.tMax = rec.t;
+                }
+            }
+            return hitAnything;
+        }
+
+        AABB bounds() const override {
+            if (m_nodes) return nodeBounds(m_nodes[0]);
+            if (m_begin == m_end) return AABB(Point3(0), Point3(0));
+            AABB b;
+            for (size_t i = m_begin; i < m_end; ++i) {
+                const io::InstanceRecord& inst = m_instances[i];
+                const Point3 c = io::instanceCenter(m_geometry[inst.geometry], inst);
+                const Vector3 rad(io::instanceRadius(m_geometry[inst.geometry], inst));
+                b = AABB::unite(b, AABB(c - rad, c + rad));
+            }
+            return b;
+        }
+
+    private:
+        static AABB nodeBounds(const io::BVHNodeRecord& n) {
+            return AABB(Vector3(n.min[0], n.min[1], n.min[2]), Vector3(n.max[0], n.max[1], n.max[2]));
+        }
+
+        /**
+         * @brief Closest hit through the BVH: children are visited front to back, and the
+         * ray's tMax shrinks to the closest hit so far to prune farther nodes.
+         */
+        bool hitBVH(const Ray& r, SurfaceInteraction& rec) const {
+            bool hitAnything = false;
+            Ray testRay = r;
+
+            uint32_t stack[io::MAX_BVH_DEPTH];
+            int top = 0;
+            uint32_t node = 0;
+            for (;;) {
+                const io::BVHNodeRecord& n = m_nodes[node];
+                if (nodeBounds(n).intersect(testRay, testRay.tMin, testRay.tMax)) {
+                    if (n.count == 0) {
+                        // The first child directly follows its parent; the second is at n.offset
+                        const bool dirNeg = r.d[n.axis] < Real(0);
+                        stack[top++] = dirNeg ? node + 1 : n.offset;
+                        node = dirNeg ? n.offset : node + 1;
+                        continue;
+                    }
+                    for (uint32_t k = 0; k < n.count; ++k) {
+                        if (hitInstance(m_indices[n.offset + k], testRay, rec)) {
+                            hitAnything = true;
+                            testRay.tMax = rec.t;
+                        }
+                    }
+                }
+                if (top == 0) break;
+                node = stack[--top];
+            }
+            return hitAnything;
+        }
+
+        /// Ray against instance i within [r.tMin, r.tMax]; rec is only written on a hit.
+        bool hitInstance(size_t i, const Ray& r, SurfaceInteraction& rec) const {
+            const io::InstanceRecord& inst = m_instances[i];
+            const io::SphereRecord& sphere = m_geometry[inst.geometry];
+            SurfaceInteraction tempRec;
+            if (!Sphere::intersect(io::instanceCenter(sphere, inst), io::instanceRadius(sphere, inst), r, tempRec))
+                return false;
+            tempRec.matPtr = nullptr;
+            tempRec.materialId = inst.material;
+            rec = tempRec;
+            return true;
+        }
+
+        const io::SphereRecord* m_geometry;
+        const io::InstanceRecord* m_instances;
+        size_t m_begin, m_end;
+        const io::BVHNodeRecord* m_nodes = nullptr;
+        const uint32_t* m_indices = nullptr;
+        std::shared_ptr<const void> m_backing;
+    };
+
+} // namespace rayt
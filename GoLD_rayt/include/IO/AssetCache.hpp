@@ -0,0 +1,139 @@
+#pragma once
+
+/**
+ * @file AssetCache.hpp
+ * @brief Persistent, content-addressed cache for data derived from assets (sampling tables, resampled maps, IOR grids).
+ * * What is built from an asset depends only on the asset's content and the
+ * build parameters, yet every run used to rebuild it. AssetCache stores each
+ * such structure in a file named after a 64-bit hash of both
+ * (`<directory>/<kind>-<key>.bin`): a fixed header, a section table, then the
+ * structure's arrays as plain data without pointers, each section 64-byte
+ * aligned. A later run with the same inputs maps the file and the structure
+ * reads its arrays where they lie: nothing is parsed or copied, and the OS
+ * pages in only what is touched.
+ * * The header records the cache layout version, the byte order, the kind, the
+ * kind's own format version and the full key; any mismatch, or a truncated
+ * file, is a miss, after which the caller rebuilds and stores again
+ * (replacing the stale entry). Entries are written with io::atomicWrite, so
+ * a crash never leaves a valid-looking partial one.
+ * * Entries of old asset versions are never hit again, so the directory is
+ * capped: after each store, the least recently used entries (a hit counts as
+ * a use) are deleted until the total is under maxBytes.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "IO/MappedFile.hpp"
+
+namespace rayt::io {
+
+    /**
+     * @brief Incremental 64-bit hash (XXH64 rounds) of everything a cached structure depends on.
+     * * Not cryptographic: it tells versions of an asset apart, it does not defend against forgery.
+     */
+    class CacheKey {
+    public:
+        CacheKey& add(const void* data, size_t bytes);
+
+        /// Adds a parameter by value (ints, floats, enums, ...).
+        template <class T>
+            requires std::is_trivially_copyable_v<T>
+        CacheKey& add(const T& value) { return add(&value, sizeof(T)); }
+
+        CacheKey& add(const std::string& s) {
+            add(uint64_t(s.size()));
+            return add(s.data(), s.size());
+        }
+
+        /**
+         * @brief Adds the content of a file (memory-mapped while it is hashed).
+         * @return false if the file cannot be read.
+         */
+        bool addFile(const std::string& path);
+
+        uint64_t value() const { return m_hash; }
+
+    private:
+        uint64_t m_hash = 0;
+    };
+
+    /// One array of a cache entry, as written.
+    struct CacheSection {
+        const void* data;
+        size_t bytes;
+    };
+
+    /**
+     * @brief A cache entry mapped into memory; its sections stay valid while the entry or keepAlive() lives.
+     */
+    class CacheEntry {
+    public:
+        size_t sectionCount() const { return m_sections.size(); }
+        size_t sectionBytes(size_t i) const { return m_sections[i].second; }
+
+        /// Start of section i (64-byte aligned).
+        const void* section(size_t i) const {
+            return static_cast<const char*>(m_file->data()) + m_sections[i].first;
+        }
+
+        /// Section i as an array of T, or nullptr if its size is not `count` elements.
+        template <class T>
+        const T* sectionAs(size_t i, size_t count) const {
+            return i < m_sections.size() && m_sections[i].second == count * sizeof(T)
+                ? static_cast<const T*>(section(i)) : nullptr;
+        }
+
+        /// Owner to hand to structures that keep pointing into the sections.
+        std::shared_ptr<const void> keepAlive() const { return m_file; }
+
+    private:
+        friend class AssetCache;
+        std::shared_ptr<MappedFile> m_file;
+        std::vector<std::pair<size_t, size_t>> m_sections; // offset, bytes
+    };
+
+    class AssetCache {
+    public:
+        static constexpr const char* DEFAULT_DIRECTORY = ".rayt_cache";
+        static constexpr uint64_t DEFAULT_MAX_BYTES = uint64_t(4) << 30;
+
+        /// Cache in `directory` (created on the first store), holding at most about maxBytes of entries.
+        explicit AssetCache(std::string directory = DEFAULT_DIRECTORY, uint64_t maxBytes = DEFAULT_MAX_BYTES)
+            : m_directory(std::move(directory)), m_maxBytes(maxBytes) {}
+
+        const std::string& directory() const { return m_directory; }
+        uint64_t maxBytes() const { return m_maxBytes; }
+
+        /// File holding the entry of `kind` (at most 15 characters) for `key`.
+        std::string path(const std::string& kind, uint64_t key) const;
+
+        /**
+         * @brief Maps the entry for (kind, key) if it exists and was written with formatVersion.
+         * @return false on any miss; the entry is then left empty.
+         */
+        bool load(const std::string& kind, uint32_t formatVersion, uint64_t key, CacheEntry& entry) const;
+
+        /**
+         * @brief Writes the entry for (kind, key), replacing any previous one.
+         * @return false if it could not be written (the cache is then simply not used).
+         */
+        bool store(const std::string& kind, uint32_t formatVersion, uint64_t key, const std::vector<CacheSection>& sections) const;
+
+        /**
+         * @brief Deletes least recently used entries until the directory holds at most maxBytes
+         * (never `keep`), and temporaries left by crashed writers. store() calls it.
+         */
+        void prune(const std::string& keep = "") const;
+
+    private:
+        std::string m_directory;
+        uint64_t m_maxBytes;
+    };
+
+} // namespace rayt::io
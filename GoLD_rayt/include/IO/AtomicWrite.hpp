@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * @file AtomicWrite.hpp
+ * @brief Writes a file under a temporary name and renames it into place.
+ * * Caches, tables and compiled scenes are read back by later runs, so a
+ * crash or a full disk must never leave a valid-looking partial file behind.
+ * atomicWrite() writes next to the target under a name no other writer uses
+ * (two renders storing the same entry at once do not share a temporary), then
+ * renames it over the target, which readers see either whole or not at all.
+ */
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace rayt::io {
+
+    /**
+     * @brief A tag unique to this call and process, for temporary file names.
+     */
+    std::string uniqueFileTag();
+
+    /**
+     * @brief Writes `path` with `write`, atomically replacing any existing file.
+     * @param write Writes the whole content; a failed stream fails the write.
+     * @return false if the file could not be written or renamed (the temporary is removed).
+     */
+    bool atomicWrite(const std::string& path, const std::function<void(std::ostream&)>& write);
+
+} // namespace rayt::io
@@ -2,36 +2,117 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <vector>
 #include <memory>
 
 #include "Core/Types.hpp"
 #include "Core/Constants.hpp"
 #include "Core/Image.hpp"
+#include "Core/TiledImage.hpp"
 #include "Core/Distribution2D.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/AliasTable.hpp"
+#include "Core/EqualAreaMapping.hpp"
+#include "IO/AssetCache.hpp"
 
 namespace rayt {
 
+    /**
+     * @brief How EnvMap::sample picks a texel.
+     */
+    enum class EnvSampling {
+        CDF,    ///< Distribution2D: inverse CDF, two binary searches per sample.
+        Alias   ///< AliasTable2D: O(1) alias method, same pdf.
+    };
+
+    /**
+     * @brief How EnvMap stores the radiance it looks up.
+     */
+    enum class EnvLayout {
+        Equirect,   ///< The loaded latitude-longitude image as is (acos/atan2 per lookup).
+        Octahedral  ///< Resampled once into an equal-area octahedral square (Core/EqualAreaMapping.hpp).
+    };
+
     /**
      * @class EnvMap
      * @brief A class representing an Image-Based Lighting (IBL) environment map.
      *
      * This class handles an equirectangular environment map (latitude-longitude format).
      * It provides functionality to sample radiance from a given direction using bilinear interpolation.
+     * * With EnvLayout::Octahedral the image is resampled at construction into an
+     * equal-area octahedral map with about as many texels. Lookups then need no
+     * trigonometry, and because every texel covers the same solid angle the
+     * sampling density needs no sin(theta) factor: poles are neither over- nor
+     * under-weighted, and texels near them no longer get huge pdf / tiny weight.
+     * * Texels stay in the image's PixelFormat (the resampled octahedral map too)
+     * and are decoded per fetch, so an RGBE map costs 4 bytes per texel. They are
+     * stored as a TiledImage whose aprons carry the layout's boundary rule, so a
+     * bilinear lookup reads one tile and does no wrap arithmetic.
+     * * Given an io::AssetCache, the octahedral resample and the sampling tables
+     * are keyed by the image content and the layout. On a repeat run the
+     * tables are mapped from the cache and used in place, and the resampled
+     * texels are copied from it.
      */
     class EnvMap {
     public:
         /**
          * @brief Constructs an environment map from an image.
          * @param image The source image (equirectangular projection).
+         * @param sampling Texel sampler for NEE (both draw from the same density).
+         * @param layout Storage used for lookups and sampling.
+         * @param cache Where derived data is looked up and stored (none: always built). It must
+         *        outlive the map when the tables are deferred.
+         * @param buildTables false: leave the sampling tables to buildSampling(), so lookups
+         *        (previews, prefiltering) can start without them.
+         * @throws std::bad_alloc if the texels, the octahedral resample or the sampling tables
+         *         cannot be allocated (hundreds of MiB for an 8k map).
          */
-        explicit EnvMap(Image image) noexcept
-            : m_img(std::move(image)) {
-            if (m_img.isValid()) {
-                buildDistribution();
+        explicit EnvMap(Image image, EnvSampling sampling = EnvSampling::Alias, EnvLayout layout = EnvLayout::Equirect,
+            const io::AssetCache* cache = nullptr, bool buildTables = true)
+            : m_sampling(sampling), m_layout(EnvLayout::Equirect), m_cache(cache) {
+            if (image.isValid()) {
+                // Everything derived below depends on the texels and the layout only
+                io::CacheKey key;
+                if (cache) key.add(image.width()).add(image.height()).add(image.format()).add(image.data(), image.memoryBytes());
+
+                m_texels = TiledImage(image, [w = image.width(), h = image.height()](int& x, int& y) { addressEquirect(w, h, x, y); });
+                if (layout == EnvLayout::Octahedral) {
+                    const Image octahedral = toOctahedral(cache, key.value());
+                    m_texels = TiledImage(octahedral, [n = octahedral.width()](int& x, int& y) { equalAreaWrapTexel(n, x, y); });
+                    m_layout = EnvLayout::Octahedral;
+                }
+                m_cacheKey = key.add(m_layout).value();
+                if (buildTables) buildSampling();
             }
         }
 
+        /**
+         * @brief Builds (or maps from the cache) the sampling tables if they do not exist yet.
+         * * Until then sample() and pdf() return 0, while eval() already works. Must
+         * not run while another thread samples the map.
+         * @throws std::bad_alloc if the tables cannot be allocated; the map is then left without them.
+         */
+        void buildSampling() {
+            if (!hasSampling()) buildDistribution(m_cache, m_cacheKey);
+        }
+
+        /// The sampling tables exist (sample() and pdf() are usable).
+        bool hasSampling() const { return m_dist || m_alias; }
+
+        EnvSampling sampling() const { return m_sampling; }
+        EnvLayout layout() const { return m_layout; }
+        /// The stored texels (the octahedral image when resampled).
+        const TiledImage& texels() const { return m_texels; }
+
+        /// Bytes held by the sampling tables (not counting the image).
+        size_t distributionBytes() const {
+            if (m_alias) return m_alias->memoryBytes();
+            return m_dist ? m_dist->memoryBytes() : 0;
+        }
+
         /**
          * @brief Evaluates the environment radiance from a specific direction.
          *
@@ -43,13 +124,17 @@ namespace rayt {
          * Returns black if the image is invalid.
          */
         Vector3 eval(const Vector3& dir) const {
-            if (!m_img.isValid()) {
+            if (!m_texels.isValid()) {
                 return Vector3(0.0);
             }
 
             Real u, v;
 
             // Ensure direction is normalized before calculating UV
+            if (m_layout == EnvLayout::Octahedral) {
+                equalAreaSphereToSquare(glm::normalize(dir), u, v);
+                return sampleOctahedral(static_cast<float>(u), static_cast<float>(v));
+            }
             dirToUV(glm::normalize(dir), u, v);
             return sampleBilinear(static_cast<float>(u), static_cast<float>(v));
         }
@@ -63,16 +148,25 @@ namespace rayt {
          */
         Vector3 sample(const Point2& u, Vector3& wi, Real& pdfW) const {
             pdfW = Real(0);
-            if (!m_img.isValid() || !m_dist) return Vector3(0.0);
+            if (!m_texels.isValid() || !(m_dist || m_alias)) return Vector3(0.0);
 
             // 1) Sample UV from 2D distribution (pdf in uv-domain)
             Point2 uvImg;
             float pdfUV_f = 0.0f;
-            m_dist->sampleContinuous(u, uvImg, pdfUV_f); // uv in [0,1), pdfUV is density on [0,1]^2
+            // uv in [0,1), pdfUV is density on [0,1]^2
+            if (m_alias) m_alias->sampleContinuous(u, uvImg, pdfUV_f);
+            else m_dist->sampleContinuous(u, uvImg, pdfUV_f);
             Real pdfUV = Real(pdfUV_f);
 
             if (pdfUV <= Real(0)) return Vector3(0.0);
 
+            // Equal-area layout: constant Jacobian 4 pi
+            if (m_layout == EnvLayout::Octahedral) {
+                wi = equalAreaSquareToSphere(uvImg.x, uvImg.y);
+                pdfW = pdfUV * constants::INV_FOUR_PI;
+                return sampleOctahedral(uvImg.x, uvImg.y);
+            }
+
             Real uSph = uvImg.x;
             Real vSph = Real(1) - uvImg.y;
 
@@ -98,13 +192,20 @@ namespace rayt {
          * @brief Pdf of sampling direction wi by EnvMap::sample (w.r.t solid angle).
          */
         Real pdf(const Vector3& wi) const {
-            if (!m_img.isValid() || !m_dist) return Real(0);
+            if (!m_texels.isValid() || !(m_dist || m_alias)) return Real(0);
 
             //------------------------------------------------------------------------
             // EnvMap が期待するv球面とDistribution2D が扱う v（画像)が上下反転
             // していたので直した今後改善が必要
             //------------------------------------------------------------------------
 
+            if (m_layout == EnvLayout::Octahedral) {
+                Real u, v;
+                equalAreaSphereToSquare(glm::normalize(wi), u, v);
+                const Point2 uv((float)u, (float)v);
+                return Real(m_alias ? m_alias->pdf(uv) : m_dist->pdf(uv)) * constants::INV_FOUR_PI;
+            }
+
             // Direction -> UV
             Real uSph, vSph;
             dirToUV(glm::normalize(wi), uSph, vSph);
@@ -112,7 +213,8 @@ namespace rayt {
             Real vImg = Real(1) - vSph;
 
             // pdf in uv-domain
-            float pdfUV_f = m_dist->pdf(Point2((float)uSph, (float)vImg));
+            const Point2 uvImg((float)uSph, (float)vImg);
+            float pdfUV_f = m_alias ? m_alias->pdf(uvImg) : m_dist->pdf(uvImg);
             Real pdfUV = Real(pdfUV_f);
             if (pdfUV <= Real(0)) return Real(0);
 
@@ -124,10 +226,26 @@ namespace rayt {
         }
 
     private:
-        Image m_img;
-
-        // 2D importance distribution (built from luminance * sinθ)
+        // Bump when the resampling or the sampling weights change, so older cache entries miss
+        static constexpr uint32_t OCTAHEDRAL_CACHE_VERSION = 1;
+        static constexpr uint32_t DISTRIBUTION_CACHE_VERSION = 1;
+
+        /// First section of a cached distribution; the tables follow.
+        struct DistributionCacheInfo {
+            int32_t width, height;
+            float integral;     // Distribution2D
+            uint32_t uniform;   // AliasTable2D
+        };
+
+        TiledImage m_texels;
+        EnvSampling m_sampling;
+        EnvLayout m_layout;
+        const io::AssetCache* m_cache = nullptr;
+        uint64_t m_cacheKey = 0; // texels and layout, for the tables
+
+        // 2D importance distribution (built from luminance * sinθ); one of the two, per m_sampling
         std::unique_ptr<Distribution2D> m_dist;
+        std::unique_ptr<AliasTable2D> m_alias;
 
         static Real luminance(const Vector3& rgb) {
             // Rec.709 / sRGB luminance weights (common choice)
@@ -177,22 +295,13 @@ namespace rayt {
         }
 
         /**
-         * @brief Fetches a pixel color with boundary handling.
+         * @brief Boundary rule of the equirectangular map (applied once, to the tile aprons).
          *
          * Wraps horizontally (longitude) and clamps vertically (latitude).
-         *
-         * @param x The x-coordinate (column).
-         * @param y The y-coordinate (row).
-         * @return The pixel color.
          */
-        Vector3 texel(int x, int y) const {
-            const int w = m_img.width();
-            const int h = m_img.height();
-
+        static void addressEquirect(int w, int h, int& x, int& y) {
             x = (x % w + w) % w;              // wrap horizontally
             y = std::clamp(y, 0, h - 1);      // clamp vertically
-
-            return m_img.at(x, y);
         }
 
         /**
@@ -209,61 +318,134 @@ namespace rayt {
             // Map UV to pixel coordinates (center aligned)
             // Note: (1.0 - v) flips V because image origin (0,0) is top-left,
             // but spherical V=1 usually corresponds to the top (North Pole).
-            const float x = u * m_img.width() - 0.5f;
-            const float y = (1.0f - v) * m_img.height() - 0.5f;
-
-            const int x0 = static_cast<int>(std::floor(x));
-            const int y0 = static_cast<int>(std::floor(y));
-            const int x1 = x0 + 1;
-            const int y1 = y0 + 1;
-
-            const float tx = x - std::floor(x);
-            const float ty = y - std::floor(y);
-
-            const Vector3 c00 = texel(x0, y0);
-            const Vector3 c10 = texel(x1, y0);
-            const Vector3 c01 = texel(x0, y1);
-            const Vector3 c11 = texel(x1, y1);
-
-            // Bilinear interpolation
-            return glm::mix(
-                glm::mix(c00, c10, tx),
-                glm::mix(c01, c11, tx),
-                ty
-            );
+            // The footprint lies in one tile, whose apron already wraps/clamps.
+            return m_texels.bilinear(u * m_texels.width() - 0.5f, (1.0f - v) * m_texels.height() - 0.5f);
+        }
+
+        /**
+         * @brief Bilinear lookup in the octahedral map; u, v in [0, 1] as produced by equalAreaSphereToSquare.
+         */
+        Vector3 sampleOctahedral(float u, float v) const {
+            const int n = m_texels.width();
+            return m_texels.bilinear(u * n - 0.5f, v * n - 0.5f);
         }
 
-        void buildDistribution() {
-            const int w = m_img.width();
-            const int h = m_img.height();
+        /**
+         * @brief Resamples the (equirectangular) m_texels into an n x n equal-area octahedral image.
+         * * n^2 is about the source texel count. Each texel averages a 2x2 grid of
+         * bilinear lookups, so the oversampled polar rows are filtered rather than skipped.
+         */
+        Image toOctahedral(const io::AssetCache* cache, uint64_t key) const {
+            const int n = std::max(2, int(std::lround(std::sqrt(double(m_texels.width()) * m_texels.height()))));
+            const char* kind = "env-octahedral";
+            if (io::CacheEntry entry; cache && cache->load(kind, OCTAHEDRAL_CACHE_VERSION, key, entry)) {
+                Image cached(n, n, m_texels.format());
+                if (entry.sectionCount() == 1 && entry.sectionBytes(0) == cached.memoryBytes()) {
+                    std::memcpy(cached.data(), entry.section(0), cached.memoryBytes());
+                    return cached;
+                }
+            }
+
+            std::vector<Vector3> pixels(size_t(n) * n);
+
+            parallelFor(n, 16, [&](int begin, int end) {
+                for (int y = begin; y < end; ++y)
+                    for (int x = 0; x < n; ++x) {
+                        Vector3 sum(0.0);
+                        for (int sy = 0; sy < 2; ++sy)
+                            for (int sx = 0; sx < 2; ++sx) {
+                                Real u, v;
+                                const Vector3 dir = equalAreaSquareToSphere((x + (sx + Real(0.5)) / 2) / n, (y + (sy + Real(0.5)) / 2) / n);
+                                dirToUV(dir, u, v);
+                                sum += sampleBilinear(static_cast<float>(u), static_cast<float>(v));
+                            }
+                        pixels[size_t(y) * n + x] = sum * Real(0.25);
+                    }
+                });
+            Image octahedral(n, n, pixels, m_texels.format());
+            if (cache) cache->store(kind, OCTAHEDRAL_CACHE_VERSION, key, { { octahedral.data(), octahedral.memoryBytes() } });
+            return octahedral;
+        }
+
+        /**
+         * @brief Views the sampling tables of a cache entry in place; false if there is none for key.
+         */
+        bool loadDistribution(const io::AssetCache& cache, uint64_t key) {
+            const int w = m_texels.width(), h = m_texels.height();
+            io::CacheEntry entry;
+            if (!cache.load(m_sampling == EnvSampling::Alias ? "env-alias" : "env-cdf", DISTRIBUTION_CACHE_VERSION, key, entry))
+                return false;
+            const DistributionCacheInfo* info = entry.sectionAs<DistributionCacheInfo>(0, 1);
+            if (!info || info->width != w || info->height != h) return false;
+
+            if (m_sampling == EnvSampling::Alias) {
+                const AliasBin* bins = entry.sectionAs<AliasBin>(1, size_t(w) * h);
+                const AliasBin* rows = entry.sectionAs<AliasBin>(2, size_t(h));
+                if (!bins || !rows) return false;
+                m_alias = std::make_unique<AliasTable2D>(bins, rows, w, h, info->uniform != 0, entry.keepAlive());
+                return true;
+            }
+            if (entry.sectionCount() != 2) return false;
+            auto dist = std::make_unique<Distribution2D>(static_cast<const float*>(entry.section(1)), w, h, info->integral, entry.keepAlive());
+            if (entry.sectionBytes(1) != dist->memoryBytes()) return false;
+            m_dist = std::move(dist);
+            return true;
+        }
+
+        void storeDistribution(const io::AssetCache& cache, uint64_t key) const {
+            DistributionCacheInfo info{ m_texels.width(), m_texels.height(), 0.0f, 0 };
+            if (m_alias) {
+                info.uniform = m_alias->uniform() ? 1 : 0;
+                cache.store("env-alias", DISTRIBUTION_CACHE_VERSION, key, { { &info, sizeof(info) },
+                    { m_alias->bins(), size_t(info.width) * info.height * sizeof(AliasBin) },
+                    { m_alias->rows(), size_t(info.height) * sizeof(AliasBin) } });
+            }
+            else if (m_dist) {
+                info.integral = m_dist->integral();
+                cache.store("env-cdf", DISTRIBUTION_CACHE_VERSION, key, { { &info, sizeof(info) },
+                    { m_dist->tables(), m_dist->memoryBytes() } });
+            }
+        }
+
+        void buildDistribution(const io::AssetCache* cache, uint64_t key) {
+            const int w = m_texels.width();
+            const int h = m_texels.height();
             if (w <= 0 || h <= 0) return;
+            if (cache && loadDistribution(*cache, key)) return;
 
-            // Build weights = luminance * sin(theta)
+            // Build weights = luminance * sin(theta) (equirect; octahedral texels need no sin(theta))
             std::vector<float> weights;
             weights.resize(size_t(w) * size_t(h));
 
-            for (int y = 0; y < h; ++y) {
-                // v coordinate at pixel center (match sampleBilinear convention)
-                // Using pixel centers helps stability.
-                Real v = (Real(y) + Real(0.5)) / Real(h);
-                // Note: sampleBilinear uses (1 - v) for y mapping; our v here is the "spherical v"
-                // consistent with dirToUV: v=1 at north pole.
-                // Image row y=0 is top, so spherical v at row y is:
-                Real vSph = Real(1) - v;
-
-                Real sinTheta = sinThetaFromV(vSph);
-                float sinT = static_cast<float>(sinTheta);
-
-                for (int x = 0; x < w; ++x) {
-                    Vector3 rgb = m_img.at(x, y);
-                    Real lum = luminance(rgb);
-                    // Clamp negative luminance (just in case)
-                    float wt = static_cast<float>(std::max(lum, Real(0))) * sinT;
-                    weights[size_t(y) * size_t(w) + size_t(x)] = wt;
+            // Rows are independent; the tables below build their rows in parallel as well
+            parallelFor(h, 16, [&](int begin, int end) {
+                for (int y = begin; y < end; ++y) {
+                    // v coordinate at pixel center (match sampleBilinear convention)
+                    // Using pixel centers helps stability.
+                    Real v = (Real(y) + Real(0.5)) / Real(h);
+                    // Note: sampleBilinear uses (1 - v) for y mapping; our v here is the "spherical v"
+                    // consistent with dirToUV: v=1 at north pole.
+                    // Image row y=0 is top, so spherical v at row y is:
+                    Real vSph = Real(1) - v;
+
+                    Real sinTheta = m_layout == EnvLayout::Octahedral ? Real(1) : sinThetaFromV(vSph);
+                    float sinT = static_cast<float>(sinTheta);
+
+                    for (int x = 0; x < w; ++x) {
+                        Vector3 rgb = m_texels.at(x, y);
+                        Real lum = luminance(rgb);
+                        // Clamp negative luminance (just in case)
+                        float wt = static_cast<float>(std::max(lum, Real(0))) * sinT;
+                        weights[size_t(y) * size_t(w) + size_t(x)] = wt;
+                    }
                 }
-            }
+                });
 
-            m_dist = std::make_unique<Distribution2D>(weights.data(), w, h);
+            if (m_sampling == EnvSampling::Alias)
+                m_alias = std::make_unique<AliasTable2D>(weights.data(), w, h);
+            else
+                m_dist = std::make_unique<Distribution2D>(weights.data(), w, h);
+            if (cache) storeDistribution(*cache, key);
         }
 
     };
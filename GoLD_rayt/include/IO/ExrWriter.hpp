@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file ExrWriter.hpp
+ * @brief Minimal OpenEXR 2 writer: single- or multi-part, scanline or tiled,
+ * uncompressed or RLE, half / float / uint channels.
+ * * No external dependency. Channels point at the caller's planar buffers
+ * (one value per pixel, rows `yStride` bytes apart): when the stored type
+ * matches the buffer type and compression is off, each row goes from the
+ * buffer to the file as is. Otherwise one row at a time is converted or
+ * compressed. A channel without a buffer supplies its rows through a
+ * callback instead, for data that has to be resolved first (Film beauty).
+ * * Files follow the OpenEXR 2.0 layout (magic, version flags, headers,
+ * per-part offset tables, chunks) and are little-endian, as is every host
+ * this project builds on. Tiled parts have a single resolution level.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rayt::io {
+
+    enum class ExrPixelType : int32_t { UInt = 0, Half = 1, Float = 2 };
+
+    enum class ExrCompression : uint8_t {
+        None = 0, ///< Rows are written straight from the channel buffers when the types match.
+        RLE = 1   ///< Byte-level run-length coding; cheap, good on flat AOVs (ids, depth, normals of large surfaces).
+    };
+
+    struct ExrChannel {
+        std::string name;        ///< Full channel name, e.g. "R" or "albedo.R".
+        ExrPixelType type;       ///< Type stored in the file.
+
+        ExrPixelType sourceType = ExrPixelType::Float; ///< Type of `data` (or Float for `rows`).
+        const void* data = nullptr;                    ///< Pixel (0, 0) of a planar buffer, or null to use `rows`.
+        size_t xStride = 0;                            ///< Bytes between pixels (0: tightly packed).
+        size_t yStride = 0;                            ///< Bytes between rows (0: width * xStride).
+
+        /// Fills `out` with row y (width floats) when there is no buffer.
+        std::function<void(int y, float* out)> rows;
+    };
+
+    struct ExrPart {
+        std::string name;                          ///< Part name (required, and unique, in multi-part files).
+        std::vector<ExrChannel> channels;          ///< Any order; written sorted by name as the format requires.
+        ExrCompression compression = ExrCompression::None;
+        int tileSize = 0;                          ///< 0: scanline image; otherwise square tiles of this size.
+    };
+
+    /**
+     * @brief Writes width x height parts to an OpenEXR file.
+     * * One part gives a plain single-part file that every reader accepts; more
+     * give a multi-part file (OpenEXR 2.0).
+     * @throws std::runtime_error If the file cannot be written or a part is malformed.
+     */
+    void writeEXR(const std::string& filename, int width, int height, const std::vector<ExrPart>& parts);
+
+    /**
+     * @brief A single-part tiled OpenEXR file written one tile at a time, in any order.
+     * * The header and a zeroed offset table are written on construction, each
+     * writeTile appends one chunk (line order RANDOM_Y), and finish() fills the
+     * table in. Nothing but the tile being written is held in memory, so this
+     * is how images larger than RAM reach the disk. writeTile may be called
+     * from several threads: conversion and compression run unlocked, only the
+     * append is serialized.
+     */
+    class ExrTileWriter {
+    public:
+        /**
+         * @param layout Channel names and types, compression and tileSize (> 0);
+         *        the channels' data / rows are not used.
+         * @throws std::runtime_error If the file cannot be created or the layout is malformed.
+         */
+        ExrTileWriter(const std::string& filename, int width, int height, const ExrPart& layout);
+        ~ExrTileWriter();
+
+        ExrTileWriter(const ExrTileWriter&) = delete;
+        ExrTileWriter& operator=(const ExrTileWriter&) = delete;
+
+        int tilesX() const;
+        int tilesY() const;
+
+        /**
+         * @brief Writes tile (tx, ty) from float planes, one per layout channel in layout order.
+         * * Each plane holds the tile's pixels row-major, clipped to the image
+         * ((x1 - x0) x (y1 - y0) for the tile's pixel rectangle).
+         * @throws std::runtime_error If the tile is out of range or was already written.
+         */
+        void writeTile(int tx, int ty, const float* const* planes);
+
+        /**
+         * @brief Patches the offset table and closes the file (once; later calls do nothing).
+         * @throws std::runtime_error If a tile was never written or the file could not be written.
+         */
+        void finish();
+
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+    };
+
+} // namespace rayt::io
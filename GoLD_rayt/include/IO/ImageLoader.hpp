@@ -7,6 +7,18 @@
 
 namespace rayt::io {
 
+    /**
+     * @brief How 8-bit (LDR) pixel values are to be interpreted.
+     *
+     * Color textures are authored in sRGB and must be linearized; data maps
+     * (roughness, normals) store linear values and must be read as-is.
+     * HDR files are always linear and ignore this setting.
+     */
+    enum class ColorEncoding {
+        sRGB,   ///< Apply the sRGB -> linear transfer function (default).
+        Linear  ///< Only normalize to [0, 1].
+    };
+
     /**
      * @brief Loads an image file, automatically determining the format/loader by extension.
      *
@@ -14,31 +26,36 @@ namespace rayt::io {
      * Throws an exception if the format is unsupported or the file cannot be read.
      *
      * @param filename The path to the image file.
+     * @param encoding How LDR values are interpreted (ignored for HDR).
      * @return The loaded Image object.
      * @throws std::runtime_error If loading fails.
      */
-    Image loadImage(const std::string& filename);
+    Image loadImage(const std::string& filename, ColorEncoding encoding = ColorEncoding::sRGB);
 
     /**
      * @brief Explicitly loads a High Dynamic Range (HDR) image.
      *
      * Reads the file as floating-point data. Assumes the data is already in linear space.
+     * The pixels are encoded straight into the requested storage format; RGBE
+     * reproduces a Radiance .hdr file exactly at a third of the Float3 footprint.
      *
      * @param filename The path to the HDR file (typically .hdr).
-     * @return The loaded Image object containing linear float data.
+     * @param format The storage format of the returned image.
+     * @return The loaded Image object containing linear data.
      */
-    Image loadHDR(const std::string& filename);
+    Image loadHDR(const std::string& filename, PixelFormat format = PixelFormat::Float3);
 
     /**
      * @brief Explicitly loads a Low Dynamic Range (LDR) image (PNG, JPG, etc.).
      *
      * Reads the file as 8-bit data and normalizes it.
-     * IMPORTANT: This function automatically converts colors from sRGB to Linear space
-     * for physically based rendering.
+     * IMPORTANT: By default this function converts colors from sRGB to Linear space
+     * for physically based rendering. Pass ColorEncoding::Linear for data maps.
      *
      * @param filename The path to the LDR file.
+     * @param encoding Whether to apply the sRGB -> linear conversion.
      * @return The loaded Image object containing linear float data.
      */
-    Image loadLDR(const std::string& filename);
+    Image loadLDR(const std::string& filename, ColorEncoding encoding = ColorEncoding::sRGB);
 
 } //namespace rayt::io
\ No newline at end of file
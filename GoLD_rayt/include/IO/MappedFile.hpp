@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file MappedFile.hpp
+ * @brief Read-only memory mapping of a whole file.
+ * * Large precomputed tables are mapped instead of read: the OS pages them in
+ * on first touch and shares them between processes, so startup does not pay
+ * for a copy of data that is mostly never looked at.
+ */
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace rayt::io {
+
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * @brief Maps `path` read-only, replacing any current mapping.
+         * @return false if the file cannot be opened or is empty.
+         */
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        const void* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const void* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        void* m_file = nullptr;     // HANDLE
+        void* m_mapping = nullptr;  // HANDLE
+#endif
+    };
+
+} // namespace rayt::io
@@ -0,0 +1,223 @@
+#pragma once
+
+/**
+ * @file SceneFile.hpp
+ * @brief Scene descriptions: a text form for authoring and a compiled binary form that is mapped and used in place.
+ * * A scene (image settings, camera, environment, materials, geometry and
+ * instances) used to be C++ in main.cpp, so every variant meant a rebuild.
+ * It is now data. The text form (`.rscn`) is one directive per line:
+ *
+ *     image 800 450
+ *     samples 100
+ *     maxdepth 50
+ *     environment assets/env/grace-new.hdr
+ *     camera from 0 0.5 2.5 to 0 0 -1 up 0 1 0 fov 35 aperture 0   # focus <d>, default |from - to|
+ *     material floor lambertian albedo 0.5 0.5 0.5
+ *     material gold conductor eta 0.16 0.42 1.45 k 3.48 2.45 1.77 roughness 0.2 fresnel tabulated measured Johnson.csv
+ *     geometry ball sphere center 0 0 0 radius 1
+ *     instance ball gold translate 0 0 -1 scale 0.5
+ *
+ * Material types: lambertian (albedo), conductor (eta, k, roughness,
+ * anisotropy, fresnel exact|tabulated, measured <n,k CSV> used in spectral
+ * builds), dielectric (ior, roughness, anisotropy), light (emission) and
+ * mirror (eta, k). An instance places a geometry with a uniform scale and a
+ * translation and gives it a material; names must be defined before use.
+ * * The binary form (`.rsb`, written by tools/scenec.cpp) holds the same
+ * content as fixed-layout tables: a header, then the settings, material,
+ * geometry, instance, string, BVH node and BVH index sections, each 64-byte
+ * aligned. SceneFile maps it and hands out pointers into the mapping: nothing
+ * is parsed or built, and the instances are intersected where they lie,
+ * through the flat BVH stored next to them (SphereInstances, built by
+ * Renderer/SceneBuilder.hpp). Only the material table is turned into objects,
+ * since materials carry derived tables (Fresnel, measured IOR).
+ * * SceneFile::load() also accepts the text form, compiling it in memory to the
+ * same layout, so one renderer binary renders any scene in either form. The
+ * BVH is built as part of compiling, so a text scene pays for it on every
+ * load and a binary one only once, in scenec.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Core/Types.hpp"
+
+namespace rayt::io {
+
+    /// Offset into the string section, or NO_STRING.
+    using StringRef = uint32_t;
+    inline constexpr StringRef NO_STRING = ~StringRef(0);
+
+    /// Image, sampling, camera and environment settings (one per scene).
+    struct SceneSettings {
+        int32_t width = 800;
+        int32_t height = 450;
+        int32_t samplesPerPixel = 100;
+        int32_t maxDepth = 50;
+        double from[3] = { 0, 0, 0 };
+        double to[3] = { 0, 0, -1 };
+        double up[3] = { 0, 1, 0 };
+        double vfov = 35;
+        double aperture = 0;
+        double focusDistance = 0;       ///< <= 0: distance from `from` to `to`
+        StringRef environment = NO_STRING; ///< Path of the HDRI, or none (black background).
+        uint32_t reserved = 0;
+    };
+
+    enum class MaterialKind : uint32_t {
+        Lambertian,
+        Conductor,      ///< RoughConductor
+        Dielectric,
+        Light,          ///< DiffuseLight
+        Mirror,         ///< MirrorConductor
+    };
+
+    struct MaterialRecord {
+        MaterialKind kind = MaterialKind::Lambertian;
+        StringRef name = NO_STRING;
+        StringRef measured = NO_STRING; ///< Conductor: n,k CSV used by spectral builds.
+        uint32_t fresnel = 0;           ///< Conductor: fresnel::ConductorFresnelMode.
+        double color[3] = { 0, 0, 0 };  ///< Albedo, emission or eta.
+        double k[3] = { 0, 0, 0 };      ///< Conductor / mirror extinction.
+        double roughness = 0;
+        double anisotropy = 0;
+        double ior = 1.5;               ///< Dielectric.
+    };
+
+    /// A sphere in its own space; instances place it in the world.
+    struct SphereRecord {
+        double center[3] = { 0, 0, 0 };
+        double radius = 1;
+        StringRef name = NO_STRING;
+        uint32_t reserved = 0;
+    };
+
+    /// world = geometry * scale + translation, shaded with `material`.
+    struct InstanceRecord {
+        uint32_t geometry = 0;
+        uint32_t material = 0;
+        double translation[3] = { 0, 0, 0 };
+        double scale = 1;
+    };
+
+    /**
+     * @brief One node of the flat instance BVH; nodes are stored depth first from the root.
+     * * An interior node's first child is the next node and its second child is
+     * node `offset`. A leaf tests the instances bvhIndices[offset, offset + count).
+     */
+    struct BVHNodeRecord {
+        double min[3] = { 0, 0, 0 };
+        double max[3] = { 0, 0, 0 };
+        uint32_t offset = 0;
+        uint16_t count = 0;     ///< Instances in a leaf; 0 for interior nodes.
+        uint16_t axis = 0;      ///< Split axis of an interior node, for front-to-back traversal.
+    };
+
+    /// Deepest BVH a scene may hold (traversal keeps a fixed stack of this size).
+    inline constexpr int MAX_BVH_DEPTH = 64;
+
+    /// World-space center of an instance (the same arithmetic for building and intersecting).
+    inline Point3 instanceCenter(const SphereRecord& geometry, const InstanceRecord& inst) {
+        return Point3(geometry.center[0], geometry.center[1], geometry.center[2]) * Real(inst.scale)
+            + Vector3(inst.translation[0], inst.translation[1], inst.translation[2]);
+    }
+
+    /// World-space radius of an instance.
+    inline Real instanceRadius(const SphereRecord& geometry, const InstanceRecord& inst) {
+        return Real(geometry.radius * inst.scale);
+    }
+
+    /**
+     * @brief Scene content in editable form (vectors), as parsed from text or built in code.
+     */
+    struct SceneDescription {
+        SceneSettings settings;
+        std::vector<MaterialRecord> materials;
+        std::vector<SphereRecord> geometry;
+        std::vector<InstanceRecord> instances;
+        std::string strings; ///< NUL-terminated strings referenced by StringRef.
+
+        StringRef addString(std::string_view s);
+
+        /// The binary form, byte for byte as SceneFile reads it, including a BVH over the instances.
+        std::vector<char> compile() const;
+    };
+
+    /**
+     * @brief Parses the text form.
+     * @param sourceName Used in error messages.
+     * @throws std::runtime_error with the line number on a syntax or reference error.
+     */
+    SceneDescription parseSceneText(std::istream& in, const std::string& sourceName = "<scene>");
+
+    /**
+     * @brief Read-only view of a compiled scene, mapped from disk or compiled from text in memory.
+     */
+    class SceneFile {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 2;
+
+        /**
+         * @brief Maps a binary scene, or parses and compiles a text one (anything without the binary magic).
+         * @throws std::runtime_error if the file cannot be read or is malformed.
+         */
+        static SceneFile load(const std::string& path);
+
+        /// Wraps a compiled scene held in memory.
+        static SceneFile fromDescription(const SceneDescription& description);
+
+        /// True if the tables are read from a file mapping (not compiled from text).
+        bool isMapped() const { return m_mapped; }
+
+        const SceneSettings& settings() const { return *m_settings; }
+        const MaterialRecord* materials() const { return m_materials; }
+        size_t materialCount() const { return m_materialCount; }
+        const SphereRecord* geometry() const { return m_geometry; }
+        size_t geometryCount() const { return m_geometryCount; }
+        const InstanceRecord* instances() const { return m_instances; }
+        size_t instanceCount() const { return m_instanceCount; }
+
+        /// Flat BVH over the instances (empty when there are none); node 0 is the root.
+        const BVHNodeRecord* bvhNodes() const { return m_bvhNodes; }
+        size_t bvhNodeCount() const { return m_bvhNodeCount; }
+        /// Instance indices referenced by the BVH leaves (one per instance).
+        const uint32_t* bvhIndices() const { return m_bvhIndices; }
+
+        /// The string at `ref` ("" for NO_STRING).
+        std::string_view string(StringRef ref) const;
+
+        /// Owner of the tables, for objects that keep pointing into them.
+        std::shared_ptr<const void> keepAlive() const { return m_backing; }
+
+        /// Writes the scene back in text form (round-trips through parseSceneText).
+        void writeText(std::ostream& out) const;
+
+        /**
+         * @brief Writes the binary form (the compiled image as it is in memory).
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        void writeBinary(const std::string& path) const;
+
+    private:
+        SceneFile() = default;
+        static SceneFile view(const char* data, size_t size, std::shared_ptr<const void> backing, const std::string& sourceName);
+
+        std::shared_ptr<const void> m_backing;
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        const SceneSettings* m_settings = nullptr;
+        const MaterialRecord* m_materials = nullptr;
+        const SphereRecord* m_geometry = nullptr;
+        const InstanceRecord* m_instances = nullptr;
+        const char* m_strings = nullptr;
+        const BVHNodeRecord* m_bvhNodes = nullptr;
+        const uint32_t* m_bvhIndices = nullptr;
+        size_t m_materialCount = 0, m_geometryCount = 0, m_instanceCount = 0, m_stringBytes = 0, m_bvhNodeCount = 0;
+        bool m_mapped = false;
+    };
+
+} // namespace rayt::io
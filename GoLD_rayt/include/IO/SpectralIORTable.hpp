@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * @file SpectralIORTable.hpp
+ * @brief Complex IOR (n + ik) resampled onto a uniform wavelength grid for O(1) lookups.
+ * * IORInterpolator keeps the measured points as they come and binary searches
+ * them on every query. That is fine for building a material, but in spectral
+ * mode n and k are needed per wavelength per path vertex. This is the compiled
+ * form: both channels are resampled once onto a uniform grid (1 nm over the
+ * rendered range by default), so a lookup is one multiply, one truncation and
+ * one lerp, and four wavelengths are interpolated together in SIMD.
+ * * loadCSV() caches the resampled grid in an io::AssetCache keyed by the
+ * CSV's content, so later runs skip CSV parsing; copies, checkouts and
+ * touched files still hit, and edits always miss. Outside the measured range
+ * the table holds the end values, matching IORInterpolator::evaluate.
+ */
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Simd.hpp"
+#include "Core/SampledSpectrum.hpp"
+#include "IO/IORInterpolator.hpp"
+#include "IO/AssetCache.hpp"
+
+namespace rayt {
+
+    class SpectralIORTable {
+    public:
+        /// Default grid spacing [nm]; Johnson & Christy's data is ~10-30 nm apart.
+        static constexpr Real DEFAULT_STEP = 1.0;
+
+        SpectralIORTable() = default;
+
+        /**
+         * @brief Resamples measured data onto [lambdaMin, lambdaMax] every `step` nm.
+         */
+        explicit SpectralIORTable(const IORInterpolator& data,
+            Real lambdaMin = LAMBDA_MIN, Real lambdaMax = LAMBDA_MAX, Real step = DEFAULT_STEP);
+
+        /**
+         * @brief Loads a RefractiveIndex.info style CSV (see IORInterpolator::loadCSV).
+         * * Parses the CSV and resamples it onto the default grid; if useCache, through
+         * the default io::AssetCache (as the overload below).
+         * @return false if the CSV could not be read.
+         */
+        bool loadCSV(const std::string& filename, bool useCache = true);
+
+        /**
+         * @brief Same, with the resampled grid looked up in and stored to `cache`, keyed by the CSV's content.
+         * @return false if the CSV could not be read.
+         */
+        bool loadCSV(const std::string& filename, const io::AssetCache& cache);
+
+        bool empty() const { return m_n.empty(); }
+        size_t size() const { return m_size; }
+        Real lambdaMin() const { return m_lambda0; }
+        Real step() const { return m_step; }
+
+        /**
+         * @brief n + ik at one wavelength [nm] (clamped to the grid).
+         */
+        std::complex<double> evaluate(double wavelength_nm) const {
+            if (empty()) return { 1.0, 0.0 };
+            const float x = std::clamp(float((wavelength_nm - m_lambda0) * m_invStep), 0.0f, m_maxX);
+            const int i = int(x);
+            const float t = x - float(i);
+            return { m_n[i] + (m_n[i + 1] - m_n[i]) * t, m_k[i] + (m_k[i + 1] - m_k[i]) * t };
+        }
+
+        /**
+         * @brief n and k at each of a path's sampled wavelengths (4 lanes at once).
+         */
+        void evaluate(const SampledWavelengths& lambda, SampledSpectrum& n, SampledSpectrum& k) const {
+            simd::Float4 n4, k4;
+            evaluate4(lambda.lanes(), n4, k4);
+            n = SampledSpectrum(n4);
+            k = SampledSpectrum(k4);
+        }
+
+        /**
+         * @brief Batch form: n[i], k[i] at wavelength[i] for i < count.
+         */
+        void evaluate(const float* wavelength_nm, size_t count, float* n, float* k) const;
+
+    private:
+        /// Interpolates four wavelengths; the per-lane table reads are the only scalar part.
+        void evaluate4(simd::Float4 lambda, simd::Float4& n, simd::Float4& k) const {
+            if (empty()) {
+                n = simd::Float4(1.0f);
+                k = simd::Float4(0.0f);
+                return;
+            }
+            const simd::Float4 x = simd::min(simd::max(
+                (lambda - simd::Float4(float(m_lambda0))) * simd::Float4(m_invStep),
+                simd::Float4(0.0f)), simd::Float4(m_maxX));
+
+            float xs[simd::LANES], ts[simd::LANES];
+            float n0[simd::LANES], n1[simd::LANES], k0[simd::LANES], k1[simd::LANES];
+            x.store(xs);
+            for (int l = 0; l < simd::LANES; ++l) {
+                const int i = int(xs[l]); // x >= 0, so truncation is floor
+                ts[l] = xs[l] - float(i);
+                n0[l] = m_n[i]; n1[l] = m_n[i + 1];
+                k0[l] = m_k[i]; k1[l] = m_k[i + 1];
+            }
+            const simd::Float4 t = simd::Float4::load(ts);
+            const simd::Float4 a = simd::Float4::load(n0), b = simd::Float4::load(k0);
+            n = a + t * (simd::Float4::load(n1) - a);
+            k = b + t * (simd::Float4::load(k1) - b);
+        }
+
+        void setGrid(Real lambdaMin, Real step, size_t size);
+
+        Real m_lambda0 = 0;
+        Real m_step = DEFAULT_STEP;
+        float m_invStep = 1.0f;
+        float m_maxX = 0.0f;     // last grid index, as the clamp bound for x
+        size_t m_size = 0;       // grid points
+        std::vector<float> m_n;  // size + 1 entries; the last repeats so i + 1 is always valid
+        std::vector<float> m_k;
+    };
+
+} // namespace rayt
@@ -21,27 +21,37 @@
 
 namespace rayt {
 
-    class Dielectric : public Material {
+    class Dielectric final : public Material {
         Real ior;      // Interior IOR
         Real alpha_x;  // Roughness X
         Real alpha_y;  // Roughness Y
+        GGXDistribution dist; // Built once from alpha_x/alpha_y
 
     public:
-        Dielectric(Real ior, Real roughness, Real anisotropy = 0.0) : ior(ior) {
-            Real aspect = std::sqrt(1.0 - anisotropy * 0.9);
-            alpha_x = MicrofacetDistribution::roughnessToAlpha(roughness / aspect);
-            alpha_y = MicrofacetDistribution::roughnessToAlpha(roughness * aspect);
-        }
+        Dielectric(Real ior, Real roughness, Real anisotropy = 0.0)
+            : ior(ior),
+            alpha_x(MicrofacetDistribution::roughnessToAlpha(roughness / anisotropyAspect(anisotropy))),
+            alpha_y(MicrofacetDistribution::roughnessToAlpha(roughness * anisotropyAspect(anisotropy))),
+            dist(alpha_x, alpha_y) {}
 
         // ---------------------------------------------------------------------
         // Evaluation (BSDF)
         // ---------------------------------------------------------------------
-        Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode) const override {
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
+            return evalAndPdf(ctx, wi).f;
+        }
+
+        /**
+         * @brief Evaluates the BSDF and its sampling PDF sharing wh, F, D and Lambda(wo).
+         */
+        BSDFEval evalAndPdf(const BSDFContext& ctx, const Vector3& wi) const override {
+            BSDFEval result;
+
+            // Delta lobes: eval() and pdf() return 0 (Dirac delta)
+            if (isSmooth()) return result;
 
-            // Delta lobes: eval() returns 0 (Dirac delta)
-            if (isSmooth()) return Spectrum(0.0);
+            const SurfaceInteraction& rec = ctx.rec;
+            const Vector3& wo = ctx.wo;
 
             Real cosThetaO = glm::dot(rec.n, wo);
             Real cosThetaI = glm::dot(rec.n, wi);
@@ -49,16 +59,8 @@ namespace rayt {
             // Determine reflection vs transmission in shading-normal hemisphere sense
             bool isReflection = cosThetaO * cosThetaI > 0;
 
-            // For reflection, both must be on the geometric front side
-            // For transmission, allow opposite sides (don't kill it here)
-            if (isReflection) {
-                if (glm::dot(rec.gn, wo) <= 0 || glm::dot(rec.gn, wi) <= 0)
-                    return Spectrum(0.0);
-            }
-
             // PBRT logic for eta/etap
             bool entering = cosThetaO > 0;
-            Real eta = entering ? (1.0 / ior) : ior;          // etaI / etaT  (for refractOutward)
             Real etap = entering ? ior : (1.0 / ior);          // etaT / etaI  (for half-vector reconstruction)
 
             // Compute half-vector (wh)
@@ -69,57 +71,72 @@ namespace rayt {
             else {
                 wh = wo + wi * etap;
             }
-            if (glm::length2(wh) == 0) return Spectrum(0.0);
+            if (glm::length2(wh) == 0) return result;
             wh = glm::normalize(wh);
 
             if (glm::dot(wh, wo) < 0) wh = -wh;
 
-            // Local frame conversion for GGX
-            rayt::frame::Frame frame(rec.n);
-            Vector3 wo_local = frame.worldToLocal(wo);
-            Vector3 wi_local = frame.worldToLocal(wi);
-            Vector3 wh_local = frame.worldToLocal(wh);
+            Real dot_wo_wh = glm::dot(wo, wh);
+            if (dot_wo_wh == 0) return result;
+
+            // Local frame conversion for GGX (frame cached in ctx)
+            Vector3 wi_local = ctx.toLocal(wi);
+            Vector3 wh_local = ctx.toLocal(wh);
 
-            GGXDistribution dist(alpha_x, alpha_y);
             Real D = dist.D(wh_local);
-            Real G = dist.G(wo_local, wi_local);
-            Real F = rayt::fresnel::fresnelDielectric(std::abs(glm::dot(wo, wh)), 1.0, ior);
+            Real lambdaO = ctx.lambdaO(dist); // Lambda is even in w, so the sign of wo.z does not matter
+            Real G = Real(1.0) / (Real(1.0) + lambdaO + dist.lambda(wi_local));
+            Real F = rayt::fresnel::fresnelDielectric(std::abs(dot_wo_wh), 1.0, ior);
+
+            // VNDF pdf of wh: G1(wo) * |wo.wh| * D(wh) / |wo.z|
+            Real pdf_wh = std::abs(dot_wo_wh) * D / ((Real(1.0) + lambdaO) * std::abs(ctx.woLocal.z));
 
             if (isReflection) {
+                result.pdf = (pdf_wh / (4.0 * std::abs(dot_wo_wh))) * F;
+
+                // For reflection, both must be on the geometric front side
+                if (ctx.cosGeoO <= 0 || glm::dot(rec.gn, wi) <= 0)
+                    return result;
+
                 Real denom = std::abs(4.0 * cosThetaI * cosThetaO);
-                if (denom < 1e-8) return Spectrum(0.0);
-                return Spectrum(D * G * F / denom);
+                if (denom >= 1e-8) result.f = Spectrum(D * G * F / denom);
+                return result;
             }
-            else {
-                // Refraction BSDF (Walter 2007 / PBRT v4)
-                Real dot_wi_wh = glm::dot(wi, wh);
-                Real dot_wo_wh = glm::dot(wo, wh);
 
-                Real sqrtDenom = dot_wi_wh * etap + dot_wo_wh;
-                Real denom = rayt::math::sqr(sqrtDenom) * cosThetaI * cosThetaO; // signed
+            // Refraction BSDF (Walter 2007 / PBRT v4)
+            // For transmission, allow opposite sides (don't kill it here)
+            Real dot_wi_wh = glm::dot(wi, wh);
+            Real sqrtDenom = dot_wi_wh * etap + dot_wo_wh;
+            if (sqrtDenom == 0) return result;
 
-                if (std::abs(denom) < 1e-8) return Spectrum(0.0);
+            Real dwh_dwi = std::abs(dot_wi_wh) * rayt::math::sqr(etap) / rayt::math::sqr(sqrtDenom);
+            result.pdf = (pdf_wh * dwh_dwi) * (1.0 - F);
 
-                Real val = D * G * (1.0 - F) *
-                    std::abs(dot_wi_wh * dot_wo_wh / denom);
+            Real denom = rayt::math::sqr(sqrtDenom) * cosThetaI * cosThetaO; // signed
+            if (std::abs(denom) < 1e-8) return result;
 
-                if (mode == TransportMode::Radiance)
-                    val /= rayt::math::sqr(etap);
+            Real val = D * G * (1.0 - F) *
+                std::abs(dot_wi_wh * dot_wo_wh / denom);
 
-                return Spectrum(val);
-            }
+            if (ctx.mode == TransportMode::Radiance)
+                val /= rayt::math::sqr(etap);
+
+            result.f = Spectrum(val);
+            return result;
         }
 
         // ---------------------------------------------------------------------
         // Sampling
         // ---------------------------------------------------------------------
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
 
             BSDFSample bsdfSample;
 
+            const SurfaceInteraction& rec = ctx.rec;
+            const Vector3& wo = ctx.wo;
+            const TransportMode mode = ctx.mode;
+
             Real cosThetaO = glm::dot(rec.n, wo);
             bool entering = cosThetaO > 0;
 
@@ -163,16 +180,12 @@ namespace rayt {
             }
 
             // --- Case B: Rough (microfacet) ---
-            rayt::frame::Frame frame(rec.n);
-            Vector3 wo_local = frame.worldToLocal(wo);
-            GGXDistribution dist(alpha_x, alpha_y);
-
-            Vector3 wo_sampling = wo_local;
+            Vector3 wo_sampling = ctx.woLocal;
             if (wo_sampling.z < 0) wo_sampling = -wo_sampling;
 
             // 1) sample wh (uses u)
             Vector3 wh_local = dist.sample_wh(wo_sampling, u);
-            Vector3 wh = frame.localToWorld(wh_local);
+            Vector3 wh = ctx.toWorld(wh_local);
             if (glm::dot(wh, wo) < 0) wh = -wh;
 
             // 2) Fresnel
@@ -181,6 +194,10 @@ namespace rayt {
 
             Real F = rayt::fresnel::fresnelDielectric(std::abs(dot_wo_wh), 1.0, ior);
 
+            // VNDF pdf of wh, reusing the cached Lambda(wo)
+            Real pdf_wh = std::abs(dot_wo_wh) * dist.D(wh_local) /
+                ((Real(1.0) + ctx.lambdaO(dist)) * std::abs(wo_sampling.z));
+
             // IMPORTANT:
             // Don't reuse u.x (already used in VNDF sampling) for lobe selection.
             // Ideally sample should take Point3. Minimal fix: draw one extra RNG here.
@@ -198,10 +215,9 @@ namespace rayt {
                 bsdfSample.flags = BxDFFlags::Glossy | BxDFFlags::Reflection;
 
                 // f via eval() to keep eval/pdf/sample consistent
-                bsdfSample.f = eval(rec, wo, bsdfSample.wi, mode);
+                bsdfSample.f = eval(ctx, bsdfSample.wi);
 
                 // PDF
-                Real pdf_wh = dist.pdf(wo_sampling, wh_local);
                 bsdfSample.pdf = (pdf_wh / (4.0 * std::abs(dot_wo_wh))) * F;
             }
             else {
@@ -217,7 +233,7 @@ namespace rayt {
                 bsdfSample.flags = BxDFFlags::Glossy | BxDFFlags::Transmission;
 
                 // f via eval() to keep consistent
-                bsdfSample.f = eval(rec, wo, wi, mode);
+                bsdfSample.f = eval(ctx, wi);
 
                 // PDF (PBRT v4 Jacobian)
                 Real dot_wi_wh = glm::dot(wi, wh);
@@ -225,7 +241,6 @@ namespace rayt {
                 if (sqrtDenom == 0) return std::nullopt;
 
                 Real dwh_dwi = std::abs(dot_wi_wh) * rayt::math::sqr(etap) / rayt::math::sqr(sqrtDenom);
-                Real pdf_wh = dist.pdf(wo_sampling, wh_local);
                 bsdfSample.pdf = pdf_wh * dwh_dwi * (1.0 - F);
             }
 
@@ -238,61 +253,23 @@ namespace rayt {
         // ---------------------------------------------------------------------
         // PDF
         // ---------------------------------------------------------------------
-        Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const override {
-
-            if (isSmooth()) return 0.0;
-
-            Real cosThetaO = glm::dot(rec.n, wo);
-            Real cosThetaI = glm::dot(rec.n, wi);
-
-            bool isReflection = cosThetaO * cosThetaI > 0;
-
-            bool entering = cosThetaO > 0;
-            Real etap = entering ? ior : (1.0 / ior);
-
-            // Reconstruct wh correctly depending on reflection/transmission
-            Vector3 wh;
-            if (isReflection) {
-                wh = wo + wi;
-            }
-            else {
-                wh = wo + wi * etap;
-            }
-            if (glm::length2(wh) == 0) return 0.0;
-            wh = glm::normalize(wh);
-            if (glm::dot(wh, wo) < 0) wh = -wh;
-
-            Real dot_wo_wh = glm::dot(wo, wh);
-            if (dot_wo_wh == 0) return 0.0;
-
-            Real F = rayt::fresnel::fresnelDielectric(std::abs(dot_wo_wh), 1.0, ior);
-
-            rayt::frame::Frame frame(rec.n);
-            GGXDistribution dist(alpha_x, alpha_y);
-
-            Vector3 wo_local = frame.worldToLocal(wo);
-            if (wo_local.z < 0) wo_local = -wo_local;
-
-            Real pdf_wh = dist.pdf(wo_local, frame.worldToLocal(wh));
-
-            if (isReflection) {
-                return (pdf_wh / (4.0 * std::abs(dot_wo_wh))) * F;
-            }
-            else {
-                Real dot_wi_wh = glm::dot(wi, wh);
-                Real sqrtDenom = dot_wi_wh * etap + dot_wo_wh;
-                if (sqrtDenom == 0) return 0.0;
-
-                Real dwh_dwi = std::abs(dot_wi_wh) * rayt::math::sqr(etap) / rayt::math::sqr(sqrtDenom);
-                return (pdf_wh * dwh_dwi) * (1.0 - F);
-            }
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
+            return evalAndPdf(ctx, wi).pdf;
         }
 
         bool isSpecular() const override { return isSmooth(); }
 
+        std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction&) const override {
+            PreviewMaterial p;
+            p.type = PreviewMaterial::Type::Dielectric;
+            p.eta = Spectrum(ior);
+            p.alpha = isSmooth() ? Real(0) : std::sqrt(alpha_x * alpha_y);
+            return p;
+        }
+
     private:
         bool isSmooth() const { return alpha_x < 0.001 && alpha_y < 0.001; }
+        static Real anisotropyAspect(Real anisotropy) { return std::sqrt(1.0 - anisotropy * 0.9); }
     };
 
 } // namespace rayt
@@ -4,7 +4,7 @@
 
 namespace rayt {
 
-    class DiffuseLight : public Material {
+    class DiffuseLight final : public Material {
     public:
         // color: 光の色と強さ (例: (10, 10, 10) なら非常に明るい白)
         DiffuseLight(const Spectrum& color) : m_emit(color) {}
@@ -15,23 +15,18 @@ namespace rayt {
         // --------------------------------------------------------
 
         // 評価値: 常に黒 (反射しない)
-        Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode) const override {
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
             return Spectrum(0.0);
         }
 
         // サンプリング: 反射方向がないので何もしない
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
             return std::nullopt;
         }
 
         // PDF: 0
-        Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const override {
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
             return 0.0;
         }
 
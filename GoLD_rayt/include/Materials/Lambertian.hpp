@@ -14,6 +14,9 @@
 #include "Materials/Material.hpp"
 #include "Geometry/Frame.hpp"
 #include "Core/Sampling.hpp"
+#include "Textures/ImageTexture.hpp"
+
+#include <memory>
 
 namespace rayt {
 
@@ -21,8 +24,13 @@ namespace rayt {
      * @brief Perfectly diffuse material following Lambert's Cosine Law.
      * * The BRDF is a constant value: f = albedo / PI.
      */
-    class Lambertian : public Material {
+    class Lambertian final : public Material {
         Spectrum albedo;
+        std::shared_ptr<const ImageTexture> albedoMap; // Optional; multiplied with albedo
+
+        Spectrum albedoAt(const SurfaceInteraction& rec) const {
+            return albedoMap ? albedo * albedoMap->evaluate(rec) : albedo;
+        }
 
         static inline Real cosNg(const SurfaceInteraction& rec, const Vector3& w) {
             return glm::dot(rec.gn, w);
@@ -39,21 +47,29 @@ namespace rayt {
          */
         Lambertian(const Spectrum& a) : albedo(a) {}
 
+        /**
+         * @brief Constructs a textured Lambertian material.
+         * @param map  Albedo map (load color maps with ColorEncoding::sRGB).
+         * @param tint Constant factor applied on top of the map.
+         */
+        Lambertian(std::shared_ptr<const ImageTexture> map, const Spectrum& tint = Spectrum(1.0))
+            : albedo(tint), albedoMap(std::move(map)) {}
+
+        bool usesTextures() const override { return albedoMap || Material::usesTextures(); }
+
         /**
          * @brief Evaluates the Lambertian BRDF.
          * * Formula: f(wo, wi) = albedo / PI
          * @return The constant spectral reflectance divided by PI.
          */
-        Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode) const override {
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
 
             // Rejects light coming from behind the surface (back-face)
-            if (cosNg(rec, wi) <= 0) {  // using geometry normal
+            if (cosNg(ctx.rec, wi) <= 0) {  // using geometry normal
                 return Spectrum(0.0);
             }
 
-            return albedo * (1.0 / constants::PI);
+            return albedoAt(ctx.rec) * (1.0 / constants::PI);
         }
 
         /**
@@ -61,13 +77,12 @@ namespace rayt {
          * * Formula: p(wi) = cos(theta) / PI
          * @return The probability density of choosing direction wi.
          */
-        Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const override {
-            if (cosNg(rec, wi) <= 0) {
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
+            if (cosNg(ctx.rec, wi) <= 0) {
                 return 0.0;
             }
 
-            Real cosTheta = cosNs(rec, wi);
+            Real cosTheta = cosNs(ctx.rec, wi);
             if (cosTheta <= 0) {
                 return 0.0;
             }
@@ -75,6 +90,19 @@ namespace rayt {
             return cosTheta * (1.0 / constants::PI);
         }
 
+        /**
+         * @brief Evaluates the BRDF and the cosine PDF with a single back-face test.
+         */
+        BSDFEval evalAndPdf(const BSDFContext& ctx, const Vector3& wi) const override {
+            BSDFEval result;
+            if (cosNg(ctx.rec, wi) <= 0) return result;
+
+            result.f = albedoAt(ctx.rec) * (1.0 / constants::PI);
+            Real cosTheta = cosNs(ctx.rec, wi);
+            if (cosTheta > 0) result.pdf = cosTheta * (1.0 / constants::PI);
+            return result;
+        }
+
         /**
          * @brief Importance samples the hemisphere using a cosine distribution.
          * * This method aligns the sample density with the cosine term of the
@@ -82,30 +110,27 @@ namespace rayt {
          * * @param u Random samples in [0, 1)^2.
          * @return A BSDFSample containing the direction, value, and PDF.
          */
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
 
             BSDFSample bsdfSample;
 
             // 1. Generate a direction in local space using cosine-weighted sampling.
             //    Z-axis in local space corresponds to the surface normal.
-            rayt::frame::Frame onb(rec.n);
             Vector3 localDir = sampling::CosineSampleHemisphere(u); 
 
-            // 2. Transform the sampled direction to World Space.
-            bsdfSample.wi = onb.localToWorld(localDir);
+            // 2. Transform the sampled direction to World Space (frame cached in ctx).
+            bsdfSample.wi = ctx.toWorld(localDir);
 
             // 3. Geometric sanity check: Ensure the direction is in the upper hemisphere.
-            if (cosNg(rec, bsdfSample.wi) <= 0) return std::nullopt;
+            if (cosNg(ctx.rec, bsdfSample.wi) <= 0) return std::nullopt;
 
             // 4. PDF calculation: p(wi) = cos(theta) / PI.
             //    Since localDir is on a unit hemisphere, localDir.z is exactly cos(theta).
             bsdfSample.pdf = localDir.z * (Real(1.0) / constants::PI);
 
             // 5. BSDF value: constant for Lambertian surfaces.
-            bsdfSample.f = albedo *(Real(1.0) / constants::PI);
+            bsdfSample.f = albedoAt(ctx.rec) * (Real(1.0) / constants::PI);
 
             // 6. Set flags indicating a diffuse reflection interaction.
             bsdfSample.flags =
@@ -114,6 +139,12 @@ namespace rayt {
 
             return bsdfSample;
         }
+
+        std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction& rec) const override {
+            PreviewMaterial p;
+            p.albedo = albedoAt(rec);
+            return p;
+        }
     };
 
 } // namespace rayt
\ No newline at end of file
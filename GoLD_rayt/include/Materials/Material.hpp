@@ -15,7 +15,11 @@
 #include "Core/Assert.hpp"
 #include "Core/Interaction.hpp"
 #include "Core/Ray.hpp"
+#include "Core/SampledSpectrum.hpp"
+#include "Geometry/Frame.hpp"
+#include "Textures/ImageTexture.hpp"
 
+#include <memory>
 #include <optional>
 
 // Include your spectral data handler
@@ -117,6 +121,15 @@ namespace rayt {
         /// The specific flags of the BxDF lobe that was actually sampled.
         BxDFFlags flags = BxDFFlags::Unset;
 
+#if RAYT_SPECTRAL
+        /// Value at the path's wavelengths, when the material evaluated per wavelength.
+        SampledSpectrum fLambda;
+        bool hasSpectral = false;
+
+        /// Stores a per-wavelength value; f becomes its lane average (kept for black checks).
+        void setSpectral(const SampledSpectrum& v) { fLambda = v; hasSpectral = true; f = Spectrum(v.average()); }
+#endif
+
         /**
          * @brief Checks if the sampled interaction was perfectly specular (delta distribution).
          * @return true If the sampled component is specular.
@@ -136,10 +149,125 @@ namespace rayt {
         bool isTransmission() const { return has(flags, BxDFFlags::Transmission); }
     };
 
+    /**
+     * @brief Result of a combined BSDF evaluation (value and PDF for one direction pair).
+     */
+    struct BSDFEval {
+        /// The BSDF value f(wo, wi) [1/sr].
+        Spectrum f = Spectrum(0.0);
+
+        /// The solid-angle PDF of sampling wi given wo.
+        Real pdf = 0;
+
+#if RAYT_SPECTRAL
+        /// Value at the path's wavelengths, when the material evaluated per wavelength.
+        SampledSpectrum fLambda;
+        bool hasSpectral = false;
+
+        /// Stores a per-wavelength value; f becomes its lane average (kept for black checks).
+        void setSpectral(const SampledSpectrum& v) { fLambda = v; hasSpectral = true; f = Spectrum(v.average()); }
+#endif
+    };
+
+    /**
+     * @brief Outline of a glossy reflection lobe: exp(sharpness * (dot(axis, wi) - 1)).
+     * * A spherical Gaussian that light sampling can aim at (see EnvProductSampler);
+     * it only shapes where samples go, the BSDF value and pdf are unchanged.
+     */
+    struct GlossyLobe {
+        Vector3 axis;   ///< Unit lobe center in World Space.
+        Real sharpness; ///< SG sharpness; angular spread is about 1 / sqrt(sharpness).
+    };
+
+    /**
+     * @brief A material reduced to one of the lobes pre-integrated lighting supports.
+     * * The IBL preview (PreviewIntegrator) does not sample BSDFs; it looks up
+     * tables built once per environment for these few analytic lobes, so
+     * roughness and n, k can change between frames at no cost.
+     */
+    struct PreviewMaterial {
+        enum class Type {
+            Diffuse,    ///< Lambertian: albedo.
+            Conductor,  ///< GGX conductor: eta, k, alpha.
+            Dielectric  ///< GGX dielectric: eta.x is the IOR, alpha.
+        };
+        Type type = Type::Diffuse;
+        Spectrum albedo = Spectrum(0.0);
+        Spectrum eta = Spectrum(1.0);
+        Spectrum k = Spectrum(0.0);
+        Real alpha = 0; ///< Isotropic GGX alpha (geometric mean of alpha_x, alpha_y); 0 is a mirror.
+    };
+
+    /**
+     * @brief The value a path multiplies by for a BSDF result.
+     * * The material's own per-wavelength value if it produced one, otherwise
+     * its RGB value lifted to the path's wavelengths (the RGB value itself in RGB mode).
+     */
+    template <typename Result>
+    inline PathSpectrum pathValue(const Result& r, const SampledWavelengths& lambda) {
+#if RAYT_SPECTRAL
+        if (r.hasSpectral) return r.fLambda;
+#endif
+        return spectral::lift(r.f, lambda);
+    }
+
+    /**
+     * @brief Per-interaction shading state shared by every BSDF query at one path vertex.
+     * * The integrator builds one context per bounce and passes it to eval, pdf,
+     * sample and evalAndPdf, so the shading frame, the local outgoing direction
+     * and the geometric-side test for wo are computed once instead of once per
+     * call. Material-dependent microfacet terms that only depend on wo (Smith
+     * Lambda) are cached lazily on first use.
+     * * The context references the SurfaceInteraction and must not outlive it.
+     */
+    struct BSDFContext {
+        const SurfaceInteraction& rec;  ///< The hit the context was built for.
+        Vector3 wo;                     ///< Outgoing direction in world space.
+        frame::Frame frame;             ///< Shading frame around rec.n.
+        Vector3 woLocal;                ///< wo expressed in @ref frame.
+        Real cosGeoO;                   ///< dot(rec.gn, wo); <= 0 means wo is below the geometric surface.
+        TransportMode mode;             ///< Transport mode for the whole vertex.
+#if RAYT_SPECTRAL
+        const SampledWavelengths* lambda = nullptr; ///< The path's wavelengths (set by the integrator).
+#endif
+
+        /**
+         * @brief Builds the context for a hit.
+         * @param rec  The surface interaction details.
+         * @param wo   The outgoing (view) direction in World Space.
+         * @param mode The transport mode.
+         */
+        BSDFContext(const SurfaceInteraction& rec, const Vector3& wo,
+            TransportMode mode = TransportMode::Radiance)
+            : rec(rec), wo(wo), frame(rec.n),
+            woLocal(frame.worldToLocal(wo)),
+            cosGeoO(glm::dot(rec.gn, wo)),
+            mode(mode) {}
+
+        Vector3 toLocal(const Vector3& w) const { return frame.worldToLocal(w); }
+        Vector3 toWorld(const Vector3& w) const { return frame.localToWorld(w); }
+
+        /**
+         * @brief Smith Lambda(wo) of the hit's microfacet distribution, computed on first use.
+         * @param dist The material's distribution (a hit only ever has one).
+         */
+        template <typename Distribution>
+        Real lambdaO(const Distribution& dist) const {
+            if (m_lambdaO < 0) m_lambdaO = dist.lambda(woLocal);
+            return m_lambdaO;
+        }
+
+    private:
+        mutable Real m_lambdaO = -1; // Lambda >= 0, so negative means "not computed yet"
+    };
+
     /**
      * @brief Abstract base class for all materials.
      * * Materials define how light interacts with a surface by providing
      * a Bidirectional Scattering Distribution Function (BSDF).
+     * * The virtual interface takes a BSDFContext built once per hit. The
+     * (rec, wo, wi) overloads below are convenience wrappers that build a
+     * throw-away context; prefer the context form in hot loops.
      */
     class Material {
     public:
@@ -147,44 +275,71 @@ namespace rayt {
 
         /**
          * @brief Evaluates the BSDF value f(wo, wi) for a given pair of directions.
-         * * @param rec  The surface interaction details (normal, tangents, UVs).
-         * @param wo   The outgoing (view) direction in World Space.
+         * * @param ctx  The per-hit shading context (interaction, wo, frame, mode).
          * @param wi   The incident (light) direction in World Space.
-         * @param mode The transport mode (usually Radiance).
          * @return Spectrum The BSDF value [1/sr].
          * * @note Following standard PBR conventions, this returns the pure BSDF value.
          * The cosine term (n·wi) is typically applied by the Integrator.
          * For delta distributions (perfect Specular), this returns 0.
          */
-        virtual Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode = TransportMode::Radiance) const = 0;
+        virtual Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const = 0;
 
         /**
          * @brief Importance samples a new incident direction wi based on the BSDF.
          * * This method is crucial for variance reduction in path tracing.
-         * @param rec    The surface interaction details.
-         * @param wo     The outgoing (view) direction in World Space.
+         * @param ctx    The per-hit shading context.
          * @param u      A 2D random sample from the RNG [0, 1)^2.
-         * @param mode   The transport mode.
          * @return std::optional<BSDFSample> The result of the sampling,
          * or nullopt if sampling fails (e.g., Total Internal Reflection).
          */
-        virtual std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u, // ランダムシード
-            TransportMode mode = TransportMode::Radiance) const = 0;
+        virtual std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const = 0; // u: ランダムシード
 
         /**
          * @brief Evaluates the Probability Density Function (PDF) for a given direction.
          * * Essential for Multiple Importance Sampling (MIS).
-         * @param rec The surface interaction details.
-         * @param wo  The outgoing direction.
+         * @param ctx The per-hit shading context.
          * @param wi  The incident direction to evaluate.
          * @return Real The PDF value with respect to solid angle.
          */
-        virtual Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const = 0;
+        virtual Real pdf(const BSDFContext& ctx, const Vector3& wi) const = 0;
+
+        /**
+         * @brief Evaluates f(wo, wi) and pdf(wo, wi) together.
+         * * Light sampling needs both for the same direction; materials override
+         * this to share the half vector, D and Smith terms between the two.
+         * @param ctx The per-hit shading context.
+         * @param wi  The incident direction to evaluate.
+         * @return BSDFEval The BSDF value and its solid-angle PDF.
+         */
+        virtual BSDFEval evalAndPdf(const BSDFContext& ctx, const Vector3& wi) const {
+            BSDFEval result;
+            result.f = eval(ctx, wi);
+            result.pdf = pdf(ctx, wi);
+            return result;
+        }
+
+        // -----------------------------------------------------------
+        // Convenience wrappers (build a context per call)
+        // -----------------------------------------------------------
+
+        Spectrum eval(const SurfaceInteraction& rec,
+            const Vector3& wo, const Vector3& wi,
+            TransportMode mode = TransportMode::Radiance) const {
+            return eval(BSDFContext(rec, wo, mode), wi);
+        }
+
+        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
+            const Vector3& wo,
+            const Point2& u,
+            TransportMode mode = TransportMode::Radiance) const {
+            return sample(BSDFContext(rec, wo, mode), u);
+        }
+
+        Real pdf(const SurfaceInteraction& rec,
+            const Vector3& wo, const Vector3& wi) const {
+            return pdf(BSDFContext(rec, wo), wi);
+        }
 
         // -----------------------------------------------------------
         // Optional Helpers
@@ -205,6 +360,50 @@ namespace rayt {
          * @brief Optimization hint to check if the material is perfectly specular.
          */
         virtual bool isSpecular() const { return false; }
+
+        /**
+         * @brief The glossy lobe f * cos concentrates in for this hit, if it has one.
+         * * Lets the integrator sample the environment times the lobe instead of
+         * the environment alone. Diffuse and specular materials return nullopt.
+         */
+        virtual std::optional<GlossyLobe> glossyLobe(const BSDFContext& ctx) const { return std::nullopt; }
+
+        /**
+         * @brief This hit's material as a lobe the IBL preview can shade.
+         * * Materials that do not fit one return nullopt and only show their emission there.
+         */
+        virtual std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction& rec) const { return std::nullopt; }
+
+        // -----------------------------------------------------------
+        // Textures (shared by every material)
+        // -----------------------------------------------------------
+
+        /**
+         * @brief Whether any lookup of this material reads a texture.
+         * * Untextured materials skip the footprint computation entirely.
+         */
+        virtual bool usesTextures() const { return m_normalMap != nullptr; }
+
+        /**
+         * @brief Attaches a tangent-space normal map (load it with ColorEncoding::Linear).
+         */
+        void setNormalMap(std::shared_ptr<const ImageTexture> map) { m_normalMap = std::move(map); }
+
+        /**
+         * @brief Prepares a hit for texture lookups: footprint, then normal map.
+         * * Must run before the BSDFContext is built, since the context caches the frame.
+         * @param rec       The hit to update.
+         * @param ray       The ray that produced it (differentials used if present).
+         * @param coneWidth Ray-cone footprint width at the hit, used without differentials.
+         */
+        void prepareShading(SurfaceInteraction& rec, const RayDifferential& ray, Real coneWidth) const {
+            if (!usesTextures()) return;
+            rec.computeDifferentials(ray, coneWidth);
+            if (m_normalMap) rec.applyTangentSpaceNormal(m_normalMap->evaluateNormal(rec));
+        }
+
+    private:
+        std::shared_ptr<const ImageTexture> m_normalMap;
     };
 
 } // namespace rayt
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * @file MaterialTable.hpp
+ * @brief Closed set of built-in materials stored by value, with devirtualized dispatch.
+ * * The built-in materials are stored in a std::variant inside one contiguous
+ * table owned by the Scene. Geometry refers to them by MaterialId, and the
+ * integrator dispatches through std::visit, so every eval/sample/pdf call on a
+ * built-in material is a jump-table branch plus an inlinable direct call
+ * instead of a virtual call through a scattered heap object. In the gold
+ * roughness scene that is no faster in practice: the BSDF math dominates a
+ * bounce (debug::TestMaterialDispatch times both paths).
+ * * Materials outside the closed set (user extensions) keep working through the
+ * virtual Material interface and SurfaceInteraction::matPtr; MaterialRef hides
+ * which of the two paths a hit uses.
+ */
+
+#include "Core/Types.hpp"
+#include "Core/Assert.hpp"
+#include "Core/Interaction.hpp"
+
+#include "Materials/Material.hpp"
+#include "Materials/Lambertian.hpp"
+#include "Materials/RoughConductor.hpp"
+#include "Materials/Dielectric.hpp"
+#include "Materials/DiffuseLight.hpp"
+#include "Materials/MirrorConductor.hpp"
+#include "Materials/SpectralMetal.hpp"
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rayt {
+
+    /**
+     * @brief Tagged union over every built-in material.
+     * * All alternatives are declared `final`, so calls made on the concrete
+     * alternative inside std::visit are resolved statically.
+     */
+    using MaterialVariant = std::variant<
+        Lambertian,
+        RoughConductor,
+        Dielectric,
+        DiffuseLight,
+        MirrorConductor,
+        SpectralMetal>;
+
+    /**
+     * @brief Contiguous, index-addressed storage for built-in materials.
+     */
+    class MaterialTable {
+    public:
+        MaterialTable() = default;
+
+        /**
+         * @brief Constructs a material in place and returns its id.
+         * @tparam T    One of the MaterialVariant alternatives.
+         * @param args  Constructor arguments forwarded to T.
+         * @return MaterialId Index of the new entry.
+         */
+        template <typename T, typename... Args>
+        MaterialId emplace(Args&&... args) {
+            m_materials.emplace_back(std::in_place_type<T>, std::forward<Args>(args)...);
+            return MaterialId(m_materials.size() - 1);
+        }
+
+        /**
+         * @brief Appends an already constructed material and returns its id.
+         */
+        MaterialId add(MaterialVariant material) {
+            m_materials.push_back(std::move(material));
+            return MaterialId(m_materials.size() - 1);
+        }
+
+        const MaterialVariant& operator[](MaterialId id) const {
+            Assert(id < m_materials.size());
+            return m_materials[id];
+        }
+
+        bool contains(MaterialId id) const { return id < m_materials.size(); }
+        size_t size() const { return m_materials.size(); }
+        bool empty() const { return m_materials.empty(); }
+
+    private:
+        std::vector<MaterialVariant> m_materials;
+    };
+
+    /**
+     * @brief Lightweight handle to the material at a hit point.
+     * * Holds either a pointer into the MaterialTable (closed set, visited) or a
+     * pointer to a virtual Material (open set). Mirrors the Material interface
+     * so the integrator does not care which one it got.
+     */
+    class MaterialRef {
+    public:
+        MaterialRef() = default;
+        explicit MaterialRef(const MaterialVariant* closed) : m_closed(closed) {}
+        explicit MaterialRef(const Material* open) : m_open(open) {}
+
+        /// @brief True if the handle refers to a material.
+        explicit operator bool() const { return m_closed || m_open; }
+
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const {
+            return dispatch([&](const auto& m) { return m.eval(ctx, wi); });
+        }
+
+        std::optional<BSDFSample> sample(const BSDFContext& ctx, const Point2& u) const {
+            return dispatch([&](const auto& m) { return m.sample(ctx, u); });
+        }
+
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const {
+            return dispatch([&](const auto& m) { return m.pdf(ctx, wi); });
+        }
+
+        BSDFEval evalAndPdf(const BSDFContext& ctx, const Vector3& wi) const {
+            return dispatch([&](const auto& m) { return m.evalAndPdf(ctx, wi); });
+        }
+
+        Spectrum emitted(const SurfaceInteraction& rec, const Vector3& wo) const {
+            return dispatch([&](const auto& m) { return m.emitted(rec, wo); });
+        }
+
+        bool isSpecular() const {
+            return dispatch([](const auto& m) { return m.isSpecular(); });
+        }
+
+        std::optional<GlossyLobe> glossyLobe(const BSDFContext& ctx) const {
+            return dispatch([&](const auto& m) { return m.glossyLobe(ctx); });
+        }
+
+        std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction& rec) const {
+            return dispatch([&](const auto& m) { return m.previewMaterial(rec); });
+        }
+
+        void prepareShading(SurfaceInteraction& rec, const RayDifferential& ray, Real coneWidth) const {
+            dispatch([&](const auto& m) { m.prepareShading(rec, ray, coneWidth); });
+        }
+
+    private:
+        /**
+         * @brief Invokes f on the concrete material.
+         * * For table entries f sees the final alternative type (static call);
+         * for extensions it sees `const Material&` (virtual call).
+         */
+        template <typename F>
+        std::invoke_result_t<F&, const Material&> dispatch(F&& f) const {
+            if (m_closed) return std::visit(f, *m_closed);
+            Assert(m_open != nullptr);
+            return f(*m_open);
+        }
+
+        const MaterialVariant* m_closed = nullptr;
+        const Material* m_open = nullptr;
+    };
+
+} // namespace rayt
@@ -14,23 +14,18 @@ namespace rayt {
         Mirror(const Spectrum& a = Spectrum(1.0)) : albedo(a) {}
 
         // 鏡面反射は「特定の方向」以外確率0なので、任意の方向に対する評価は常に黒
-        Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode) const override {
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
             return Spectrum(0.0);
         }
 
         // デルタ関数の確率は点評価できないため 0
-        Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const override {
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
             return 0.0;
         }
 
         // サンプリングのみ機能する
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
             BSDFSample result;
 
             // 正反射ベクトル R = I - 2(N・I)N
@@ -38,10 +33,10 @@ namespace rayt {
             // 一般的な reflect(v, n) は v - 2*dot(v,n)*n
             // wo (視線) を反転(-wo)して入射として計算するか、公式通りやるか
             // rayt::Reflect の定義によりますが、通常は:
-            result.wi = glm::reflect(-wo, rec.n);
+            result.wi = glm::reflect(-ctx.wo, ctx.rec.n);
 
             // 幾何法線の面で反射が成立してるか（裏面に飛んだら無効）
-            if (glm::dot(rec.gn, result.wi) <= Real(0))
+            if (glm::dot(ctx.rec.gn, result.wi) <= Real(0))
                 return std::nullopt;
 
             result.pdf = 1.0; // 特異点なのでダミーの1を入れる
@@ -24,7 +24,7 @@ namespace rayt {
      * * Handles perfect specular reflection with wavelength-dependent (RGB)
      * Fresnel reflectance for metallic surfaces.
      */
-    class MirrorConductor : public Material {
+    class MirrorConductor final : public Material {
         Spectrum eta; // Real part of the refractive index 'n'
         Spectrum k;   // Imaginary part (extinction coefficient) 'k'
 
@@ -41,14 +41,14 @@ namespace rayt {
          * * Specular reflections are Dirac delta distributions and cannot be
          * evaluated via standard sampling; they must be generated via sample().
          */
-        Spectrum eval(const SurfaceInteraction&, const Vector3&, const Vector3&, TransportMode) const override {
+        Spectrum eval(const BSDFContext&, const Vector3&) const override {
             return Spectrum(0.0);
         }
 
         /**
          * @brief PDF for a delta distribution is 0.
          */
-        Real pdf(const SurfaceInteraction&, const Vector3&, const Vector3&) const override {
+        Real pdf(const BSDFContext&, const Vector3&) const override {
             return 0.0;
         }
 
@@ -57,17 +57,16 @@ namespace rayt {
          * * Computes the reflection vector and scales the throughput by the
          * complex Fresnel reflectance for each RGB channel.
          */
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
 
             BSDFSample bsdfSample;
+            const SurfaceInteraction& rec = ctx.rec;
 
             // 1. Direction Calculation: Perfect Specular Reflection
             // Reflecting the outgoing vector 'wo' about the normal 'n'.
             // Formula: wi = -wo + 2(n · wo)n
-            bsdfSample.wi = glm::reflect(-wo, rec.n);
+            bsdfSample.wi = glm::reflect(-ctx.wo, rec.n);
 
             // Geometric sanity: must go above the geometric surface
             if (glm::dot(rec.gn, bsdfSample.wi) <= Real(0))
@@ -96,6 +95,14 @@ namespace rayt {
          * @brief Checks if the material is specular.
          */
         bool isSpecular() const override { return true; }
+
+        std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction&) const override {
+            PreviewMaterial p;
+            p.type = PreviewMaterial::Type::Conductor;
+            p.eta = eta;
+            p.k = k;
+            return p;
+        }
     
     };
 
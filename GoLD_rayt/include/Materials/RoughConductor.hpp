@@ -15,18 +15,38 @@
 #include "Core/Interaction.hpp"
 #include "Core/Math.hpp"
 #include "Core/Fresnel.hpp"
+#include "Core/FresnelTable.hpp"
+#include "Core/SampledSpectrum.hpp"
 
 #include "Geometry/Frame.hpp"
+#include "IO/SpectralIORTable.hpp"
 #include "Materials/Material.hpp"
 #include "Microfacet/GGX.hpp" 
+#include "Textures/ImageTexture.hpp"
+
+#include <memory>
+#include <optional>
 
 namespace rayt {
 
-    class RoughConductor : public Material {
+    class RoughConductor final : public Material {
         Spectrum eta;   // Index of Refraction (Real)
         Spectrum k;     // Extinction Coefficient
         Real alpha_x;   // Roughness X
         Real alpha_y;   // Roughness Y (same as X if isotropic)
+        Real roughness;
+        Real anisotropy;
+        GGXDistribution dist; // Built once from alpha_x/alpha_y
+
+        // Optional per-texel roughness (scaled by `roughness`); null keeps `dist` for every hit.
+        std::shared_ptr<const ImageTexture> roughnessMap;
+
+        // Precomputed F(cos) for this (eta, k); null selects the exact path.
+        // Shared so that copies of the material (e.g. in a MaterialTable) reuse it.
+        std::shared_ptr<const fresnel::ConductorFresnelTable> fresnelTable;
+
+        // Measured n, k (optional); spectral mode evaluates them per path wavelength.
+        std::shared_ptr<const SpectralIORTable> measuredIOR;
 
     public:
         /**
@@ -35,114 +55,123 @@ namespace rayt {
          * @param k Imaginary part of IOR.
          * @param roughness Roughness value [0, 1].
          * @param anisotropy Anisotropy factor [-1, 1] (0 for isotropic).
+         * @param fresnelMode Exact complex-IOR Fresnel, or a table built here (see FresnelTable.hpp for its error bound).
+         * @param roughnessMap Optional grayscale map (ColorEncoding::Linear); roughness becomes roughness * map.
          */
-        RoughConductor(const Spectrum& eta, const Spectrum& k, Real roughness, Real anisotropy = 0.0)
-            : eta(eta), k(k) {
-
+        RoughConductor(const Spectrum& eta, const Spectrum& k, Real roughness, Real anisotropy = 0.0,
+            fresnel::ConductorFresnelMode fresnelMode = fresnel::ConductorFresnelMode::Exact,
+            std::shared_ptr<const ImageTexture> roughnessMap = nullptr)
             // Convert roughness to alpha (perceptually linear mapping)
-            Real aspect = std::sqrt(1.0 - anisotropy * 0.9);
-            alpha_x = MicrofacetDistribution::roughnessToAlpha(roughness / aspect);
-            alpha_y = MicrofacetDistribution::roughnessToAlpha(roughness * aspect);
+            : eta(eta), k(k),
+            alpha_x(MicrofacetDistribution::roughnessToAlpha(roughness / anisotropyAspect(anisotropy))),
+            alpha_y(MicrofacetDistribution::roughnessToAlpha(roughness * anisotropyAspect(anisotropy))),
+            roughness(roughness), anisotropy(anisotropy),
+            dist(alpha_x, alpha_y),
+            roughnessMap(std::move(roughnessMap)) {
+            if (fresnelMode == fresnel::ConductorFresnelMode::Tabulated)
+                fresnelTable = std::make_shared<const fresnel::ConductorFresnelTable>(eta, k);
         }
 
+        /**
+         * @brief Constructs a rough conductor from measured n, k data (e.g. Johnson & Christy).
+         * * RGB mode uses n, k at 650 / 550 / 450 nm (fresnelMode applies there);
+         * spectral mode evaluates them exactly at every path wavelength.
+         */
+        RoughConductor(std::shared_ptr<const SpectralIORTable> measured, Real roughness, Real anisotropy = 0.0,
+            fresnel::ConductorFresnelMode fresnelMode = fresnel::ConductorFresnelMode::Exact,
+            std::shared_ptr<const ImageTexture> roughnessMap = nullptr)
+            : RoughConductor(rgbFromMeasured(*measured, false), rgbFromMeasured(*measured, true),
+                roughness, anisotropy, fresnelMode, std::move(roughnessMap)) {
+            measuredIOR = std::move(measured);
+        }
+
+        /**
+         * @brief Maximum absolute Fresnel error of this material (0 on the exact path).
+         */
+        Real fresnelMaxError() const { return fresnelTable ? fresnelTable->maxError() : Real(0); }
+
         /**
          * @brief Evaluates the Cook-Torrance BRDF.
          */
-        Spectrum eval(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi,
-            TransportMode mode) const override {
-
-            Real cosThetaO = std::abs(glm::dot(rec.n, wo)); // n dot wo
-            Real cosThetaI = std::abs(glm::dot(rec.n, wi)); // n dot wi
-
-            // Ignore grazing angles or back-facing
-            if (cosThetaI == 0 || cosThetaO == 0) return Spectrum(0.0);
-            if (glm::dot(rec.gn, wi) <= 0 || glm::dot(rec.gn, wo) <= 0) return Spectrum(0.0); // Geometric normal check
-
-            // 1. Half vector
-            Vector3 wh = wi + wo;
-            if (wh.x == 0 && wh.y == 0 && wh.z == 0) return Spectrum(0.0);
-            wh = glm::normalize(wh);
-
-            // 2. Local Frame conversion
-            // The Distribution class assumes operations in Tangent Space.
-            // We need to transform World Space vectors to Local Space for D() and G().
-            frame::Frame frame(rec.n);
-            Vector3 wo_local = frame.worldToLocal(wo);
-            Vector3 wi_local = frame.worldToLocal(wi);
-            Vector3 wh_local = frame.worldToLocal(wh);
-
-            // 3. Create Distribution (On-the-fly is fine as it's lightweight)
-            GGXDistribution dist(alpha_x, alpha_y);
-
-            // 4. Evaluate Terms
-            Real D = dist.D(wh_local);
-            Real G = dist.G(wo_local, wi_local);
-            Spectrum F = fresnel::fresnelConductor(glm::dot(wh, wi), eta, k); // F using wh
-
-            // 5. Cook-Torrance Formula
-            return (D * G * F) / (4.0f * cosThetaI * cosThetaO);
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
+            return evalAndPdf(ctx, wi).f;
+        }
+
+        /**
+         * @brief Evaluates the BRDF and its VNDF sampling PDF in one pass.
+         * * The half vector, D(wh) and Lambda(wo) are shared:
+         * pdf = G1(wo) * D(wh) / (4 * |cos(theta_o)|), since the |wo.wh| of the
+         * VNDF cancels against the reflection Jacobian.
+         */
+        BSDFEval evalAndPdf(const BSDFContext& ctx, const Vector3& wi) const override {
+            BSDFEval result;
+
+            // Geometric normal check (both directions on the front side)
+            if (ctx.cosGeoO <= 0 || glm::dot(ctx.rec.gn, wi) <= 0) return result;
+
+            Vector3 wiLocal = ctx.toLocal(wi);
+            Real cosThetaO = std::abs(ctx.woLocal.z); // n dot wo
+            Real cosThetaI = std::abs(wiLocal.z);     // n dot wi
+
+            // Ignore grazing angles
+            if (cosThetaI == 0 || cosThetaO == 0) return result;
+
+            std::optional<GGXDistribution> scratch;
+            const GGXDistribution& ggx = distribution(ctx.rec, scratch);
+
+            // 1. Half vector (directly in tangent space)
+            Vector3 whLocal = ctx.woLocal + wiLocal;
+            if (whLocal.x == 0 && whLocal.y == 0 && whLocal.z == 0) return result;
+            whLocal = glm::normalize(whLocal);
+
+            // 2. Terms
+            Real D = ggx.D(whLocal);
+            Real lambdaO = ctx.lambdaO(ggx);
+            Real G = Real(1.0) / (Real(1.0) + lambdaO + ggx.lambda(wiLocal));
+            // 3. Cook-Torrance Formula (F using wh)
+            setValue(result, ctx, D * G, 4.0 * cosThetaI * cosThetaO, glm::dot(whLocal, wiLocal));
+            result.pdf = D / ((Real(1.0) + lambdaO) * 4.0 * cosThetaO);
+            return result;
         }
 
         /**
          * @brief Importance samples the GGX distribution (VNDF).
          */
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
 
             // Reflection only
-            if (glm::dot(rec.gn, wo) <= 0)
+            if (ctx.cosGeoO <= 0)
                 return std::nullopt;
 
             BSDFSample bsdfSample;
+            const Vector3& wo_local = ctx.woLocal;
+            std::optional<GGXDistribution> scratch;
+            const GGXDistribution& ggx = distribution(ctx.rec, scratch);
 
-            // 1. Setup Frame & Distribution
-            rayt::frame::Frame frame(rec.n);
-            Vector3 wo_local = frame.worldToLocal(wo);
-            GGXDistribution dist(alpha_x, alpha_y);
-
-            // 2. Sample micro-normal (wh) using VNDF
-            Vector3 wh_local = dist.sample_wh(wo_local, u);
-            Vector3 wh = frame.localToWorld(wh_local);
+            // 1. Sample micro-normal (wh) using VNDF
+            Vector3 wh_local = ggx.sample_wh(wo_local, u);
 
-            // 3. Reflect wo about wh to get wi
-            bsdfSample.wi = glm::reflect(-wo, wh);
-
-            if (glm::dot(rec.gn, bsdfSample.wi) <= 0)
-                return std::nullopt;
+            // 2. Reflect wo about wh to get wi
+            Real dot_wo_wh = glm::dot(wo_local, wh_local);
+            if (dot_wo_wh <= 0) return std::nullopt;
 
-            Vector3 wi_local = frame.worldToLocal(bsdfSample.wi);
+            Vector3 wi_local = Real(2.0) * dot_wo_wh * wh_local - wo_local;
+            bsdfSample.wi = ctx.toWorld(wi_local);
 
-            // 4. Sanity checks (geometric & shading normals)
-            if (glm::dot(rec.gn, bsdfSample.wi) <= 0) return std::nullopt; // Below surface
+            // 3. Sanity checks (geometric & shading normals)
+            if (glm::dot(ctx.rec.gn, bsdfSample.wi) <= 0) return std::nullopt; // Below surface
             if (wo_local.z == 0 || wi_local.z == 0) return std::nullopt;
 
-            // 5. Compute PDF
+            // 4. f and PDF from the shared terms
             // Jacobian transformation: dwh / dwi = 1 / (4 * (wo . wh))
-            Real dot_wo_wh = glm::dot(wo, wh);
-            if (dot_wo_wh <= 0) return std::nullopt;
-
-            Real pdf_wh = dist.pdf(wo_local, wh_local);
-            bsdfSample.pdf = pdf_wh / (4.0f * dot_wo_wh);
-
-            // 6. Evaluate Weight (f / pdf) directly to reduce variance
-            // f = D * G * F / (4 * cosI * cosO)
-            // pdf = D * G1 * (wo.wh) / (wo.z * 4 * (wo.wh)) ... (VNDF pdf simplified)
-            //
-            // However, to be safe and verify correctness first, we can just call eval() / pdf.
-            // But let's calculate F and G explicitly for clarity.
-
-            Spectrum F = fresnel::fresnelConductor(dot_wo_wh, eta, k);
-            Real G = dist.G(wo_local, wi_local);
-            Real D = dist.D(wh_local); // Usually cancels out in weight, but computed for completeness
-
-            // Correct Cook-Torrance weight with VNDF usually simplifies to: F * G2 / G1
-            // Let's stick to the standard definition for now:
-
-            bsdfSample.f = eval(rec, wo, bsdfSample.wi, mode);
-            // bsdfSample.sampledType = BxDFType(BSDF_GLOSSY | BSDF_REFLECTION);
+            Real D = ggx.D(wh_local);
+            Real lambdaO = ctx.lambdaO(ggx);
+            Real G = Real(1.0) / (Real(1.0) + lambdaO + ggx.lambda(wi_local));
+            Real cosThetaO = std::abs(wo_local.z);
+            Real cosThetaI = std::abs(wi_local.z);
+            setValue(bsdfSample, ctx, D * G, 4.0 * cosThetaI * cosThetaO, dot_wo_wh);
+            bsdfSample.pdf = D / ((Real(1.0) + lambdaO) * 4.0 * cosThetaO);
 
             if (bsdfSample.pdf <= 1e-6f || math::hasNaNs(bsdfSample.f)) return std::nullopt;
 
@@ -151,36 +180,104 @@ namespace rayt {
                 BxDFFlags::Reflection |
                 BxDFFlags::Glossy;
 
-
             return bsdfSample;
         }
 
         /**
          * @brief PDF evaluation.
          */
-        Real pdf(const SurfaceInteraction& rec,
-            const Vector3& wo, const Vector3& wi) const override {
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
 
-            if (glm::dot(rec.gn, wi) <= 0 || glm::dot(rec.gn, wo) <= 0) return 0.0;
+            if (ctx.cosGeoO <= 0 || glm::dot(ctx.rec.gn, wi) <= 0) return 0.0;
 
-            Vector3 wh = glm::normalize(wo + wi);
-            if (glm::dot(wh, wh) == 0)
+            Vector3 wh_local = ctx.woLocal + ctx.toLocal(wi);
+            if (glm::dot(wh_local, wh_local) == 0)
                 return 0.0;
-            wh = glm::normalize(wh);
-
-            rayt::frame::Frame frame(rec.n);
-            Vector3 wo_local = frame.worldToLocal(wo);
-            Vector3 wh_local = frame.worldToLocal(wh);
+            wh_local = glm::normalize(wh_local);
 
-            GGXDistribution dist(alpha_x, alpha_y);
-            Real pdf_wh = dist.pdf(wo_local, wh_local);
+            Real cosThetaO = std::abs(ctx.woLocal.z);
+            if (cosThetaO == 0) return 0.0;
 
-            // Transform PDF from half-vector to solid angle
-            return pdf_wh / (4.0f * std::abs(glm::dot(wo, wh)));
+            // VNDF pdf transformed from half-vector to solid angle
+            std::optional<GGXDistribution> scratch;
+            const GGXDistribution& ggx = distribution(ctx.rec, scratch);
+            return ggx.D(wh_local) / ((Real(1.0) + ctx.lambdaO(ggx)) * 4.0 * cosThetaO);
         }
 
         bool isSpecular() const override { return false; } // It is Glossy, not delta-Specular
 
+        /**
+         * @brief SG around the mirror direction of wo.
+         * * A GGX lobe of roughness alpha has a half-vector spread of about alpha / sqrt(2),
+         * doubled by the reflection, so sharpness = 1 / (2 alpha^2). That is its width in
+         * the plane of incidence, the wider of its two at grazing angles; the larger alpha
+         * is used for anisotropic surfaces, keeping the outline on the wide side.
+         */
+        std::optional<GlossyLobe> glossyLobe(const BSDFContext& ctx) const override {
+            if (ctx.cosGeoO <= 0) return std::nullopt;
+            std::optional<GGXDistribution> scratch;
+            const GGXDistribution& ggx = distribution(ctx.rec, scratch);
+            const Real alpha = std::max(ggx.alphaX(), ggx.alphaY());
+            return GlossyLobe{ glm::normalize(math::reflectOutward(ctx.wo, ctx.rec.n)), Real(1) / (Real(2) * alpha * alpha) };
+        }
+
+        std::optional<PreviewMaterial> previewMaterial(const SurfaceInteraction& rec) const override {
+            std::optional<GGXDistribution> scratch;
+            const GGXDistribution& ggx = distribution(rec, scratch);
+            PreviewMaterial p;
+            p.type = PreviewMaterial::Type::Conductor;
+            p.eta = eta;
+            p.k = k;
+            p.alpha = std::sqrt(ggx.alphaX() * ggx.alphaY());
+            return p;
+        }
+
+        bool usesTextures() const override { return roughnessMap || Material::usesTextures(); }
+
+    private:
+        /// The hit's distribution: the fixed one, or one rebuilt from the roughness map into scratch.
+        const GGXDistribution& distribution(const SurfaceInteraction& rec,
+            std::optional<GGXDistribution>& scratch) const {
+            if (!roughnessMap) return dist;
+            const Real r = roughness * roughnessMap->evaluateFloat(rec);
+            const Real aspect = anisotropyAspect(anisotropy);
+            return scratch.emplace(MicrofacetDistribution::roughnessToAlpha(r / aspect),
+                MicrofacetDistribution::roughnessToAlpha(r * aspect));
+        }
+
+        /// F(cos) from the table when present, otherwise the exact formula.
+        Spectrum fresnelTerm(Real cosThetaI) const {
+            return fresnelTable ? fresnelTable->eval(cosThetaI)
+                : fresnel::fresnelConductor(cosThetaI, eta, k);
+        }
+
+        /// Stores (DG * F) / denom into r: per wavelength for measured data in spectral mode, RGB otherwise.
+        template <typename Result>
+        void setValue(Result& r, const BSDFContext& ctx, Real DG, Real denom, Real cosThetaI) const {
+#if RAYT_SPECTRAL
+            if (measuredIOR && ctx.lambda) {
+                SampledSpectrum n, kk;
+                measuredIOR->evaluate(*ctx.lambda, n, kk);
+                r.setSpectral((DG * fresnel::fresnelConductor(cosThetaI, n, kk)) / denom);
+                return;
+            }
+#else
+            (void)ctx;
+#endif
+            r.f = (DG * fresnelTerm(cosThetaI)) / denom;
+        }
+
+        /// n (or k) of measured data at the RGB representative wavelengths.
+        static Spectrum rgbFromMeasured(const SpectralIORTable& ior, bool imaginary) {
+            auto part = [&](double wl) {
+                const std::complex<double> c = ior.evaluate(wl);
+                return imaginary ? c.imag() : c.real();
+            };
+            return Spectrum(part(650.0), part(550.0), part(450.0));
+        }
+
+        static Real anisotropyAspect(Real anisotropy) { return std::sqrt(1.0 - anisotropy * 0.9); }
+
     };
 
 } // namespace rayt
\ No newline at end of file
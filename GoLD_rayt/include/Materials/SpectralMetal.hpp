@@ -1,12 +1,16 @@
 ﻿#pragma once
 
 #include "Materials/Material.hpp"
-#include "IO/IORInterpolator.hpp"
+#include "IO/SpectralIORTable.hpp"
 #include "Core/Sampling.hpp"
+#include "Core/Fresnel.hpp"
+#include "Core/SampledSpectrum.hpp"
+
+#include <memory>
 
 namespace rayt {
 
-    class SpectralMetal : public Material {
+    class SpectralMetal final : public Material {
     public:
         // コンストラクタでCSVファイル名を指定
         // roughness: 表面の粗さ (0.0=鏡面, 1.0=ザラザラ)
@@ -14,8 +18,9 @@ namespace rayt {
             : m_roughness(std::min(roughness, (Real)1.0))
         {
             // CSVをロード
-            IORInterpolator ior;
-            if (!ior.loadCSV(csvPath)) {
+            // 波長グリッドに再標本化した表（2 回目以降はバイナリキャッシュから読む）
+            auto ior = std::make_shared<SpectralIORTable>();
+            if (!ior->loadCSV(csvPath)) {
                 std::cerr << "[Error] Failed to load IOR data: " << csvPath << std::endl;
                 // エラー時はデフォルトで銀のような値をセット
                 m_eta = Spectrum(0.05);
@@ -24,9 +29,9 @@ namespace rayt {
             else {
                 // R, G, B それぞれの代表波長における n, k を取得
                 // Red: 650nm, Green: 550nm, Blue: 450nm
-                auto complexR = ior.evaluate(650.0);
-                auto complexG = ior.evaluate(550.0);
-                auto complexB = ior.evaluate(450.0);
+                auto complexR = ior->evaluate(650.0);
+                auto complexG = ior->evaluate(550.0);
+                auto complexB = ior->evaluate(450.0);
 
                 m_eta = Spectrum(complexR.real(), complexG.real(), complexB.real());
                 m_k = Spectrum(complexR.imag(), complexG.imag(), complexB.imag());
@@ -35,6 +40,9 @@ namespace rayt {
                     << "  R(650nm): n=" << m_eta.r << ", k=" << m_k.r << "\n"
                     << "  G(550nm): n=" << m_eta.g << ", k=" << m_k.g << "\n"
                     << "  B(450nm): n=" << m_eta.b << ", k=" << m_k.b << std::endl;
+
+                // スペクトルモードではパスの波長ごとに n, k を評価するので実測データを保持
+                m_ior = std::move(ior);
             }
         }
 
@@ -45,7 +53,7 @@ namespace rayt {
         // 簡易実装として「ラフネスがある導体も特異点に近い」とみなして 0 を返すか、
         // あるいは完全鏡面として振る舞わせます。
         // ※今回は「sample」ですべて処理するタイプ（Delta分布扱い）として実装します。
-        Spectrum eval(const SurfaceInteraction& rec, const Vector3& wo, const Vector3& wi, TransportMode mode) const override {
+        Spectrum eval(const BSDFContext& ctx, const Vector3& wi) const override {
             return Spectrum(0.0);
         }
 
@@ -53,19 +61,21 @@ namespace rayt {
         // 2. pdf: 確率密度関数
         // ---------------------------------------------------------------------
         // Delta分布扱いなので 0
-        Real pdf(const SurfaceInteraction& rec, const Vector3& wo, const Vector3& wi) const override {
+        Real pdf(const BSDFContext& ctx, const Vector3& wi) const override {
             return 0.0;
         }
 
+        bool isSpecular() const override { return true; }
+
         // ---------------------------------------------------------------------
         // 3. sample: 次の方向を決定し、重みを計算
         // ---------------------------------------------------------------------
-        std::optional<BSDFSample> sample(const SurfaceInteraction& rec,
-            const Vector3& wo,
-            const Point2& u,
-            TransportMode mode) const override {
+        std::optional<BSDFSample> sample(const BSDFContext& ctx,
+            const Point2& u) const override {
 
             BSDFSample bsdfSample;
+            const SurfaceInteraction& rec = ctx.rec;
+            const Vector3& wo = ctx.wo;
 
             // (A) 反射方向の計算
             // 完全鏡面反射ベクトル
@@ -89,13 +99,23 @@ namespace rayt {
             // ラフネスがあっても、この簡易実装では「確率的に1方向を選ぶ」ので
             // 数学的には SPECULAR (デルタ分布) として扱ったほうがIntegratorとの相性が良いです。
             // (GLOSSYにすると pdf の計算が必要になるため)
-            bsdfSample.sampledType = BxDFType(BSDF_SPECULAR | BSDF_REFLECTION);
+            bsdfSample.flags = BxDFFlags::Specular | BxDFFlags::Reflection;
             bsdfSample.pdf = 1.0;
 
             // (E) フレネル反射率の計算 (複素数)
             // 視線ベクトル wo と法線 n の角度を使います (厳密にはハーフベクトルですが、ここでは wo・n で近似)
             Real cosThetaI = std::clamp(glm::dot(wo, rec.n), (Real)0.0, (Real)1.0);
 
+#if RAYT_SPECTRAL
+            // スペクトルモード: 3 波長に潰さず、パスの各波長で実測 n, k から計算
+            if (m_ior && ctx.lambda) {
+                SampledSpectrum n, k;
+                m_ior->evaluate(*ctx.lambda, n, k);
+                bsdfSample.setSpectral(fresnel::fresnelConductor(cosThetaI, n, k));
+                return bsdfSample;
+            }
+#endif
+
             Spectrum F;
             F.r = fresnelConductorExact(cosThetaI, m_eta.r, m_k.r);
             F.g = fresnelConductorExact(cosThetaI, m_eta.g, m_k.g);
@@ -150,6 +170,7 @@ namespace rayt {
         Spectrum m_eta; // 屈折率 n
         Spectrum m_k;   // 消衰係数 k
         Real m_roughness;
+        std::shared_ptr<const SpectralIORTable> m_ior; // 実測データ（読み込み失敗時は null）
     };
 
 }
\ No newline at end of file
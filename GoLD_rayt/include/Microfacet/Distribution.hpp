@@ -40,6 +40,9 @@ namespace rayt {
 
         virtual ~MicrofacetDistribution() = default;
 
+        Real alphaX() const { return alpha_x; }
+        Real alphaY() const { return alpha_y; }
+
         /**
          * @brief The Normal Distribution Function (NDF), D(wh).
          * Describes the statistical concentration of micro-normals 'wh'.
@@ -16,7 +16,7 @@
 
 namespace rayt {
 
-    class GGXDistribution : public MicrofacetDistribution {
+    class GGXDistribution final : public MicrofacetDistribution {
     public:
         /**
          * @brief Constructs an anisotropic GGX distribution.
@@ -0,0 +1,239 @@
+#pragma once
+
+/**
+ * @file GGXBatch.hpp
+ * @brief Batched (SoA, 4-wide SIMD) versions of the GGX kernels.
+ * * GGXDistribution works on one direction at a time in double precision. When
+ * many directions share one roughness - a wavefront shading stage that has
+ * sorted its hits by material, or several NEE samples at one vertex - the
+ * same math can run on four float lanes at a time. Inputs and outputs are
+ * structure-of-arrays (DirectionBatch + plain float arrays).
+ * * Results match GGXDistribution to float precision (see
+ * rayt::debug::TestGGXBatch for the measured error), with two deliberate
+ * differences at measure-zero inputs: lambda(w) is 0 instead of NaN for
+ * w = (0, 0, 1), and no lane ever calls std::cos/std::sin (simd::sincos).
+ */
+
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Constants.hpp"
+#include "Core/Simd.hpp"
+#include "Microfacet/GGX.hpp"
+
+namespace rayt {
+
+    /**
+     * @brief Structure-of-arrays block of directions, padded to whole SIMD lanes.
+     * * Padding entries are (0, 0, 1) so the unused lanes stay finite.
+     */
+    struct DirectionBatch {
+        std::vector<float> x, y, z;
+
+        DirectionBatch() = default;
+        explicit DirectionBatch(size_t n) { resize(n); }
+
+        void resize(size_t n) {
+            m_count = n;
+            const size_t padded = simd::roundUpToLanes(n);
+            x.assign(padded, 0.0f);
+            y.assign(padded, 0.0f);
+            z.assign(padded, 1.0f);
+        }
+
+        /// Number of valid directions (excluding padding).
+        size_t size() const { return m_count; }
+        /// Number of SIMD lanes groups covering size().
+        size_t laneGroups() const { return x.size() / simd::LANES; }
+
+        void set(size_t i, const Vector3& v) {
+            x[i] = float(v.x); y[i] = float(v.y); z[i] = float(v.z);
+        }
+        Vector3 get(size_t i) const { return Vector3(x[i], y[i], z[i]); }
+
+    private:
+        size_t m_count = 0;
+    };
+
+    /**
+     * @brief GGX kernels evaluated for a batch of directions with one roughness.
+     * * Every plain float array (random numbers in, results out) must hold at
+     * least simd::roundUpToLanes(n) floats, where n is the batch size.
+     */
+    class GGXBatch {
+    public:
+        GGXBatch(Real ax, Real ay) : GGXBatch(GGXDistribution(ax, ay)) {}
+
+        /// Uses the (clamped) roughness of an existing distribution.
+        explicit GGXBatch(const GGXDistribution& dist)
+            : m_ax(float(dist.alphaX())), m_ay(float(dist.alphaY())) {}
+
+        /// D(wh) per direction.
+        void D(const DirectionBatch& wh, float* out) const {
+            for (size_t g = 0; g < wh.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                D4(load(wh.x, i), load(wh.y, i), load(wh.z, i)).store(out + i);
+            }
+        }
+
+        /// Smith lambda(w) per direction.
+        void lambda(const DirectionBatch& w, float* out) const {
+            for (size_t g = 0; g < w.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                lambda4(load(w.x, i), load(w.y, i), load(w.z, i)).store(out + i);
+            }
+        }
+
+        /// G1(w) = 1 / (1 + lambda(w)) per direction.
+        void G1(const DirectionBatch& w, float* out) const {
+            for (size_t g = 0; g < w.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                const simd::Float4 l = lambda4(load(w.x, i), load(w.y, i), load(w.z, i));
+                (simd::Float4(1.0f) / (simd::Float4(1.0f) + l)).store(out + i);
+            }
+        }
+
+        /// Height-correlated G(wo, wi) = 1 / (1 + lambda(wo) + lambda(wi)) per pair.
+        void G(const DirectionBatch& wo, const DirectionBatch& wi, float* out) const {
+            for (size_t g = 0; g < wi.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                const simd::Float4 lo = lambda4(load(wo.x, i), load(wo.y, i), load(wo.z, i));
+                const simd::Float4 li = lambda4(load(wi.x, i), load(wi.y, i), load(wi.z, i));
+                (simd::Float4(1.0f) / (simd::Float4(1.0f) + lo + li)).store(out + i);
+            }
+        }
+
+        /**
+         * @brief VNDF pdf of wh, one wo per lane (wavefront stage).
+         * pdf = G1(wo) * |wo.wh| * D(wh) / |wo.z|
+         */
+        void pdf(const DirectionBatch& wo, const DirectionBatch& wh, float* out) const {
+            for (size_t g = 0; g < wh.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                const simd::Float4 ox = load(wo.x, i), oy = load(wo.y, i), oz = load(wo.z, i);
+                const simd::Float4 hx = load(wh.x, i), hy = load(wh.y, i), hz = load(wh.z, i);
+                const simd::Float4 g1 = simd::Float4(1.0f) / (simd::Float4(1.0f) + lambda4(ox, oy, oz));
+                pdf4(g1, ox, oy, oz, hx, hy, hz).store(out + i);
+            }
+        }
+
+        /**
+         * @brief VNDF pdf of wh for a single shared wo (multi-sample NEE at one vertex).
+         */
+        void pdf(const Vector3& wo, const DirectionBatch& wh, float* out) const {
+            const simd::Float4 ox(float(wo.x)), oy(float(wo.y)), oz(float(wo.z));
+            const simd::Float4 g1 = simd::Float4(1.0f) / (simd::Float4(1.0f) + lambda4(ox, oy, oz));
+            for (size_t g = 0; g < wh.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                pdf4(g1, ox, oy, oz, load(wh.x, i), load(wh.y, i), load(wh.z, i)).store(out + i);
+            }
+        }
+
+        /**
+         * @brief VNDF samples (Heitz 2018), one wo and one (u1, u2) per lane.
+         * @param wo Outgoing directions in the upper hemisphere (local space).
+         * @param u1 First random number per lane (radius).
+         * @param u2 Second random number per lane (angle).
+         * @param wh Receives the sampled micro-normals; resized to wo.size().
+         */
+        void sample_wh(const DirectionBatch& wo, const float* u1, const float* u2, DirectionBatch& wh) const {
+            wh.resize(wo.size());
+            for (size_t g = 0; g < wo.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                Basis4 b = basis4(load(wo.x, i), load(wo.y, i), load(wo.z, i));
+                sample4(b, simd::Float4::load(u1 + i), simd::Float4::load(u2 + i), wh, i);
+            }
+        }
+
+        /**
+         * @brief n VNDF samples for a single shared wo; the stretched basis is built once.
+         */
+        void sample_wh(const Vector3& wo, const float* u1, const float* u2, size_t n, DirectionBatch& wh) const {
+            wh.resize(n);
+            const Basis4 b = basis4(simd::Float4(float(wo.x)), simd::Float4(float(wo.y)), simd::Float4(float(wo.z)));
+            for (size_t g = 0; g < wh.laneGroups(); ++g) {
+                const size_t i = g * simd::LANES;
+                sample4(b, simd::Float4::load(u1 + i), simd::Float4::load(u2 + i), wh, i);
+            }
+        }
+
+    private:
+        using F4 = simd::Float4;
+
+        /// Stretched view direction Vh and its tangent frame (T1, T2).
+        struct Basis4 {
+            F4 vx, vy, vz;
+            F4 t1x, t1y;           // T1.z == 0
+            F4 t2x, t2y, t2z;
+        };
+
+        static F4 load(const std::vector<float>& v, size_t i) { return F4::load(v.data() + i); }
+
+        F4 D4(F4 x, F4 y, F4 z) const {
+            const F4 x2 = x * x, y2 = y * y, z2 = z * z;
+            const F4 e = x2 / F4(m_ax * m_ax) + y2 / F4(m_ay * m_ay) + z2;
+            const F4 d = F4(1.0f) / (F4(float(constants::PI) * m_ax * m_ay) * e * e);
+            return simd::select(z2 == F4(0.0f), F4(0.0f), d); // horizon, as in the scalar version
+        }
+
+        /// alpha^2(phi) * tan^2(theta) folded into one division: (x^2 ax^2 + y^2 ay^2) / z^2
+        F4 lambda4(F4 x, F4 y, F4 z) const {
+            const F4 z2 = z * z;
+            const F4 ax = x * F4(m_ax), ay = y * F4(m_ay);
+            const F4 a2t2 = (ax * ax + ay * ay) / z2;
+            const F4 l = F4(0.5f) * (simd::sqrt(F4(1.0f) + a2t2) - F4(1.0f));
+            return simd::select(z2 == F4(0.0f), F4(0.0f), l);
+        }
+
+        F4 pdf4(F4 g1, F4 ox, F4 oy, F4 oz, F4 hx, F4 hy, F4 hz) const {
+            const F4 dot = simd::abs(ox * hx + oy * hy + oz * hz);
+            return g1 * dot * D4(hx, hy, hz) / simd::abs(oz);
+        }
+
+        Basis4 basis4(F4 ox, F4 oy, F4 oz) const {
+            Basis4 b;
+            F4 vx = F4(m_ax) * ox, vy = F4(m_ay) * oy, vz = oz;
+            const F4 invLen = F4(1.0f) / simd::sqrt(vx * vx + vy * vy + vz * vz);
+            b.vx = vx * invLen; b.vy = vy * invLen; b.vz = vz * invLen;
+
+            const F4 lenSq = b.vx * b.vx + b.vy * b.vy;
+            const simd::Mask4 hasT = lenSq > F4(0.0f);
+            const F4 invT = F4(1.0f) / simd::sqrt(simd::select(hasT, lenSq, F4(1.0f)));
+            b.t1x = simd::select(hasT, -b.vy * invT, F4(1.0f));
+            b.t1y = simd::select(hasT, b.vx * invT, F4(0.0f));
+
+            // T2 = cross(Vh, T1) with T1.z = 0
+            b.t2x = -b.vz * b.t1y;
+            b.t2y = b.vz * b.t1x;
+            b.t2z = b.vx * b.t1y - b.vy * b.t1x;
+            return b;
+        }
+
+        void sample4(const Basis4& b, F4 u1, F4 u2, DirectionBatch& wh, size_t i) const {
+            const F4 r = simd::sqrt(u1);
+            F4 sinPhi, cosPhi;
+            simd::sincos(F4(float(2.0 * constants::PI)) * u2, sinPhi, cosPhi);
+            const F4 t1 = r * cosPhi;
+            F4 t2 = r * sinPhi;
+
+            const F4 s = F4(0.5f) * (F4(1.0f) + b.vz);
+            t2 = (F4(1.0f) - s) * simd::sqrt(simd::max(F4(0.0f), F4(1.0f) - t1 * t1)) + s * t2;
+
+            const F4 nz = simd::sqrt(simd::max(F4(0.0f), F4(1.0f) - t1 * t1 - t2 * t2));
+            const F4 hx = t1 * b.t1x + t2 * b.t2x + nz * b.vx;
+            const F4 hy = t1 * b.t1y + t2 * b.t2y + nz * b.vy;
+            const F4 hz = t2 * b.t2z + nz * b.vz;
+
+            // Unstretch and normalize
+            const F4 ex = F4(m_ax) * hx, ey = F4(m_ay) * hy, ez = simd::max(F4(0.0f), hz);
+            const F4 invLen = F4(1.0f) / simd::sqrt(ex * ex + ey * ey + ez * ez);
+            (ex * invLen).store(wh.x.data() + i);
+            (ey * invLen).store(wh.y.data() + i);
+            (ez * invLen).store(wh.z.data() + i);
+        }
+
+        float m_ax;
+        float m_ay;
+    };
+
+} // namespace rayt
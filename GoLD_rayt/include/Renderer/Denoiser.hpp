@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * @file Denoiser.hpp
+ * @brief Feature-guided edge-avoiding a-trous denoiser for a Film with AOVs.
+ * * Dammertz et al., "Edge-Avoiding A-Trous Wavelet Transform for fast Global
+ * Illumination Filtering" (2010), with the variance-driven luminance weight of
+ * Schied et al., "Spatiotemporal Variance-Guided Filtering" (2017), without
+ * the temporal part. The beauty is divided by the albedo AOV, so the filter
+ * only blurs illumination and texture detail survives; it is multiplied back
+ * at the end.
+ * * Each pass is a 5x5 B3-spline kernel with its taps 2^i pixels apart, so five
+ * passes reach 125 pixels across at 25 taps each. A tap q of pixel p weighs
+ *     h(q) * max(0, n_p . n_q)^sigmaNormal
+ *          * exp(-|z_p - z_q| / (sigmaDepth |grad z_p| |p - q|)
+ *                -|l_p - l_q| / (sigmaLuminance sqrt(Var l_p)))
+ * and nothing when the two pixels have different material ids (or one of them
+ * saw the background), where l is the demodulated luminance and Var l its
+ * variance, taken from the Variance AOV (a 3x3 spatial estimate without it,
+ * or in pixels with fewer than 4 samples) and carried through the passes as
+ * sum(w^2 Var) / sum(w)^2.
+ * * The work is done on float planes four pixels at a time (Core/Simd.hpp),
+ * in bands of rows across all hardware threads.
+ */
+
+#include "Renderer/Film.hpp"
+
+namespace rayt {
+
+    struct DenoiserSettings {
+        int iterations = 5;            ///< A-trous passes (1-8); the last uses taps 2^(iterations-1) apart.
+        float sigmaLuminance = 4.0f;   ///< Luminance edge stop, in standard deviations of the noise.
+        int sigmaNormal = 128;         ///< Exponent of the normal edge stop.
+        float sigmaDepth = 1.0f;       ///< Depth edge stop, in multiples of the local depth gradient.
+    };
+
+    /**
+     * @brief Replaces the film's beauty by its denoised version (AOVs are left as they are).
+     * * Needs the Albedo and Normal AOVs; Depth, MaterialId and Variance are used when enabled.
+     * Splats are resolved into the result, which is stored as one sample per pixel.
+     * @throws std::runtime_error If the film has no Albedo or no Normal AOV.
+     */
+    void denoise(Film& film, const DenoiserSettings& settings = {});
+
+} // namespace rayt
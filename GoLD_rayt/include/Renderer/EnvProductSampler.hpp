@@ -0,0 +1,343 @@
+#pragma once
+
+/**
+ * @file EnvProductSampler.hpp
+ * @brief Environment x glossy-lobe product sampling by hierarchical warping.
+ * * Env NEE draws directions by radiance alone. For a glossy conductor most of
+ * them land where the BSDF is ~0, while BSDF sampling misses small bright
+ * sources, so even with MIS the glossy highlights stay noisy. This sampler
+ * draws directions proportional to (env luminance) x (GlossyLobe) instead.
+ * * The environment's luminance is resampled once into a quadtree (a mip pyramid
+ * of sums) over the equal-area octahedral square (EqualAreaMapping.hpp), so
+ * every node at a level covers the same solid angle. A sample walks down from
+ * the root: at each level one of the four children is picked with probability
+ * proportional to its luminance sum times the lobe's bound over the child.
+ * Once nodes are narrower than the lobe that factor is nearly constant inside
+ * them, so the rest of the walk uses the luminance alone, down to a leaf, and
+ * the direction is uniform in the leaf. Both u components are remapped level
+ * by level (Clarberg et al. 2005, "Wavelet importance sampling"; McCool &
+ * Harwood 1997), so the walk consumes about one bit of each per level.
+ * * The lobe factor of a node is the lobe's maximum over the node's bounding
+ * cone, its value at the cone point closest to the lobe axis. Unlike a value
+ * at the node's center, the bound never underrates a node the lobe peaks in,
+ * however broad the lobe is against the node, so lobes of GGX alpha up to
+ * ~0.35 are accepted.
+ * * The lobe is a Gaussian stand-in for GGX, whose tails are much heavier, so
+ * half of the samples walk by luminance alone (a defensive mixture): a small
+ * bright source in the tail then keeps the pdf plain env sampling would give
+ * it instead of being left to BSDF sampling. The luminance walk's pdf is
+ * leaf / root, so the mixture costs nothing extra to evaluate.
+ * * Only lobes that handles() accepts are worth the walk: a lobe broader than a
+ * few tens of degrees barely reshapes the env distribution, and one narrower
+ * than a leaf is left to BSDF sampling, which draws it exactly, while the
+ * walk could only place a sample somewhere inside the leaf.
+ * * Even so it does not pay for itself on the gold scene (roughness 0.2 to
+ * 0.5 under grace-new.hdr): a sample costs about twice an EnvMap one and the
+ * variance it removes is offset by the Gaussian's mismatch with GGX.
+ * DebugTools/EnvDebug's equal-time test finds it a little ahead of env NEE
+ * at roughness 0.2 and behind at 0.5 and on the floor the gold lights, so
+ * main.cpp leaves it off. PathIntegrator::setEnvProductSampler opts in.
+ * * Each level is stored in Morton order, so a node's four children are
+ * adjacent: one cache line per level for the sums and one for the bounds.
+ * pdf() replays the walk for a given direction; the luminance-only levels
+ * telescope to leaf sum / node sum, so it costs four lobe evaluations per
+ * product level and no search.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Constants.hpp"
+#include "Core/EqualAreaMapping.hpp"
+#include "Core/Parallel.hpp"
+#include "IO/EnvMap.hpp"
+#include "Materials/Material.hpp"
+
+namespace rayt {
+
+    class EnvProductSampler {
+    public:
+        /// Leaves = 4^DEFAULT_LEVELS (1024^2, about 0.2 degrees each; a 2K equirect map has ~2000^2 texels).
+        static constexpr int DEFAULT_LEVELS = 10;
+
+        /// Deepest level the lobe can weight; its nodes are ~0.5 degrees, finer than any lobe we sample.
+        static constexpr int MAX_LOBE_LEVEL = 8;
+
+        /**
+         * @brief Builds the luminance pyramid and node bounds for env.
+         * @param env    The environment to sample; radiance is still looked up through it.
+         * @param levels Pyramid depth; the leaves are 2^levels on a side.
+         */
+        explicit EnvProductSampler(std::shared_ptr<const EnvMap> env, int levels = DEFAULT_LEVELS)
+            : m_env(std::move(env)), m_levels(std::clamp(levels, 1, 12)) {
+            const int res = 1 << m_levels;
+            m_sum.resize(levelOffset(m_levels + 1));
+
+            // Leaves: mean luminance over a 2x2 grid of directions per leaf (closer than a 2K map's texels)
+            constexpr int SUB = 2;
+            float* leaves = &m_sum[levelOffset(m_levels)];
+            parallelFor(res, 8, [&](int begin, int end) {
+                for (int y = begin; y < end; ++y)
+                    for (int x = 0; x < res; ++x) {
+                        Real sum = 0;
+                        for (int sy = 0; sy < SUB; ++sy)
+                            for (int sx = 0; sx < SUB; ++sx) {
+                                const Vector3 d = equalAreaSquareToSphere((x + (sx + Real(0.5)) / SUB) / res,
+                                    (y + (sy + Real(0.5)) / SUB) / res);
+                                sum += std::max(luminance(m_env->eval(d)), Real(0));
+                            }
+                        leaves[morton(x, y)] = float(sum / (SUB * SUB));
+                    }
+                });
+
+            // Inner nodes: sums of their four children, which Morton order keeps adjacent
+            for (int l = m_levels - 1; l >= 0; --l) {
+                const float* c = &m_sum[levelOffset(l + 1)];
+                float* parent = &m_sum[levelOffset(l)];
+                for (size_t i = 0, n = size_t(1) << (2 * l); i < n; ++i)
+                    parent[i] = c[4 * i] + c[4 * i + 1] + c[4 * i + 2] + c[4 * i + 3];
+            }
+
+            // Bounding cones: center direction, and the widest angle to a grid of points on the node
+            const int lobeLevels = std::min(m_levels, MAX_LOBE_LEVEL);
+            m_bounds.resize(levelOffset(lobeLevels + 1));
+            m_levelRadius.resize(lobeLevels + 1);
+            for (int l = 0; l <= lobeLevels; ++l) {
+                const int n = 1 << l;
+                const int grid = l < 4 ? 16 : 4;
+                std::vector<Real> widest(n, Real(-1));
+                parallelFor(n, 8, [&](int begin, int end) {
+                    for (int y = begin; y < end; ++y)
+                        for (int x = 0; x < n; ++x) {
+                            const Vector3 c = equalAreaSquareToSphere((x + Real(0.5)) / n, (y + Real(0.5)) / n);
+                            Real cosR = 1;
+                            for (int j = 0; j <= grid; ++j)
+                                for (int i = 0; i <= grid; ++i)
+                                    cosR = std::min(cosR, glm::dot(c, equalAreaSquareToSphere(
+                                        (x + Real(i) / grid) / n, (y + Real(j) / grid) / n)));
+                            // Widen slightly: the grid can miss the farthest point between its samples
+                            const Real r = std::min(std::acos(std::clamp(cosR, Real(-1), Real(1))) * Real(1.05), constants::PI);
+                            m_bounds[levelOffset(l) + morton(x, y)] = { float(c.x), float(c.y), float(c.z), float(std::cos(r)) };
+                            widest[y] = std::max(widest[y], r);
+                        }
+                    });
+                m_levelRadius[l] = *std::max_element(widest.begin(), widest.end());
+            }
+        }
+
+        /**
+         * @brief Samples wi proportionally to env luminance x lobe (mixed with luminance alone).
+         * @param lobe The glossy lobe at the shading point.
+         * @param u    2D uniform random in [0,1)^2.
+         * @param wi   [out] Sampled direction (world).
+         * @param pdfW [out] pdf w.r.t. solid angle; 0 if the environment is black.
+         * @return Le from the sampled direction.
+         */
+        Vector3 sample(const GlossyLobe& lobe, const Point2& u, Vector3& wi, Real& pdfW) const {
+            pdfW = Real(0);
+            if (!(m_sum[0] > 0.0f)) return Vector3(0.0);
+            double ux = std::min(double(u.x), ONE_MINUS_EPSILON);
+            double uy = std::min(double(u.y), ONE_MINUS_EPSILON);
+
+            // Pick the strategy with u.x, then reuse it for the walk
+            const bool luminanceOnly = ux < LUMINANCE_FRACTION;
+            ux = luminanceOnly ? ux / LUMINANCE_FRACTION : (ux - LUMINANCE_FRACTION) / (1.0 - LUMINANCE_FRACTION);
+            ux = std::min(ux, ONE_MINUS_EPSILON);
+            const int productLevels = productDepth(lobe);
+
+            int x = 0, y = 0;
+            size_t node = 0; // Morton index within the level
+            Real p = 1;
+            for (int l = 1; l <= m_levels; ++l) {
+                const bool product = !luminanceOnly && l <= productLevels;
+                float w[4];
+                childWeights(l, node, product, lobe, w);
+
+                // Row first (w[0] + w[1] is the y = 0 row), then the column within it
+                const float total = w[0] + w[1] + w[2] + w[3];
+                const int row = pick(w[0] + w[1], total, uy);
+                const float* r = &w[2 * row];
+                const int col = pick(r[0], r[0] + r[1], ux);
+
+                if (product) p *= Real(r[col]) / Real(total);
+                node = 4 * node + 2 * row + col;
+                x = 2 * x + col;
+                y = 2 * y + row;
+            }
+
+            // Keep off the leaf's edges, where the mapping's round trip in pdf() could land in the neighbor
+            const Real res = Real(1 << m_levels);
+            ux = std::clamp(ux, LEAF_MARGIN, 1.0 - LEAF_MARGIN);
+            uy = std::clamp(uy, LEAF_MARGIN, 1.0 - LEAF_MARGIN);
+            wi = equalAreaSquareToSphere((x + ux) / res, (y + uy) / res);
+
+            // The other strategy's probability of the same leaf: replayed for the product, free for luminance
+            if (luminanceOnly) p = productProbability(lobe, node, productLevels);
+            else p *= leafOverNode(node, productLevels);
+            pdfW = mixedPdf(node, p);
+            return m_env->eval(wi);
+        }
+
+        /**
+         * @brief Solid-angle pdf of sample() returning wi for this lobe.
+         */
+        Real pdf(const GlossyLobe& lobe, const Vector3& wi) const {
+            if (!(m_sum[0] > 0.0f)) return Real(0);
+            Real u, v;
+            equalAreaSphereToSquare(glm::normalize(wi), u, v);
+            const int res = 1 << m_levels;
+            const size_t leaf = morton(std::clamp(int(u * res), 0, res - 1), std::clamp(int(v * res), 0, res - 1));
+            return mixedPdf(leaf, productProbability(lobe, leaf, productDepth(lobe)));
+        }
+
+        /**
+         * @brief Whether product sampling pays off for this lobe (see the file comment).
+         * * Callers sample the plain EnvMap otherwise, and must use the same test for its pdf.
+         */
+        bool handles(const GlossyLobe& lobe) const {
+            const Real spread = Real(1) / std::sqrt(std::max(lobe.sharpness, Real(1e-6)));
+            return spread <= MAX_LOBE_SPREAD && spread >= m_levelRadius.back();
+        }
+
+        /// Bytes held by the pyramid and the node bounds.
+        size_t memoryBytes() const { return m_sum.size() * sizeof(float) + m_bounds.size() * sizeof(NodeBound); }
+
+    private:
+        static constexpr double ONE_MINUS_EPSILON = 0x1.fffffffffffffp-1;
+        static constexpr double LEAF_MARGIN = 1e-4;
+
+        /// Share of samples that walk by luminance alone.
+        static constexpr Real LUMINANCE_FRACTION = 0.5;
+
+        /// Broadest lobe handles() accepts, in radians (GGX alpha ~0.35).
+        static constexpr Real MAX_LOBE_SPREAD = 0.5;
+
+        /// How narrow a node must be, in lobe spreads, before the lobe is treated as constant over it.
+        static constexpr Real LOBE_RESOLUTION = 2;
+
+        struct NodeBound {
+            float x, y, z;  ///< Center direction.
+            float cosR;     ///< cos r for the cone half-angle r around it covering the node.
+        };
+
+        static size_t levelOffset(int l) { return ((size_t(1) << (2 * l)) - 1) / 3; }
+
+        /// Interleaves the bits of x (even) and y (odd): the four children of node i are 4i .. 4i + 3.
+        static size_t morton(int x, int y) {
+            auto spread = [](uint32_t v) {
+                v = (v | (v << 8)) & 0x00FF00FFu;
+                v = (v | (v << 4)) & 0x0F0F0F0Fu;
+                v = (v | (v << 2)) & 0x33333333u;
+                v = (v | (v << 1)) & 0x55555555u;
+                return v;
+            };
+            return size_t(spread(uint32_t(x)) | (spread(uint32_t(y)) << 1));
+        }
+
+        static Real luminance(const Vector3& rgb) {
+            return Real(0.2126) * rgb.x + Real(0.7152) * rgb.y + Real(0.0722) * rgb.z;
+        }
+
+        /// Levels (from 1) whose children are weighted by the lobe: until nodes are LOBE_RESOLUTION spreads wide.
+        int productDepth(const GlossyLobe& lobe) const {
+            const int deepest = int(m_levelRadius.size()) - 1;
+            const Real spread = Real(1) / std::sqrt(std::max(lobe.sharpness, Real(1e-6)));
+            int l = 1;
+            while (l < deepest && m_levelRadius[l] > LOBE_RESOLUTION * spread) ++l;
+            return l;
+        }
+
+        /// log2 of the lobe's maximum over a node's cone: its value at the cone point closest to the axis.
+        static float log2Lobe(const NodeBound& b, const GlossyLobe& lobe) {
+            constexpr float LOG2E = 1.44269504f;
+            const float cosT = float(lobe.axis.x) * b.x + float(lobe.axis.y) * b.y + float(lobe.axis.z) * b.z;
+            if (cosT >= b.cosR) return 0.0f; // the axis is inside the cone
+            // cos(theta - r), theta being the angle from the axis to the cone's center
+            const float sinT = std::sqrt(std::max(0.0f, 1.0f - cosT * cosT));
+            const float sinR = std::sqrt(std::max(0.0f, 1.0f - b.cosR * b.cosR));
+            return LOG2E * float(lobe.sharpness) * (cosT * b.cosR + sinT * sinR - 1.0f);
+        }
+
+        /**
+         * 2^t for t <= 0, to ~1e-4 relative: the exponent bits plus a cubic for the fraction.
+         * Child weights only need to be consistent between sample() and pdf(), not exact.
+         */
+        static float fastExp2(float t) {
+            t = std::max(t, -126.0f);
+            const float i = std::floor(t);
+            const float f = t - i;
+            const float frac = 1.0f + f * (0.6951786f + f * (0.2261475f + f * 0.0781440f));
+            return std::bit_cast<float>(int32_t(i + 127.0f) << 23) * frac;
+        }
+
+        /// Weights of the four children (row-major: (0,0), (1,0), (0,1), (1,1)) of node `parent` at level l - 1.
+        void childWeights(int l, size_t parent, bool product, const GlossyLobe& lobe, float w[4]) const {
+            const size_t first = levelOffset(l) + 4 * parent;
+            const float* sum = &m_sum[first];
+            if (!product) {
+                for (int k = 0; k < 4; ++k) w[k] = sum[k];
+                return;
+            }
+            // Only ratios matter within a level: relative to the strongest lit child, so a sharp lobe cannot underflow them all
+            const NodeBound* bound = &m_bounds[first];
+            float e[4];
+            float eMax = -std::numeric_limits<float>::infinity();
+            for (int k = 0; k < 4; ++k) {
+                e[k] = log2Lobe(bound[k], lobe);
+                if (sum[k] > 0.0f) eMax = std::max(eMax, e[k]);
+            }
+            for (int k = 0; k < 4; ++k) w[k] = sum[k] > 0.0f ? sum[k] * fastExp2(e[k] - eMax) : 0.0f;
+        }
+
+        /// Probability of the product walk reaching `leaf`: replays the lobe levels, then leaf / node.
+        Real productProbability(const GlossyLobe& lobe, size_t leaf, int productLevels) const {
+            Real p = 1;
+            for (int l = 1; l <= productLevels; ++l) {
+                const size_t node = leaf >> (2 * (m_levels - l));
+                float w[4];
+                childWeights(l, node >> 2, true, lobe, w);
+                const float chosen = w[node & 3];
+                if (!(chosen > 0.0f)) return Real(0);
+                p *= Real(chosen) / Real(w[0] + w[1] + w[2] + w[3]);
+            }
+            return p * leafOverNode(leaf, productLevels);
+        }
+
+        /// Luminance-only levels below level l telescope to leaf sum / node sum.
+        Real leafOverNode(size_t leaf, int l) const {
+            const float node = m_sum[levelOffset(l) + (leaf >> (2 * (m_levels - l)))];
+            return node > 0.0f ? Real(m_sum[levelOffset(m_levels) + leaf]) / Real(node) : Real(0);
+        }
+
+        /// Solid-angle pdf of the mixture at `leaf`, given the product walk's probability of it.
+        Real mixedPdf(size_t leaf, Real productP) const {
+            const Real luminanceP = Real(m_sum[levelOffset(m_levels) + leaf]) / Real(m_sum[0]);
+            const Real res = Real(1 << m_levels);
+            return (LUMINANCE_FRACTION * luminanceP + (1 - LUMINANCE_FRACTION) * productP) * res * res * constants::INV_FOUR_PI;
+        }
+
+        /// Picks 0 with probability first / total and rescales u to [0, 1) within the choice.
+        static int pick(float first, float total, double& u) {
+            const double p0 = double(first) / double(total);
+            if (u < p0) {
+                u = std::min(u / p0, ONE_MINUS_EPSILON);
+                return 0;
+            }
+            u = std::min((u - p0) / (1.0 - p0), ONE_MINUS_EPSILON);
+            return 1;
+        }
+
+        std::shared_ptr<const EnvMap> m_env;
+        int m_levels;
+        std::vector<float> m_sum;         ///< Luminance sums, level by level (level l: 4^l nodes in Morton order).
+        std::vector<NodeBound> m_bounds;  ///< Same indexing as m_sum, levels up to MAX_LOBE_LEVEL.
+        std::vector<Real> m_levelRadius;  ///< Widest node cone at each of those levels.
+    };
+
+} // namespace rayt
@@ -6,17 +6,163 @@
  * * The Film class represents the image sensor of the camera. It captures
  * the high-dynamic-range (HDR) radiance values for each pixel and manages
  * the final image output with appropriate post-processing (tone mapping, gamma).
+ * * Samples are accumulated, not stored: each pixel keeps the filter-weighted
+ * sum of the radiance that landed in its reconstruction-filter footprint and
+ * the sum of the filter weights, and resolves to their ratio (plus the
+ * unnormalized splat buffer, see addSplat). Parallel renderers fill one
+ * FilmTile per thread and merge it once; the shared buffers are atomics, so
+ * neither merging nor splatting takes a lock.
+ * * Optional AOVs (enableAOVs) are box-filtered per pixel and kept as running
+ * means in planar float / uint buffers, so saveEXR writes them as they are.
+ * Every pixel belongs to the one tile whose sample rectangle contains it, so
+ * AOV merges need no atomics.
  */
 
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <future>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 
 #include "Core/Core.hpp"  // Include core definitions (Spectrum, Real, etc.)
+#include "Renderer/Filter.hpp"
+#include "Renderer/ToneMap.hpp"
+#include "IO/ExrWriter.hpp"
+#include "IO/PngWriter.hpp"
 
 namespace rayt {
 
+    class Film;
+    class TiledFilm;
+
+    /**
+     * @brief Arbitrary output variables a Film can record next to the beauty pass.
+     */
+    enum class AOV : uint32_t {
+        None = 0,
+        Albedo = 1 << 0,      ///< Reflectance at the first hit (denoiser guide).
+        Normal = 1 << 1,      ///< World-space shading normal at the first hit.
+        Depth = 1 << 2,       ///< Camera-ray distance to the nearest first hit in the pixel.
+        MaterialId = 1 << 3,  ///< MaterialId of the first hit of the first sample (uint; ~0 = none).
+        Direct = 1 << 4,      ///< Light that reached the camera after at most one bounce.
+        Indirect = 1 << 5,    ///< The rest of the beauty.
+        SampleCount = 1 << 6, ///< Samples that landed in the pixel (uint).
+        Variance = 1 << 7,    ///< Variance of the pixel's mean luminance (sample variance / n).
+        All = (1 << 8) - 1
+    };
+    constexpr AOV operator|(AOV a, AOV b) { return AOV(uint32_t(a) | uint32_t(b)); }
+    constexpr bool hasAOV(AOV set, AOV a) { return (uint32_t(set) & uint32_t(a)) != 0; }
+
+    /**
+     * @brief Per-sample AOV values reported by an integrator with a beauty sample.
+     */
+    struct AOVSample {
+        Spectrum albedo{ 0.0 };
+        Vector3 normal{ 0.0 };
+        Real depth = std::numeric_limits<Real>::infinity();
+        uint32_t materialId = ~uint32_t(0);
+        Spectrum direct{ 0.0 }; ///< Indirect is the sample's radiance minus this.
+    };
+
+    /**
+     * @brief Film::saveEXR layout.
+     */
+    struct FilmExrOptions {
+        io::ExrPixelType colorType = io::ExrPixelType::Half; ///< Beauty, albedo, normal, direct, indirect.
+        io::ExrCompression compression = io::ExrCompression::RLE;
+        int tileSize = 0;       ///< 0: scanlines.
+        bool multiPart = true;  ///< One part per layer, or every channel in one part.
+    };
+
+    /**
+     * @brief Thread-private accumulation buffer for a rectangle of film samples.
+     * * Covers the pixels the samples of its rectangle can reach through the
+     * filter, so samples near the tile border still land where they belong;
+     * Film::mergeTile adds the overlap with neighbouring tiles atomically.
+     */
+    class FilmTile {
+    public:
+        /**
+         * @brief Adds a sample at continuous film position pFilm (pixels, origin top-left).
+         * @param weight Sample weight (e.g. camera importance); scales L but not the filter weight.
+         */
+        void addSample(const Point2& pFilm, const Spectrum& L, Real weight = 1) {
+            m_filter->forEachPixel(pFilm, m_x0, m_y0, m_x1, m_y1, [&](int x, int y, Real w) {
+                Pixel& px = m_pixels[size_t(y - m_y0) * (m_x1 - m_x0) + (x - m_x0)];
+                px.sum += L * (weight * w);
+                px.weight += w;
+                });
+            if (!m_aov.empty()) recordAOV(pFilm, L, nullptr);
+        }
+
+        /**
+         * @brief addSample() that also records the sample's AOVs (when the film has any).
+         */
+        void addSample(const Point2& pFilm, const Spectrum& L, const AOVSample& aov, Real weight = 1) {
+            m_filter->forEachPixel(pFilm, m_x0, m_y0, m_x1, m_y1, [&](int x, int y, Real w) {
+                Pixel& px = m_pixels[size_t(y - m_y0) * (m_x1 - m_x0) + (x - m_x0)];
+                px.sum += L * (weight * w);
+                px.weight += w;
+                });
+            if (!m_aov.empty()) recordAOV(pFilm, L, &aov);
+        }
+
+    private:
+        friend class Film;
+        friend class TiledFilm;
+
+        struct Pixel {
+            Spectrum sum{ 0.0 };
+            Real weight = 0;
+        };
+
+        /// Sums over the samples of one pixel of the tile's sample rectangle.
+        struct AOVPixel {
+            uint32_t count = 0;
+            uint32_t materialId = ~uint32_t(0);
+            Real depth = std::numeric_limits<Real>::infinity();
+            Spectrum albedo{ 0.0 }, direct{ 0.0 }, indirect{ 0.0 };
+            Vector3 normal{ 0.0 };
+            Real lumMean = 0, lumM2 = 0; // Welford
+        };
+
+        /// Tile for samples in [x0, x1) x [y0, y1) on a width x height film: stores every pixel they can reach.
+        static FilmTile covering(int x0, int y0, int x1, int y1, int width, int height, const Filter* filter, bool aovs);
+
+        FilmTile(int x0, int y0, int x1, int y1, int sx0, int sy0, int sx1, int sy1, const Filter* filter, bool aovs)
+            : m_x0(x0), m_y0(y0), m_x1(x1), m_y1(y1), m_sx0(sx0), m_sy0(sy0), m_sx1(sx1), m_sy1(sy1), m_filter(filter),
+            m_pixels(size_t(std::max(x1 - x0, 0)) * std::max(y1 - y0, 0)),
+            m_aov(aovs ? size_t(std::max(sx1 - sx0, 0)) * std::max(sy1 - sy0, 0) : 0) {}
+
+        void recordAOV(const Point2& pFilm, const Spectrum& L, const AOVSample* aov) {
+            // The pixel containing the sample (float rounding can put x + 0.99999 on x + 1)
+            const int x = std::clamp(int(std::floor(pFilm.x)), m_sx0, m_sx1 - 1);
+            const int y = std::clamp(int(std::floor(pFilm.y)), m_sy0, m_sy1 - 1);
+            AOVPixel& a = m_aov[size_t(y - m_sy0) * (m_sx1 - m_sx0) + (x - m_sx0)];
+            ++a.count;
+            const Real lum = Luminance(L);
+            const Real delta = lum - a.lumMean;
+            a.lumMean += delta / a.count;
+            a.lumM2 += delta * (lum - a.lumMean);
+            if (!aov) return;
+            if (a.count == 1) a.materialId = aov->materialId;
+            a.depth = std::min(a.depth, aov->depth);
+            a.albedo += aov->albedo;
+            a.normal += aov->normal;
+            a.direct += aov->direct;
+            a.indirect += L - aov->direct;
+        }
+
+        int m_x0, m_y0, m_x1, m_y1;     // stored pixels, half-open
+        int m_sx0, m_sy0, m_sx1, m_sy1; // sample rectangle (the pixels whose AOVs this tile owns)
+        const Filter* m_filter;
+        std::vector<Pixel> m_pixels;
+        std::vector<AOVPixel> m_aov;
+    };
+
     /**
      * @brief Models the light-sensing device in a simulated camera.
      * * It stores raw 'Spectrum' data for each pixel to preserve physical intensity,
@@ -28,19 +174,114 @@ namespace rayt {
          * @brief Initializes the film with a given resolution.
          * @param width  Horizontal resolution in pixels.
          * @param height Vertical resolution in pixels.
+         * @param filter Reconstruction filter (the default box of radius 0.5 is a plain per-pixel average).
          */
-        Film(int width, int height);
+        Film(int width, int height, const Filter& filter = Filter::box());
 
         /**
          * @brief Sets the spectral radiance for a specific pixel coordinate.
-         * * In advanced integrators, this may be extended to an 'addSample' method
-         * to facilitate multi-sample accumulation and reconstruction filtering.
+         * * Overwrites whatever was accumulated there, for integrators that
+         * average their own samples. Safe from several threads on different pixels.
          * @param x        Pixel x-coordinate.
          * @param y        Pixel y-coordinate.
          * @param radiance The physical intensity (radiance) to store.
          */
         void setPixel(int x, int y, const Spectrum& radiance);
 
+        /**
+         * @brief Returns the radiance stored at a pixel (black outside the film).
+         */
+        Spectrum getPixel(int x, int y) const;
+
+        /**
+         * @brief Adds one filtered sample directly to the film (thread-safe).
+         * * Prefer a FilmTile when one thread renders a block of pixels: it
+         * touches the shared buffers once per pixel instead of once per sample.
+         * @param pFilm  Continuous film position in pixels, origin at the top-left corner.
+         * @param weight Sample weight; scales L but not the filter weight.
+         */
+        void addSample(const Point2& pFilm, const Spectrum& L, Real weight = 1);
+
+        /**
+         * @brief Creates an empty tile for samples with pFilm in [x0, x1) x [y0, y1).
+         */
+        FilmTile tile(int x0, int y0, int x1, int y1) const;
+
+        /**
+         * @brief Adds a finished tile into the film (thread-safe).
+         */
+        void mergeTile(const FilmTile& tile);
+
+        /**
+         * @brief Adds a contribution that is not normalized by the filter weights (thread-safe).
+         * * For estimators that land on the film at arbitrary positions, such as
+         * light tracing: the pixel receives L f(p - c) / integral(f), scaled by
+         * splatScale() when the film is resolved.
+         */
+        void addSplat(const Point2& pFilm, const Spectrum& L);
+
+        /// Factor applied to the splat buffer on resolve (typically 1 / samples per pixel).
+        void setSplatScale(Real scale) { m_splatScale = scale; }
+        Real splatScale() const { return m_splatScale; }
+
+        const Filter& filter() const { return m_filter; }
+
+        /**
+         * @brief Allocates (and clears) the AOV buffers in `set`; AOV::None frees them.
+         * * AOVs are only recorded through FilmTile::addSample, and each pixel
+         * must be covered by one tile at a time.
+         */
+        void enableAOVs(AOV set);
+        AOV aovs() const { return m_aovSet; }
+
+        /**
+         * @brief Row-major plane of a float AOV, or null when it is not enabled.
+         * * Albedo, Normal, Direct and Indirect have channels 0-2; Depth and Variance only 0.
+         */
+        const float* aovPlane(AOV aov, int channel = 0) const;
+
+        /// Material id per pixel (~0u where no sample hit anything), or null when not enabled.
+        const uint32_t* materialIds() const { return m_materialId.empty() ? nullptr : m_materialId.data(); }
+
+        /// Samples recorded per pixel, or null when no AOV is enabled.
+        const uint32_t* sampleCounts() const { return m_sampleCount.empty() ? nullptr : m_sampleCount.data(); }
+
+        /**
+         * @brief Writes the beauty and every enabled AOV to an OpenEXR file.
+         * * Layers are "beauty" (R, G, B), "albedo", "normal" (X, Y, Z), "depth" (Z,
+         * float), "materialId" (ID, uint), "direct", "indirect", "sampleCount"
+         * (N, uint) and "variance" (Y, float). The AOV buffers are written
+         * without a conversion copy when colorType is Float and compression is
+         * None; the beauty is resolved one row at a time.
+         * @throws std::runtime_error If the file cannot be written.
+         */
+        void saveEXR(const std::string& filename, const FilmExrOptions& options = {}) const;
+
+        /**
+         * @brief The resolved beauty through a display transform, as 8-bit RGB rows (top row first).
+         * * Rows are tone mapped in parallel, four pixels at a time (see ToneMap.hpp).
+         */
+        std::vector<uint8_t> toLDR(const ToneMapSettings& settings = {}) const;
+
+        /**
+         * @brief Writes toLDR(settings) as PNG, BMP or JPG (quality 90), by extension.
+         * * PNG goes through io::writePNG (chunked deflate on all threads, see PngWriter.hpp).
+         * @return False (with a message) if the extension is not one of these or the write failed.
+         */
+        bool saveLDR(const std::string& filename, const ToneMapSettings& settings = {},
+            const io::PngOptions& pngOptions = {}) const;
+
+        /**
+         * @brief saveLDR with the encoding and the file write on a background thread.
+         * * The film is tone mapped before this returns, so rendering may go on
+         * accumulating into it (or the film may be destroyed) right away; only the
+         * 8-bit copy lives on until the task ends. Progressive renders can save
+         * every pass this way without waiting for the previous file.
+         * @return The result of saveLDR; an unsupported extension gives a ready false.
+         */
+        std::future<bool> saveLDRAsync(const std::string& filename, const ToneMapSettings& settings = {},
+            const io::PngOptions& pngOptions = {}) const;
+
         /**
          * @brief Returns the width of the film in pixels.
          */
@@ -55,7 +296,8 @@ namespace rayt {
          * @brief Saves the current film data to a file.
          * * Automatic format handling based on extension:
          * - ".hdr": Saves raw linear radiance (Radiance HDR format).
-         * - ".png" / ".jpg": Performs tone mapping and gamma correction (LDR).
+         * - ".exr": Beauty and AOVs with the default FilmExrOptions (see saveEXR).
+         * - ".png" / ".bmp" / ".jpg": saveLDR with the default ToneMapSettings (Reinhard, gamma 2.2).
          * @param filename Path to the output file.
          */
         void save(const std::string& filename) const;
@@ -63,13 +305,28 @@ namespace rayt {
     private:
         int m_width;
         int m_height;
+        Filter m_filter;
+        Real m_splatScale = 1;
 
         /**
          * @brief Internal buffer for raw pixel data.
-         * * Using 'Spectrum' ensures that no physical light information is lost
+         * * Using full-precision sums ensures that no physical light information is lost
          * during the rendering process, allowing for flexible post-processing.
          */
-        std::vector<Spectrum> m_pixels;
+        struct Pixel {
+            std::atomic<Real> sum[3];
+            std::atomic<Real> weight;
+            std::atomic<Real> splat[3];
+        };
+        std::vector<Pixel> m_pixels;
+
+        /// AOV planes (row-major, one value per pixel); empty when not enabled.
+        AOV m_aovSet = AOV::None;
+        std::vector<float> m_albedo[3], m_normal[3], m_direct[3], m_indirect[3], m_depth, m_variance;
+        std::vector<uint32_t> m_materialId, m_sampleCount;
+        std::vector<double> m_lumMean, m_lumM2; // Welford state behind m_variance
+
+        Spectrum resolve(const Pixel& p) const;
     };
 
 } // namespace rayt
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file Filter.hpp
+ * @brief Pixel reconstruction filters for Film::addSample.
+ * * A sample at continuous film position p contributes f(p - c) L to every pixel
+ * whose center c lies within the filter radius, and f(p - c) to that pixel's
+ * weight; the pixel value is the weighted average. All filters here are
+ * separable, f(dx, dy) = f1(dx) f1(dy), so a sample only evaluates the 1D
+ * profile once per footprint column and once per footprint row.
+ * * Box with radius 0.5 touches exactly one pixel and reproduces a plain
+ * per-pixel average. Mitchell has negative lobes: it sharpens, and can ring
+ * around very bright edges (e.g. the sun in an HDRI).
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Core/Types.hpp"
+#include "Core/Constants.hpp"
+
+namespace rayt {
+
+    class Filter {
+    public:
+        enum class Type { Box, Tent, Gaussian, Mitchell };
+
+        /// Largest radius a filter keeps (larger ones are clamped), so a footprint fits forEachPixel's stack array.
+        static constexpr int MaxRadius = 8;
+
+        /// Constant weight over [-radius, radius)^2.
+        static Filter box(Real radius = 0.5) { return Filter(Type::Box, radius); }
+
+        /// Linear falloff to zero at the radius.
+        static Filter tent(Real radius = 1.0) { return Filter(Type::Tent, radius); }
+
+        /// Gaussian of standard deviation sigma, shifted so it reaches zero at the radius.
+        static Filter gaussian(Real radius = 1.5, Real sigma = 0.5) {
+            Filter f(Type::Gaussian, radius);
+            f.m_a = sigma;
+            f.m_b = std::exp(-radius * radius / (2 * sigma * sigma));
+            return f;
+        }
+
+        /// Mitchell-Netravali cubic (B, C); B = C = 1/3 is the usual compromise between blur and ringing.
+        static Filter mitchell(Real radius = 2.0, Real b = Real(1) / 3, Real c = Real(1) / 3) {
+            Filter f(Type::Mitchell, radius);
+            f.m_a = b;
+            f.m_b = c;
+            return f;
+        }
+
+        Type type() const { return m_type; }
+        Real radius() const { return m_radius; }
+
+        /// 1D profile at offset d = p - center (pixels); zero outside [-radius, radius).
+        Real evaluate1D(Real d) const {
+            if (d < -m_radius || d >= m_radius) return Real(0);
+            d = std::abs(d);
+            switch (m_type) {
+            case Type::Box:
+                return Real(1);
+            case Type::Tent:
+                return m_radius - d;
+            case Type::Gaussian:
+                return std::max(Real(0), std::exp(-d * d / (2 * m_a * m_a)) - m_b);
+            case Type::Mitchell: {
+                // The cubic is defined on [-2, 2]; the radius rescales it
+                const Real x = 2 * d / m_radius;
+                const Real B = m_a, C = m_b;
+                if (x < 1)
+                    return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6;
+                return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6;
+            }
+            }
+            return Real(0);
+        }
+
+        Real evaluate(Real dx, Real dy) const { return evaluate1D(dx) * evaluate1D(dy); }
+
+        /// Integral of evaluate() over the plane (what a splat divides by to stay unbiased).
+        Real integral() const {
+            Real i1 = 0;
+            switch (m_type) {
+            case Type::Box:      i1 = 2 * m_radius; break;
+            case Type::Tent:     i1 = m_radius * m_radius; break;
+            case Type::Gaussian: i1 = std::sqrt(2 * constants::PI) * m_a * std::erf(m_radius / (std::sqrt(Real(2)) * m_a)) - 2 * m_radius * m_b; break;
+            case Type::Mitchell: i1 = m_radius / 2; break; // the [-2, 2] cubic integrates to 1 for any (B, C)
+            }
+            return i1 * i1;
+        }
+
+        /**
+         * @brief Pixels k along one axis whose offset p - (k + 0.5) lies in [-radius, radius).
+         * * The half-open interval means a box of radius 0.5 covers exactly one pixel for
+         * every p, including samples that land exactly on a pixel border.
+         */
+        void footprint(Real p, int& first, int& last) const {
+            first = int(std::floor(p - m_radius - Real(0.5))) + 1;
+            last = int(std::floor(p + m_radius - Real(0.5)));
+        }
+
+        /**
+         * @brief Calls f(x, y, weight) for every pixel of the footprint of p inside [x0, x1) x [y0, y1).
+         */
+        template <typename F>
+        void forEachPixel(const Point2& p, int x0, int y0, int x1, int y1, F&& f) const {
+            int fx0, fx1, fy0, fy1;
+            footprint(p.x, fx0, fx1);
+            footprint(p.y, fy0, fy1);
+            fx0 = std::max(fx0, x0); fx1 = std::min(fx1, x1 - 1);
+            fy0 = std::max(fy0, y0); fy1 = std::min(fy1, y1 - 1);
+            if (fx0 > fx1 || fy0 > fy1) return;
+            // Footprint width is at most floor(2 radius) + 1
+            Real wx[2 * MaxRadius + 1];
+            for (int x = fx0; x <= fx1; ++x) wx[x - fx0] = evaluate1D(Real(p.x) - (x + Real(0.5)));
+            for (int y = fy0; y <= fy1; ++y) {
+                const Real wy = evaluate1D(Real(p.y) - (y + Real(0.5)));
+                if (wy == 0) continue;
+                for (int x = fx0; x <= fx1; ++x) {
+                    const Real w = wx[x - fx0] * wy;
+                    if (w != 0) f(x, y, w);
+                }
+            }
+        }
+
+    private:
+        Filter(Type type, Real radius) : m_type(type), m_radius(std::clamp(radius, Real(1e-3), Real(MaxRadius))) {}
+
+        Type m_type;
+        Real m_radius;
+        Real m_a = 0, m_b = 0; // Gaussian: sigma, value at the radius; Mitchell: B, C
+    };
+
+} // namespace rayt
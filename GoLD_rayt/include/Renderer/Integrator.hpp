@@ -4,15 +4,21 @@
 #include "renderer/Scene.hpp"   // HittableList, etc.
 #include "Renderer/Camera.hpp"
 #include "renderer/Film.hpp"
+#include "Renderer/TiledFilm.hpp"
 #include "Core/Ray.hpp"
 #include "Core/Interaction.hpp"
 #include "Materials/Material.hpp"
 #include "Core/Sampling.hpp"
+#include "Core/SampledSpectrum.hpp"
+#include "Core/Fresnel.hpp"
+#include "Core/Parallel.hpp"
 #include "IO/EnvMap.hpp"
+#include "Renderer/EnvProductSampler.hpp"
 
 #include <memory>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 
 namespace rayt {
 
@@ -36,53 +42,103 @@ namespace rayt {
             : m_camera(camera), m_env(env), 
             m_maxDepth(maxDepth), m_spp(spp) {}
 
+        // 光沢ローブを持つマテリアルでは、環境光 NEE を「環境 × ローブ」の積サンプリングに切り替える
+        // （null なら従来どおり環境の輝度だけでサンプリング）
+        void setEnvProductSampler(std::shared_ptr<const EnvProductSampler> sampler) { m_envProduct = std::move(sampler); }
+
         // レンダリングループの実装
-        virtual void render(const Scene& scene, Film& film) override {
+        virtual void render(const Scene& scene, Film& film) override { renderTiles(scene, film); }
+
+        // 巨大解像度向け：完成したタイルから順に書き出す TiledFilm に描く（メモリはフィルム側の予算内）
+        void render(const Scene& scene, TiledFilm& film) { renderTiles(scene, film); }
+
+        // タイルループ本体（Film と TiledFilm で共通）
+        template <class FilmT>
+        void renderTiles(const Scene& scene, FilmT& film) {
             int width = film.width();
             int height = film.height();
 
             std::cout << "[PathIntegrator] Rendering " << width << "x" << height
                 << " (" << m_spp << " spp)" << std::endl;
 
-            for (int j = 0; j < height; ++j) {
-                // 進捗表示
-                std::cout << "\rScanlines remaining: " << (height - j) << " " << std::flush;
-
-                // #pragma omp parallel for // 可能なら並列化推奨
-
-                for (int i = 0; i < width; ++i) {
-                    Spectrum pixelColor(0.0);
-
-                    for (int s = 0; s < m_spp; ++s) {
-                        // アンチエイリアシング用のジッター
-                        Real u = (Real(i) + rayt::sampling::Random()) / Real((width));
-                        Real v = (Real(j) + rayt::sampling::Random()) / Real((height));
-
-                        Point2 lensSample = sampling::Random2D();
-
-                        Ray r = m_camera->getRay(u, v, lensSample);
-                        pixelColor += Li(r, scene);
-                    }
-                    pixelColor /= Real(m_spp);
-
-                    // NaN除去（デバッグ用）
-                    if (HasInvalidValues(pixelColor)) {
-                        std::cerr << "NaN detected at " << i << ", " << j << std::endl;
-                        pixelColor = Spectrum(0.0);
+            // テクスチャフットプリント用：1ピクセル分のフィルム幅と、二次レイのコーン広がり角
+            const Real dFilmX = Real(1.0) / Real(width);
+            const Real dFilmY = Real(1.0) / Real(height);
+            m_pixelSpread = m_camera->pixelSpreadAngle(height);
+
+            // タイル単位で並列化する。各スレッドは自分の FilmTile に足し込み、終わったら一度だけマージする
+            // （フィルム側はアトミック加算なのでロック不要）
+            const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+            const int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+            const int tileCount = tilesX * tilesY;
+            const uint32_t frame = m_frameIndex++;
+            std::atomic<int> tilesDone{ 0 };
+            // AOV（アルベド・法線・直接光など）はフィルムで有効になっているときだけ集める
+            const bool recordAOVs = film.aovs() != AOV::None;
+
+            parallelFor(tileCount, 1, [&](int begin, int end) {
+                for (int t = begin; t < end; ++t) {
+                    const int x0 = (t % tilesX) * TILE_SIZE, y0 = (t / tilesX) * TILE_SIZE;
+                    const int x1 = std::min(x0 + TILE_SIZE, width), y1 = std::min(y0 + TILE_SIZE, height);
+
+                    // 乱数列はタイルとフレームから決める（どのスレッドが担当しても同じ画像になる）
+                    sampling::SeedRandom(sampling::Hash32(uint32_t(t) + frame * uint32_t(tileCount)));
+                    FilmTile tile = film.tile(x0, y0, x1, y1);
+
+                    for (int y = y0; y < y1; ++y) {
+                        for (int x = x0; x < x1; ++x) {
+                            for (int s = 0; s < m_spp; ++s) {
+                                // アンチエイリアシング用のジッター（フィルム座標は左上原点、カメラの v は下が 0）
+                                const Point2 pFilm(float(x + sampling::Random()), float(y + sampling::Random()));
+                                Real u = Real(pFilm.x) / Real(width);
+                                Real v = Real(1.0) - Real(pFilm.y) / Real(height);
+
+                                Point2 lensSample = sampling::Random2D();
+
+                                RayDifferential r = m_camera->getRayDifferential(u, v, lensSample, dFilmX, dFilmY);
+
+                                // スペクトルモード（RAYT_SPECTRAL）ではパスごとにヒーロー波長をサンプリングし、
+                                // 結果は XYZ 経由で RGB にしてからフィルムに足す（RGB モードでは何もしない）
+                                SampledWavelengths lambda;
+#if RAYT_SPECTRAL
+                                lambda = SampledWavelengths::sampleHero(sampling::Random());
+#endif
+                                AOVSample aov;
+                                const Spectrum L = spectral::toFilmRGB(Li(r, scene, lambda, recordAOVs ? &aov : nullptr), lambda);
+
+                                // NaN除去（デバッグ用）：そのサンプルだけ捨てる
+                                if (HasInvalidValues(L)) {
+                                    std::cerr << "NaN detected at " << x << ", " << y << std::endl;
+                                    continue;
+                                }
+                                if (recordAOVs) tile.addSample(pFilm, L, aov);
+                                else tile.addSample(pFilm, L);
+                            }
+                        }
                     }
+                    film.mergeTile(tile);
 
-                    // 上下反転して保存
-                    film.setPixel(i, height - 1 - j, pixelColor);
+                    // 進捗表示
+                    const int done = ++tilesDone;
+                    if (done % tilesX == 0 || done == tileCount)
+                        std::cout << "\rTiles remaining: " << (tileCount - done) << " " << std::flush;
                 }
-            }
+                });
             std::cout << "\n[PathIntegrator] Done." << std::endl;
         }
 
         // 放射輝度計算 (Li)
-        Spectrum Li(Ray r, const Scene& scene) const {
-            Spectrum L(0.0);        // 最終的な放射輝度（Accumulated Radiance）
-            Spectrum beta(1.0);     // スループット（Throughput: 経路の重み）
+        // （PathSpectrum は RGB モードでは Spectrum、スペクトルモードでは lambda の各波長の値）
+        // aov が非 null なら一次ヒットの情報と直接光成分も返す
+        PathSpectrum Li(RayDifferential r, const Scene& scene, const SampledWavelengths& lambda,
+            AOVSample* aov = nullptr) const {
+            PathSpectrum L(0.0);    // 最終的な放射輝度（Accumulated Radiance）
+            PathSpectrum Ldirect(0.0); // 1 バウンス以内で届いた分（深さ 1 の自己発光・環境光まで）
+            bool directDone = false;
+            PathSpectrum beta(1.0); // スループット（Throughput: 経路の重み）
+            Real pathLength = 0;    // カメラからの累積距離（レイコーン幅 = 広がり角 * 距離）
             Real lastPdf = 0;
+            std::optional<GlossyLobe> lastLobe; // 直前の頂点で積サンプリングに使ったローブ（MIS 用）
             bool lastSpecular = false;
             bool hasLastBsdf = false;
             
@@ -142,7 +198,8 @@ namespace rayt {
                         envL = Spectrum(rgb.x, rgb.y, rgb.z);
 
                         if (hasLastBsdf && !lastSpecular) {
-                            Real pdfEnv = m_env->pdf(r.d);   // ★ EnvMap に pdf(dir) を用意しておく
+                            // 直前の頂点の NEE と同じ戦略の pdf で重みを付ける
+                            Real pdfEnv = lastLobe ? m_envProduct->pdf(*lastLobe, r.d) : m_env->pdf(r.d);
 
                             Real w = 1.0;
                             if (pdfEnv > 0 && lastPdf > 0) {
@@ -150,21 +207,49 @@ namespace rayt {
                                 Real b = pdfEnv;
                                 w = (a * a) / (a * a + b * b); // power heuristic
                             }
-                            L += beta * envL * w;
+                            L += beta * spectral::lift(envL, lambda) * w;
                         }
                         else {
                             // カメラレイ直撃 or 鏡面経路は MIS しない
-                            L += beta * envL;
+                            L += beta * spectral::lift(envL, lambda);
                         }
                     }
                     break;
                 }
 
 
+                // マテリアル解決（組み込みは variant 経由、拡張は仮想関数経由）
+                const MaterialRef mat = scene.material(rec);
+
+                // テクスチャ用フットプリント（一次レイは微分レイ、それ以降はレイコーンで近似）と法線マップ
+                // フレームを作る前に済ませる。テクスチャを使わないマテリアルでは何もしない
+                pathLength += rec.t * glm::length(r.d);
+                mat.prepareShading(rec, r, m_pixelSpread * pathLength);
+
+                // このバウンスで共有するシェーディング状態（フレーム・ローカル wo など）
+                // カメラレイの方向は正規化されていない（長さ = 焦点距離程度）ので、ここで単位ベクトルにする。
+                // そのままだとハーフベクトル wo + wi が wo 側に偏り、粗い導体が大きく暗くなる
+                BSDFContext ctx(rec, -glm::normalize(r.d));
+#if RAYT_SPECTRAL
+                ctx.lambda = &lambda;
+#endif
+
                 // 2. 自己発光の加算 (Le)
                 // 光源に当たったら、ここまでの減衰(beta)を掛けて足す
-                // ※ wo = -r.direction
-                L += beta * rec.matPtr->emitted(rec, -r.d);
+                // ※ wo はコンテキストの ctx.wo（正規化済みの -r.d）をそのまま使う
+                L += beta * spectral::lift(mat.emitted(rec, ctx.wo), lambda);
+
+                // AOV: 一次ヒットの情報、直接光は深さ 1 の自己発光まで（ここから先の NEE は間接光）
+                if (aov && depth == 0) {
+                    aov->albedo = firstHitAlbedo(mat, rec);
+                    aov->normal = rec.n;
+                    aov->depth = pathLength;
+                    aov->materialId = rec.materialId;
+                }
+                if (depth == 1) {
+                    Ldirect = L;
+                    directDone = true;
+                }
 
                 // 2.5. Next Event Estimation (Environment Light)
                 /*if (m_env && !rec.matPtr->isSpecular()) {
@@ -213,13 +298,19 @@ namespace rayt {
                 }*/
 
                 // 2.5. Next Event Estimation (Environment Light)
-                if (m_env && !rec.matPtr->isSpecular()) {
+                // 光沢ローブがあれば環境 × ローブの積に比例してサンプリングする
+                // （広すぎる・鋭すぎるローブは効果がないので従来の環境サンプリングのまま）
+                std::optional<GlossyLobe> lobe = m_envProduct ? mat.glossyLobe(ctx) : std::nullopt;
+                if (lobe && !m_envProduct->handles(*lobe)) lobe.reset();
+
+                if (m_env && !mat.isSpecular()) {
 
                     Point2 uLight(sampling::Random(), sampling::Random());
 
                     Vector3 wi;
                     Real pdfEnv;
-                    Vector3 Le = m_env->sample(uLight, wi, pdfEnv);
+                    Vector3 Le = lobe ? m_envProduct->sample(*lobe, uLight, wi, pdfEnv)
+                        : m_env->sample(uLight, wi, pdfEnv);
 
                     if (pdfEnv > 0 && !isBlack(Le)) {
 
@@ -229,26 +320,26 @@ namespace rayt {
                         SurfaceInteraction tmp;
                         if (!scene.hit(shadow, tmp)) {
 
-                            // BSDF評価
-                            Spectrum f = rec.matPtr->eval(rec, -r.d, wi);
-                            if (isBlack(f)) continue; // or continue;
-
-                            // cos項は abs を取る（重要）
-                            Real cosTheta = std::abs(glm::dot(rec.n, wi));
-
-                            // BSDF側 pdf
-                            Real pdfBsdf = rec.matPtr->pdf(rec, -r.d, wi);
+                            // BSDF評価と BSDF側 pdf を一度に計算
+                            // f が黒ならこの光サンプルの寄与だけを捨てる
+                            // （continue すると同じレイを再追跡してしまう）
+                            BSDFEval bsdf = mat.evalAndPdf(ctx, wi);
+                            PathSpectrum f = pathValue(bsdf, lambda);
+                            if (!isBlack(f)) {
+                                // cos項は abs を取る（重要）
+                                Real cosTheta = std::abs(glm::dot(rec.n, wi));
+
+                                // MIS（Power heuristic）
+                                Real w = 1.0;
+                                if (bsdf.pdf > 0) {
+                                    Real a = pdfEnv;
+                                    Real b = bsdf.pdf;
+                                    w = (a * a) / (a * a + b * b);
+                                }
 
-                            // MIS（Power heuristic）
-                            Real w = 1.0;
-                            if (pdfBsdf > 0) {
-                                Real a = pdfEnv;
-                                Real b = pdfBsdf;
-                                w = (a * a) / (a * a + b * b);
+                                L += beta * f * spectral::lift(Spectrum(Le.x, Le.y, Le.z), lambda)
+                                    * cosTheta * (w / pdfEnv);
                             }
-
-                            L += beta * f * Spectrum(Le.x, Le.y, Le.z)
-                                * cosTheta * (w / pdfEnv);
                         }
                     }
                 }
@@ -258,8 +349,8 @@ namespace rayt {
                 // ランダムな乱数を用意 (本来はSamplerクラスから取得すべき)
                 Point2 u(rayt::sampling::Random(), rayt::sampling::Random());
 
-                // sample() 呼び出し: wo, uv を渡す
-                auto bsdfSample = rec.matPtr->sample(rec, -r.d, u);
+                // sample() 呼び出し: コンテキスト（wo を含む）と uv を渡す
+                auto bsdfSample = mat.sample(ctx, u);
 
                 // サンプリング失敗（吸収、全反射角超過など）なら終了
                 if (!bsdfSample) {
@@ -269,11 +360,12 @@ namespace rayt {
                 // 4. スループットの更新 (Beta update)
                 // モンテカルロ積分の式: beta_new = beta_old * (f * cos_theta / pdf)
 
-                Spectrum f = bsdfSample->f;
+                PathSpectrum f = pathValue(*bsdfSample, lambda);
                 Real pdf = bsdfSample->pdf;
                 Vector3 wi = bsdfSample->wi; // 新しい方向
 
                 lastPdf = pdf;
+                lastLobe = lobe;
                 lastSpecular = bsdfSample->isSpecular();
                 hasLastBsdf = true;
 
@@ -317,15 +409,32 @@ namespace rayt {
                 r = rayt::SpawnRay(rec.p, rec.gn, wi);
             }
 
+            if (aov) aov->direct = spectral::toFilmRGB(directDone ? Ldirect : L, lambda);
             return L;
         }
 
     private:
         std::shared_ptr<Camera> m_camera;
         std::shared_ptr<EnvMap> m_env;
+        std::shared_ptr<const EnvProductSampler> m_envProduct;
 
         int m_maxDepth;
         int m_spp;
+        uint32_t m_frameIndex = 0; // render() 呼び出しごとに別の乱数列を使う
+        static constexpr int TILE_SIZE = 16;
+        Real m_pixelSpread = 0; // Camera::pixelSpreadAngle() for the film being rendered
+
+        // デノイザ用アルベド：拡散はテクスチャ込みの反射率、金属は垂直入射の Fresnel、ガラスは 1
+        static Spectrum firstHitAlbedo(const MaterialRef& mat, const SurfaceInteraction& rec) {
+            const std::optional<PreviewMaterial> pm = mat.previewMaterial(rec);
+            if (!pm) return Spectrum(0.0);
+            switch (pm->type) {
+            case PreviewMaterial::Type::Diffuse:    return pm->albedo;
+            case PreviewMaterial::Type::Conductor:  return fresnel::fresnelConductor(Real(1), pm->eta, pm->k);
+            case PreviewMaterial::Type::Dielectric: return Spectrum(1.0);
+            }
+            return Spectrum(0.0);
+        }
 
         static bool visible(const Scene& scene, const SurfaceInteraction& ref,
             const Point3& pLight)
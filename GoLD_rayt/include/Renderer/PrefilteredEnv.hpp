@@ -0,0 +1,109 @@
+#pragma once
+
+/**
+ * @file PrefilteredEnv.hpp
+ * @brief An EnvMap convolved with GGX lobes of increasing roughness, and with a cosine lobe.
+ * * The lighting half of the split sum (SplitSumTable.hpp holds the BRDF half).
+ * Level L = 1..LEVELS holds the environment filtered with an isotropic GGX
+ * lobe of roughness L / LEVELS (alpha = roughness^2) around each direction,
+ * under the usual n = v = reflection assumption; level 0 is the EnvMap
+ * itself. eval() interpolates between the two levels around a roughness.
+ * Levels are equal-area octahedral squares, 256^2 for the sharpest down to
+ * 32^2, so each keeps a few texels across its lobe.
+ * * Each texel averages 64 GGX samples, every one read from the level of a
+ * box-filtered pyramid of the environment whose texels match the sample's
+ * solid angle (Krivanek and Colbert, "Real-time Shading with Filtered
+ * Importance Sampling", 2008): small bright sources are blurred, not aliased
+ * into sparkles. The irradiance for diffuse surfaces is a 32^2 map convolved
+ * exactly (every source texel) from the 64^2 pyramid level.
+ * * Building takes about half a second; load() keeps the result in an
+ * io::AssetCache keyed by the HDR's content.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "Core/Types.hpp"
+#include "Core/EqualAreaMapping.hpp"
+#include "Core/TiledImage.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/EnvMap.hpp"
+
+namespace rayt {
+
+    class PrefilteredEnv {
+    public:
+        static constexpr int LEVELS = 6;           ///< Filtered levels (roughness 1/6 .. 1).
+        static constexpr int FILTER_SAMPLES = 64;  ///< GGX samples per filtered texel.
+
+        /**
+         * @brief Filters an environment (kept for level 0).
+         */
+        explicit PrefilteredEnv(std::shared_ptr<const EnvMap> env);
+
+        /**
+         * @brief Maps the filtered maps of hdrPath's content from `cache`, otherwise builds (and stores) them.
+         * @param env     The environment loaded from hdrPath.
+         * @param hdrPath The file env was loaded from; its content is the cache key.
+         * @param cache   Where filtered maps are kept (nullptr: always build).
+         */
+        static std::shared_ptr<const PrefilteredEnv> load(std::shared_ptr<const EnvMap> env,
+            const std::string& hdrPath, const io::AssetCache* cache);
+
+        /// Side length of filtered level L (1..LEVELS).
+        static int resolution(int level) { return std::max(32, 512 >> level); }
+
+        /**
+         * @brief Radiance around dir filtered with a GGX lobe of the given alpha (0 = unfiltered).
+         */
+        Vector3 eval(const Vector3& dir, Real alpha) const {
+            const Vector3 d = glm::normalize(dir);
+            const Real x = std::clamp(std::sqrt(std::max(alpha, Real(0))), Real(0), Real(1)) * LEVELS;
+            const int l0 = std::min(int(x), LEVELS - 1);
+            const Real t = x - l0;
+            const Vector3 c0 = level(l0, d);
+            return t > 0 ? glm::mix(c0, level(l0 + 1, d), t) : c0;
+        }
+
+        /**
+         * @brief Irradiance E(n) = integral of L(w) max(0, n.w) dw; a Lambertian surface reflects albedo * E / pi.
+         */
+        Vector3 irradiance(const Vector3& n) const {
+            return lookup(m_irradiance, glm::normalize(n));
+        }
+
+        /// Bytes held by the filtered levels and the irradiance map.
+        size_t memoryBytes() const {
+            size_t bytes = m_irradiance.memoryBytes();
+            for (const TiledImage& l : m_levels) bytes += l.memoryBytes();
+            return bytes;
+        }
+
+    private:
+        std::shared_ptr<const EnvMap> m_env;
+        std::array<TiledImage, LEVELS> m_levels; // m_levels[L - 1] is level L
+        TiledImage m_irradiance;
+
+        PrefilteredEnv() = default;
+
+        Vector3 level(int l, const Vector3& d) const {
+            if (l == 0) return m_env ? m_env->eval(d) : Vector3(0.0);
+            return lookup(m_levels[l - 1], d);
+        }
+
+        /// Bilinear lookup of a normalized direction in an equal-area octahedral map.
+        static Vector3 lookup(const TiledImage& map, const Vector3& d) {
+            Real u, v;
+            equalAreaSphereToSquare(d, u, v);
+            const int n = map.width();
+            return map.bilinear(static_cast<float>(u) * n - 0.5f, static_cast<float>(v) * n - 0.5f);
+        }
+
+        bool loadCache(const io::AssetCache& cache, uint64_t key);
+        bool storeCache(const io::AssetCache& cache, uint64_t key) const;
+    };
+
+} // namespace rayt
@@ -9,6 +9,7 @@
  */
 
 #include "Geometry/Hittable.hpp"
+#include "Materials/MaterialTable.hpp"
 
 #include <memory>
 #include <vector>
@@ -26,9 +27,10 @@ namespace rayt {
         /**
          * @brief Constructs a scene with a geometric root.
          * @param aggregate The root of the geometry hierarchy (usually a BVHNode or HittableList).
+         * @param materials Built-in materials referenced by MaterialId from the geometry.
          */
-        Scene(std::shared_ptr<Hittable> aggregate)
-            : m_aggregate(aggregate) {}
+        Scene(std::shared_ptr<Hittable> aggregate, MaterialTable materials = {})
+            : m_aggregate(aggregate), m_materials(std::move(materials)) {}
 
         /**
          * @brief Queries the scene for the closest ray-geometry intersection.
@@ -42,6 +44,21 @@ namespace rayt {
             return m_aggregate->hit(r, rec);
         }
 
+        /**
+         * @brief Resolves the material at a hit point.
+         * * Table entries (rec.materialId) are dispatched through the variant;
+         * anything else falls back to the virtual rec.matPtr.
+         * @param rec A surface interaction filled in by hit().
+         * @return MaterialRef Handle used by the integrator for all BSDF queries.
+         */
+        MaterialRef material(const SurfaceInteraction& rec) const {
+            if (m_materials.contains(rec.materialId))
+                return MaterialRef(&m_materials[rec.materialId]);
+            return MaterialRef(rec.matPtr);
+        }
+
+        const MaterialTable& materials() const { return m_materials; }
+
         // ---------------------------------------------------------------------
         // Future Extensions
         // ---------------------------------------------------------------------
@@ -55,6 +72,9 @@ namespace rayt {
          */
         std::shared_ptr<Hittable> m_aggregate;
 
+        /// Built-in materials, stored contiguously by value.
+        MaterialTable m_materials;
+
         // Future member for light sources
         // std::vector<std::shared_ptr<Light>> m_lights;
     };
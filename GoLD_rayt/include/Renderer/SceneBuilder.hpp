@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file SceneBuilder.hpp
+ * @brief Turns a loaded io::SceneFile into the Scene and Camera the integrators render.
+ */
+
+#include <memory>
+
+#include "IO/SceneFile.hpp"
+
+namespace rayt {
+
+    class Camera;
+    class Scene;
+
+    namespace io { class AssetCache; }
+
+    /**
+     * @brief Builds the renderable scene: materials into a MaterialTable, geometry, instances and their BVH used in place.
+     * * Measured n, k files of conductors are loaded in spectral builds (through
+     * `cache` when given); if one cannot be read, the record's RGB eta and k are used.
+     */
+    std::unique_ptr<Scene> buildScene(const io::SceneFile& file, const io::AssetCache* cache = nullptr);
+
+    /// Camera for the settings (aspect from width / height, focus from the look-at distance unless set).
+    std::shared_ptr<Camera> buildCamera(const io::SceneSettings& settings);
+
+} // namespace rayt
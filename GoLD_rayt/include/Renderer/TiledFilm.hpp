@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * @file TiledFilm.hpp
+ * @brief Out-of-core film for renders too large for a Film: bounded memory, tiles streamed out as they complete.
+ * * A Film keeps the double-precision sums, weight and splat of every pixel
+ * (56 bytes each, 67 GB at 40000 x 30000 before any AOV). A TiledFilm cuts
+ * the image into square storage tiles that only exist while samples can
+ * still land on them:
+ * - a storage tile is allocated when the first FilmTile reaching it is merged;
+ * - it is complete once the merged sample rectangles cover every sample
+ *   position that can reach it through the filter. It is then resolved, handed
+ *   to the sink (by default an io::ExrTileWriter, so it goes straight into a
+ *   tiled OpenEXR file) and freed;
+ * - while the resident tiles exceed the memory budget, the least recently
+ *   used ones are paged out to a scratch file and read back when touched again.
+ * * Rendered in row-major tile order (PathIntegrator's tile loop), only about
+ * two rows of storage tiles are incomplete at any time, so memory follows the
+ * image width rather than its area, and the budget caps it anyway.
+ * * The film assumes a single pass: the sample rectangles of the merged
+ * FilmTiles are disjoint and cover the image. It records no AOVs and no
+ * splats, which need the whole film at once; progressive, denoised or
+ * light-traced renders stay on Film.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "Renderer/Film.hpp"
+#include "Renderer/Filter.hpp"
+#include "IO/ExrWriter.hpp"
+
+namespace rayt {
+
+    struct TiledFilmOptions {
+        int tileSize = 64;                        ///< Storage (and output) tile side in pixels.
+        size_t memoryBudget = size_t(256) << 20;  ///< Bytes of resident storage tiles before paging out.
+        std::string scratchPath;                  ///< Page file (empty: output path + ".scratch", or a unique name in the temp directory).
+        io::ExrPixelType pixelType = io::ExrPixelType::Half;
+        io::ExrCompression compression = io::ExrCompression::RLE;
+    };
+
+    class TiledFilm {
+    public:
+        /**
+         * @brief Receives each completed tile as planar R, G, B, (x1 - x0) x (y1 - y0) floats each.
+         * * Called from whichever thread completed the tile, possibly several at once.
+         */
+        using TileSink = std::function<void(int x0, int y0, int x1, int y1, const float* const* rgb)>;
+
+        /**
+         * @brief Film that writes its tiles into a tiled OpenEXR file (R, G, B) as they complete.
+         * @throws std::runtime_error If the file cannot be created.
+         */
+        TiledFilm(int width, int height, const std::string& exrPath, const Filter& filter = Filter::box(),
+            const TiledFilmOptions& options = {});
+
+        /// Film that hands its completed tiles to `sink` instead of a file.
+        TiledFilm(int width, int height, TileSink sink, const Filter& filter = Filter::box(),
+            const TiledFilmOptions& options = {});
+
+        /// Calls finish(); errors are reported on std::cerr.
+        ~TiledFilm();
+
+        TiledFilm(const TiledFilm&) = delete;
+        TiledFilm& operator=(const TiledFilm&) = delete;
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        const Filter& filter() const { return m_filter; }
+        AOV aovs() const { return AOV::None; }
+
+        /**
+         * @brief Creates an empty tile for samples with pFilm in [x0, x1) x [y0, y1).
+         */
+        FilmTile tile(int x0, int y0, int x1, int y1) const;
+
+        /**
+         * @brief Adds a finished tile (thread-safe) and streams out the storage tiles it completes.
+         */
+        void mergeTile(const FilmTile& tile);
+
+        /**
+         * @brief Streams out every storage tile not completed yet (black where nothing landed),
+         * closes the output and removes the scratch file. Later calls do nothing.
+         * @throws std::runtime_error If the output or the scratch file could not be written.
+         */
+        void finish();
+
+        struct Stats {
+            size_t residentBytes = 0;     ///< Storage tiles in memory now.
+            size_t peakResidentBytes = 0; ///< The most there ever were.
+            size_t pageOuts = 0;          ///< Tiles written to the scratch file.
+            size_t pageIns = 0;           ///< Tiles read back from it.
+            size_t tilesWritten = 0;      ///< Tiles handed to the sink.
+        };
+        Stats stats() const;
+
+    private:
+        enum class TileState : uint8_t { Untouched, Resident, Paged, Done };
+
+        struct Accum {
+            Spectrum sum{ 0.0 };
+            Real weight = 0;
+        };
+
+        struct StorageTile {
+            TileState state = TileState::Untouched;
+            int64_t pending = 0;     // sample positions that can still reach the tile
+            uint32_t slot = 0;       // scratch slot while paged
+            uint64_t stamp = 0;      // merge that last touched it
+            std::vector<Accum> pixels;
+            std::list<int>::iterator lru;
+        };
+
+        int m_width, m_height;
+        Filter m_filter;
+        TiledFilmOptions m_options;
+        int m_tilesX, m_tilesY;
+        TileSink m_sink;
+        std::unique_ptr<io::ExrTileWriter> m_writer;
+
+        mutable std::mutex m_mutex; // everything below
+        std::vector<StorageTile> m_tiles;
+        std::list<int> m_lru;       // resident tiles, most recently used first
+        uint64_t m_stamp = 0;
+        std::fstream m_scratch;
+        std::vector<uint32_t> m_freeSlots;
+        uint32_t m_slotCount = 0;
+        Stats m_stats;
+        bool m_finished = false;
+
+        void init();
+        void tileRect(int t, int& x0, int& y0, int& x1, int& y1) const;
+        void makeResident(int t);
+        void pageOut(int t);
+        void evict();
+        void emit(int t, const std::vector<Accum>& pixels) const;
+    };
+
+} // namespace rayt
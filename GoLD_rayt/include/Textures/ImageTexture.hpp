@@ -0,0 +1,93 @@
+#pragma once
+
+/**
+ * @file ImageTexture.hpp
+ * @brief Image-backed texture evaluated at a SurfaceInteraction with its UV footprint.
+ * * Wraps a (shared) MIPMap with a UV transform and a filter choice. The
+ * footprint comes from SurfaceInteraction::dudx/dvdx/dudy/dvdy, which the
+ * integrator fills from the camera's ray differentials (or the ray-cone
+ * fallback on secondary bounces).
+ * * Typical uses:
+ * - albedo maps:    ColorEncoding::sRGB,   evaluate()
+ * - roughness maps: ColorEncoding::Linear, evaluateFloat()
+ * - normal maps:    ColorEncoding::Linear, evaluateNormal()
+ */
+
+#include <memory>
+#include <string>
+
+#include "Core/Types.hpp"
+#include "Core/Interaction.hpp"
+#include "Textures/MIPMap.hpp"
+
+namespace rayt {
+
+    class ImageTexture {
+    public:
+        /**
+         * @brief Creates a texture over an existing pyramid (pyramids can be shared).
+         * @param mip    The MIP pyramid.
+         * @param filter Reconstruction filter.
+         * @param scale  UV tiling factor (st = uv * scale + offset).
+         * @param offset UV offset.
+         */
+        explicit ImageTexture(std::shared_ptr<const MIPMap> mip,
+            TextureFilter filter = TextureFilter::Trilinear,
+            const UV& scale = UV(1.0), const UV& offset = UV(0.0))
+            : m_mip(std::move(mip)), m_filter(filter), m_scale(scale), m_offset(offset) {}
+
+        /**
+         * @brief Convenience: lazily loaded, file-backed texture.
+         * @param filename Image path (loaded through io::loadImage on first use).
+         * @param encoding sRGB for color, Linear for roughness/normal data.
+         */
+        static std::shared_ptr<ImageTexture> fromFile(const std::string& filename,
+            io::ColorEncoding encoding,
+            TextureFilter filter = TextureFilter::Trilinear,
+            const UV& scale = UV(1.0),
+            WrapMode wrap = WrapMode::Repeat) {
+            auto mip = std::make_shared<MIPMap>(filename, encoding, wrap);
+            return std::make_shared<ImageTexture>(std::move(mip), filter, scale);
+        }
+
+        /**
+         * @brief Filtered RGB value at the hit.
+         */
+        Spectrum evaluate(const SurfaceInteraction& rec) const {
+            const UV st = rec.uv * m_scale + m_offset;
+            const UV dst0 = UV(rec.dudx, rec.dvdx) * m_scale;
+            const UV dst1 = UV(rec.dudy, rec.dvdy) * m_scale;
+            const Vector3 c = m_mip->lookup(st, dst0, dst1, m_filter);
+            return Spectrum(c.x, c.y, c.z);
+        }
+
+        /**
+         * @brief Filtered scalar (channel average) at the hit, for grayscale data maps.
+         */
+        Real evaluateFloat(const SurfaceInteraction& rec) const {
+            const Spectrum c = evaluate(rec);
+            return (c.x + c.y + c.z) * (Real(1.0) / Real(3.0));
+        }
+
+        /**
+         * @brief Tangent-space normal at the hit, decoded from [0, 1] to [-1, 1].
+         * @return Vector3 Normalized (x = along dpdu, y = bitangent, z = surface normal).
+         */
+        Vector3 evaluateNormal(const SurfaceInteraction& rec) const {
+            const Spectrum c = evaluate(rec);
+            Vector3 n(2 * c.x - 1, 2 * c.y - 1, 2 * c.z - 1);
+            const Real len2 = glm::dot(n, n);
+            return len2 > 0 ? n / std::sqrt(len2) : Vector3(0, 0, 1);
+        }
+
+        const MIPMap& mipmap() const { return *m_mip; }
+        TextureFilter filter() const { return m_filter; }
+
+    private:
+        std::shared_ptr<const MIPMap> m_mip;
+        TextureFilter m_filter;
+        UV m_scale;
+        UV m_offset;
+    };
+
+} // namespace rayt
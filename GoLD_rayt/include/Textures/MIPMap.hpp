@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * @file MIPMap.hpp
+ * @brief Tiled MIP pyramid with footprint-filtered lookups (bilinear, trilinear, EWA).
+ * * Texels live in fixed-size tiles served by a TileCache, never as one big
+ * array. A file-backed MIPMap is lazy: constructing it only records the
+ * path. The first lookup decodes the image with io::loadImage, builds the
+ * pyramid and stores it, tile by tile, in an io::AssetCache entry keyed by the
+ * image's content; after that the decoded image is released and tiles are
+ * copied out of the mapped entry on demand. Later runs map the entry without
+ * decoding, so a large texture set costs nothing until it is hit and then
+ * only as many tiles as the cache budget allows.
+ * * If the entry cannot be written (e.g. read-only cache directory), the
+ * pyramid stays resident and tiles are cut from it instead; lookups behave
+ * the same.
+ * * Filtering follows PBRT (3rd ed., Ch. 10.4): the trilinear filter picks the
+ * level from the largest footprint axis, EWA uses an elliptical Gaussian on
+ * the level matching the (anisotropy-clamped) minor axis.
+ */
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Core/Types.hpp"
+#include "Core/Image.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/ImageLoader.hpp"
+#include "Textures/TileCache.hpp"
+
+namespace rayt {
+
+    /**
+     * @brief Texture reconstruction filter.
+     */
+    enum class TextureFilter {
+        Bilinear,   ///< Finest level only (no prefiltering; aliases under minification).
+        Trilinear,  ///< Isotropic: blends the two levels bracketing the footprint width.
+        EWA         ///< Anisotropic elliptical weighted average (highest quality, most texels).
+    };
+
+    /**
+     * @brief What lookups outside [0, 1) do.
+     */
+    enum class WrapMode {
+        Repeat,
+        Clamp
+    };
+
+    class MIPMap {
+    public:
+        /// Edge length of a tile, in texels.
+        static constexpr int TILE_SIZE = 32;
+
+        /// EWA never lets the ellipse get more eccentric than this (bounds texel count).
+        static constexpr Real MAX_ANISOTROPY = 8.0;
+
+        /**
+         * @brief Lazily loaded texture backed by an image file.
+         * @param filename Image path (anything io::loadImage accepts).
+         * @param encoding ColorEncoding::sRGB for color maps, Linear for data maps.
+         * @param wrap     Behavior outside [0, 1).
+         * @param cache    Tile cache to use (the process-wide one by default).
+         * @param assets   Where the tiled pyramid is kept between runs.
+         */
+        MIPMap(std::string filename, io::ColorEncoding encoding,
+            WrapMode wrap = WrapMode::Repeat, TileCache& cache = TileCache::global(),
+            io::AssetCache assets = io::AssetCache());
+
+        /**
+         * @brief Resident texture built from an in-memory image (procedural or already decoded).
+         */
+        explicit MIPMap(const Image& image,
+            WrapMode wrap = WrapMode::Repeat, TileCache& cache = TileCache::global());
+
+        MIPMap(const MIPMap&) = delete;
+        MIPMap& operator=(const MIPMap&) = delete;
+
+        /// Number of pyramid levels (level 0 is full resolution). Triggers loading.
+        int levels() const;
+        int width(int level = 0) const;
+        int height(int level = 0) const;
+
+        /**
+         * @brief Single texel with wrap handling.
+         */
+        Vector3 texel(int level, int x, int y) const;
+
+        /**
+         * @brief Bilinear interpolation of one level at st in [0, 1]^2.
+         */
+        Vector3 bilerp(int level, const UV& st) const;
+
+        /**
+         * @brief Filtered lookup over the footprint spanned by two st-space axes.
+         * @param st     Texture coordinate of the footprint center.
+         * @param dst0   Footprint axis for one screen pixel in x (ds/dx, dt/dx).
+         * @param dst1   Footprint axis for one screen pixel in y (ds/dy, dt/dy).
+         * @param filter Reconstruction filter.
+         * @return Vector3 Filtered RGB value. A zero footprint degrades to bilinear on level 0.
+         */
+        Vector3 lookup(const UV& st, const UV& dst0, const UV& dst1, TextureFilter filter) const;
+
+        /// Whether texels come from a mapped cache entry (true) or a resident pyramid (false).
+        bool isFileBacked() const;
+
+        const std::string& filename() const { return m_filename; }
+
+    private:
+        struct LevelInfo {
+            int width = 0;
+            int height = 0;
+            int tilesX = 0;
+            int tilesY = 0;
+            size_t firstTile = 0; // index of the level's first tile in the cache entry
+        };
+
+        void ensureLoaded() const;
+        void loadFromFile() const;
+        void buildPyramid(const Image& image) const;
+        bool mapTiles(uint64_t key) const;
+        bool storeTiles(uint64_t key) const;
+        void setupLevels(const std::vector<std::pair<int, int>>& sizes) const;
+
+        const TextureTile& tile(int level, int tx, int ty) const;
+        TilePtr loadTile(int level, int tx, int ty) const;
+
+        Vector3 trilinear(const UV& st, Real width) const;
+        Vector3 ewa(int level, UV st, UV dst0, UV dst1) const;
+
+        std::string m_filename;
+        io::ColorEncoding m_encoding = io::ColorEncoding::sRGB;
+        WrapMode m_wrap = WrapMode::Repeat;
+        TileCache& m_cache;
+        io::AssetCache m_assets;
+        uint32_t m_textureId = 0;
+
+        // Filled once by ensureLoaded()
+        mutable std::once_flag m_loaded;
+        mutable std::vector<LevelInfo> m_levels;
+        mutable std::vector<std::vector<glm::vec3>> m_resident; // only when not file-backed
+        mutable bool m_fileBacked = false;
+        mutable io::CacheEntry m_entry;  // only when file-backed
+        mutable const glm::vec3* m_tiles = nullptr;
+    };
+
+} // namespace rayt
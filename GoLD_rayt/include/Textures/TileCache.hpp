@@ -0,0 +1,203 @@
+#pragma once
+
+/**
+ * @file TileCache.hpp
+ * @brief Bounded-memory LRU cache of texture tiles, shared by every texture and thread.
+ * * Textures never own their texels directly. A MIPMap asks the cache for the
+ * tile (texture, level, tx, ty); on a miss the MIPMap's loader reads it (from
+ * the mapped cache entry or the resident pyramid) and the cache keeps it
+ * until the byte budget forces it out, least recently used first.
+ * * The cache is split into shards, each with its own mutex, so threads that
+ * touch different tiles rarely contend. Tiles are handed out as
+ * shared_ptr<const TextureTile>: an evicted tile stays valid for whoever is
+ * still holding it, so eviction never races with a lookup in flight.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace rayt {
+
+    /**
+     * @brief A square block of RGB texels from one MIP level (row-major, float).
+     */
+    struct TextureTile {
+        int size = 0;
+        std::vector<glm::vec3> texels;
+
+        explicit TextureTile(int size) : size(size), texels(size_t(size) * size) {}
+
+        const glm::vec3& at(int x, int y) const { return texels[size_t(y) * size + x]; }
+        size_t bytes() const { return texels.size() * sizeof(glm::vec3) + sizeof(TextureTile); }
+    };
+
+    using TilePtr = std::shared_ptr<const TextureTile>;
+
+    /**
+     * @brief Identifies one tile of one MIP level of one texture.
+     */
+    struct TileKey {
+        uint32_t texture = 0;
+        uint32_t level = 0;
+        uint32_t tx = 0;
+        uint32_t ty = 0;
+
+        bool operator==(const TileKey& o) const {
+            return texture == o.texture && level == o.level && tx == o.tx && ty == o.ty;
+        }
+
+        size_t hash() const {
+            uint64_t h = (uint64_t(texture) * 0x9E3779B97F4A7C15ull) ^
+                (uint64_t(level) << 56) ^ (uint64_t(ty) << 28) ^ uint64_t(tx);
+            h ^= h >> 31;
+            h *= 0xBF58476D1CE4E5B9ull;
+            return size_t(h ^ (h >> 29));
+        }
+    };
+
+    class TileCache {
+    public:
+        /// Default budget of the process-wide cache.
+        static constexpr size_t DEFAULT_CAPACITY = size_t(256) << 20; // 256 MiB
+
+        explicit TileCache(size_t capacityBytes = DEFAULT_CAPACITY) { setCapacity(capacityBytes); }
+
+        TileCache(const TileCache&) = delete;
+        TileCache& operator=(const TileCache&) = delete;
+
+        /**
+         * @brief The cache shared by all textures unless one is given explicitly.
+         */
+        static TileCache& global() {
+            static TileCache cache;
+            return cache;
+        }
+
+        /**
+         * @brief Allocates a process-unique texture id for TileKey::texture.
+         * * Ids are never reused, so stale entries of a destroyed texture can
+         * only age out, never alias a new one.
+         */
+        static uint32_t newTextureId() {
+            static std::atomic<uint32_t> next{ 1 };
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Sets the byte budget (split evenly across shards) and evicts down to it.
+         */
+        void setCapacity(size_t capacityBytes) {
+            m_capacity = capacityBytes;
+            for (Shard& s : m_shards) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.capacity = std::max<size_t>(capacityBytes / SHARDS, 1);
+                evict(s);
+            }
+        }
+
+        size_t capacity() const { return m_capacity; }
+
+        /**
+         * @brief Returns the tile for key, calling load() to produce it on a miss.
+         * * load() runs without any cache lock held, so a slow read does not
+         * stall other threads. If two threads miss on the same key at once,
+         * both load and the first insert wins.
+         * @param key  Tile identity.
+         * @param load Callable returning TilePtr.
+         */
+        template <typename LoadFn>
+        TilePtr get(const TileKey& key, LoadFn&& load) {
+            Shard& s = m_shards[key.hash() % SHARDS];
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                auto it = s.index.find(key);
+                if (it != s.index.end()) {
+                    s.lru.splice(s.lru.begin(), s.lru, it->second);
+                    m_hits.fetch_add(1, std::memory_order_relaxed);
+                    return it->second->second;
+                }
+            }
+
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            TilePtr tile = load();
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.index.find(key);
+            if (it != s.index.end()) return it->second->second; // lost the race
+
+            s.lru.emplace_front(key, tile);
+            s.index.emplace(key, s.lru.begin());
+            s.bytes += tile->bytes();
+            evict(s);
+            return tile;
+        }
+
+        /// Drops every cached tile (tiles still held by callers stay alive).
+        void clear() {
+            for (Shard& s : m_shards) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.lru.clear();
+                s.index.clear();
+                s.bytes = 0;
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Statistics
+        // ---------------------------------------------------------------------
+        size_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+        size_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+        size_t bytesUsed() {
+            size_t total = 0;
+            for (Shard& s : m_shards) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                total += s.bytes;
+            }
+            return total;
+        }
+
+    private:
+        static constexpr size_t SHARDS = 16;
+
+        struct KeyHash {
+            size_t operator()(const TileKey& k) const { return k.hash(); }
+        };
+
+        using Entry = std::pair<TileKey, TilePtr>;
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<Entry> lru; // front = most recently used
+            std::unordered_map<TileKey, std::list<Entry>::iterator, KeyHash> index;
+            size_t bytes = 0;
+            size_t capacity = 0;
+        };
+
+        // Keeps at least the newest tile so one oversized tile cannot thrash forever
+        static void evict(Shard& s) {
+            while (s.bytes > s.capacity && s.lru.size() > 1) {
+                Entry& victim = s.lru.back();
+                s.bytes -= victim.second->bytes();
+                s.index.erase(victim.first);
+                s.lru.pop_back();
+            }
+        }
+
+        std::array<Shard, SHARDS> m_shards;
+        size_t m_capacity = 0;
+        std::atomic<size_t> m_hits{ 0 };
+        std::atomic<size_t> m_misses{ 0 };
+    };
+
+} // namespace rayt
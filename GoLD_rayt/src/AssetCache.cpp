@@ -0,0 +1,238 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <ostream>
+
+#include "IO/AssetCache.hpp"
+#include "IO/AtomicWrite.hpp"
+
+namespace rayt::io {
+
+    namespace {
+
+        constexpr char ENTRY_MAGIC[8] = { 'R', 'A', 'Y', 'T', 'C', 'A', 'C', 'H' };
+        constexpr uint32_t LAYOUT_VERSION = 1;
+        constexpr uint32_t ENDIAN_TAG = 0x01020304u;
+        constexpr size_t SECTION_ALIGN = 64;
+        constexpr uint32_t MAX_SECTIONS = 64;
+
+        /**
+         * @brief Fixed-size header of an entry, followed by `sectionCount` SectionRecords, then the sections.
+         */
+        struct EntryHeader {
+            char magic[8];
+            uint32_t layoutVersion;
+            uint32_t endianTag;
+            char kind[16];
+            uint32_t formatVersion;
+            uint32_t sectionCount;
+            uint64_t key;
+            uint64_t fileSize;
+        };
+
+        struct SectionRecord {
+            uint64_t offset;
+            uint64_t bytes;
+        };
+
+        size_t alignUp(size_t n) { return (n + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN; }
+
+        // ---------------------------------------------------------------------
+        // XXH64 (Y. Collet), seeded with the hash so far
+        // ---------------------------------------------------------------------
+
+        constexpr uint64_t P1 = 11400714785074694791ull;
+        constexpr uint64_t P2 = 14029467366897019727ull;
+        constexpr uint64_t P3 = 1609587929392839161ull;
+        constexpr uint64_t P4 = 9650029242287828579ull;
+        constexpr uint64_t P5 = 2870177450012600261ull;
+
+        uint64_t read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+        uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+        uint64_t round(uint64_t acc, uint64_t input) { return std::rotl(acc + input * P2, 31) * P1; }
+        uint64_t merge(uint64_t acc, uint64_t v) { return (acc ^ round(0, v)) * P1 + P4; }
+
+        uint64_t xxh64(const uint8_t* p, size_t len, uint64_t seed) {
+            const uint8_t* const end = p + len;
+            uint64_t h;
+            if (len >= 32) {
+                uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+                for (; end - p >= 32; p += 32) {
+                    v1 = round(v1, read64(p));
+                    v2 = round(v2, read64(p + 8));
+                    v3 = round(v3, read64(p + 16));
+                    v4 = round(v4, read64(p + 24));
+                }
+                h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+                h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+            }
+            else {
+                h = seed + P5;
+            }
+            h += uint64_t(len);
+
+            for (; end - p >= 8; p += 8) h = std::rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+            if (end - p >= 4) {
+                h = std::rotl(h ^ (uint64_t(read32(p)) * P1), 23) * P2 + P3;
+                p += 4;
+            }
+            for (; p < end; ++p) h = std::rotl(h ^ (*p * P5), 11) * P1;
+
+            h ^= h >> 33;
+            h *= P2;
+            h ^= h >> 29;
+            h *= P3;
+            h ^= h >> 32;
+            return h;
+        }
+
+    } // namespace
+
+    CacheKey& CacheKey::add(const void* data, size_t bytes) {
+        m_hash = xxh64(static_cast<const uint8_t*>(data), bytes, m_hash);
+        return *this;
+    }
+
+    bool CacheKey::addFile(const std::string& path) {
+        MappedFile file;
+        if (!file.open(path)) return false;
+        add(uint64_t(file.size()));
+        add(file.data(), file.size());
+        return true;
+    }
+
+    std::string AssetCache::path(const std::string& kind, uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "-%016llx.bin", static_cast<unsigned long long>(key));
+        return (std::filesystem::path(m_directory) / (kind + name)).string();
+    }
+
+    bool AssetCache::load(const std::string& kind, uint32_t formatVersion, uint64_t key, CacheEntry& entry) const {
+        entry = CacheEntry();
+        if (kind.size() >= sizeof(EntryHeader::kind)) return false;
+
+        const std::string entryPath = path(kind, key);
+        auto file = std::make_shared<MappedFile>();
+        if (!file->open(entryPath) || file->size() < sizeof(EntryHeader)) return false;
+
+        EntryHeader header{};
+        std::memcpy(&header, file->data(), sizeof(header));
+        char expectedKind[sizeof(header.kind)] = {};
+        std::memcpy(expectedKind, kind.data(), kind.size());
+        if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+            header.layoutVersion != LAYOUT_VERSION ||
+            header.endianTag != ENDIAN_TAG ||
+            std::memcmp(header.kind, expectedKind, sizeof(expectedKind)) != 0 ||
+            header.formatVersion != formatVersion ||
+            header.key != key ||
+            header.fileSize != file->size() ||
+            header.sectionCount > MAX_SECTIONS ||
+            file->size() < sizeof(EntryHeader) + header.sectionCount * sizeof(SectionRecord)) {
+            return false;
+        }
+
+        CacheEntry result;
+        const char* records = static_cast<const char*>(file->data()) + sizeof(EntryHeader);
+        for (uint32_t i = 0; i < header.sectionCount; ++i) {
+            SectionRecord record{};
+            std::memcpy(&record, records + i * sizeof(SectionRecord), sizeof(record));
+            if (record.offset % SECTION_ALIGN != 0 || record.offset > file->size() || record.bytes > file->size() - record.offset)
+                return false;
+            result.m_sections.emplace_back(size_t(record.offset), size_t(record.bytes));
+        }
+        result.m_file = std::move(file);
+        entry = std::move(result);
+
+        // Marks the entry as used for prune()
+        std::error_code ec;
+        std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+        return true;
+    }
+
+    bool AssetCache::store(const std::string& kind, uint32_t formatVersion, uint64_t key, const std::vector<CacheSection>& sections) const {
+        if (kind.size() >= sizeof(EntryHeader::kind) || sections.size() > MAX_SECTIONS) return false;
+
+        EntryHeader header{};
+        std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        header.layoutVersion = LAYOUT_VERSION;
+        header.endianTag = ENDIAN_TAG;
+        std::memcpy(header.kind, kind.data(), kind.size());
+        header.formatVersion = formatVersion;
+        header.sectionCount = uint32_t(sections.size());
+        header.key = key;
+
+        std::vector<SectionRecord> records(sections.size());
+        size_t offset = alignUp(sizeof(EntryHeader) + sections.size() * sizeof(SectionRecord));
+        for (size_t i = 0; i < sections.size(); ++i) {
+            records[i] = { uint64_t(offset), uint64_t(sections[i].bytes) };
+            offset = alignUp(offset + sections[i].bytes);
+        }
+        header.fileSize = offset;
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+        const std::string target = path(kind, key);
+
+        const bool stored = atomicWrite(target, [&](std::ostream& out) {
+            const char zeros[SECTION_ALIGN] = {};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(SectionRecord)));
+            size_t written = sizeof(EntryHeader) + records.size() * sizeof(SectionRecord);
+            for (size_t i = 0; i < sections.size(); ++i) {
+                out.write(zeros, std::streamsize(records[i].offset - written));
+                out.write(static_cast<const char*>(sections[i].data), std::streamsize(sections[i].bytes));
+                written = size_t(records[i].offset + records[i].bytes);
+            }
+            out.write(zeros, std::streamsize(header.fileSize - written));
+            });
+        if (stored) prune(target);
+        return stored;
+    }
+
+    void AssetCache::prune(const std::string& keep) const {
+        namespace fs = std::filesystem;
+        struct File {
+            fs::path path;
+            fs::file_time_type time;
+            uintmax_t bytes;
+        };
+
+        std::error_code walk, ec;
+        const fs::file_time_type now = fs::file_time_type::clock::now();
+        std::vector<File> files;
+        uintmax_t total = 0;
+        for (fs::directory_iterator it(m_directory, walk), end; !walk && it != end; it.increment(walk)) {
+            const fs::directory_entry& e = *it;
+            if (!e.is_regular_file(ec)) continue;
+            const fs::file_time_type time = e.last_write_time(ec);
+            if (ec) continue;
+            const File f{ e.path(), time, e.file_size(ec) };
+            if (ec) continue;
+            // Temporaries of writers that crashed; a live writer's are seconds old
+            if (f.path.extension() == ".tmp") {
+                if (now - f.time > std::chrono::hours(1)) fs::remove(f.path, ec);
+                continue;
+            }
+            if (f.path.extension() != ".bin") continue;
+            files.push_back(f);
+            total += f.bytes;
+        }
+        if (total <= m_maxBytes) return;
+
+        // Least recently used first (load() refreshes the time of a hit)
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+        for (const File& f : files) {
+            if (total <= m_maxBytes) break;
+            if (f.path == fs::path(keep)) continue;
+            // Fails for entries mapped by another process on Windows; they go on a later pass
+            if (fs::remove(f.path, ec)) total -= f.bytes;
+        }
+    }
+
+} // namespace rayt::io
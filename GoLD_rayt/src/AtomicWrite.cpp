@@ -0,0 +1,51 @@
+#include "pch.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "IO/AtomicWrite.hpp"
+
+namespace rayt::io {
+
+    std::string uniqueFileTag() {
+        static const uint32_t processTag = std::random_device{}();
+        static std::atomic<uint32_t> counter{ 0 };
+        std::ostringstream tag;
+        tag << std::hex << processTag << '-' << counter.fetch_add(1);
+        return tag.str();
+    }
+
+    bool atomicWrite(const std::string& path, const std::function<void(std::ostream&)>& write) {
+        const std::string tmp = path + "." + uniqueFileTag() + ".tmp";
+        std::error_code ec;
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out) return false;
+            try {
+                write(out);
+            }
+            catch (...) {
+                out.close();
+                std::filesystem::remove(tmp, ec);
+                throw;
+            }
+            out.close();
+            if (!out) {
+                std::filesystem::remove(tmp, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace rayt::io
@@ -0,0 +1,33 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Geometry/HittableList.hpp"
+#include "Geometry/Sphere.hpp"
+#include "Materials/MaterialTable.hpp"
+#include "DebugTools/DebugScenes.hpp"
+
+namespace rayt::debug {
+
+    Scene makeGoldRoughnessScene(std::vector<std::string>* regionNames) {
+        const Spectrum nAu(0.16, 0.42, 1.45), kAu(3.48, 2.45, 1.77);
+        MaterialTable materials;
+        const MaterialId floor = materials.emplace<Lambertian>(Spectrum(0.5));
+        const MaterialId left = materials.emplace<RoughConductor>(nAu, kAu, 0.01);
+        const MaterialId middle = materials.emplace<RoughConductor>(nAu, kAu, 0.2);
+        const MaterialId right = materials.emplace<RoughConductor>(nAu, kAu, 0.5);
+        if (regionNames) *regionNames = { "floor", "gold 0.01", "gold 0.2", "gold 0.5", "background" };
+
+        auto world = std::make_shared<HittableList>();
+        world->add(std::make_shared<Sphere>(Point3(0, -100.5, -1), 100.0, floor));
+        world->add(std::make_shared<Sphere>(Point3(-1.2, 0, -1), 0.5, left));
+        world->add(std::make_shared<Sphere>(Point3(0.0, 0, -1), 0.5, middle));
+        world->add(std::make_shared<Sphere>(Point3(1.2, 0, -1), 0.5, right));
+        return Scene(world, std::move(materials));
+    }
+
+    std::shared_ptr<Camera> makeGoldRoughnessCamera(int width, int height) {
+        const Point3 lookFrom(0, 0.5, 2.5), lookAt(0, 0, -1);
+        return std::make_shared<Camera>(lookFrom, lookAt, Vector3(0, 1, 0), 35.0,
+            double(width) / height, 0.0, glm::length(lookFrom - lookAt));
+    }
+
+}
@@ -0,0 +1,951 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "Core/Distribution1D.hpp"
+#include "Core/Distribution2D.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/AliasTable.hpp"
+#include "IO/EnvMap.hpp"
+#include "Renderer/EnvProductSampler.hpp"
+#include "IO/ImageLoader.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/SpectralIORTable.hpp"
+#include "Renderer/Film.hpp"
+#include "Renderer/Integrator.hpp"
+#include "DebugTools/DebugScenes.hpp"
+#include "DebugTools/EnvDebug.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include "Core/TiledImage.hpp"
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rayt::debug {
+
+    namespace {
+
+        template <typename F>
+        double secondsFor(F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(t1 - t0).count();
+        }
+
+        // Sky-like weights: smooth gradient, texel noise and one small bright "sun", times sin(theta)
+        std::vector<float> makeSky(int w, int h) {
+            std::vector<float> data(size_t(w) * h);
+            for (int y = 0; y < h; ++y) {
+                const float sinT = float(std::sin(constants::PI * (y + 0.5) / h));
+                for (int x = 0; x < w; ++x) {
+                    const float dx = float(x - w / 3) / w, dy = float(y - h / 4) / h;
+                    const float sun = dx * dx + dy * dy < 1e-5f ? 5e4f : 0.0f;
+                    data[size_t(y) * w + x] = (0.2f + 0.8f * y / h + 0.3f * float(sampling::Random()) + sun) * sinT;
+                }
+            }
+            return data;
+        }
+
+        /// Distribution2D as it was before the arena: one heap-allocated Distribution1D per row.
+        struct RowListDistribution2D {
+            std::vector<std::unique_ptr<Distribution1D>> rows;
+            std::unique_ptr<Distribution1D> marginal;
+
+            RowListDistribution2D(const float* data, int w, int h) {
+                std::vector<float> integrals;
+                for (int v = 0; v < h; ++v) {
+                    rows.emplace_back(std::make_unique<Distribution1D>(&data[size_t(v) * w], w));
+                    integrals.push_back(rows.back()->funcInt);
+                }
+                marginal = std::make_unique<Distribution1D>(integrals.data(), h);
+            }
+
+            void sampleContinuous(const Point2& u, Point2& uv, float& pdf) const {
+                float pdfV, pdfU;
+                int vOff, uOff;
+                const float v = marginal->sampleContinuous(u.y, pdfV, vOff);
+                const float x = rows[vOff]->sampleContinuous(u.x, pdfU, uOff);
+                uv = Point2(x, v);
+                pdf = pdfU * pdfV;
+            }
+
+            float pdf(const Point2& uv) const {
+                const int h = marginal->count(), w = rows[0]->count();
+                const int v = std::clamp(int(uv.y * h), 0, h - 1);
+                const int u = std::clamp(int(uv.x * w), 0, w - 1);
+                if (marginal->funcInt == 0.0f) return 1.0f;
+                if (rows[v]->funcInt == 0.0f) return 0.0f;
+                return (marginal->func[v] / marginal->funcInt) * (rows[v]->func[u] / rows[v]->funcInt);
+            }
+
+            /// Payload bytes; every Distribution1D and each of its two vectors is a separate heap block.
+            size_t memoryBytes() const {
+                size_t total = (marginal->func.size() + marginal->cdf.size()) * sizeof(float);
+                for (const auto& r : rows) total += sizeof(Distribution1D) + (r->func.size() + r->cdf.size()) * sizeof(float);
+                return total + rows.size() * sizeof(rows[0]);
+            }
+        };
+
+        Real luminance(const Vector3& rgb) { return 0.2126 * rgb.x + 0.7152 * rgb.y + 0.0722 * rgb.z; }
+
+        // ns per sample and per pdf() lookup over random (cache-missing) positions
+        template <typename Dist>
+        void measureLatency(const char* name, const Dist& dist, const std::vector<Point2>& us) {
+            float sink = 0;
+            const double tSample = secondsFor([&] {
+                for (const Point2& u : us) {
+                    Point2 uv;
+                    float pdf;
+                    dist.sampleContinuous(u, uv, pdf);
+                    sink += uv.x + pdf;
+                }
+                });
+            const double tPdf = secondsFor([&] {
+                for (const Point2& u : us) sink += dist.pdf(u);
+                });
+            std::cout << "  " << name << ": " << tSample * 1e9 / us.size() << " ns/sample, "
+                << tPdf * 1e9 / us.size() << " ns/pdf  (sink " << sink << ")\n";
+        }
+
+        // ns per sample, pdf(sample) agreement, and a coarse histogram against the exact density
+        template <typename Dist>
+        void measure(const char* name, const Dist& dist, const std::vector<float>& data, int w, int h) {
+            constexpr int N = 1 << 21;
+            std::vector<Point2> us(N);
+            for (Point2& u : us) u = Point2(float(sampling::Random()), float(sampling::Random()));
+
+            float sink = 0;
+            const double t = secondsFor([&] {
+                for (const Point2& u : us) {
+                    Point2 uv;
+                    float pdf;
+                    dist.sampleContinuous(u, uv, pdf);
+                    sink += uv.x + pdf;
+                }
+                });
+
+            // Coarse cells so the histogram converges; expected mass from the data
+            constexpr int CX = 32, CY = 16;
+            std::vector<double> expected(CX * CY, 0.0), observed(CX * CY, 0.0);
+            double total = 0;
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x) {
+                    expected[(y * CY / h) * CX + x * CX / w] += data[size_t(y) * w + x];
+                    total += data[size_t(y) * w + x];
+                }
+            double pdfErr = 0;
+            for (int i = 0; i < N; ++i) {
+                Point2 uv;
+                float pdf;
+                dist.sampleContinuous(us[i], uv, pdf);
+                const int cx = std::min(int(uv.x * CX), CX - 1), cy = std::min(int(uv.y * CY), CY - 1);
+                observed[cy * CX + cx] += 1.0 / N;
+                if (pdf > 0) pdfErr = std::max(pdfErr, double(std::abs(dist.pdf(uv) - pdf) / pdf));
+            }
+            double histErr = 0;
+            for (int i = 0; i < CX * CY; ++i) {
+                const double e = expected[i] / total;
+                if (e > 1e-3) histErr = std::max(histErr, std::abs(observed[i] - e) / e);
+            }
+
+            std::cout << "  " << name << ": " << t * 1e9 / N << " ns/sample, "
+                << dist.memoryBytes() / double(1 << 20) << " MiB, max |pdf(uv) - sample pdf| / pdf = " << pdfErr
+                << ", max histogram deviation " << histErr * 100 << " %  (sink " << sink << ")\n";
+        }
+
+        // Set-associative LRU cache with 64-byte lines, fed with the addresses a lookup reads
+        class CacheModel {
+        public:
+            CacheModel(size_t bytes, int ways)
+                : m_sets(bytes / 64 / ways), m_ways(ways), m_lines(m_sets * ways, ~uint64_t(0)), m_stamps(m_sets * ways, 0) {}
+
+            void read(uint64_t address, size_t bytes) {
+                for (uint64_t line = address >> 6; line <= (address + bytes - 1) >> 6; ++line) touch(line);
+            }
+            uint64_t misses() const { return m_misses; }
+
+        private:
+            size_t m_sets;
+            size_t m_ways;
+            std::vector<uint64_t> m_lines;
+            std::vector<uint64_t> m_stamps;
+            uint64_t m_clock = 0;
+            uint64_t m_misses = 0;
+
+            void touch(uint64_t line) {
+                const size_t set = size_t(line % m_sets) * m_ways;
+                size_t victim = set;
+                ++m_clock;
+                for (size_t i = set; i < set + m_ways; ++i) {
+                    if (m_lines[i] == line) { m_stamps[i] = m_clock; return; }
+                    if (m_stamps[i] < m_stamps[victim]) victim = i;
+                }
+                m_lines[victim] = line;
+                m_stamps[victim] = m_clock;
+                ++m_misses;
+            }
+        };
+
+        // Hardware cache-miss counter (perf_event_open); count() is -1 where there is none
+        // (other platforms, VMs without a virtual PMU, perf_event_paranoid)
+        class MissCounter {
+        public:
+            explicit MissCounter(bool lastLevel) {
+#ifdef __linux__
+                perf_event_attr attr{};
+                attr.size = sizeof(attr);
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = (lastLevel ? PERF_COUNT_HW_CACHE_LL : PERF_COUNT_HW_CACHE_L1D)
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                m_fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+                (void)lastLevel;
+#endif
+            }
+            ~MissCounter() {
+#ifdef __linux__
+                if (m_fd >= 0) close(m_fd);
+#endif
+            }
+            MissCounter(const MissCounter&) = delete;
+            MissCounter& operator=(const MissCounter&) = delete;
+
+            template <typename F>
+            long long count(F&& f) {
+#ifdef __linux__
+                if (m_fd >= 0) {
+                    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+                    f();
+                    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+                    long long value = 0;
+                    if (::read(m_fd, &value, sizeof(value)) == sizeof(value)) return value;
+                }
+#endif
+                f();
+                return -1;
+            }
+
+        private:
+            int m_fd = -1;
+        };
+
+    } // namespace
+
+    void TestEnvSampling(const std::string& hdrPath) {
+        // ---------------------------------------------------------------------
+        // 1. Samplers alone on a large map (the tables no longer fit in cache)
+        // ---------------------------------------------------------------------
+        {
+            constexpr int W = 8192, H = 4096;
+            std::cout << "\n[Debug] Env sampling tables, synthetic " << W << "x" << H << " sky\n";
+            const std::vector<float> data = makeSky(W, H);
+
+            std::unique_ptr<Distribution2D> cdf;
+            std::unique_ptr<AliasTable2D> alias;
+            const double tCdf = secondsFor([&] { cdf = std::make_unique<Distribution2D>(data.data(), W, H); });
+            const double tAlias = secondsFor([&] { alias = std::make_unique<AliasTable2D>(data.data(), W, H); });
+            std::cout << "  build: CDF " << tCdf << " s, alias " << tAlias << " s\n";
+
+            measure("CDF  ", *cdf, data, W, H);
+            measure("alias", *alias, data, W, H);
+        }
+
+        // ---------------------------------------------------------------------
+        // 2. EnvMap::sample / pdf on the scene's HDRI, both modes
+        // ---------------------------------------------------------------------
+        Image img;
+        try {
+            img = io::loadHDR(hdrPath);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] EnvMap NEE sampling, " << hdrPath << " (" << img.width() << "x" << img.height() << ")\n";
+
+        const EnvMap cdfEnv(img, EnvSampling::CDF);
+        const EnvMap aliasEnv(std::move(img), EnvSampling::Alias);
+
+        constexpr int N = 1 << 20;
+        std::vector<Point2> us(N);
+        for (Point2& u : us) u = Point2(float(sampling::Random()), float(sampling::Random()));
+
+        for (const EnvMap* env : { &cdfEnv, &aliasEnv }) {
+            Real sink = 0;
+            const double t = secondsFor([&] {
+                for (const Point2& u : us) {
+                    Vector3 wi;
+                    Real pdf;
+                    sink += env->sample(u, wi, pdf).x + pdf;
+                }
+                });
+
+            // The two modes must agree on the density of every direction (MIS relies on it)
+            double modeErr = 0, selfErr = 0;
+            for (int i = 0; i < 100000; ++i) {
+                Vector3 wi;
+                Real pdf;
+                env->sample(us[i], wi, pdf);
+                if (pdf <= 0) continue;
+                selfErr = std::max(selfErr, std::abs(env->pdf(wi) - pdf) / pdf);
+                modeErr = std::max(modeErr, std::abs(cdfEnv.pdf(wi) - aliasEnv.pdf(wi)) / pdf);
+            }
+            std::cout << "  " << (env->sampling() == EnvSampling::CDF ? "CDF  " : "alias") << ": "
+                << t * 1e9 / N << " ns/sample, " << env->distributionBytes() / double(1 << 20) << " MiB"
+                << ", max |pdf(wi) - sample pdf| / pdf = " << selfErr
+                << ", max |pdf_CDF - pdf_alias| / pdf = " << modeErr << "  (sink " << sink << ")\n";
+        }
+    }
+
+    void TestDistributionLayout(int width, int height) {
+        std::cout << "\n[Debug] Distribution2D layout, synthetic " << width << "x" << height
+            << " sky, " << hardwareThreads() << " thread(s)\n";
+        const std::vector<float> data = makeSky(width, height);
+
+        std::unique_ptr<RowListDistribution2D> rowList;
+        std::unique_ptr<Distribution2D> flat;
+        const double tRowList = secondsFor([&] { rowList = std::make_unique<RowListDistribution2D>(data.data(), width, height); });
+        const double tFlat = secondsFor([&] { flat = std::make_unique<Distribution2D>(data.data(), width, height); });
+        std::cout << "  build: per-row " << tRowList << " s, flat " << tFlat << " s\n"
+            << "  memory: per-row " << rowList->memoryBytes() / double(1 << 20) << " MiB in "
+            << 3 * size_t(height) + 4 << " heap blocks, flat "
+            << flat->memoryBytes() / double(1 << 20) << " MiB in 1\n";
+
+        constexpr int N = 1 << 21;
+        std::vector<Point2> us(N);
+        for (Point2& u : us) u = Point2(float(sampling::Random()), float(sampling::Random()));
+
+        // Same arithmetic, so samples and densities must match bit for bit
+        int mismatches = 0;
+        for (const Point2& u : us) {
+            Point2 uvA, uvB;
+            float pdfA, pdfB;
+            rowList->sampleContinuous(u, uvA, pdfA);
+            flat->sampleContinuous(u, uvB, pdfB);
+            if (std::memcmp(&uvA, &uvB, sizeof(uvA)) != 0 || pdfA != pdfB || rowList->pdf(uvA) != flat->pdf(uvB)) ++mismatches;
+        }
+        std::cout << "  mismatching samples: " << mismatches << " / " << N << "\n";
+
+        measureLatency("per-row", *rowList, us);
+        measureLatency("flat   ", *flat, us);
+    }
+
+    void TestEnvLayout(const std::string& hdrPath) {
+        Image img;
+        try {
+            img = io::loadHDR(hdrPath);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] EnvMap layouts, " << hdrPath << " (" << img.width() << "x" << img.height() << ")\n";
+
+        std::unique_ptr<EnvMap> equirect, octahedral;
+        const double tEquirect = secondsFor([&] { equirect = std::make_unique<EnvMap>(img, EnvSampling::Alias, EnvLayout::Equirect); });
+        const double tOctahedral = secondsFor([&] { octahedral = std::make_unique<EnvMap>(std::move(img), EnvSampling::Alias, EnvLayout::Octahedral); });
+        std::cout << "  build: equirect " << tEquirect << " s, octahedral " << tOctahedral << " s ("
+            << octahedral->texels().width() << "^2 texels, resampling included)\n";
+
+        constexpr int N = 1 << 20;
+        std::vector<Point2> us(N);
+        std::vector<Vector3> dirs(N);
+        for (int i = 0; i < N; ++i) {
+            us[i] = Point2(float(sampling::Random()), float(sampling::Random()));
+            dirs[i] = sampling::UniformSampleSphere(Point2(float(sampling::Random()), float(sampling::Random())));
+        }
+
+        // Spread of the NEE weights L / pdf among samples within 10 degrees of
+        // either pole. For a constant map this is all Jacobian mismatch: zero
+        // when the pdf follows the solid angle exactly.
+        const Real capCos = std::cos(10.0 * constants::DEG_TO_RAD);
+        auto poleWeightSpread = [&](const EnvMap& env) {
+            Real sum = 0, sq = 0;
+            int count = 0;
+            for (const Point2& u : us) {
+                Vector3 wi;
+                Real pdf;
+                const Vector3 Le = env.sample(u, wi, pdf);
+                if (pdf <= 0 || std::abs(wi.y) < capCos) continue;
+                const Real w = luminance(Le) / pdf;
+                sum += w; sq += w * w;
+                ++count;
+            }
+            const Real mean = count ? sum / count : Real(0);
+            return mean > 0 ? std::sqrt(std::max(Real(0), sq / count - mean * mean)) / mean : Real(0);
+        };
+
+        for (const EnvMap* env : { equirect.get(), octahedral.get() }) {
+            Real sink = 0;
+            const double tEval = secondsFor([&] { for (const Vector3& d : dirs) sink += env->eval(d).x; });
+            const double tPdf = secondsFor([&] { for (const Vector3& d : dirs) sink += env->pdf(d); });
+            const double tSample = secondsFor([&] {
+                for (const Point2& u : us) {
+                    Vector3 wi;
+                    Real pdf;
+                    sink += env->sample(u, wi, pdf).x + pdf;
+                }
+                });
+
+            // Uniform-sphere estimate of the total power: the resampling must keep it
+            Real total = 0;
+            for (const Vector3& d : dirs) total += luminance(env->eval(d)) * constants::FOUR_PI / N;
+
+            // Irradiance at an upward normal from NEE alone, and its per-sample noise
+            double selfErr = 0;
+            Real eSum = 0, eSq = 0;
+            for (int i = 0; i < N; ++i) {
+                Vector3 wi;
+                Real pdf;
+                const Vector3 Le = env->sample(us[i], wi, pdf);
+                if (pdf <= 0) continue;
+                if (i < 100000) selfErr = std::max(selfErr, std::abs(env->pdf(wi) - pdf) / pdf);
+                const Real e = luminance(Le) * std::max(wi.y, Real(0)) / pdf;
+                eSum += e; eSq += e * e;
+            }
+            const Real eMean = eSum / N;
+
+            std::cout << "  " << (env->layout() == EnvLayout::Equirect ? "equirect  " : "octahedral") << ": eval "
+                << tEval * 1e9 / N << " ns, pdf " << tPdf * 1e9 / N << " ns, sample " << tSample * 1e9 / N << " ns\n"
+                << "              total power " << total << ", max |pdf(wi) - sample pdf| / pdf = " << selfErr << "\n"
+                << "              irradiance at +Y " << eMean << ", per-sample relative std " << std::sqrt(std::max(Real(0), eSq / N - eMean * eMean)) / eMean
+                << "; pole-cap NEE weight spread " << poleWeightSpread(*env) << "  (sink " << sink << ")\n";
+        }
+
+        const Image white(512, 256, std::vector<Vector3>(512 * 256, Vector3(1.0)));
+        std::cout << "  constant map, pole-cap NEE weight spread: equirect "
+            << poleWeightSpread(EnvMap(white, EnvSampling::Alias, EnvLayout::Equirect)) << ", octahedral "
+            << poleWeightSpread(EnvMap(white, EnvSampling::Alias, EnvLayout::Octahedral)) << "\n";
+    }
+
+    void TestEnvProductSampling(const std::string& hdrPath) {
+        std::shared_ptr<EnvMap> env;
+        try {
+            env = std::make_shared<EnvMap>(io::loadHDR(hdrPath));
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] Env x lobe product sampling, " << hdrPath << "\n";
+
+        std::unique_ptr<EnvProductSampler> product;
+        const double tBuild = secondsFor([&] { product = std::make_unique<EnvProductSampler>(env); });
+        std::cout << "  build " << tBuild << " s, " << product->memoryBytes() / double(1 << 20) << " MiB\n";
+
+        constexpr int N = 1 << 18;
+        std::vector<Point2> us(N);
+        std::vector<Vector3> dirs(N);
+        for (int i = 0; i < N; ++i) {
+            us[i] = Point2(float(sampling::Random()), float(sampling::Random()));
+            dirs[i] = sampling::UniformSampleSphere(Point2(float(sampling::Random()), float(sampling::Random())));
+        }
+
+        // Lobes the integrator hands over (roughness 0.2 and 0.5 as in the gold scene, and ~0.32), toward the sky and the horizon
+        for (Real alpha : { 0.04, 0.1, 0.25 })
+            for (const Vector3& axis : { Vector3(0, 1, 0), glm::normalize(Vector3(1, 0.15, 0.3)) }) {
+                const GlossyLobe lobe{ axis, Real(1) / (Real(2) * alpha * alpha) };
+                auto g = [&](const Vector3& w) { return std::exp(lobe.sharpness * (glm::dot(lobe.axis, w) - Real(1))); };
+
+                Real sink = 0;
+                const double tSample = secondsFor([&] {
+                    for (const Point2& u : us) {
+                        Vector3 wi;
+                        Real pdf;
+                        sink += product->sample(lobe, u, wi, pdf).x + pdf;
+                    }
+                    });
+                const double tPdf = secondsFor([&] { for (const Vector3& d : dirs) sink += product->pdf(lobe, d); });
+
+                // The pdf is constant over each leaf, so one point per cell of a finer equal-area grid
+                // integrates it exactly; the same grid gives a stratified reference for I = integral of L * g
+                constexpr int GRID = 1024;
+                Real ref = 0, norm = 0;
+                for (int y = 0; y < GRID; ++y)
+                    for (int x = 0; x < GRID; ++x) {
+                        const Vector3 d = equalAreaSquareToSphere((x + Real(0.5)) / GRID, (y + Real(0.5)) / GRID);
+                        ref += luminance(env->eval(d)) * g(d) * constants::FOUR_PI / (GRID * GRID);
+                        norm += product->pdf(lobe, d) * constants::FOUR_PI / (GRID * GRID);
+                    }
+                Real envSum = 0, envSq = 0, prodSum = 0, prodSq = 0;
+                double selfErr = 0;
+                for (const Point2& u : us) {
+                    Vector3 wi;
+                    Real pdf;
+                    Vector3 Le = env->sample(u, wi, pdf);
+                    const Real e = pdf > 0 ? luminance(Le) * g(wi) / pdf : Real(0);
+                    envSum += e; envSq += e * e;
+
+                    Le = product->sample(lobe, u, wi, pdf);
+                    if (pdf > 0) selfErr = std::max(selfErr, std::abs(product->pdf(lobe, wi) - pdf) / pdf);
+                    const Real q = pdf > 0 ? luminance(Le) * g(wi) / pdf : Real(0);
+                    prodSum += q; prodSq += q * q;
+                }
+                auto relVar = [](Real sum, Real sq) { const Real m = sum / N; return m > 0 ? (sq / N - m * m) / (m * m) : Real(0); };
+
+                std::cout << "  alpha " << alpha << (product->handles(lobe) ? "" : " (not handled)")
+                    << ", axis (" << axis.x << ", " << axis.y << ", " << axis.z << "): "
+                    << tSample * 1e9 / N << " ns/sample, " << tPdf * 1e9 / N << " ns/pdf, integral of pdf " << norm
+                    << ", max |pdf(wi) - sample pdf| / pdf = " << selfErr << "\n"
+                    << "      integral of L*lobe: grid " << ref << ", env-only " << envSum / N << ", product " << prodSum / N
+                    << "; per-sample relative variance env-only " << relVar(envSum, envSq) << ", product " << relVar(prodSum, prodSq)
+                    << "  (sink " << sink << ")\n";
+            }
+    }
+
+    void TestEnvProductEqualTime(const std::string& hdrPath, int referenceSpp, double seconds) {
+        std::shared_ptr<EnvMap> env;
+        try {
+            env = std::make_shared<EnvMap>(io::loadHDR(hdrPath));
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] Env x lobe product sampling at equal time, " << hdrPath << "\n";
+
+        constexpr int W = 160, H = 90;
+        std::vector<std::string> names;
+        const Scene scene = makeGoldRoughnessScene(&names);
+        auto camera = makeGoldRoughnessCamera(W, H);
+        const auto product = std::make_shared<EnvProductSampler>(env);
+
+        // Plain env sampling converges to the same image; it is the reference so neither side grades itself
+        Film reference(W, H);
+        const double tRef = secondsFor([&] { PathIntegrator(camera, env, 50, referenceSpp).render(scene, reference); });
+        std::cout << "  gold scene " << W << "x" << H << ", reference " << referenceSpp << " spp (" << tRef << " s)\n";
+
+        // Per-pixel region: material id of the first hit, the last name for the background
+        const size_t regions = names.size();
+        std::vector<size_t> region(size_t(W) * H);
+        for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x) {
+                // Film row y holds camera row H - 1 - y
+                const Ray r = camera->getRay((x + Real(0.5)) / W, (H - 1 - y + Real(0.5)) / H, Point2(0.5f, 0.5f));
+                SurfaceInteraction rec;
+                region[size_t(y) * W + x] = scene.hit(r, rec) ? std::min<size_t>(rec.materialId, regions - 1) : regions - 1;
+            }
+
+        for (const bool useProduct : { false, true }) {
+            auto makePath = [&](int spp) {
+                PathIntegrator path(camera, env, 50, spp);
+                if (useProduct) path.setEnvProductSampler(product);
+                return path;
+            };
+            // Calibrate the spp that fills the budget, then average the error of a few independent renders:
+            // a single one is dominated by whichever fireflies it happens to catch
+            constexpr int PROBE_SPP = 8, RENDERS = 4;
+            Film probe(W, H);
+            const double tProbe = secondsFor([&] { makePath(PROBE_SPP).render(scene, probe); });
+            const int spp = std::max(1, int(seconds / tProbe * PROBE_SPP));
+
+            std::vector<std::vector<Real>> errors(regions);
+            double t = 0;
+            for (int run = 0; run < RENDERS; ++run) {
+                Film film(W, H);
+                t += secondsFor([&] { makePath(spp).render(scene, film); });
+                for (int y = 0; y < H; ++y)
+                    for (int x = 0; x < W; ++x) {
+                        const size_t g = region[size_t(y) * W + x];
+                        const Real lp = luminance(film.getPixel(x, y)), lr = luminance(reference.getPixel(x, y));
+                        errors[g].push_back((lp - lr) * (lp - lr) / (lr * lr + Real(1e-2)));
+                    }
+            }
+            // Mean, and mean without the highest 0.1% of pixel errors (relMSE is otherwise one firefly's).
+            // Variance falls as 1 / time, so scaling by time / budget corrects for the calibration's miss
+            const double scale = t / RENDERS / seconds;
+            std::cout << "  " << (useProduct ? "product " : "env-only") << ": " << spp << " spp in " << t / RENDERS
+                << " s; relMSE at " << seconds << " s (mean of " << RENDERS << " renders), full / trimmed:\n";
+            for (size_t i = 0; i < regions; ++i) {
+                std::vector<Real>& e = errors[i];
+                if (e.empty()) continue;
+                std::sort(e.begin(), e.end());
+                const size_t kept = e.size() - e.size() / 1000;
+                Real full = 0, trimmed = 0;
+                for (size_t k = 0; k < e.size(); ++k) (k < kept ? trimmed : full) += e[k];
+                full += trimmed;
+                std::cout << "      " << names[i] << ": " << full / e.size() * scale << " / " << trimmed / kept * scale << "\n";
+            }
+        }
+    }
+
+    void TestImageFormats(const std::string& hdrPath) {
+        Image reference;
+        try {
+            reference = io::loadHDR(hdrPath);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        const int w = reference.width(), h = reference.height();
+        std::cout << "\n[Debug] Image formats, " << hdrPath << " (" << w << "x" << h << ")\n";
+
+        constexpr int N = 1 << 20;
+        std::vector<Point2> us(N);
+        std::vector<Vector3> dirs(N);
+        for (int i = 0; i < N; ++i) {
+            us[i] = Point2(float(sampling::Random()), float(sampling::Random()));
+            dirs[i] = sampling::UniformSampleSphere(Point2(float(sampling::Random()), float(sampling::Random())));
+        }
+
+        struct Entry { const char* name; PixelFormat format; };
+        for (const Entry& e : { Entry{ "float3", PixelFormat::Float3 }, Entry{ "half3 ", PixelFormat::Half3 },
+                                Entry{ "rgbe  ", PixelFormat::RGBE }, Entry{ "rgb9e5", PixelFormat::RGB9E5 } }) {
+            Image img;
+            const double tLoad = secondsFor([&] { img = io::loadHDR(hdrPath, e.format); });
+
+            // Error relative to the pixel's largest channel (what shared-exponent formats bound),
+            // and the bias of the map's total luminance
+            double maxErr = 0, sumErr = 0, lumRef = 0, lum = 0;
+            size_t exact = 0;
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x) {
+                    const Vector3 a = reference.at(x, y), b = img.at(x, y);
+                    const double m = std::max({ a.x, a.y, a.z });
+                    const double err = m > 0 ? glm::length(b - a) / m : glm::length(b);
+                    maxErr = std::max(maxErr, err);
+                    sumErr += err;
+                    exact += (a == b);
+                    lumRef += luminance(a);
+                    lum += luminance(b);
+                }
+
+            const EnvMap env(std::move(img));
+            Real sink = 0;
+            const double tEval = secondsFor([&] { for (const Vector3& d : dirs) sink += env.eval(d).x; });
+            const double tSample = secondsFor([&] {
+                for (const Point2& u : us) {
+                    Vector3 wi;
+                    Real pdf;
+                    sink += env.sample(u, wi, pdf).x + pdf;
+                }
+                });
+
+            const double bytes = double(env.texels().memoryBytes());
+            std::cout << "  " << e.name << ": " << bytes / (1 << 20) << " MiB (16k x 8k: "
+                << bytes / (double(w) * h) * 16384 * 8192 / (1 << 30) << " GiB), load " << tLoad << " s\n"
+                << "          error / max channel: max " << maxErr << ", mean " << sumErr / (double(w) * h)
+                << ", exact " << 100.0 * exact / (double(w) * h) << "%, luminance bias " << lum / lumRef - 1.0 << "\n"
+                << "          eval " << tEval * 1e9 / N << " ns, sample " << tSample * 1e9 / N << " ns  (sink " << sink << ")\n";
+        }
+    }
+
+    void TestImageLayout(const std::string& hdrPath) {
+        Image source;
+        try {
+            source = io::loadHDR(hdrPath);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        const int w = source.width(), h = source.height();
+        std::cout << "\n[Debug] Image layouts, " << hdrPath << " (" << w << "x" << h << ")\n";
+
+        // Lookup streams in the continuous texel coordinates EnvMap::sampleBilinear produces.
+        // The screen is a 1024^2 view of the background: magnified 1.33x and rolled by 30 degrees,
+        // so its rows cut across texel rows as they do with a tilted camera.
+        constexpr int SCREEN = 1024;
+        constexpr int N = SCREEN * SCREEN;
+        const float c = std::cos(0.5236f) * 0.75f, s = std::sin(0.5236f) * 0.75f;
+        auto screenToTexel = [&](int px, int py) {
+            const float sx = float(px - SCREEN / 2), sy = float(py - SCREEN / 2);
+            float x = 0.5f * w + c * sx - s * sy;
+            const float y = 0.5f * h + s * sx + c * sy;
+            x -= w * std::floor(x / w);
+            return Point2(x - 0.5f, std::clamp(y, 0.0f, float(h)) - 0.5f);
+        };
+
+        std::vector<Point2> scanline, screenTiles, random;
+        scanline.reserve(N); screenTiles.reserve(N); random.reserve(N);
+        for (int py = 0; py < SCREEN; ++py)
+            for (int px = 0; px < SCREEN; ++px) scanline.push_back(screenToTexel(px, py));
+        for (int by = 0; by < SCREEN; by += 16)
+            for (int bx = 0; bx < SCREEN; bx += 16)
+                for (int py = by; py < by + 16; ++py)
+                    for (int px = bx; px < bx + 16; ++px) screenTiles.push_back(screenToTexel(px, py));
+        for (int i = 0; i < N; ++i)
+            random.push_back(Point2(float(sampling::Random()) * w - 0.5f, float(sampling::Random()) * h - 0.5f));
+
+        auto wrapClamp = [w, h](int& x, int& y) {
+            x = (x % w + w) % w;
+            y = std::clamp(y, 0, h - 1);
+        };
+
+        for (PixelFormat format : { PixelFormat::Float3, PixelFormat::RGBE }) {
+            const Image rowMajor = source.converted(format);
+            const TiledImage tiled(rowMajor, wrapClamp);
+            const size_t bpp = bytesPerPixel(format);
+            std::cout << "  " << (format == PixelFormat::Float3 ? "float3" : "rgbe") << ": row-major "
+                << rowMajor.memoryBytes() / double(1 << 20) << " MiB, tiled " << tiled.memoryBytes() / double(1 << 20) << " MiB\n";
+
+            // The previous EnvMap path: wrap/clamp every texel of the footprint, rows w texels apart
+            auto rowMajorTexel = [&](int x, int y) { wrapClamp(x, y); return rowMajor.at(x, y); };
+            auto rowMajorBilinear = [&](const Point2& p) {
+                const int x0 = int(std::floor(p.x)), y0 = int(std::floor(p.y));
+                const float tx = p.x - std::floor(p.x), ty = p.y - std::floor(p.y);
+                return glm::mix(glm::mix(rowMajorTexel(x0, y0), rowMajorTexel(x0 + 1, y0), tx),
+                    glm::mix(rowMajorTexel(x0, y0 + 1), rowMajorTexel(x0 + 1, y0 + 1), tx), ty);
+            };
+
+            struct Stream { const char* name; const std::vector<Point2>* points; };
+            for (const Stream& stream : { Stream{ "scanline    ", &scanline }, Stream{ "screen tiles", &screenTiles }, Stream{ "random      ", &random } }) {
+                const std::vector<Point2>& points = *stream.points;
+
+                CacheModel rowL1(32 << 10, 8), rowL2(1 << 20, 16), tileL1(32 << 10, 8), tileL2(1 << 20, 16);
+                double maxDiff = 0;
+                for (const Point2& p : points) {
+                    const int x0 = int(std::floor(p.x)), y0 = int(std::floor(p.y));
+                    for (int dy = 0; dy < 2; ++dy)
+                        for (int dx = 0; dx < 2; ++dx) {
+                            int x = x0 + dx, y = y0 + dy;
+                            wrapClamp(x, y);
+                            const uint64_t address = (uint64_t(y) * w + x) * bpp;
+                            rowL1.read(address, bpp); rowL2.read(address, bpp);
+                        }
+                    const uint64_t base = tiled.byteOffset(x0, y0);
+                    for (const uint64_t address : { base, base + bpp, base + TiledImage::TILE_STRIDE * bpp, base + (TiledImage::TILE_STRIDE + 1) * bpp }) {
+                        tileL1.read(address, bpp); tileL2.read(address, bpp);
+                    }
+                    maxDiff = std::max(maxDiff, double(glm::length(rowMajorBilinear(p) - tiled.bilinear(p.x, p.y))));
+                }
+
+                Real sink = 0;
+                auto runRowMajor = [&] { for (const Point2& p : points) sink += rowMajorBilinear(p).x; };
+                auto runTiled = [&] { for (const Point2& p : points) sink += tiled.bilinear(p.x, p.y).x; };
+                const double tRow = secondsFor(runRowMajor), tTiled = secondsFor(runTiled);
+
+                MissCounter l1(false), ll(true);
+                const long long hwRowL1 = l1.count(runRowMajor), hwTileL1 = l1.count(runTiled);
+                const long long hwRowLL = ll.count(runRowMajor), hwTileLL = ll.count(runTiled);
+                auto perLookup = [&](long long n) { return n < 0 ? std::string("n/a") : std::to_string(double(n) / N); };
+
+                std::cout << "    " << stream.name << ": " << tRow * 1e9 / N << " -> " << tTiled * 1e9 / N << " ns/lookup"
+                    << "; misses/lookup, model L1 " << double(rowL1.misses()) / N << " -> " << double(tileL1.misses()) / N
+                    << ", L2 " << double(rowL2.misses()) / N << " -> " << double(tileL2.misses()) / N
+                    << "; perf L1D " << perLookup(hwRowL1) << " -> " << perLookup(hwTileL1)
+                    << ", LLC " << perLookup(hwRowLL) << " -> " << perLookup(hwTileLL)
+                    << "  (max |diff| " << maxDiff << ", sink " << sink << ")\n";
+            }
+        }
+    }
+
+    void TestImageIngest(const std::string& hdrPath) {
+        std::cout << "\n[Debug] Image ingest, " << hardwareThreads() << " threads\n";
+
+        // Pixels of two images identical once decoded, and their storage byte for byte
+        auto compare = [](const Image& a, const Image& b, size_t& equal) {
+            equal = 0;
+            if (a.width() != b.width() || a.height() != b.height()) return false;
+            for (int y = 0; y < a.height(); ++y)
+                for (int x = 0; x < a.width(); ++x) equal += (a.at(x, y) == b.at(x, y));
+            return a.memoryBytes() == b.memoryBytes() && std::memcmp(a.data(), b.data(), a.memoryBytes()) == 0;
+        };
+
+        // What loadHDR did before: stb_image into a float buffer, then one set() per pixel
+        auto loadHDRReference = [](const std::string& path, PixelFormat format) {
+            int w = 0, h = 0, n = 0;
+            float* data = stbi_loadf(path.c_str(), &w, &h, &n, 3);
+            Image image(data ? w : 0, data ? h : 0, format);
+            for (int y = 0; data && y < h; ++y)
+                for (int x = 0; x < w; ++x) {
+                    const float* p = data + 3 * (size_t(y) * w + x);
+                    image.set(x, y, Vector3(p[0], p[1], p[2]));
+                }
+            stbi_image_free(data);
+            return image;
+        };
+
+        Image probe;
+        try {
+            probe = io::loadHDR(hdrPath, PixelFormat::RGBE);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+        }
+        if (probe.isValid()) {
+            const double pixels = double(probe.width()) * probe.height();
+            std::cout << "  " << hdrPath << " (" << probe.width() << "x" << probe.height() << ", "
+                << std::filesystem::file_size(hdrPath) / double(1 << 20) << " MiB)\n";
+            struct Entry { const char* name; PixelFormat format; };
+            for (const Entry& e : { Entry{ "float3", PixelFormat::Float3 }, Entry{ "half3 ", PixelFormat::Half3 },
+                                    Entry{ "rgbe  ", PixelFormat::RGBE }, Entry{ "rgb9e5", PixelFormat::RGB9E5 } }) {
+                Image reference, image;
+                const double tRef = secondsFor([&] { reference = loadHDRReference(hdrPath, e.format); });
+                const double tNew = secondsFor([&] { image = io::loadHDR(hdrPath, e.format); });
+                size_t equal = 0;
+                const bool bytes = compare(reference, image, equal);
+                // RGBE keeps the file's bytes, which need not be normalized the way the encoder writes them
+                std::cout << "  " << e.name << ": stb + set " << tRef * 1e3 << " ms, loadHDR " << tNew * 1e3 << " ms ("
+                    << tRef / tNew << "x, " << pixels / tNew / 1e6 << " Mpixel/s); equal pixels "
+                    << 100.0 * equal / pixels << "%, storage " << (bytes ? "identical" : "differs") << "\n";
+            }
+        }
+
+        const std::filesystem::path dir = std::filesystem::temp_directory_path();
+
+        // Flat (not run-length encoded) scanlines: stb_image writes them below 8 pixels wide
+        {
+            const std::string flat = (dir / "rayt_ingest_flat.hdr").string();
+            const int w = 5, h = 7;
+            std::vector<float> data(size_t(3) * w * h);
+            for (float& v : data) v = float(sampling::Random() * 100.0);
+            stbi_write_hdr(flat.c_str(), w, h, 3, data.data());
+            size_t equal = 0;
+            const bool bytes = compare(loadHDRReference(flat, PixelFormat::Float3), io::loadHDR(flat), equal);
+            std::cout << "  flat .hdr fallback: equal pixels " << equal << " / " << w * h
+                << ", storage " << (bytes ? "identical" : "differs") << "\n";
+            std::filesystem::remove(flat);
+        }
+
+        // 8-bit input: what loadLDR did before (std::pow per channel) against the table
+        {
+            const std::string png = (dir / "rayt_ingest.png").string();
+            const int w = 4096, h = 2048;
+            std::vector<uint8_t> data(size_t(3) * w * h);
+            for (size_t i = 0; i < data.size(); ++i) data[i] = uint8_t(i % 3 == 0 ? i / 3 % 256 : sampling::Random() * 256.0);
+            stbi_write_png(png.c_str(), w, h, 3, data.data(), 3 * w);
+
+            for (io::ColorEncoding encoding : { io::ColorEncoding::sRGB, io::ColorEncoding::Linear }) {
+                Image reference, image;
+                const double tRef = secondsFor([&] {
+                    int rw = 0, rh = 0, n = 0;
+                    unsigned char* bytes = stbi_load(png.c_str(), &rw, &rh, &n, 3);
+                    std::vector<Vector3> pixels(size_t(rw) * rh);
+                    for (size_t i = 0; bytes && i < pixels.size(); ++i) {
+                        float c[3];
+                        for (int k = 0; k < 3; ++k) {
+                            c[k] = bytes[3 * i + k] / 255.0f;
+                            if (encoding == io::ColorEncoding::sRGB)
+                                c[k] = c[k] <= 0.04045f ? c[k] / 12.92f : std::pow((c[k] + 0.055f) / 1.055f, 2.4f);
+                        }
+                        pixels[i] = Vector3(c[0], c[1], c[2]);
+                    }
+                    stbi_image_free(bytes);
+                    reference = Image(rw, rh, pixels);
+                    });
+                const double tNew = secondsFor([&] { image = io::loadLDR(png, encoding); });
+                size_t equal = 0;
+                const bool bytes = compare(reference, image, equal);
+                std::cout << "  png " << w << "x" << h << (encoding == io::ColorEncoding::sRGB ? " sRGB  " : " linear")
+                    << ": stb + convert " << tRef * 1e3 << " ms, loadLDR " << tNew * 1e3 << " ms (" << tRef / tNew
+                    << "x); equal pixels " << 100.0 * equal / (double(w) * h) << "%, storage "
+                    << (bytes ? "identical" : "differs") << "\n";
+            }
+            std::filesystem::remove(png);
+        }
+    }
+
+    void TestAssetCache(const std::string& hdrPath, const std::string& csvPath) {
+        Image image;
+        try {
+            image = io::loadHDR(hdrPath, PixelFormat::RGBE);
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] Asset cache, " << hdrPath << " (" << image.width() << "x" << image.height() << ")\n";
+
+        const std::filesystem::path dir = std::filesystem::temp_directory_path() / "rayt_asset_cache_debug";
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+        const io::AssetCache cache(dir.string());
+
+        // Same draws, pdfs and radiance from two maps
+        constexpr int N = 1 << 18;
+        auto sameSamples = [](const EnvMap& a, const EnvMap& b) {
+            size_t equal = 0;
+            for (int i = 0; i < N; ++i) {
+                const Point2 u(float(sampling::Random()), float(sampling::Random()));
+                Vector3 wa, wb;
+                Real pa, pb;
+                const Vector3 la = a.sample(u, wa, pa), lb = b.sample(u, wb, pb);
+                equal += (la == lb && wa == wb && pa == pb && a.pdf(wa) == b.pdf(wa));
+            }
+            return equal;
+        };
+
+        struct Config { const char* name; EnvSampling sampling; EnvLayout layout; };
+        for (const Config& c : { Config{ "equirect / alias     ", EnvSampling::Alias, EnvLayout::Equirect },
+                                 Config{ "equirect / cdf       ", EnvSampling::CDF, EnvLayout::Equirect },
+                                 Config{ "octahedral / alias   ", EnvSampling::Alias, EnvLayout::Octahedral } }) {
+            std::unique_ptr<EnvMap> built, stored, mapped;
+            const double tBuild = secondsFor([&] { built = std::make_unique<EnvMap>(image, c.sampling, c.layout); });
+            const double tStore = secondsFor([&] { stored = std::make_unique<EnvMap>(image, c.sampling, c.layout, &cache); });
+            const double tMapped = secondsFor([&] { mapped = std::make_unique<EnvMap>(image, c.sampling, c.layout, &cache); });
+            std::cout << "  " << c.name << ": build " << tBuild * 1e3 << " ms, build + store " << tStore * 1e3
+                << " ms, from cache " << tMapped * 1e3 << " ms; identical samples "
+                << 100.0 * sameSamples(*built, *mapped) / N << "%\n";
+        }
+
+        // Key hashing, which every lookup pays: the whole image
+        const double tHash = secondsFor([&] { io::CacheKey().add(image.data(), image.memoryBytes()); });
+        std::cout << "  hashing the image: " << tHash * 1e3 << " ms (" << image.memoryBytes() / tHash / 1e9 << " GB/s)\n";
+
+        // Stale entries: a truncated file and a different format version miss, and the rebuild replaces them
+        size_t entries = 0, bytes = 0;
+        for (const auto& f : std::filesystem::directory_iterator(dir)) {
+            ++entries;
+            bytes += size_t(f.file_size());
+            if (f.path().filename().string().rfind("env-cdf", 0) == 0)
+                std::filesystem::resize_file(f.path(), f.file_size() / 2);
+            if (f.path().filename().string().rfind("env-alias", 0) == 0) {
+                std::fstream file(f.path(), std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(32); // formatVersion
+                file.put(char(99));
+            }
+        }
+        std::cout << "  " << entries << " entries, " << bytes / double(1 << 20) << " MiB\n";
+        for (EnvSampling s : { EnvSampling::CDF, EnvSampling::Alias }) {
+            const double tStale = secondsFor([&] { std::make_unique<EnvMap>(image, s, EnvLayout::Equirect, &cache); });
+            const double tAgain = secondsFor([&] { std::make_unique<EnvMap>(image, s, EnvLayout::Equirect, &cache); });
+            std::cout << "  " << (s == EnvSampling::CDF ? "truncated cdf entry" : "alias entry, version 99")
+                << ": " << tStale * 1e3 << " ms (rebuilt), then " << tAgain * 1e3 << " ms\n";
+        }
+
+        // A changed texel is a different key
+        image.set(0, 0, image.at(0, 0) + Vector3(1.0));
+        const double tChanged = secondsFor([&] { std::make_unique<EnvMap>(image, EnvSampling::Alias, EnvLayout::Equirect, &cache); });
+        std::cout << "  one texel changed: " << tChanged * 1e3 << " ms (rebuilt)\n";
+
+        // IOR grid: parsed and resampled, then copied out of the cache
+        SpectralIORTable parsed, cached;
+        const double tParse = secondsFor([&] { parsed.loadCSV(csvPath, false); });
+        if (parsed.empty()) {
+            std::cout << "  [skip] " << csvPath << " not found\n";
+        }
+        else {
+            cached.loadCSV(csvPath, cache);
+            const double tCached = secondsFor([&] { cached.loadCSV(csvPath, cache); });
+            size_t equal = 0;
+            for (size_t i = 0; i < 1000; ++i) {
+                const double lambda = LAMBDA_MIN + (LAMBDA_MAX - LAMBDA_MIN) * double(i) / 999;
+                equal += (parsed.evaluate(lambda) == cached.evaluate(lambda));
+            }
+            std::cout << "  " << csvPath << ": parse " << tParse * 1e3 << " ms, from cache " << tCached * 1e3
+                << " ms; identical lookups " << equal / 10.0 << "%\n";
+        }
+
+        std::filesystem::remove_all(dir, ec);
+    }
+
+} // namespace rayt::debug
@@ -0,0 +1,370 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "Renderer/Film.hpp"
+#include "Renderer/TiledFilm.hpp"
+#include "Renderer/Filter.hpp"
+#include "Renderer/ColorTransform.hpp"
+#include "Core/Math.hpp"
+#include "Core/Parallel.hpp"
+#include "DebugTools/FilmDebug.hpp"
+#include "IO/ExrWriter.hpp"
+#include "IO/PngWriter.hpp"
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace rayt::debug {
+
+    void TestFilmAccumulation() {
+        std::cout << "\n[Debug] Film accumulation (64x64, 256 samples per pixel)\n";
+
+        constexpr int N = 64, SPP = 256, TILE = 16;
+        const struct { const char* name; Filter filter; } filters[] = {
+            { "box 0.5", Filter::box() },
+            { "tent 1", Filter::tent() },
+            { "gaussian 1.5", Filter::gaussian() },
+            { "mitchell 2", Filter::mitchell() },
+        };
+
+        std::vector<Point2> points(size_t(N) * N * SPP);
+        for (Point2& p : points) p = Point2(float(sampling::Random() * N), float(sampling::Random() * N));
+
+        for (const auto& f : filters) {
+            Film direct(N, N, f.filter), tiled(N, N, f.filter), splat(N, N, f.filter);
+            splat.setSplatScale(Real(1) / SPP);
+
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (const Point2& p : points) direct.addSample(p, Spectrum(p.x / N, 1.0, 2.0));
+            auto t1 = std::chrono::high_resolution_clock::now();
+
+            // Bucket the samples by tile the way PathIntegrator does, then merge each tile once
+            std::vector<FilmTile> tiles;
+            for (int y = 0; y < N; y += TILE)
+                for (int x = 0; x < N; x += TILE) tiles.push_back(tiled.tile(x, y, x + TILE, y + TILE));
+            auto t2 = std::chrono::high_resolution_clock::now();
+            for (const Point2& p : points)
+                tiles[size_t(int(p.y) / TILE) * (N / TILE) + int(p.x) / TILE].addSample(p, Spectrum(p.x / N, 1.0, 2.0));
+            for (const FilmTile& t : tiles) tiled.mergeTile(t);
+            auto t3 = std::chrono::high_resolution_clock::now();
+
+            for (const Point2& p : points) splat.addSplat(p, Spectrum(1.0));
+
+            Real tileError = 0, constantError = 0, splatSum = 0;
+            int interior = 0;
+            const int margin = int(std::ceil(f.filter.radius()));
+            for (int y = 0; y < N; ++y)
+                for (int x = 0; x < N; ++x) {
+                    tileError = std::max(tileError, glm::length(direct.getPixel(x, y) - tiled.getPixel(x, y)));
+                    constantError = std::max(constantError, std::abs(direct.getPixel(x, y).y - 1));
+                    if (x >= margin && y >= margin && x < N - margin && y < N - margin) {
+                        splatSum += splat.getPixel(x, y).x;
+                        ++interior;
+                    }
+                }
+
+            const double sDirect = std::chrono::duration<double>(t1 - t0).count();
+            const double sTiled = std::chrono::duration<double>(t3 - t2).count();
+            std::cout << "  " << f.name << ": tiles vs direct max diff " << tileError
+                << ", constant field error " << constantError
+                << ", splat mean " << splatSum / interior << " (expect ~1)"
+                << "; Msamples/s tile " << points.size() / sTiled * 1e-6
+                << ", atomic " << points.size() / sDirect * 1e-6 << "\n";
+        }
+    }
+
+    void TestEXRWriter(const std::string& outputPath) {
+        std::cout << "\n[Debug] EXR writer, 1920x1080, beauty + all AOVs\n";
+
+        constexpr int W = 1920, H = 1080;
+        Film film(W, H);
+        film.enableAOVs(AOV::All);
+        std::vector<FilmTile> tiles;
+        for (int y = 0; y < H; y += 64)
+            for (int x = 0; x < W; x += 64) {
+                FilmTile tile = film.tile(x, y, x + 64, y + 64);
+                for (int py = y; py < std::min(y + 64, H); ++py)
+                    for (int px = x; px < std::min(x + 64, W); ++px) {
+                        // Smooth gradients with flat regions, roughly what a render's AOVs look like
+                        AOVSample aov;
+                        aov.albedo = Spectrum(px < W / 2 ? 0.5 : 0.8, 0.5, 0.2);
+                        aov.normal = glm::normalize(Vector3(px - W / 2, H, py - H / 2));
+                        aov.depth = 2.0 + py * 0.01;
+                        aov.materialId = uint32_t(px / 480);
+                        aov.direct = Spectrum(px / Real(W), py / Real(H), 0.25);
+                        const Spectrum L = aov.direct * Real(1.25);
+                        tile.addSample(Point2(px + 0.5f, py + 0.5f), L, aov);
+                    }
+                film.mergeTile(tile);
+            }
+
+        const struct { const char* name; io::ExrPixelType type; io::ExrCompression compression; int tileSize; bool multiPart; } modes[] = {
+            { "float, none, multi-part", io::ExrPixelType::Float, io::ExrCompression::None, 0, true },
+            { "half,  none, multi-part", io::ExrPixelType::Half, io::ExrCompression::None, 0, true },
+            { "half,  RLE,  multi-part", io::ExrPixelType::Half, io::ExrCompression::RLE, 0, true },
+            { "half,  RLE,  64^2 tiles", io::ExrPixelType::Half, io::ExrCompression::RLE, 64, true },
+            { "half,  RLE,  single part", io::ExrPixelType::Half, io::ExrCompression::RLE, 0, false },
+        };
+        for (const auto& m : modes) {
+            FilmExrOptions options;
+            options.colorType = m.type;
+            options.compression = m.compression;
+            options.tileSize = m.tileSize;
+            options.multiPart = m.multiPart;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            film.saveEXR(outputPath, options);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::cout << "  " << m.name << ": " << std::chrono::duration<double>(t1 - t0).count() << " s, "
+                << std::filesystem::file_size(outputPath) / double(1 << 20) << " MiB\n";
+        }
+
+        // --- A tile written twice must be rejected, not appended as an orphaned chunk ---
+        {
+            io::ExrPart layout;
+            layout.name = "rgba";
+            layout.tileSize = 16;
+            layout.channels = { { "R", io::ExrPixelType::Half } };
+            io::ExrTileWriter writer(outputPath, 32, 16, layout);
+            std::vector<float> plane(16 * 16, 0.5f);
+            const float* planes[] = { plane.data() };
+            writer.writeTile(0, 0, planes);
+            bool rejected = false;
+            try {
+                writer.writeTile(0, 0, planes);
+            }
+            catch (const std::runtime_error&) {
+                rejected = true;
+            }
+            writer.writeTile(1, 0, planes);
+            writer.finish();
+            std::cout << "  tiled writer, tile written twice: " << (rejected ? "rejected" : "ACCEPTED") << "\n";
+        }
+    }
+
+    void TestToneMapping(int width, int height) {
+        std::cout << "\n[Debug] LDR output (" << width << "x" << height << ", " << hardwareThreads() << " threads)\n";
+
+        // Log-uniform radiance over 1e-4 .. 1e3, so every part of each curve is exercised
+        Film film(width, height);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                Spectrum c;
+                for (int k = 0; k < 3; ++k) c[k] = std::pow(Real(10), Real(7) * sampling::Random() - 4);
+                film.setPixel(x, y, c);
+            }
+        const double megapixels = width * double(height) * 1e-6;
+
+        // The loop Film::save used to run: Reinhard, linearToGamma, saturate, truncate
+        std::vector<uint8_t> legacy(size_t(width) * height * 3);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int y = 0, i = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x, ++i) {
+                Spectrum pixel = film.getPixel(x, y);
+                pixel = pixel / (pixel + Spectrum(1.0));
+                for (int k = 0; k < 3; ++k)
+                    legacy[size_t(i) * 3 + k] = static_cast<unsigned char>(255.99 * math::saturate(renderer::linearToGamma(pixel[k])));
+            }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        const double tLegacy = std::chrono::duration<double>(t1 - t0).count();
+        std::cout << "  scalar loop: " << tLegacy * 1000 << " ms (" << tLegacy * 1000 / megapixels << " ms/MP)\n";
+
+        const struct { const char* name; ToneMapOperator op; } operators[] = {
+            { "clamp", ToneMapOperator::Clamp }, { "reinhard", ToneMapOperator::Reinhard },
+            { "aces", ToneMapOperator::ACES }, { "filmic", ToneMapOperator::Filmic },
+        };
+        for (const auto& o : operators)
+            for (OutputTransfer transfer : { OutputTransfer::Gamma22, OutputTransfer::SRGB })
+                for (bool dither : { false, true }) {
+                    ToneMapSettings settings;
+                    settings.op = o.op;
+                    settings.transfer = transfer;
+                    settings.dither = dither;
+
+                    t0 = std::chrono::high_resolution_clock::now();
+                    const std::vector<uint8_t> rgb8 = film.toLDR(settings);
+                    t1 = std::chrono::high_resolution_clock::now();
+                    const double t = std::chrono::duration<double>(t1 - t0).count();
+
+                    // Codes against the double-precision pipeline (same dither threshold)
+                    size_t mismatches = 0;
+                    int maxError = 0;
+                    for (int y = 0; y < height; ++y)
+                        for (int x = 0; x < width; ++x) {
+                            const Spectrum c = film.getPixel(x, y);
+                            const Real threshold = (((x ^ y) & 1) * 32 + (y & 1) * 16 + ((x ^ y) >> 1 & 1) * 8 + (y >> 1 & 1) * 4
+                                + ((x ^ y) >> 2 & 1) * 2 + (y >> 2 & 1) + Real(0.5)) / 64;
+                            for (int k = 0; k < 3; ++k) {
+                                const Real v = toneMapReference(c[k], settings);
+                                const int expected = dither ? std::min(255, int(v * 255 + threshold)) : int(v * Real(255.99));
+                                const int e = std::abs(int(rgb8[(size_t(y) * width + x) * 3 + k]) - expected);
+                                mismatches += e != 0;
+                                maxError = std::max(maxError, e);
+                            }
+                        }
+
+                    std::cout << "  " << o.name << (transfer == OutputTransfer::SRGB ? " + sRGB" : " + gamma 2.2")
+                        << (dither ? " + dither" : "") << ": " << t * 1000 << " ms (" << t * 1000 / megapixels << " ms/MP, "
+                        << tLegacy / t << "x), codes off by " << maxError << " at most, "
+                        << mismatches * 1e6 / (rgb8.size()) << " per million";
+                    if (o.op == ToneMapOperator::Reinhard && transfer == OutputTransfer::Gamma22 && !dither) {
+                        size_t changed = 0;
+                        for (size_t i = 0; i < rgb8.size(); ++i) changed += rgb8[i] != legacy[i];
+                        std::cout << "; " << changed << " codes differ from the scalar loop";
+                    }
+                    std::cout << "\n";
+                }
+    }
+    void TestPngWriter(int width, int height) {
+        std::cout << "\n[Debug] PNG writer (" << width << "x" << height << " RGB, " << hardwareThreads() << " threads)\n";
+
+        // Smooth gradients and waves (long matches) over the top half, the same plus noise below
+        std::vector<uint8_t> rgb8(size_t(width) * height * 3);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                for (int k = 0; k < 3; ++k) {
+                    Real v = 0.5 + 0.3 * std::sin(x * 0.01 * (k + 1)) * std::cos(y * 0.013) + 0.2 * x / width;
+                    if (y >= height / 2) v += (sampling::Random() - 0.5) * 8.0 / 255.0;
+                    rgb8[(size_t(y) * width + x) * 3 + k] = uint8_t(std::clamp(v, Real(0), Real(1)) * 255);
+                }
+        const double megapixels = width * double(height) * 1e-6;
+
+        for (int level : { 0, 1, 6, 9 }) {
+            io::PngOptions options;
+            options.level = level;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            const std::vector<uint8_t> png = io::encodePNG(width, height, 3, rgb8.data(), 0, options);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            const double t = std::chrono::duration<double>(t1 - t0).count();
+
+            int w = 0, h = 0, n = 0;
+            uint8_t* decoded = stbi_load_from_memory(png.data(), int(png.size()), &w, &h, &n, 3);
+            const bool lossless = decoded && w == width && h == height && std::memcmp(decoded, rgb8.data(), rgb8.size()) == 0;
+            stbi_image_free(decoded);
+
+            // stb only has levels 1+ (and no stored mode)
+            stbi_write_png_compression_level = std::max(level, 1);
+            size_t stbSize = 0;
+            t0 = std::chrono::high_resolution_clock::now();
+            stbi_write_png_to_func([](void* context, void*, int size) { *static_cast<size_t*>(context) += size_t(size); },
+                &stbSize, width, height, 3, rgb8.data(), width * 3);
+            t1 = std::chrono::high_resolution_clock::now();
+            const double tStb = std::chrono::duration<double>(t1 - t0).count();
+
+            std::cout << "  level " << level << ": " << t * 1000 << " ms (" << t * 1000 / megapixels << " ms/MP), "
+                << png.size() / double(1 << 20) << " MiB, " << (lossless ? "round trip exact" : "ROUND TRIP FAILED")
+                << " | stb level " << std::max(level, 1) << ": " << tStb * 1000 << " ms, " << stbSize / double(1 << 20) << " MiB\n";
+        }
+        stbi_write_png_compression_level = 8;
+
+        // What the render loop waits for when it saves a pass
+        Film film(width, height);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                const uint8_t* p = &rgb8[(size_t(y) * width + x) * 3];
+                film.setPixel(x, y, Spectrum(p[0], p[1], p[2]) / Real(255));
+            }
+        auto t0 = std::chrono::high_resolution_clock::now();
+        film.saveLDR("png_writer_test.png");
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::future<bool> pending = film.saveLDRAsync("png_writer_test_async.png");
+        auto t2 = std::chrono::high_resolution_clock::now();
+        const bool ok = pending.get();
+        auto t3 = std::chrono::high_resolution_clock::now();
+        std::cout << "  saveLDR blocks " << std::chrono::duration<double>(t1 - t0).count() * 1000 << " ms; saveLDRAsync returns after "
+            << std::chrono::duration<double>(t2 - t0 - (t1 - t0)).count() * 1000 << " ms and is done after "
+            << std::chrono::duration<double>(t3 - t1).count() * 1000 << " ms (" << (ok ? "ok" : "failed") << ")\n";
+    }
+    void TestTiledFilm(int width, int height, const std::string& outputPath) {
+        std::cout << "\n[Debug] TiledFilm (" << hardwareThreads() << " threads)\n";
+
+        constexpr int RENDER_TILE = 16;
+        // Row-major 16x16 sample tiles, as PathIntegrator renders them; the radiance is cheap and deterministic
+        auto render = [&](int w, int h, int spp, auto&& forTile) {
+            const int tilesX = (w + RENDER_TILE - 1) / RENDER_TILE, tilesY = (h + RENDER_TILE - 1) / RENDER_TILE;
+            parallelFor(tilesX * tilesY, 1, [&](int begin, int end) {
+                for (int t = begin; t < end; ++t) {
+                    const int x0 = (t % tilesX) * RENDER_TILE, y0 = (t / tilesX) * RENDER_TILE;
+                    const int x1 = std::min(x0 + RENDER_TILE, w), y1 = std::min(y0 + RENDER_TILE, h);
+                    sampling::SeedRandom(sampling::Hash32(uint32_t(t)));
+                    forTile(x0, y0, x1, y1, [&](auto&& addSample) {
+                        for (int y = y0; y < y1; ++y)
+                            for (int x = x0; x < x1; ++x)
+                                for (int s = 0; s < spp; ++s) {
+                                    const Point2 p(float(x + sampling::Random()), float(y + sampling::Random()));
+                                    addSample(p, Spectrum(0.5 + 0.5 * std::sin(p.x * 0.05f), 0.5 + 0.5 * std::cos(p.y * 0.03f),
+                                        ((int(p.x) >> 5) ^ (int(p.y) >> 5)) & 1));
+                                }
+                        });
+                }
+                });
+        };
+
+        // --- Same samples into both films; the tiled one pages out most of the time ---
+        {
+            constexpr int W = 1000, H = 700, SPP = 4;
+            const Filter filter = Filter::gaussian();
+            Film film(W, H, filter);
+            std::vector<float> tiled(size_t(W) * H * 3, -1.0f);
+            TiledFilmOptions options;
+            options.tileSize = 32;
+            options.memoryBudget = size_t(256) << 10;
+            TiledFilm out(W, H, [&](int x0, int y0, int x1, int y1, const float* const* rgb) {
+                const int w = x1 - x0;
+                for (int y = y0; y < y1; ++y)
+                    for (int x = x0; x < x1; ++x)
+                        for (int k = 0; k < 3; ++k) tiled[(size_t(y) * W + x) * 3 + k] = rgb[k][size_t(y - y0) * w + (x - x0)];
+                }, filter, options);
+
+            render(W, H, SPP, [&](int x0, int y0, int x1, int y1, auto&& samples) {
+                FilmTile a = film.tile(x0, y0, x1, y1), b = out.tile(x0, y0, x1, y1);
+                samples([&](const Point2& p, const Spectrum& L) { a.addSample(p, L); b.addSample(p, L); });
+                film.mergeTile(a);
+                out.mergeTile(b);
+                });
+            const TiledFilm::Stats before = out.stats();
+            out.finish();
+
+            double maxError = 0;
+            size_t missing = 0;
+            for (int y = 0; y < H; ++y)
+                for (int x = 0; x < W; ++x) {
+                    const Spectrum c = film.getPixel(x, y);
+                    for (int k = 0; k < 3; ++k) {
+                        const float v = tiled[(size_t(y) * W + x) * 3 + k];
+                        missing += v < 0;
+                        maxError = std::max(maxError, std::abs(double(v) - c[k]) / std::max(1e-3, double(std::abs(c[k]))));
+                    }
+                }
+            std::cout << "  " << W << "x" << H << ", gaussian filter, 32^2 storage tiles, 256 KiB budget: "
+                << before.tilesWritten << " of " << out.stats().tilesWritten << " tiles streamed during the render, "
+                << before.pageOuts << " page-outs / " << before.pageIns << " page-ins, peak "
+                << before.peakResidentBytes / 1024.0 << " KiB; max relative difference to Film " << maxError
+                << (missing ? ", PIXELS MISSING" : "") << "\n";
+        }
+
+        // --- Large render streamed to a tiled EXR ---
+        {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            TiledFilm out(width, height, outputPath, Filter::tent());
+            render(width, height, 1, [&](int x0, int y0, int x1, int y1, auto&& samples) {
+                FilmTile tile = out.tile(x0, y0, x1, y1);
+                samples([&](const Point2& p, const Spectrum& L) { tile.addSample(p, L); });
+                out.mergeTile(tile);
+                });
+            out.finish();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            const TiledFilm::Stats s = out.stats();
+            const double filmBytes = double(width) * height * (7 * sizeof(Real));
+            std::cout << "  " << width << "x" << height << " -> " << outputPath << ": "
+                << std::chrono::duration<double>(t1 - t0).count() << " s, peak resident "
+                << s.peakResidentBytes / double(1 << 20) << " MiB (a Film would hold " << filmBytes / double(1 << 30)
+                << " GiB), " << s.pageOuts << " page-outs, " << std::filesystem::file_size(outputPath) / double(1 << 20) << " MiB file\n";
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Fresnel.hpp"
+#include "Core/FresnelTable.hpp"
+#include "Materials/RoughConductor.hpp"
+#include "DebugTools/FresnelDebug.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace rayt::debug {
+
+    namespace {
+
+        struct ConductorCase {
+            const char* name;
+            Vector3 eta;
+            Vector3 k;
+            double bound;   // documented in FresnelTable.hpp
+        };
+
+        template <typename F>
+        double secondsFor(F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(t1 - t0).count();
+        }
+
+    } // namespace
+
+    void TestFresnelTable() {
+        using fresnel::ConductorFresnelTable;
+
+        // 64 samples per table interval, so the sweep sees the interpolant between the nodes
+        constexpr int SWEEP = (ConductorFresnelTable::SIZE - 1) * 64 + 1;
+        constexpr int REPEAT = 50;
+
+        const ConductorCase cases[] = {
+            { "gold",      Vector3(0.16, 0.42, 1.45), Vector3(3.48, 2.45, 1.77), 4e-5 },
+            { "silver",    Vector3(0.15, 0.14, 0.13), Vector3(3.98, 3.35, 2.58), 2e-4 },
+            { "copper",    Vector3(0.27, 0.68, 1.22), Vector3(3.61, 2.63, 2.29), 2e-4 },
+            { "aluminium", Vector3(1.50, 0.98, 0.62), Vector3(7.60, 6.60, 5.40), 2e-4 },
+            { "iron",      Vector3(2.87, 2.92, 2.58), Vector3(3.10, 2.92, 2.76), 2e-4 },
+            { "chromium",  Vector3(3.18, 3.18, 2.01), Vector3(3.30, 3.33, 3.04), 2e-4 },
+        };
+
+        std::cout << "\n[Debug] ConductorFresnelTable vs fresnelConductor (SIZE="
+            << ConductorFresnelTable::SIZE << ", " << SWEEP << " cos samples)\n";
+
+        std::vector<Real> cosines(SWEEP);
+        for (int i = 0; i < SWEEP; ++i)
+            cosines[i] = Real(i) / Real(SWEEP - 1);
+
+        bool ok = true;
+        for (const ConductorCase& c : cases) {
+            ConductorFresnelTable table(c.eta, c.k);
+
+            double sweepErr = 0;
+            for (Real cosTheta : cosines) {
+                Vector3 err = glm::abs(table.eval(cosTheta) - fresnel::fresnelConductor(cosTheta, c.eta, c.k));
+                sweepErr = std::max(sweepErr, double(math::maxComponent(err)));
+            }
+
+            // maxError() only checks interval midpoints; the dense sweep must not find much worse
+            const double reported = table.maxError();
+            const bool caseOk = reported < c.bound && sweepErr < c.bound && sweepErr <= reported * 1.05 + 1e-7;
+            ok = ok && caseOk;
+            std::cout << "  " << c.name << ": maxError()=" << reported << " sweep=" << sweepErr
+                << " bound=" << c.bound << (caseOk ? "" : "  <-- FAIL") << "\n";
+        }
+
+        // The material must surface the same figure through fresnelMaxError()
+        const ConductorCase& gold = cases[0];
+        RoughConductor tabulated(gold.eta, gold.k, 0.3, 0.0, fresnel::ConductorFresnelMode::Tabulated);
+        RoughConductor exact(gold.eta, gold.k, 0.3);
+        const bool materialOk = tabulated.fresnelMaxError() == ConductorFresnelTable(gold.eta, gold.k).maxError() &&
+            exact.fresnelMaxError() == Real(0);
+        ok = ok && materialOk;
+        std::cout << "  RoughConductor::fresnelMaxError(): tabulated=" << tabulated.fresnelMaxError()
+            << " exact=" << exact.fresnelMaxError() << (materialOk ? "" : "  <-- FAIL") << "\n";
+
+        std::cout << (ok ? "  [OK] table error within the documented bounds.\n"
+            : "  [WARN] table error exceeds the documented bounds!\n");
+
+        // ---------------------------------------------------------------------
+        // Throughput (gold)
+        // ---------------------------------------------------------------------
+        ConductorFresnelTable table(gold.eta, gold.k);
+        double sink = 0;
+
+        double tExact = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r)
+                for (Real cosTheta : cosines)
+                    sink += fresnel::fresnelConductor(cosTheta, gold.eta, gold.k).x;
+            });
+        double tTable = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r)
+                for (Real cosTheta : cosines)
+                    sink += table.eval(cosTheta).x;
+            });
+
+        const double count = double(SWEEP) * REPEAT;
+        std::cout << "  exact " << tExact / count * 1e9 << " ns/eval, table " << tTable / count * 1e9
+            << " ns/eval (x" << tExact / tTable << ")\n";
+        std::cout << "  (checksum " << sink << ")\n";
+    }
+
+} // namespace rayt::debug
@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "Microfacet/GGX.hpp"
+#include "Microfacet/GGXBatch.hpp"
+#include "DebugTools/GGXBatchDebug.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+namespace rayt::debug {
+
+    namespace {
+
+        // |a - b| relative to |b|, with an absolute floor so values near 0 do not blow up
+        double relErr(double a, double b) {
+            return std::abs(a - b) / std::max(std::abs(b), 1e-3);
+        }
+
+        Vector3 randomUpperHemisphere() {
+            Vector3 w;
+            do {
+                w = Vector3(sampling::Random(-1, 1), sampling::Random(-1, 1), sampling::Random(0, 1));
+            } while (glm::length2(w) > 1 || glm::length2(w) < 1e-4 || w.z < 1e-3);
+            return glm::normalize(w);
+        }
+
+        template <typename F>
+        double secondsFor(F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(t1 - t0).count();
+        }
+
+    } // namespace
+
+    void TestGGXBatch() {
+        constexpr size_t N = 1 << 16;
+        constexpr int REPEAT = 20;
+        const Real ax = 0.3, ay = 0.12;
+
+        std::cout << "\n[Debug] GGX batch kernels vs scalar (N=" << N
+            << ", ax=" << ax << ", ay=" << ay << ", lanes=" << simd::LANES
+            << (RAYT_SIMD_SSE2 ? ", SSE2" : ", scalar fallback") << ")\n";
+
+        GGXDistribution dist(ax, ay);
+        GGXBatch batch(dist);
+
+        DirectionBatch wo(N), wh(N);
+        std::vector<float> u1(simd::roundUpToLanes(N)), u2(simd::roundUpToLanes(N));
+        for (size_t i = 0; i < N; ++i) {
+            wo.set(i, randomUpperHemisphere());
+            wh.set(i, randomUpperHemisphere());
+            u1[i] = float(sampling::Random());
+            u2[i] = float(sampling::Random());
+        }
+
+        // ---------------------------------------------------------------------
+        // Accuracy (scalar reference is evaluated on the float-rounded inputs)
+        // ---------------------------------------------------------------------
+        std::vector<float> outD(wh.x.size()), outG1(wh.x.size()), outG(wh.x.size());
+        std::vector<float> outPdf(wh.x.size()), outPdfShared(wh.x.size());
+        DirectionBatch outWh, outWhShared;
+
+        const Vector3 woShared = wo.get(0);
+        batch.D(wh, outD.data());
+        batch.G1(wo, outG1.data());
+        batch.G(wo, wh, outG.data());
+        batch.pdf(wo, wh, outPdf.data());
+        batch.pdf(woShared, wh, outPdfShared.data());
+        batch.sample_wh(wo, u1.data(), u2.data(), outWh);
+        batch.sample_wh(woShared, u1.data(), u2.data(), N, outWhShared);
+
+        double eD = 0, eG1 = 0, eG = 0, ePdf = 0, ePdfShared = 0, eWh = 0, eWhShared = 0;
+        for (size_t i = 0; i < N; ++i) {
+            const Vector3 o = wo.get(i), h = wh.get(i);
+            const Point2 u(u1[i], u2[i]);
+            eD = std::max(eD, relErr(outD[i], dist.D(h)));
+            eG1 = std::max(eG1, relErr(outG1[i], dist.G1(o)));
+            eG = std::max(eG, relErr(outG[i], dist.G(o, h)));
+            ePdf = std::max(ePdf, relErr(outPdf[i], dist.pdf(o, h)));
+            ePdfShared = std::max(ePdfShared, relErr(outPdfShared[i], dist.pdf(woShared, h)));
+            eWh = std::max(eWh, double(glm::length(outWh.get(i) - dist.sample_wh(o, u))));
+            eWhShared = std::max(eWhShared, double(glm::length(outWhShared.get(i) - dist.sample_wh(woShared, u))));
+        }
+
+        // float lanes: ~1e-6 per op; sample_wh loses a few more bits in sqrt(1 - t1^2 - t2^2) near the disk rim
+        const double evalTol = 1e-4;
+        const double sampleTol = 2e-3;
+        std::cout << "  [max rel err] D=" << eD << " G1=" << eG1 << " G=" << eG
+            << " pdf=" << ePdf << " pdf(shared wo)=" << ePdfShared << "\n";
+        std::cout << "  [max |dwh|]   sample_wh=" << eWh << " sample_wh(shared wo)=" << eWhShared << "\n";
+
+        const bool ok = eD < evalTol && eG1 < evalTol && eG < evalTol && ePdf < evalTol &&
+            ePdfShared < evalTol && eWh < sampleTol && eWhShared < sampleTol;
+        std::cout << (ok ? "  [OK] batch kernels match scalar within tolerance.\n"
+            : "  [WARN] batch kernels exceed tolerance!\n");
+
+        // ---------------------------------------------------------------------
+        // Throughput
+        // ---------------------------------------------------------------------
+        double sink = 0;
+
+        double tEvalScalar = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r)
+                for (size_t i = 0; i < N; ++i)
+                    sink += dist.pdf(wo.get(i), wh.get(i));
+            });
+        double tEvalSimd = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r) {
+                batch.pdf(wo, wh, outPdf.data());
+                sink += outPdf[r];
+            }
+            });
+        double tSampleScalar = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r)
+                for (size_t i = 0; i < N; ++i)
+                    sink += dist.sample_wh(wo.get(i), Point2(u1[i], u2[i])).z;
+            });
+        double tSampleSimd = secondsFor([&] {
+            for (int r = 0; r < REPEAT; ++r) {
+                batch.sample_wh(wo, u1.data(), u2.data(), outWh);
+                sink += outWh.z[r];
+            }
+            });
+
+        const double count = double(N) * REPEAT;
+        auto report = [&](const char* name, double tScalar, double tSimd) {
+            std::cout << "  " << name << ": scalar " << count / tScalar * 1e-6 << " M/s, SIMD "
+                << count / tSimd * 1e-6 << " M/s (x" << tScalar / tSimd << ")\n";
+            };
+        report("pdf (D*G1)", tEvalScalar, tEvalSimd);
+        report("sample_wh ", tSampleScalar, tSampleSimd);
+        std::cout << "  (checksum " << sink << ")\n";
+    }
+
+} // namespace rayt::debug
@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "Core/Math.hpp"
+#include "Materials/MaterialTable.hpp"
+#include "DebugTools/DebugScenes.hpp"
+#include "DebugTools/MaterialDebug.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace rayt::debug {
+
+    namespace {
+
+        // One shading point of a traced path, with the random numbers it is shaded with
+        struct Bounce {
+            SurfaceInteraction rec;
+            Vector3 wo;
+            Vector3 wi;   // an NEE-like direction for eval / pdf
+            Point2 u;     // for sample
+        };
+
+        // |a - b| relative to |b|, with an absolute floor so values near 0 do not blow up
+        double relErr(double a, double b) {
+            return std::abs(a - b) / std::max(std::abs(b), 1e-3);
+        }
+
+        double relErr(const Spectrum& a, const Spectrum& b) {
+            return std::max({ relErr(a.x, b.x), relErr(a.y, b.y), relErr(a.z, b.z) });
+        }
+
+        template <typename F>
+        double secondsFor(F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(t1 - t0).count();
+        }
+
+    } // namespace
+
+    void TestMaterialDispatch() {
+        constexpr int W = 320, H = 180, MAX_DEPTH = 8;
+        constexpr int REPEAT = 5, RUNS = 3;
+
+        const Scene scene = makeGoldRoughnessScene();
+        auto camera = makeGoldRoughnessCamera(W, H);
+
+        // The same materials as separate heap objects, the way geometry held them before the table
+        std::vector<std::shared_ptr<Material>> heap;
+        for (MaterialId id = 0; id < scene.materials().size(); ++id)
+            heap.push_back(std::visit([](const auto& m) -> std::shared_ptr<Material> {
+                return std::make_shared<std::decay_t<decltype(m)>>(m);
+                }, scene.materials()[id]));
+
+        // --- Trace the paths once and record every bounce ---
+        std::vector<Bounce> bounces;
+        sampling::SeedRandom(7);
+        for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x) {
+                RayDifferential r(camera->getRay((x + sampling::Random()) / W, (y + sampling::Random()) / H, Point2(0.5f, 0.5f)));
+                for (int depth = 0; depth < MAX_DEPTH; ++depth) {
+                    SurfaceInteraction rec;
+                    if (!scene.hit(r, rec)) break;
+                    const MaterialRef mat = scene.material(rec);
+                    mat.prepareShading(rec, r, Real(0));
+                    const Vector3 wo = -glm::normalize(r.d);
+                    const BSDFContext ctx(rec, wo);
+                    const Vector3 wi = ctx.toWorld(sampling::CosineSampleHemisphere(sampling::Random2D()));
+                    const Point2 u = sampling::Random2D();
+                    bounces.push_back({ rec, wo, wi, u });
+                    const auto s = mat.sample(ctx, u);
+                    if (!s) break;
+                    r = RayDifferential(SpawnRay(rec.p, rec.gn, s->wi));
+                }
+            }
+        // Both paths shade the same records: matPtr for the virtual calls, materialId for the table
+        for (Bounce& b : bounces) b.rec.matPtr = heap[b.rec.materialId].get();
+
+        std::cout << "\n[Debug] Material dispatch, gold roughness scene " << W << "x" << H << ", "
+            << bounces.size() << " bounces (depth <= " << MAX_DEPTH << ")\n";
+
+        // --- Agreement ---
+        double evalErr = 0, pdfErr = 0, sampleErr = 0;
+        size_t sampleMismatch = 0;
+        for (const Bounce& b : bounces) {
+            const BSDFContext ctx(b.rec, b.wo);
+            const Material& v = *b.rec.matPtr;
+            const MaterialRef t = scene.material(b.rec);
+            evalErr = std::max(evalErr, relErr(v.eval(ctx, b.wi), t.eval(ctx, b.wi)));
+            pdfErr = std::max(pdfErr, relErr(v.pdf(ctx, b.wi), t.pdf(ctx, b.wi)));
+            const auto sv = v.sample(ctx, b.u), st = t.sample(ctx, b.u);
+            if (bool(sv) != bool(st) || (sv && sv->flags != st->flags)) {
+                ++sampleMismatch;
+                continue;
+            }
+            if (sv)
+                sampleErr = std::max({ sampleErr, relErr(sv->f, st->f), relErr(sv->pdf, st->pdf),
+                    double(math::maxComponent(glm::abs(sv->wi - st->wi))) });
+        }
+        const bool ok = evalErr < 1e-6 && pdfErr < 1e-6 && sampleErr < 1e-6 && sampleMismatch == 0;
+        std::cout << "  virtual vs table: eval " << evalErr << ", pdf " << pdfErr << ", sample " << sampleErr
+            << " (max rel. error), " << sampleMismatch << " sample() disagreements"
+            << (ok ? "" : "  <-- FAIL") << "\n";
+
+        // --- Shading time per bounce: context, eval, pdf and sample, as the integrator does ---
+        // The two alternate and each keeps its best run, so neither gains from going second
+        double sink = 0;
+        auto shadeVirtual = [&] {
+            for (int rep = 0; rep < REPEAT; ++rep)
+                for (const Bounce& b : bounces) {
+                    const Material* m = b.rec.matPtr;
+                    const BSDFContext ctx(b.rec, b.wo);
+                    sink += m->eval(ctx, b.wi).x + m->pdf(ctx, b.wi);
+                    if (auto s = m->sample(ctx, b.u)) sink += s->pdf;
+                }
+            };
+        auto shadeTable = [&] {
+            for (int rep = 0; rep < REPEAT; ++rep)
+                for (const Bounce& b : bounces) {
+                    const MaterialRef m = scene.material(b.rec);
+                    const BSDFContext ctx(b.rec, b.wo);
+                    sink += m.eval(ctx, b.wi).x + m.pdf(ctx, b.wi);
+                    if (auto s = m.sample(ctx, b.u)) sink += s->pdf;
+                }
+            };
+        double tVirtual = 1e30, tTable = 1e30;
+        for (int run = 0; run < RUNS; ++run) {
+            tVirtual = std::min(tVirtual, secondsFor(shadeVirtual));
+            tTable = std::min(tTable, secondsFor(shadeTable));
+        }
+
+        const double count = double(bounces.size()) * REPEAT;
+        std::cout << "  shared_ptr<Material> virtual " << tVirtual / count * 1e9 << " ns/bounce, MaterialTable visit "
+            << tTable / count * 1e9 << " ns/bounce (x" << tVirtual / tTable << ")\n";
+        std::cout << "  (checksum " << sink << ")\n";
+    }
+
+} // namespace rayt::debug
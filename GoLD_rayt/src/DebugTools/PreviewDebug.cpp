@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Fresnel.hpp"
+#include "Core/Sampling.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/EnvMap.hpp"
+#include "IO/ImageLoader.hpp"
+#include "Microfacet/SplitSumTable.hpp"
+#include "Renderer/Camera.hpp"
+#include "Renderer/Film.hpp"
+#include "Renderer/Integrator.hpp"
+#include "Renderer/PrefilteredEnv.hpp"
+#include "Renderer/PreviewIntegrator.hpp"
+#include "Renderer/Scene.hpp"
+#include "DebugTools/DebugScenes.hpp"
+#include "DebugTools/PreviewDebug.hpp"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace rayt::debug {
+
+    namespace {
+
+        template <typename F>
+        double secondsFor(F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(t1 - t0).count();
+        }
+
+        Real luminance(const Spectrum& c) { return Real(0.2126) * c.x + Real(0.7152) * c.y + Real(0.0722) * c.z; }
+
+        const Spectrum N_AU(0.16, 0.42, 1.45);
+        const Spectrum K_AU(3.48, 2.45, 1.77);
+
+        /// Directional albedo of RoughConductor with exact Fresnel, by VNDF sampling.
+        Spectrum conductorAlbedo(Real cosThetaO, Real alpha, int samples) {
+            const GGXDistribution ggx(alpha, alpha);
+            const Vector3 wo(std::sqrt(Real(1) - cosThetaO * cosThetaO), Real(0), cosThetaO);
+            const Real lambdaO = ggx.lambda(wo);
+            Spectrum sum(0.0);
+            for (int s = 0; s < samples; ++s) {
+                const Vector3 wh = ggx.sample_wh(wo, sampling::Hammersley(uint32_t(s), uint32_t(samples)));
+                const Real vh = glm::dot(wo, wh);
+                const Vector3 wi = Real(2) * vh * wh - wo;
+                if (vh <= 0 || wi.z <= 0) continue;
+                sum += fresnel::fresnelConductor(vh, N_AU, K_AU) * ((Real(1) + lambdaO) / (Real(1) + lambdaO + ggx.lambda(wi)));
+            }
+            return sum / Real(samples);
+        }
+
+    } // namespace
+
+    void TestPreviewIntegrator(const std::string& hdrPath, int referenceSpp) {
+        std::shared_ptr<EnvMap> env;
+        try {
+            env = std::make_shared<EnvMap>(io::loadHDR(hdrPath, PixelFormat::RGBE));
+        }
+        catch (const std::exception& e) {
+            std::cout << "  [skip] " << hdrPath << ": " << e.what() << "\n";
+            return;
+        }
+        std::cout << "\n[Debug] IBL preview, " << hdrPath << "\n";
+
+        // --- Tables (load() against an empty cache of its own: a miss, then a hit) ---
+        const io::AssetCache cache((std::filesystem::temp_directory_path() / "rayt_preview_debug_cache").string());
+        std::error_code ec;
+        std::filesystem::remove_all(cache.directory(), ec);
+        std::shared_ptr<const PrefilteredEnv> prefiltered;
+        const double tBuild = secondsFor([&] { prefiltered = std::make_shared<PrefilteredEnv>(env); });
+        const double tFirst = secondsFor([&] { prefiltered = PrefilteredEnv::load(env, hdrPath, &cache); });
+        const double tCached = secondsFor([&] { prefiltered = PrefilteredEnv::load(env, hdrPath, &cache); });
+        std::filesystem::remove_all(cache.directory(), ec);
+        std::unique_ptr<SplitSumTable> splitSum;
+        const double tTable = secondsFor([&] { splitSum = std::make_unique<SplitSumTable>(); });
+        std::cout << "  prefiltered env: build " << tBuild << " s, load() first run " << tFirst << " s, cached " << tCached
+            << " s, " << prefiltered->memoryBytes() / double(1 << 20) << " MiB; split-sum table " << tTable << " s\n";
+
+        // --- BRDF half: F82 fit and the tabulated albedo against exact Fresnel ---
+        Spectrum f0, a;
+        SplitSumTable::conductorFresnel(N_AU, K_AU, f0, a);
+        Real fitError = 0;
+        for (int i = 0; i <= 1000; ++i) {
+            const Real mu = i / Real(1000);
+            const Spectrum f82 = f0 + (Spectrum(1.0) - f0) * std::pow(1 - mu, Real(5)) - a * mu * std::pow(1 - mu, Real(6));
+            const Spectrum d = glm::abs(f82 - fresnel::fresnelConductor(mu, N_AU, K_AU));
+            fitError = std::max(fitError, std::max(d.x, std::max(d.y, d.z)));
+        }
+        Real tableError = 0;
+        for (Real alpha : { 1e-4, 0.04, 0.25, 0.6 })
+            for (Real mu : { 0.05, 0.3, 0.7, 1.0 }) {
+                const Spectrum d = glm::abs(splitSum->albedo(mu, alpha, f0, a) - conductorAlbedo(mu, alpha, 1 << 14));
+                tableError = std::max(tableError, std::max(d.x, std::max(d.y, d.z)));
+            }
+        std::cout << "  gold F82 fit: max |F - F_exact| " << fitError << "; table albedo vs exact-Fresnel integral: max abs error "
+            << tableError << "\n";
+
+        // --- Frame time at the main.cpp resolution ---
+        {
+            const Scene scene = makeGoldRoughnessScene();
+            Film film(800, 450);
+            PreviewIntegrator interactive(makeGoldRoughnessCamera(800, 450), prefiltered);
+            const double t = secondsFor([&] { interactive.render(scene, film); });
+            PreviewIntegrator refine = PreviewIntegrator::refinePass(makeGoldRoughnessCamera(800, 450), prefiltered);
+            const double tRefine = secondsFor([&] { refine.render(scene, film); });
+            std::cout << "  800x450 preview: interactive pass " << t << " s (1 sample, 4 diffuse / specular rays), refine pass "
+                << tRefine << " s (2x2 samples, 8 rays), " << hardwareThreads() << " threads\n";
+        }
+
+        // --- Error against path tracing ---
+        // Dielectrics are left out: Sphere flips the shading normal towards the ray, so the path-traced
+        // reference never sees a ray leaving the glass and is not a usable ground truth for them.
+        constexpr int W = 160, H = 90;
+        {
+            std::vector<std::string> names;
+            const Scene scene = makeGoldRoughnessScene(&names);
+            auto camera = makeGoldRoughnessCamera(W, H);
+
+            // Both passes, and the refine pass without specular occlusion (one ray along the dominant direction)
+            Film interactive(W, H), refine(W, H), unoccluded(W, H);
+            PreviewIntegrator(camera, prefiltered).render(scene, interactive);
+            PreviewIntegrator::refinePass(camera, prefiltered).render(scene, refine);
+            PreviewIntegrator(camera, prefiltered, 2, 8, 0).render(scene, unoccluded);
+
+            // Two half references: their difference estimates the noise left in the average.
+            // Plain environment sampling, so the ground truth does not depend on the product sampler
+            Film half0(W, H), half1(W, H);
+            PathIntegrator path(camera, env, 50, std::max(1, referenceSpp / 2));
+            const double tRef = secondsFor([&] { path.render(scene, half0); path.render(scene, half1); });
+
+            // Per pass and region: relMSE and summed luminance
+            struct Error { std::vector<Real> mse, sum; };
+            const Film* passes[3] = { &interactive, &refine, &unoccluded };
+            const size_t regions = names.size();
+            Error errors[3];
+            for (Error& e : errors) { e.mse.assign(regions, 0); e.sum.assign(regions, 0); }
+            std::vector<Real> noise(regions, 0), sumR(regions, 0);
+            std::vector<int> count(regions, 0);
+            for (int y = 0; y < H; ++y)
+                for (int x = 0; x < W; ++x) {
+                    // Film row y holds camera row H - 1 - y
+                    const Ray r = camera->getRay((x + Real(0.5)) / W, (H - 1 - y + Real(0.5)) / H, Point2(0.5f, 0.5f));
+                    SurfaceInteraction rec;
+                    const size_t region = scene.hit(r, rec) ? std::min<size_t>(rec.materialId, regions - 1) : regions - 1;
+
+                    const Spectrum h0 = half0.getPixel(x, y), h1 = half1.getPixel(x, y);
+                    const Real l0 = luminance(h0), l1 = luminance(h1), lr = Real(0.5) * (l0 + l1);
+                    const Real denom = lr * lr + Real(1e-2);
+                    for (int k = 0; k < 3; ++k) {
+                        const Real lp = luminance(passes[k]->getPixel(x, y));
+                        errors[k].mse[region] += (lp - lr) * (lp - lr) / denom;
+                        errors[k].sum[region] += lp;
+                    }
+                    noise[region] += Real(0.25) * (l0 - l1) * (l0 - l1) / denom;
+                    sumR[region] += lr;
+                    ++count[region];
+                }
+
+            // The near-mirror's reference mean is heavy-tailed (sub-pixel sun glints): its bias moves by several
+            // percent between reference runs, more than the two halves suggest
+            std::cout << "  gold scene " << W << "x" << H << ", reference " << referenceSpp
+                << " spp (" << tRef << " s); relMSE, mean luminance bias:\n";
+            for (size_t i = 0; i < regions; ++i) {
+                if (count[i] == 0) continue;
+                auto bias = [&](Real sum) { return sumR[i] > 0 ? (sum / sumR[i] - 1) * 100 : 0; };
+                std::cout << "    " << names[i] << " (" << count[i] << " px): interactive " << errors[0].mse[i] / count[i] << ", "
+                    << bias(errors[0].sum[i]) << " %; refine " << errors[1].mse[i] / count[i] << ", " << bias(errors[1].sum[i])
+                    << " %; refine without specular occlusion " << errors[2].mse[i] / count[i] << ", " << bias(errors[2].sum[i])
+                    << " %; reference noise ~" << noise[i] / count[i] << "\n";
+            }
+        }
+    }
+}
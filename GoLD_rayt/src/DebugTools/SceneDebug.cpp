@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "DebugTools/SceneDebug.hpp"
+#include "Geometry/SphereInstances.hpp"
+#include "IO/SceneFile.hpp"
+#include "Renderer/Scene.hpp"
+#include "Renderer/SceneBuilder.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace rayt::debug {
+
+    namespace {
+
+        double secondsSince(std::chrono::steady_clock::time_point t0) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+
+        std::vector<char> readAll(const std::string& path) {
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            std::vector<char> bytes(size_t(in.tellg()));
+            in.seekg(0);
+            in.read(bytes.data(), std::streamsize(bytes.size()));
+            return bytes;
+        }
+
+    } // namespace
+
+    void TestSceneFile(const std::string& scenePath, int instances) {
+        std::cout << "\n[Debug] Scene files\n";
+
+        // 1. Round trip of an authored scene
+        try {
+            const io::SceneFile text = io::SceneFile::load(scenePath);
+            text.writeBinary("scene_test.rsb");
+            const io::SceneFile binary = io::SceneFile::load("scene_test.rsb");
+            std::stringstream dumped;
+            binary.writeText(dumped);
+            const std::vector<char> again = io::parseSceneText(dumped, "dump").compile();
+            const std::vector<char> first = readAll("scene_test.rsb");
+            std::cout << "  " << scenePath << ": " << text.materialCount() << " materials, " << text.instanceCount()
+                << " instances, " << binary.bvhNodeCount() << " BVH nodes; mapped " << (binary.isMapped() ? "yes" : "no")
+                << ", text -> binary -> text -> binary identical: " << (again == first ? "yes" : "NO") << "\n";
+        }
+        catch (const std::exception& e) {
+            std::cout << "  " << e.what() << "\n";
+        }
+
+        // 2. A generated scene: a grid of small spheres on a large floor
+        io::SceneDescription big;
+        big.settings.environment = big.addString("assets/env/grace-new.hdr");
+        io::MaterialRecord floor, metal;
+        floor.color[0] = floor.color[1] = floor.color[2] = 0.5;
+        metal.kind = io::MaterialKind::Conductor;
+        metal.color[0] = 0.16; metal.color[1] = 0.42; metal.color[2] = 1.45;
+        metal.k[0] = 3.48; metal.k[1] = 2.45; metal.k[2] = 1.77;
+        metal.roughness = 0.2;
+        floor.name = big.addString("floor");
+        metal.name = big.addString("metal");
+        big.materials = { floor, metal };
+        io::SphereRecord ball;
+        ball.name = big.addString("ball");
+        big.geometry = { ball };
+
+        const int side = std::max(1, int(std::sqrt(double(instances))));
+        big.instances.push_back({ 0, 0, { 0, -1000.5, 0 }, 1000.0 });
+        for (int i = 0; i + 1 < instances; ++i) {
+            io::InstanceRecord inst;
+            inst.material = 1;
+            inst.translation[0] = (i % side) * 0.25 + sampling::Random() * 0.1;
+            inst.translation[1] = sampling::Random() * 0.1;
+            inst.translation[2] = -(i / side) * 0.25;
+            inst.scale = 0.05 + sampling::Random() * 0.05;
+            big.instances.push_back(inst);
+        }
+
+        {
+            std::ofstream out("scene_test_big.rscn");
+            io::SceneFile::fromDescription(big).writeText(out);
+        }
+        io::SceneFile::fromDescription(big).writeBinary("scene_test_big.rsb");
+        const double textMB = std::filesystem::file_size("scene_test_big.rscn") / 1e6;
+        const double binaryMB = std::filesystem::file_size("scene_test_big.rsb") / 1e6;
+
+        // (the scenes are closed before their files are removed; Windows keeps mapped files open)
+        {
+            // Time to first ray: load (parse + compile + BVH for text, map + validate for binary),
+            // then buildScene and one closest-hit query, as main.cpp does before rendering
+            struct Loaded {
+                io::SceneFile file;
+                std::unique_ptr<Scene> scene;
+                double sLoad, sFirstRay;
+            };
+            auto loadAndTrace = [](const std::string& path) {
+                const auto t0 = std::chrono::steady_clock::now();
+                io::SceneFile file = io::SceneFile::load(path);
+                const double sLoad = secondsSince(t0);
+                std::unique_ptr<Scene> scene = buildScene(file);
+                SurfaceInteraction rec;
+                scene->hit(Ray(Point3(0, 2, 0), glm::normalize(Vector3(0.1, -1, -0.2))), rec);
+                return Loaded{ std::move(file), std::move(scene), sLoad, secondsSince(t0) };
+            };
+
+            const Loaded text = loadAndTrace("scene_test_big.rscn");
+            const Loaded binary = loadAndTrace("scene_test_big.rsb");
+            const io::SceneFile& mapped = binary.file;
+
+            // Touching every instance pages the whole table in, as a render would
+            auto t0 = std::chrono::steady_clock::now();
+            double checksum = 0;
+            for (size_t i = 0; i < mapped.instanceCount(); ++i) checksum += mapped.instances()[i].scale;
+            const double sTouch = secondsSince(t0);
+
+            t0 = std::chrono::steady_clock::now();
+            const size_t readBytes = readAll("scene_test_big.rsb").size();
+            const double sRead = secondsSince(t0);
+
+            std::cout << "  " << mapped.instanceCount() << " instances, " << mapped.bvhNodeCount() << " BVH nodes:\n"
+                << "    text   " << textMB << " MB: loaded in " << text.sLoad * 1e3 << " ms (" << textMB / text.sLoad
+                << " MB/s), first ray after " << text.sFirstRay * 1e3 << " ms\n"
+                << "    binary " << binaryMB << " MB: mapped + validated in " << binary.sLoad * 1e3
+                << " ms, first ray after " << binary.sFirstRay * 1e3 << " ms (x" << text.sFirstRay / binary.sFirstRay
+                << " faster)\n"
+                << "    every instance touched in " << sTouch * 1e3 << " ms; reading the binary into memory "
+                << sRead * 1e3 << " ms (" << readBytes / 1e6 / sRead << " MB/s) [checksum " << checksum << "]\n";
+
+            // 3. The mapped BVH against a linear walk of the same tables (the linear walk is O(instances) per ray)
+            const auto bvh = SphereInstances::build(mapped);
+            const SphereInstances linear(mapped.geometry(), mapped.instances(), 0, mapped.instanceCount());
+            auto randomRay = [&] {
+                const Point3 o(sampling::Random() * side * 0.25, 2.0, sampling::Random() * 2.0);
+                return Ray(o, glm::normalize(Vector3(sampling::Random() - 0.5, -1.0, -sampling::Random())));
+            };
+            const int checkRays = int(std::clamp<size_t>(size_t(2e8) / std::max<size_t>(mapped.instanceCount(), 1), 16, 20000));
+            int hits = 0, mismatches = 0;
+            for (int i = 0; i < checkRays; ++i) {
+                const Ray r = randomRay();
+                SurfaceInteraction a, b;
+                const bool ha = bvh->hit(r, a), hb = linear.hit(r, b);
+                hits += ha;
+                if (ha != hb || (ha && (a.t != b.t || a.materialId != b.materialId))) ++mismatches;
+            }
+
+            constexpr int timedRays = 200000;
+            SurfaceInteraction rec;
+            t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < timedRays; ++i) hits += bvh->hit(randomRay(), rec);
+            const double sTrace = secondsSince(t0);
+
+            std::cout << "  mapped BVH vs linear: " << checkRays << " rays, " << mismatches << " mismatches; "
+                << timedRays / sTrace * 1e-6 << " M closest hits/s through the BVH (" << hits << " hits)\n";
+        }
+
+        std::remove("scene_test.rsb");
+        std::remove("scene_test_big.rscn");
+        std::remove("scene_test_big.rsb");
+    }
+}
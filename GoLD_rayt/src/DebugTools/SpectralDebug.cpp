@@ -0,0 +1,216 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Sampling.hpp"
+#include "Core/SampledSpectrum.hpp"
+#include "Core/SpectrumUtils.hpp"
+#include "Core/Fresnel.hpp"
+#include "IO/IORInterpolator.hpp"
+#include "IO/SpectralIORTable.hpp"
+#include "Core/RGBToSpectrumTable.hpp"
+#include "DebugTools/SpectralDebug.hpp"
+#include <chrono>
+#include <filesystem>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace rayt::debug {
+
+    namespace {
+
+        // Stratified hero samples: averages of toRGB() converge quickly
+        template <typename F>
+        Spectrum integrateRGB(int n, F&& spectrumAt) {
+            Spectrum sum(0.0);
+            for (int i = 0; i < n; ++i) {
+                const SampledWavelengths lambda = SampledWavelengths::sampleHero((i + 0.5) / n);
+                sum += spectral::toRGB(spectrumAt(lambda), lambda);
+            }
+            return sum / Real(n);
+        }
+
+        template <typename F>
+        double nsPerOp(int n, F&& f) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            f();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+        }
+
+        std::ostream& operator<<(std::ostream& os, const Spectrum& s) {
+            return os << "(" << s.x << ", " << s.y << ", " << s.z << ")";
+        }
+
+    } // namespace
+
+    void TestSpectralSampling(const std::string& iorCsv) {
+        constexpr int N = 4096;
+
+        std::cout << "\n[Debug] Spectral sampling (" << NSpectrumSamples << " hero-rotated wavelengths, "
+            << LAMBDA_MIN << "-" << LAMBDA_MAX << " nm)\n";
+
+        // ---------------------------------------------------------------------
+        // 1. RGB -> spectrum -> RGB
+        // ---------------------------------------------------------------------
+        const Spectrum colors[] = {
+            Spectrum(1.0), Spectrum(0.5), Spectrum(1, 0, 0), Spectrum(0, 1, 0), Spectrum(0, 0, 1),
+            Spectrum(1.0, 0.78, 0.34), Spectrum(0.2, 0.45, 0.8) };
+        Real worst = 0;
+        for (const Spectrum& c : colors) {
+            const Spectrum back = integrateRGB(N, [&](const SampledWavelengths& l) { return spectral::fromRGB(c, l); });
+            const Real err = glm::length(back - c);
+            worst = std::max(worst, err);
+            std::cout << "  rgb " << c << " -> " << back << "  |err| = " << err << "\n";
+        }
+        std::cout << (worst < 0.01 ? "  [OK] round trip within 0.01.\n"
+            : "  [WARN] RGB round trip error is large!\n");
+
+        // ---------------------------------------------------------------------
+        // 2. Measured conductor: 3 wavelengths vs the whole spectrum
+        // ---------------------------------------------------------------------
+        SpectralIORTable ior;
+        if (ior.loadCSV(iorCsv, false)) {
+            auto part = [&](double wl, bool imag) { auto c = ior.evaluate(wl); return imag ? c.imag() : c.real(); };
+            const Spectrum n3(part(650, false), part(550, false), part(450, false));
+            const Spectrum k3(part(650, true), part(550, true), part(450, true));
+
+            for (Real cosTheta : { 1.0, 0.5, 0.1 }) {
+                const Spectrum rgb3 = fresnel::fresnelConductor(cosTheta, n3, k3);
+                const Spectrum full = integrateRGB(N, [&](const SampledWavelengths& l) {
+                    SampledSpectrum n, k;
+                    ior.evaluate(l, n, k);
+                    return fresnel::fresnelConductor(cosTheta, n, k);
+                    });
+                std::cout << "  F(cos=" << cosTheta << ")  3-wavelength " << rgb3 << "  spectral " << full << "\n";
+            }
+        }
+        else {
+            std::cout << "  [skip] " << iorCsv << " not found; conductor comparison skipped.\n";
+        }
+
+        // ---------------------------------------------------------------------
+        // 3. Cost of the per-vertex operations (RGB double vec3 vs 4 float lanes);
+        //    beta is reset before it decays into denormals
+        // ---------------------------------------------------------------------
+        constexpr int OPS = 1 << 20;
+        const SampledWavelengths lambda = SampledWavelengths::sampleHero(sampling::Random());
+        Spectrum betaRGB(1.0), fRGB(0.9, 0.8, 0.7);
+        SampledSpectrum beta(1.0), f = spectral::fromRGB(fRGB, lambda);
+        Real cosTheta = 0.7, pdf = 0.8;
+
+        const double tRGB = nsPerOp(OPS, [&] { for (int i = 0; i < OPS; ++i) { betaRGB *= fRGB * cosTheta / pdf; if (isBlack(betaRGB - Spectrum(1e-3))) betaRGB = Spectrum(1.0); } });
+        const double tSpec = nsPerOp(OPS, [&] { for (int i = 0; i < OPS; ++i) { beta *= f * cosTheta / pdf; if (isBlack(beta - Real(1e-3))) beta = SampledSpectrum(1.0); } });
+        Spectrum sink(0.0);
+        const double tLift = nsPerOp(OPS, [&] { for (int i = 0; i < OPS; ++i) sink += spectral::toRGB(spectral::fromRGB(Spectrum(i & 1, 0.5, 0.25), lambda), lambda) * 1e-9; });
+
+        std::cout << "  throughput update: RGB " << tRGB << " ns, spectral " << tSpec << " ns\n"
+            << "  lift + XYZ->RGB per sample: " << tLift << " ns  (sink " << sink.x + betaRGB.x + beta[0] << ")\n";
+    }
+
+    void TestSpectralIORTable(const std::string& iorCsv) {
+        std::cout << "\n[Debug] SpectralIORTable vs IORInterpolator (" << iorCsv << ")\n";
+
+        // An empty cache of its own, so the first load is always a miss
+        const io::AssetCache cache((std::filesystem::temp_directory_path() / "rayt_ior_debug_cache").string());
+        std::error_code ec;
+        std::filesystem::remove_all(cache.directory(), ec);
+
+        // 1. Load times: CSV parse, CSV parse + resample + cache store, cache hit
+        IORInterpolator ior;
+        SpectralIORTable fresh, cached;
+        bool ok = true;
+        const double tParse = nsPerOp(1, [&] { ok = ior.loadCSV(iorCsv); });
+        const double tBuild = nsPerOp(1, [&] { ok = ok && fresh.loadCSV(iorCsv, cache); });
+        const double tCache = nsPerOp(1, [&] { ok = ok && cached.loadCSV(iorCsv, cache); });
+        if (!ok) {
+            std::cout << "  [skip] " << iorCsv << " could not be loaded.\n";
+            return;
+        }
+        std::cout << "  load: CSV parse " << tParse / 1e3 << " us, parse + resample + store "
+            << tBuild / 1e3 << " us, cached " << tCache / 1e3 << " us (" << cached.size() << " points)\n";
+
+        // 2. Accuracy over the rendered range (the grid is finer than the data, so only
+        //    kinks between grid points and float storage contribute)
+        double maxErr = 0;
+        for (double l = LAMBDA_MIN; l <= LAMBDA_MAX; l += 0.1) {
+            const std::complex<double> a = ior.evaluate(l), b = cached.evaluate(l);
+            maxErr = std::max({ maxErr, std::abs(a.real() - b.real()), std::abs(a.imag() - b.imag()) });
+        }
+        std::cout << "  max |table - measured| over " << LAMBDA_MIN << "-" << LAMBDA_MAX << " nm: " << maxErr << "\n";
+
+        // 3. Throughput
+        constexpr int N = 1 << 20;
+        std::vector<float> lambda(N), n(N), k(N);
+        for (float& l : lambda) l = float(sampling::Random(LAMBDA_MIN, LAMBDA_MAX));
+
+        double sink = 0;
+        const double tSearch = nsPerOp(N, [&] { for (int i = 0; i < N; ++i) sink += ior.evaluate(lambda[i]).real(); });
+        const double tTable = nsPerOp(N, [&] { for (int i = 0; i < N; ++i) sink += cached.evaluate(lambda[i]).real(); });
+        const double tBatch = nsPerOp(N, [&] { cached.evaluate(lambda.data(), N, n.data(), k.data()); });
+        sink += n[N / 2] + k[N / 3];
+
+        std::cout << "  lookups/s: lower_bound " << 1e3 / tSearch << " M, table " << 1e3 / tTable
+            << " M, table SIMD batch " << 1e3 / tBatch << " M  (sink " << sink << ")\n";
+
+        std::filesystem::remove_all(cache.directory(), ec);
+    }
+
+    void TestRGBToSpectrumTable() {
+        std::cout << "\n[Debug] RGB -> spectrum table (" << RGBToSpectrumTable::DEFAULT_RES << "^3 per max component)\n";
+
+        // 1. Fit once, then time the mapped load the renderer does at startup
+        const std::string file = (std::filesystem::temp_directory_path() / "rayt_rgb2spec_debug.coeff").string();
+        RGBToSpectrumTable fitted, mapped;
+        bool ok = false;
+        const double tFit = nsPerOp(1, [&] { fitted = RGBToSpectrumTable::fit(); });
+        const double tLoad = nsPerOp(1, [&] { ok = fitted.save(file) && mapped.load(file); });
+        if (!ok) {
+            std::cout << "  [skip] could not write or map " << file << "\n";
+            return;
+        }
+        const double tMap = nsPerOp(1, [&] { ok = mapped.load(file); });
+        std::cout << "  fit " << tFit / 1e9 << " s, save + map " << tLoad / 1e3 << " us, map " << tMap / 1e3 << " us\n";
+
+        // 2. Round trip over random reflectances and HDR values (1 nm hero sums, as rendered)
+        constexpr int COLORS = 500, N = 512;
+        Real worst = 0, mean = 0, peak = 0;
+        for (int c = 0; c < COLORS; ++c) {
+            Spectrum rgb(sampling::Random(), sampling::Random(), sampling::Random());
+            if (c % 5 == 0) rgb *= Real(8.0); // emission / environment range
+            const Spectrum back = integrateRGB(N, [&](const SampledWavelengths& l) {
+                const SampledSpectrum s = spectral::fromRGB(rgb, l);
+                if (rgb.x <= 1 && rgb.y <= 1 && rgb.z <= 1)
+                    for (int i = 0; i < NSpectrumSamples; ++i) peak = std::max(peak, Real(s[i]));
+                return s;
+                });
+            const Real err = glm::length(back - rgb) / std::max(Real(1.0), std::max(rgb.x, std::max(rgb.y, rgb.z)));
+            worst = std::max(worst, err);
+            mean += err / COLORS;
+        }
+        std::cout << "  round trip (relative): mean " << mean << ", max " << worst
+            << "; max reflectance value " << peak << "\n";
+        std::cout << (worst < 0.02 && peak <= 1 ? "  [OK] table reproduces RGB and keeps reflectances in [0, 1].\n"
+            : "  [WARN] table round trip is off!\n");
+
+        // 3. Cost: table lookup, per-wavelength evaluation and the full lift
+        constexpr int OPS = 1 << 20;
+        std::vector<float> lambda(OPS), out(OPS);
+        for (float& l : lambda) l = float(sampling::Random(LAMBDA_MIN, LAMBDA_MAX));
+        const SampledWavelengths hero = SampledWavelengths::sampleHero(0.3);
+        const RGBSigmoidPolynomial poly = mapped(Vector3(0.8, 0.5, 0.2));
+
+        float sink = 0;
+        const double tLookup = nsPerOp(OPS, [&] { for (int i = 0; i < OPS; ++i) sink += mapped(Vector3(0.8, (i & 255) / 255.0, 0.2)).c2; });
+        const double tBatch = nsPerOp(OPS, [&] { poly.evaluate(lambda.data(), OPS, out.data()); });
+        const double tLift = nsPerOp(OPS, [&] { for (int i = 0; i < OPS; ++i) sink += spectral::fromRGB(Spectrum(0.8, (i & 255) / 255.0, 0.2), hero)[0]; });
+        sink += out[OPS / 2];
+
+        std::cout << "  lookup " << tLookup << " ns, evaluate " << tBatch << " ns/wavelength (SIMD batch), fromRGB "
+            << tLift << " ns per " << NSpectrumSamples << " wavelengths  (sink " << sink << ")\n";
+
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+    }
+
+} // namespace rayt::debug
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "Core/Types.hpp"
+#include "Core/Image.hpp"
+#include "Core/Sampling.hpp"
+#include "IO/AssetCache.hpp"
+#include "Textures/MIPMap.hpp"
+#include "Textures/TileCache.hpp"
+#include "DebugTools/TextureDebug.hpp"
+#include "stb_image_write.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+
+namespace rayt::debug {
+
+    namespace {
+
+        // Fine black/white checkerboard: the worst case for minification aliasing
+        Image makeChecker(int size, int checkTexels) {
+            std::vector<Vector3> px(size_t(size) * size);
+            for (int y = 0; y < size; ++y)
+                for (int x = 0; x < size; ++x)
+                    px[size_t(y) * size + x] = Vector3(((x / checkTexels + y / checkTexels) & 1) ? 1.0 : 0.0);
+            return Image(size, size, px);
+        }
+
+        // Ground plane seen from height 1 looking at the horizon; screen (px, py) in [0, 1]^2
+        UV groundST(Real px, Real py) {
+            const Real ys = py * Real(0.5) + Real(0.01);
+            const Real z = Real(1.0) / ys;
+            const Real x = (px - Real(0.5)) * Real(2.0) * z;
+            return UV(x, z) * Real(0.25);
+        }
+
+    } // namespace
+
+    void TestTextureFiltering() {
+        constexpr int SCREEN = 64;
+        constexpr int REF_SAMPLES = 16; // per axis
+        const Real pixel = Real(1.0) / SCREEN;
+
+        std::cout << "\n[Debug] Texture filtering vs supersampled reference ("
+            << SCREEN << "x" << SCREEN << " ground plane, 512^2 checker)\n";
+
+        // Small dedicated cache so the test also exercises eviction
+        TileCache cache(size_t(512) << 10);
+        MIPMap mip(makeChecker(512, 4), WrapMode::Repeat, cache);
+
+        auto footprintLookup = [&](Real px, Real py, TextureFilter filter) {
+            const UV st = groundST(px, py);
+            const UV dst0 = groundST(px + pixel, py) - st;
+            const UV dst1 = groundST(px, py + pixel) - st;
+            return mip.lookup(st, dst0, dst1, filter).x;
+        };
+
+        // Reference: box average of REF_SAMPLES^2 point samples per pixel
+        std::vector<Real> ref(size_t(SCREEN) * SCREEN);
+        for (int y = 0; y < SCREEN; ++y)
+            for (int x = 0; x < SCREEN; ++x) {
+                Real sum = 0;
+                for (int j = 0; j < REF_SAMPLES; ++j)
+                    for (int i = 0; i < REF_SAMPLES; ++i) {
+                        const UV st = groundST((x + (i + 0.5) / REF_SAMPLES) * pixel, (y + (j + 0.5) / REF_SAMPLES) * pixel);
+                        sum += mip.bilerp(0, st).x;
+                    }
+                ref[size_t(y) * SCREEN + x] = sum / (REF_SAMPLES * REF_SAMPLES);
+            }
+
+        auto rmseOf = [&](auto&& value) {
+            Real se = 0;
+            for (int y = 0; y < SCREEN; ++y)
+                for (int x = 0; x < SCREEN; ++x) {
+                    const Real d = value(x, y) - ref[size_t(y) * SCREEN + x];
+                    se += d * d;
+                }
+            return std::sqrt(se / (SCREEN * SCREEN));
+        };
+
+        // Unfiltered point sampling at n jittered positions per pixel (what extra spp buys)
+        for (int n : { 1, 4, 16, 64 }) {
+            const Real e = rmseOf([&](int x, int y) {
+                Real sum = 0;
+                for (int s = 0; s < n; ++s)
+                    sum += mip.bilerp(0, groundST((x + sampling::Random()) * pixel, (y + sampling::Random()) * pixel)).x;
+                return sum / n;
+                });
+            std::cout << "  bilinear, " << n << " spp: RMSE = " << e << "\n";
+        }
+
+        for (auto [filter, name] : { std::pair{ TextureFilter::Trilinear, "trilinear" },
+                                     std::pair{ TextureFilter::EWA, "EWA" } }) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            const Real e = rmseOf([&](int x, int y) { return footprintLookup((x + 0.5) * pixel, (y + 0.5) * pixel, filter); });
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::cout << "  " << name << ", 1 spp: RMSE = " << e << "  ("
+                << std::chrono::duration<double, std::micro>(t1 - t0).count() / (SCREEN * SCREEN) << " us/lookup)\n";
+        }
+
+        std::cout << "  [cache] hits=" << cache.hits() << " misses=" << cache.misses()
+            << " bytes=" << cache.bytesUsed() << " / " << cache.capacity() << "\n";
+        if (cache.bytesUsed() > cache.capacity())
+            std::cout << "  [WARN] tile cache exceeded its budget!\n";
+
+        // ---------------------------------------------------------------------
+        // File-backed path: PNG -> pyramid -> AssetCache entry -> tiles on demand
+        // ---------------------------------------------------------------------
+        const std::filesystem::path dir = std::filesystem::temp_directory_path();
+        const std::string png = (dir / "rayt_texture_debug.png").string();
+        {
+            Image img = makeChecker(256, 8);
+            std::vector<unsigned char> bytes(size_t(256) * 256 * 3);
+            for (int y = 0; y < 256; ++y)
+                for (int x = 0; x < 256; ++x)
+                    for (int c = 0; c < 3; ++c) bytes[(size_t(y) * 256 + x) * 3 + c] = (unsigned char)(img.at(x, y)[c] * 255.0);
+            stbi_write_png(png.c_str(), 256, 256, 3, bytes.data(), 256 * 3);
+        }
+        const io::AssetCache assets((dir / "rayt_texture_debug_cache").string());
+        std::error_code ec;
+        std::filesystem::remove_all(assets.directory(), ec);
+
+        MIPMap resident(makeChecker(256, 8), WrapMode::Repeat, cache);
+        Real maxDiff = 0;
+        bool fileBacked = true;
+        for (int pass = 0; pass < 2; ++pass) { // pass 0 stores the tiles, pass 1 maps them
+            MIPMap fromFile(png, io::ColorEncoding::Linear, WrapMode::Repeat, cache, assets);
+            fileBacked = fileBacked && fromFile.isFileBacked();
+            for (int i = 0; i < 1000; ++i) {
+                const UV st(sampling::Random(), sampling::Random());
+                const UV d(sampling::Random() * 0.05, sampling::Random() * 0.05);
+                const Vector3 a = fromFile.lookup(st, d, UV(-d.y, d.x), TextureFilter::Trilinear);
+                const Vector3 b = resident.lookup(st, d, UV(-d.y, d.x), TextureFilter::Trilinear);
+                maxDiff = std::max(maxDiff, glm::length(a - b));
+            }
+        }
+        std::cout << "  [file] cached tiles=" << (fileBacked ? "yes" : "no (resident fallback)")
+            << " max |file - resident| = " << maxDiff << "\n";
+        std::cout << (maxDiff < 1e-5 ? "  [OK] file-backed tiles match the resident pyramid.\n"
+            : "  [WARN] file-backed tiles differ from the resident pyramid!\n");
+
+        std::filesystem::remove(png);
+        std::filesystem::remove_all(assets.directory(), ec);
+    }
+
+} // namespace rayt::debug
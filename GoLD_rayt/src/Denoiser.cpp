@@ -0,0 +1,251 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Core/Parallel.hpp"
+#include "Core/Simd.hpp"
+#include "Core/SpectrumUtils.hpp"
+#include "Renderer/Denoiser.hpp"
+
+namespace rayt {
+
+    namespace {
+
+        using simd::Float4;
+        using simd::Mask4;
+
+        constexpr int ROW_GRAIN = 8;           // rows per parallelFor chunk
+        constexpr float MIN_ALBEDO = 0.01f;    // darker channels are filtered as they are, not demodulated
+        constexpr float MISS_ID = -1.0f;       // id of pixels where no sample hit anything
+        constexpr float EPS_LUMINANCE = 1e-4f;
+        constexpr float EPS_DEPTH = 1e-3f;     // relative to the depth, so flat areas still tolerate jitter
+        constexpr float MAX_EXPONENT = 30.0f;  // taps beyond e^-30 get no weight (their w^2 would be denormal)
+        constexpr uint32_t MIN_VARIANCE_SAMPLES = 4; // fewer samples: the per-pixel variance is replaced by a 3x3 estimate
+
+        constexpr float B3[5] = { 1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+        constexpr float GAUSS3[3] = { 0.25f, 0.5f, 0.25f };
+
+        /**
+         * Padded planar buffers: every row has `pad` columns on either side, so a
+         * group of four pixels reads each tap with one unaligned load. The padding
+         * has a NaN id, which never equals anything, and zeros everywhere else.
+         */
+        struct Buffers {
+            int width, height, pad, stride;
+            std::vector<float> color[2][3], variance[2]; // ping-pong between passes
+            std::vector<float> normal[3], depth, gradient, id;
+
+            Buffers(int w, int h, int reach)
+                : width(w), height(h), pad(int(simd::roundUpToLanes(size_t(reach)))),
+                stride(2 * pad + int(simd::roundUpToLanes(size_t(w)))) {
+                const size_t n = size_t(stride) * h;
+                for (auto& buffer : color)
+                    for (auto& c : buffer) c.assign(n, 0.0f);
+                for (auto& v : variance) v.assign(n, 0.0f);
+                for (auto& c : normal) c.assign(n, 0.0f);
+                depth.assign(n, 0.0f);
+                gradient.assign(n, 0.0f);
+                id.assign(n, std::numeric_limits<float>::quiet_NaN());
+            }
+
+            size_t index(int x, int y) const { return size_t(y) * stride + pad + x; }
+        };
+
+        /// Factor the beauty is divided by: the albedo, except where it is too dark to divide by.
+        Spectrum demodulation(const Film& film, size_t i) {
+            Spectrum a(1.0);
+            for (int c = 0; c < 3; ++c) {
+                const float v = film.aovPlane(AOV::Albedo, c)[i];
+                if (v >= MIN_ALBEDO) a[c] = v;
+            }
+            return a;
+        }
+
+        Float4 luminance(Float4 r, Float4 g, Float4 b) {
+            return Float4(0.2126f) * r + Float4(0.7152f) * g + Float4(0.0722f) * b;
+        }
+
+        /// x^n for n >= 0, by squaring.
+        Float4 powi(Float4 x, int n) {
+            Float4 r(1.0f);
+            for (; n > 0; n >>= 1, x = x * x)
+                if (n & 1) r = r * x;
+            return r;
+        }
+
+        /// Demodulated color, variance, normals, depth and ids from the film.
+        void gather(const Film& film, Buffers& b) {
+            const float* normal[3] = { film.aovPlane(AOV::Normal, 0), film.aovPlane(AOV::Normal, 1), film.aovPlane(AOV::Normal, 2) };
+            const float* depth = film.aovPlane(AOV::Depth);
+            const float* variance = film.aovPlane(AOV::Variance);
+            const uint32_t* ids = film.materialIds();
+            const uint32_t* counts = film.sampleCounts();
+
+            parallelFor(b.height, ROW_GRAIN, [&](int y0, int y1) {
+                for (int y = y0; y < y1; ++y)
+                    for (int x = 0; x < b.width; ++x) {
+                        const size_t i = size_t(y) * b.width + x, j = b.index(x, y);
+                        Vector3 n(normal[0][i], normal[1][i], normal[2][i]);
+                        const Real length = glm::length(n);
+                        const bool hit = ids ? ids[i] != ~uint32_t(0) : length > 0;
+
+                        // Background pixels share a normal and a depth, so only the id keeps them apart
+                        n = hit && length > 0 ? n / length : Vector3(0, 0, 1);
+                        for (int c = 0; c < 3; ++c) b.normal[c][j] = float(n[c]);
+                        b.depth[j] = hit && depth && std::isfinite(depth[i]) ? depth[i] : 0.0f;
+                        b.id[j] = hit ? (ids ? float(ids[i]) : 0.0f) : MISS_ID;
+
+                        const Spectrum a = demodulation(film, i);
+                        const Spectrum L = film.getPixel(x, y) / a;
+                        for (int c = 0; c < 3; ++c) b.color[0][c][j] = std::isfinite(L[c]) ? float(L[c]) : 0.0f;
+                        if (variance && counts[i] >= MIN_VARIANCE_SAMPLES) {
+                            const Real la = Luminance(a);
+                            b.variance[0][j] = float(variance[i] / (la * la));
+                        }
+                        else {
+                            b.variance[0][j] = -1.0f; // estimated by derive()
+                        }
+                    }
+                });
+        }
+
+        /// Depth gradient magnitude, and a 3x3 variance estimate where the film has none.
+        void derive(Buffers& b) {
+            parallelFor(b.height, ROW_GRAIN, [&](int y0, int y1) {
+                for (int y = y0; y < y1; ++y)
+                    for (int x = 0; x < b.width; ++x) {
+                        const size_t j = b.index(x, y);
+
+                        // One-sided differences, the smaller of the two, so silhouettes do not count
+                        auto axis = [&](int dx, int dy) {
+                            float g = std::numeric_limits<float>::infinity();
+                            for (int side : { -1, 1 }) {
+                                const int xx = x + side * dx, yy = y + side * dy;
+                                if (xx < 0 || xx >= b.width || yy < 0 || yy >= b.height) continue;
+                                const size_t k = b.index(xx, yy);
+                                if (b.id[k] == b.id[j]) g = std::min(g, std::abs(b.depth[k] - b.depth[j]));
+                            }
+                            return std::isfinite(g) ? g : 0.0f;
+                        };
+                        b.gradient[j] = std::max(axis(1, 0), axis(0, 1));
+
+                        if (b.variance[0][j] >= 0) continue;
+                        double sum = 0, sum2 = 0;
+                        int count = 0;
+                        for (int yy = std::max(y - 1, 0); yy <= std::min(y + 1, b.height - 1); ++yy)
+                            for (int xx = std::max(x - 1, 0); xx <= std::min(x + 1, b.width - 1); ++xx) {
+                                const size_t k = b.index(xx, yy);
+                                if (b.id[k] != b.id[j]) continue;
+                                const double l = 0.2126 * b.color[0][0][k] + 0.7152 * b.color[0][1][k] + 0.0722 * b.color[0][2][k];
+                                sum += l;
+                                sum2 += l * l;
+                                ++count;
+                            }
+                        const double mean = sum / count;
+                        b.variance[0][j] = float(std::max(0.0, sum2 / count - mean * mean));
+                    }
+                });
+        }
+
+        /// One a-trous pass with taps `step` pixels apart, from buffer `src` into the other one.
+        void atrousPass(Buffers& b, int src, int step, const DenoiserSettings& s) {
+            const int dst = 1 - src;
+            float invDistance[5][5];
+            for (int dy = -2; dy <= 2; ++dy)
+                for (int dx = -2; dx <= 2; ++dx)
+                    invDistance[dy + 2][dx + 2] = dx || dy ? 1.0f / (step * std::sqrt(float(dx * dx + dy * dy))) : 0.0f;
+
+            const std::vector<float>* color = b.color[src];
+            const std::vector<float>& variance = b.variance[src];
+
+            parallelFor(b.height, ROW_GRAIN, [&](int y0, int y1) {
+                for (int y = y0; y < y1; ++y)
+                    for (int x = 0; x < b.width; x += simd::LANES) {
+                        const size_t p = b.index(x, y);
+                        const Float4 idP = Float4::load(&b.id[p]);
+                        const Float4 rP = Float4::load(&color[0][p]), gP = Float4::load(&color[1][p]), bP = Float4::load(&color[2][p]);
+                        const Float4 lumP = luminance(rP, gP, bP);
+                        const Float4 nxP = Float4::load(&b.normal[0][p]), nyP = Float4::load(&b.normal[1][p]), nzP = Float4::load(&b.normal[2][p]);
+                        const Float4 zP = Float4::load(&b.depth[p]);
+
+                        // The luminance edge stop uses a 3x3 blur of the variance: one pixel's is too noisy
+                        Float4 varSum(0.0f), varWeight(0.0f);
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            if (y + dy < 0 || y + dy >= b.height) continue;
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                const size_t q = b.index(x + dx, y + dy);
+                                const Float4 w = simd::select(Float4::load(&b.id[q]) == idP, Float4(GAUSS3[dy + 1] * GAUSS3[dx + 1]), Float4(0.0f));
+                                varSum = varSum + w * Float4::load(&variance[q]);
+                                varWeight = varWeight + w;
+                            }
+                        }
+                        const Float4 varP = varSum / simd::max(varWeight, Float4(1e-20f));
+                        const Float4 invLum = Float4(1.0f) / (Float4(s.sigmaLuminance) * simd::sqrt(varP) + Float4(EPS_LUMINANCE));
+                        const Float4 invDepth = Float4(1.0f) /
+                            (Float4(s.sigmaDepth) * Float4::load(&b.gradient[p]) + Float4(EPS_DEPTH) * zP + Float4(1e-6f));
+
+                        Float4 sumW(0.0f), sumR(0.0f), sumG(0.0f), sumB(0.0f), sumVar(0.0f);
+                        for (int dy = -2; dy <= 2; ++dy) {
+                            const int yy = y + dy * step;
+                            if (yy < 0 || yy >= b.height) continue;
+                            for (int dx = -2; dx <= 2; ++dx) {
+                                const size_t q = b.index(x + dx * step, yy);
+                                const Float4 rQ = Float4::load(&color[0][q]), gQ = Float4::load(&color[1][q]), bQ = Float4::load(&color[2][q]);
+                                const Float4 cosine = nxP * Float4::load(&b.normal[0][q]) + nyP * Float4::load(&b.normal[1][q])
+                                    + nzP * Float4::load(&b.normal[2][q]);
+                                const Float4 exponent = simd::abs(lumP - luminance(rQ, gQ, bQ)) * invLum
+                                    + simd::abs(zP - Float4::load(&b.depth[q])) * invDepth * Float4(invDistance[dy + 2][dx + 2]);
+                                const Float4 w = simd::select((Float4::load(&b.id[q]) == idP) & (exponent < Float4(MAX_EXPONENT)),
+                                    Float4(B3[dy + 2] * B3[dx + 2]) * powi(simd::max(cosine, Float4(0.0f)), s.sigmaNormal) * simd::exp(-exponent),
+                                    Float4(0.0f));
+                                sumW = sumW + w;
+                                sumR = sumR + w * rQ;
+                                sumG = sumG + w * gQ;
+                                sumB = sumB + w * bQ;
+                                sumVar = sumVar + w * w * Float4::load(&variance[q]);
+                            }
+                        }
+
+                        // Padding lanes (and nothing else: the center tap always matches) end with no weight
+                        const Mask4 valid = sumW > Float4(0.0f);
+                        const Float4 inv = Float4(1.0f) / simd::select(valid, sumW, Float4(1.0f));
+                        simd::select(valid, sumR * inv, rP).store(&b.color[dst][0][p]);
+                        simd::select(valid, sumG * inv, gP).store(&b.color[dst][1][p]);
+                        simd::select(valid, sumB * inv, bP).store(&b.color[dst][2][p]);
+                        simd::select(valid, sumVar * inv * inv, Float4::load(&variance[p])).store(&b.variance[dst][p]);
+                    }
+                });
+        }
+
+    } // namespace
+
+    void denoise(Film& film, const DenoiserSettings& settings) {
+        if (!film.aovPlane(AOV::Albedo) || !film.aovPlane(AOV::Normal))
+            throw std::runtime_error("denoise: the film needs the Albedo and Normal AOVs");
+        const int width = film.width(), height = film.height();
+        if (width <= 0 || height <= 0) return;
+
+        const int iterations = std::clamp(settings.iterations, 1, 8);
+        Buffers b(width, height, 1 << iterations); // the last pass reaches 2 * 2^(iterations - 1)
+        gather(film, b);
+        derive(b);
+
+        int src = 0;
+        for (int i = 0; i < iterations; ++i, src = 1 - src)
+            atrousPass(b, src, 1 << i, settings);
+
+        parallelFor(height, ROW_GRAIN, [&](int y0, int y1) {
+            for (int y = y0; y < y1; ++y)
+                for (int x = 0; x < width; ++x) {
+                    const size_t j = b.index(x, y);
+                    const Spectrum illumination(b.color[src][0][j], b.color[src][1][j], b.color[src][2][j]);
+                    film.setPixel(x, y, illumination * demodulation(film, size_t(y) * width + x));
+                }
+            });
+    }
+
+} // namespace rayt
@@ -0,0 +1,409 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include "Core/PixelFormat.hpp"
+#include "IO/ExrWriter.hpp"
+
+namespace rayt::io {
+
+    namespace {
+
+        constexpr uint32_t MAGIC = 20000630;          // 76 2f 31 01
+        constexpr uint32_t VERSION = 2;
+        constexpr uint32_t FLAG_TILED = 0x200;       // single-part tiled file
+        constexpr uint32_t FLAG_LONG_NAMES = 0x400;  // names up to 255 bytes
+        constexpr uint32_t FLAG_MULTI_PART = 0x1000;
+        constexpr uint8_t LINE_ORDER_INCREASING_Y = 0;
+        constexpr uint8_t LINE_ORDER_RANDOM_Y = 2;   // tiles in whatever order they were written
+
+        size_t typeSize(ExrPixelType t) { return t == ExrPixelType::Half ? 2 : 4; }
+
+        /// Little-endian byte sink for headers.
+        struct Bytes {
+            std::vector<uint8_t> v;
+            void u8(uint8_t x) { v.push_back(x); }
+            void u32(uint32_t x) { for (int i = 0; i < 4; ++i) v.push_back(uint8_t(x >> (8 * i))); }
+            void i32(int32_t x) { u32(uint32_t(x)); }
+            void f32(float x) { uint32_t u; std::memcpy(&u, &x, 4); u32(u); }
+            void str(const std::string& s) { v.insert(v.end(), s.begin(), s.end()); v.push_back(0); }
+            void attribute(const std::string& name, const std::string& type, const Bytes& value) {
+                str(name);
+                str(type);
+                i32(int32_t(value.v.size()));
+                v.insert(v.end(), value.v.begin(), value.v.end());
+            }
+        };
+
+        // --- RLE, byte-compatible with OpenEXR's RleCompressor ---
+
+        constexpr int MIN_RUN_LENGTH = 3;
+        constexpr int MAX_RUN_LENGTH = 127;
+
+        size_t rleEncode(const uint8_t* in, size_t length, int8_t* out) {
+            const uint8_t* end = in + length;
+            const uint8_t* runStart = in;
+            const uint8_t* runEnd = in + 1;
+            int8_t* write = out;
+            while (runStart < end) {
+                while (runEnd < end && *runStart == *runEnd && runEnd - runStart - 1 < MAX_RUN_LENGTH) ++runEnd;
+                if (runEnd - runStart >= MIN_RUN_LENGTH) {
+                    // Run: count - 1, then the repeated byte
+                    *write++ = int8_t((runEnd - runStart) - 1);
+                    *write++ = int8_t(*runStart);
+                    runStart = runEnd;
+                }
+                else {
+                    // Literals up to the next run of three: -count, then the bytes
+                    while (runEnd < end &&
+                        ((runEnd + 1 >= end || *runEnd != *(runEnd + 1)) ||
+                            (runEnd + 2 >= end || *(runEnd + 1) != *(runEnd + 2))) &&
+                        runEnd - runStart < MAX_RUN_LENGTH)
+                        ++runEnd;
+                    *write++ = int8_t(runStart - runEnd);
+                    while (runStart < runEnd) *write++ = int8_t(*runStart++);
+                }
+                ++runEnd;
+            }
+            return size_t(write - out);
+        }
+
+        /// Splits even / odd bytes (the high and low halves of half values), delta-codes, then run-length codes.
+        void rleCompress(const std::vector<uint8_t>& raw, std::vector<uint8_t>& tmp, std::vector<uint8_t>& out) {
+            const size_t n = raw.size();
+            tmp.resize(n);
+            size_t i1 = 0, i2 = (n + 1) / 2;
+            for (size_t i = 0; i < n; ++i) tmp[(i & 1) ? i2++ : i1++] = raw[i];
+            for (size_t i = n; i-- > 1; ) tmp[i] = uint8_t(int(tmp[i]) - int(tmp[i - 1]) + 128);
+
+            out.resize(n + n / 64 + 16); // literal runs cost one byte per 127
+            out.resize(n ? rleEncode(tmp.data(), n, reinterpret_cast<int8_t*>(out.data())) : 0);
+        }
+
+        struct PartLayout {
+            const ExrPart* part;
+            std::vector<const ExrChannel*> channels; // sorted by name
+            int tilesX = 1, tilesY = 1;              // scanline parts: 1 x height blocks of one row
+            int blockW = 0, blockH = 1;
+            bool direct = false;                     // rows can go from the buffers to the file unchanged
+            int chunkCount() const { return tilesX * tilesY; }
+        };
+
+        PartLayout makeLayout(const ExrPart& part, int width, int height, bool multiPart, const std::string& filename) {
+            PartLayout L;
+            L.part = &part;
+            if (part.channels.empty()) throw std::runtime_error("writeEXR: part without channels in " + filename);
+            if (multiPart && part.name.empty()) throw std::runtime_error("writeEXR: unnamed part in " + filename);
+            for (const ExrChannel& c : part.channels) L.channels.push_back(&c);
+            std::sort(L.channels.begin(), L.channels.end(), [](const ExrChannel* a, const ExrChannel* b) { return a->name < b->name; });
+
+            if (part.tileSize > 0) {
+                L.blockW = L.blockH = part.tileSize;
+                L.tilesX = (width + L.blockW - 1) / L.blockW;
+                L.tilesY = (height + L.blockH - 1) / L.blockH;
+            }
+            else {
+                L.blockW = width;
+                L.tilesY = height;
+            }
+            L.direct = part.compression == ExrCompression::None &&
+                std::all_of(L.channels.begin(), L.channels.end(), [](const ExrChannel* c) {
+                return c->data && c->sourceType == c->type && (c->xStride == 0 || c->xStride == typeSize(c->type));
+                    });
+            return L;
+        }
+
+        /// One part's header attributes and terminator.
+        void appendHeader(Bytes& head, const PartLayout& L, int width, int height, bool multiPart, uint8_t lineOrder) {
+            Bytes channels;
+            for (const ExrChannel* c : L.channels) {
+                channels.str(c->name);
+                channels.i32(int32_t(c->type));
+                channels.u8(0);                       // pLinear
+                channels.u8(0); channels.u8(0); channels.u8(0);
+                channels.i32(1); channels.i32(1);     // x / y sampling
+            }
+            channels.u8(0);
+            head.attribute("channels", "chlist", channels);
+
+            Bytes compression; compression.u8(uint8_t(L.part->compression));
+            head.attribute("compression", "compression", compression);
+            Bytes window; window.i32(0); window.i32(0); window.i32(width - 1); window.i32(height - 1);
+            head.attribute("dataWindow", "box2i", window);
+            head.attribute("displayWindow", "box2i", window);
+            Bytes order; order.u8(lineOrder);
+            head.attribute("lineOrder", "lineOrder", order);
+            Bytes aspect; aspect.f32(1.0f);
+            head.attribute("pixelAspectRatio", "float", aspect);
+            Bytes center; center.f32(0.0f); center.f32(0.0f);
+            head.attribute("screenWindowCenter", "v2f", center);
+            Bytes windowWidth; windowWidth.f32(1.0f);
+            head.attribute("screenWindowWidth", "float", windowWidth);
+            if (L.part->tileSize > 0) {
+                Bytes tiles; tiles.u32(uint32_t(L.blockW)); tiles.u32(uint32_t(L.blockH)); tiles.u8(0); // ONE_LEVEL, round down
+                head.attribute("tiles", "tiledesc", tiles);
+            }
+            if (multiPart) {
+                Bytes name; name.v.assign(L.part->name.begin(), L.part->name.end());
+                head.attribute("name", "string", name);
+                const std::string t = L.part->tileSize > 0 ? "tiledimage" : "scanlineimage";
+                Bytes type; type.v.assign(t.begin(), t.end());
+                head.attribute("type", "string", type);
+                Bytes chunks; chunks.i32(L.chunkCount());
+                head.attribute("chunkCount", "int", chunks);
+            }
+            head.u8(0); // end of this header
+        }
+
+        const uint8_t* channelRow(const ExrChannel& c, int width, int y) {
+            const size_t xs = c.xStride ? c.xStride : typeSize(c.sourceType);
+            const size_t ys = c.yStride ? c.yStride : xs * size_t(width);
+            return static_cast<const uint8_t*>(c.data) + size_t(y) * ys;
+        }
+
+        /// Appends pixels [x0, x1) of one row of `from` values, converted to `to`.
+        void appendRow(std::vector<uint8_t>& dst, ExrPixelType from, ExrPixelType to, const uint8_t* row, size_t xStride, int x0, int x1) {
+            const size_t n = size_t(x1 - x0);
+            const size_t at = dst.size();
+            dst.resize(at + n * typeSize(to));
+            uint8_t* out = dst.data() + at;
+            for (size_t i = 0; i < n; ++i) {
+                const uint8_t* src = row + (size_t(x0) + i) * xStride;
+                float f = 0;
+                uint32_t u = 0;
+                uint16_t h = 0;
+                switch (from) {
+                case ExrPixelType::Float: std::memcpy(&f, src, 4); h = pixel::floatToHalf(f); break;
+                case ExrPixelType::UInt:  std::memcpy(&u, src, 4); f = float(u); h = pixel::floatToHalf(f); break;
+                case ExrPixelType::Half:  std::memcpy(&h, src, 2); f = pixel::halfToFloat(h); break;
+                }
+                if (from != ExrPixelType::UInt) u = f > 0 ? uint32_t(std::min(f, 4294967040.0f)) : 0; // NaN -> 0
+                switch (to) {
+                case ExrPixelType::Float: std::memcpy(out + 4 * i, &f, 4); break;
+                case ExrPixelType::UInt:  std::memcpy(out + 4 * i, &u, 4); break;
+                case ExrPixelType::Half:  std::memcpy(out + 2 * i, &h, 2); break;
+                }
+            }
+        }
+
+        class Output {
+        public:
+            explicit Output(const std::string& filename) : m_file(filename, std::ios::binary) {
+                if (!m_file) throw std::runtime_error("writeEXR: cannot open " + filename);
+            }
+            void write(const void* p, size_t n) {
+                m_file.write(static_cast<const char*>(p), std::streamsize(n));
+                m_pos += n;
+            }
+            void i32(int32_t x) { uint8_t b[4]; for (int i = 0; i < 4; ++i) b[i] = uint8_t(uint32_t(x) >> (8 * i)); write(b, 4); }
+            uint64_t position() const { return m_pos; }
+            void patch(uint64_t at, const std::vector<uint64_t>& values) {
+                std::vector<uint8_t> b(values.size() * 8);
+                for (size_t i = 0; i < values.size(); ++i)
+                    for (int k = 0; k < 8; ++k) b[i * 8 + k] = uint8_t(values[i] >> (8 * k));
+                m_file.seekp(std::streamoff(at));
+                m_file.write(reinterpret_cast<const char*>(b.data()), std::streamsize(b.size()));
+            }
+            void finish(const std::string& filename) {
+                m_file.close();
+                if (!m_file) throw std::runtime_error("writeEXR: write failed for " + filename);
+            }
+        private:
+            std::ofstream m_file;
+            uint64_t m_pos = 0;
+        };
+
+    } // namespace
+
+    void writeEXR(const std::string& filename, int width, int height, const std::vector<ExrPart>& parts) {
+        if (width <= 0 || height <= 0 || parts.empty())
+            throw std::runtime_error("writeEXR: empty image " + filename);
+        const bool multiPart = parts.size() > 1;
+
+        // --- Layouts ---
+        std::vector<PartLayout> layouts;
+        bool longNames = false;
+        for (const ExrPart& part : parts) {
+            layouts.push_back(makeLayout(part, width, height, multiPart, filename));
+            for (const ExrChannel& c : part.channels) {
+                if (!c.data && !c.rows) throw std::runtime_error("writeEXR: channel " + c.name + " has no source");
+                longNames |= c.name.size() > 31;
+            }
+        }
+
+        // --- Headers ---
+        Bytes head;
+        head.u32(MAGIC);
+        head.u32(VERSION | (multiPart ? FLAG_MULTI_PART : 0) | (!multiPart && parts[0].tileSize > 0 ? FLAG_TILED : 0)
+            | (longNames ? FLAG_LONG_NAMES : 0));
+        for (const PartLayout& L : layouts) appendHeader(head, L, width, height, multiPart, LINE_ORDER_INCREASING_Y);
+        if (multiPart) head.u8(0); // end of the header list
+
+        Output out(filename);
+        out.write(head.v.data(), head.v.size());
+        const uint64_t tableStart = out.position();
+        size_t totalChunks = 0;
+        for (const PartLayout& L : layouts) totalChunks += size_t(L.chunkCount());
+        std::vector<uint64_t> offsets(totalChunks, 0);
+        out.write(offsets.data(), offsets.size() * 8); // patched at the end
+
+        // --- Chunks ---
+        std::vector<uint8_t> raw, tmp, packed;
+        std::vector<std::vector<float>> band; // rows of callback channels for the current block row
+        size_t chunkIndex = 0;
+        for (size_t p = 0; p < layouts.size(); ++p) {
+            const PartLayout& L = layouts[p];
+            const size_t channelCount = L.channels.size();
+            band.assign(channelCount, {});
+
+            for (int ty = 0; ty < L.tilesY; ++ty) {
+                const int y0 = ty * L.blockH, y1 = std::min(height, y0 + L.blockH);
+                for (size_t c = 0; c < channelCount; ++c) {
+                    if (L.channels[c]->data) continue;
+                    band[c].resize(size_t(y1 - y0) * width);
+                    for (int y = y0; y < y1; ++y) L.channels[c]->rows(y, band[c].data() + size_t(y - y0) * width);
+                }
+
+                for (int tx = 0; tx < L.tilesX; ++tx) {
+                    const int x0 = tx * L.blockW, x1 = std::min(width, x0 + L.blockW);
+                    size_t bytes = 0;
+                    for (const ExrChannel* c : L.channels) bytes += typeSize(c->type);
+                    bytes *= size_t(x1 - x0) * size_t(y1 - y0);
+
+                    offsets[chunkIndex++] = out.position();
+                    if (multiPart) out.i32(int32_t(p));
+                    if (L.part->tileSize > 0) { out.i32(tx); out.i32(ty); out.i32(0); out.i32(0); }
+                    else out.i32(y0);
+
+                    if (L.direct) {
+                        // Straight from the caller's buffers: no per-pixel work at all
+                        out.i32(int32_t(bytes));
+                        for (int y = y0; y < y1; ++y)
+                            for (const ExrChannel* c : L.channels)
+                                out.write(channelRow(*c, width, y) + size_t(x0) * typeSize(c->type), size_t(x1 - x0) * typeSize(c->type));
+                        continue;
+                    }
+
+                    raw.clear();
+                    for (int y = y0; y < y1; ++y)
+                        for (size_t c = 0; c < channelCount; ++c) {
+                            const ExrChannel& ch = *L.channels[c];
+                            if (ch.data) {
+                                const size_t xs = ch.xStride ? ch.xStride : typeSize(ch.sourceType);
+                                appendRow(raw, ch.sourceType, ch.type, channelRow(ch, width, y), xs, x0, x1);
+                            }
+                            else {
+                                const float* row = band[c].data() + size_t(y - y0) * width;
+                                appendRow(raw, ExrPixelType::Float, ch.type, reinterpret_cast<const uint8_t*>(row), 4, x0, x1);
+                            }
+                        }
+
+                    const std::vector<uint8_t>* data = &raw;
+                    if (L.part->compression == ExrCompression::RLE) {
+                        rleCompress(raw, tmp, packed);
+                        if (packed.size() < raw.size()) data = &packed; // otherwise stored raw, as readers expect
+                    }
+                    out.i32(int32_t(data->size()));
+                    out.write(data->data(), data->size());
+                }
+            }
+        }
+
+        out.patch(tableStart, offsets);
+        out.finish(filename);
+    }
+
+    // --- ExrTileWriter ---
+
+    struct ExrTileWriter::State {
+        std::string filename;
+        int width, height;
+        ExrPart layout;                // own copy: PartLayout points into it
+        PartLayout L;
+        std::vector<size_t> order;     // file (sorted) channel -> index into the caller's planes
+        Output out;
+        uint64_t tableStart = 0;
+        std::vector<uint64_t> offsets; // 0: not written yet
+        std::mutex mutex;
+        bool finished = false;
+
+        State(const std::string& filename, int width, int height, const ExrPart& part)
+            : filename(filename), width(width), height(height), layout(part), out(filename) {}
+    };
+
+    ExrTileWriter::ExrTileWriter(const std::string& filename, int width, int height, const ExrPart& layout) {
+        if (width <= 0 || height <= 0 || layout.tileSize <= 0)
+            throw std::runtime_error("ExrTileWriter: empty image or no tile size for " + filename);
+        m_state = std::make_unique<State>(filename, width, height, layout);
+        State& s = *m_state;
+        s.L = makeLayout(s.layout, width, height, false, filename);
+        for (const ExrChannel* c : s.L.channels) s.order.push_back(size_t(c - s.layout.channels.data()));
+
+        Bytes head;
+        head.u32(MAGIC);
+        const bool longNames = std::any_of(s.layout.channels.begin(), s.layout.channels.end(),
+            [](const ExrChannel& c) { return c.name.size() > 31; });
+        head.u32(VERSION | FLAG_TILED | (longNames ? FLAG_LONG_NAMES : 0));
+        appendHeader(head, s.L, width, height, false, LINE_ORDER_RANDOM_Y);
+        s.out.write(head.v.data(), head.v.size());
+        s.tableStart = s.out.position();
+        s.offsets.assign(size_t(s.L.chunkCount()), 0);
+        s.out.write(s.offsets.data(), s.offsets.size() * 8);
+    }
+
+    ExrTileWriter::~ExrTileWriter() = default;
+
+    int ExrTileWriter::tilesX() const { return m_state->L.tilesX; }
+    int ExrTileWriter::tilesY() const { return m_state->L.tilesY; }
+
+    void ExrTileWriter::writeTile(int tx, int ty, const float* const* planes) {
+        State& s = *m_state;
+        const PartLayout& L = s.L;
+        if (tx < 0 || ty < 0 || tx >= L.tilesX || ty >= L.tilesY)
+            throw std::runtime_error("ExrTileWriter: tile out of range in " + s.filename);
+        const int x0 = tx * L.blockW, x1 = std::min(s.width, x0 + L.blockW);
+        const int y0 = ty * L.blockH, y1 = std::min(s.height, y0 + L.blockH);
+        const size_t w = size_t(x1 - x0);
+
+        std::vector<uint8_t> raw, tmp, packed;
+        for (int y = y0; y < y1; ++y)
+            for (size_t c = 0; c < L.channels.size(); ++c) {
+                const float* row = planes[s.order[c]] + size_t(y - y0) * w;
+                appendRow(raw, ExrPixelType::Float, L.channels[c]->type, reinterpret_cast<const uint8_t*>(row), 4, 0, int(w));
+            }
+        const std::vector<uint8_t>* data = &raw;
+        if (L.part->compression == ExrCompression::RLE) {
+            rleCompress(raw, tmp, packed);
+            if (packed.size() < raw.size()) data = &packed;
+        }
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        uint64_t& offset = s.offsets[size_t(ty) * L.tilesX + tx];
+        // A second chunk would leave the first one in the file with nothing pointing at it
+        if (offset != 0)
+            throw std::runtime_error("ExrTileWriter: tile " + std::to_string(tx) + ", " + std::to_string(ty) +
+                " of " + s.filename + " written twice");
+        offset = s.out.position();
+        s.out.i32(tx); s.out.i32(ty); s.out.i32(0); s.out.i32(0);
+        s.out.i32(int32_t(data->size()));
+        s.out.write(data->data(), data->size());
+    }
+
+    void ExrTileWriter::finish() {
+        State& s = *m_state;
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.finished) return;
+        s.finished = true;
+        for (size_t i = 0; i < s.offsets.size(); ++i)
+            if (s.offsets[i] == 0)
+                throw std::runtime_error("ExrTileWriter: tile " + std::to_string(i % s.L.tilesX) + ", " +
+                    std::to_string(i / s.L.tilesX) + " of " + s.filename + " was never written");
+        s.out.patch(s.tableStart, s.offsets);
+        s.out.finish(s.filename);
+    }
+
+} // namespace rayt::io
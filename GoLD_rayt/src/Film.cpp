@@ -1,29 +1,216 @@
 #include "pch.h"
 
 #include "Renderer/Film.hpp"
-//#include "Core/Utils.hpp" // For linearToGamma, saturate, etc.
-#include "Renderer/ColorTransform.hpp"
-#include "Core/Math.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/Simd.hpp"
 
 // Assuming STB_IMAGE_WRITE_IMPLEMENTATION is defined in ImageIO.cpp
 #include "stb_image_write.h"
 
 namespace rayt {
 
-    Film::Film(int width, int height)
-        : m_width(width), m_height(height) {
-        // Initialize all pixels to black (0, 0, 0).
-        m_pixels.resize(width * height, Spectrum(0.0));
+    namespace {
+        // Relaxed is enough: nothing reads the sums until every writer has been joined
+        void atomicAdd(std::atomic<Real>& a, Real v) {
+            if (v != 0) a.fetch_add(v, std::memory_order_relaxed);
+        }
     }
 
+    Film::Film(int width, int height, const Filter& filter)
+        : m_width(width), m_height(height), m_filter(filter),
+        // Initialize all pixels to black (0, 0, 0); std::atomic value-initializes to zero.
+        m_pixels(size_t(width) * height) {}
+
     void Film::setPixel(int x, int y, const Spectrum& radiance) {
         // Boundary check to prevent segmentation faults.
         if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
             return;
         }
-        // Store the value directly.
+        // Store the value directly, as a single sample of weight 1.
         // Note: Coordinate system usually assumes (0,0) is top-left for images.
-        m_pixels[y * m_width + x] = radiance;
+        Pixel& p = m_pixels[size_t(y) * m_width + x];
+        for (int c = 0; c < 3; ++c) {
+            p.sum[c].store(radiance[c], std::memory_order_relaxed);
+            p.splat[c].store(0, std::memory_order_relaxed);
+        }
+        p.weight.store(1, std::memory_order_relaxed);
+    }
+
+    Spectrum Film::getPixel(int x, int y) const {
+        if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+            return Spectrum(0.0);
+        }
+        return resolve(m_pixels[size_t(y) * m_width + x]);
+    }
+
+    Spectrum Film::resolve(const Pixel& p) const {
+        Spectrum c(0.0);
+        // Pixels no sample has reached keep a zero weight
+        const Real w = p.weight.load(std::memory_order_relaxed);
+        if (w != 0)
+            c = Spectrum(p.sum[0].load(std::memory_order_relaxed), p.sum[1].load(std::memory_order_relaxed),
+                p.sum[2].load(std::memory_order_relaxed)) / w;
+        return c + m_splatScale * Spectrum(p.splat[0].load(std::memory_order_relaxed),
+            p.splat[1].load(std::memory_order_relaxed), p.splat[2].load(std::memory_order_relaxed));
+    }
+
+    void Film::addSample(const Point2& pFilm, const Spectrum& L, Real weight) {
+        m_filter.forEachPixel(pFilm, 0, 0, m_width, m_height, [&](int x, int y, Real w) {
+            Pixel& p = m_pixels[size_t(y) * m_width + x];
+            for (int c = 0; c < 3; ++c) atomicAdd(p.sum[c], L[c] * (weight * w));
+            atomicAdd(p.weight, w);
+            });
+    }
+
+    FilmTile FilmTile::covering(int x0, int y0, int x1, int y1, int width, int height, const Filter* filter, bool aovs) {
+        // Pixels reachable from pFilm in [x0, x1): offsets p - (k + 0.5) in [-radius, radius)
+        const Real r = filter->radius();
+        const int px0 = std::max(0, int(std::floor(x0 - r - Real(0.5))) + 1);
+        const int py0 = std::max(0, int(std::floor(y0 - r - Real(0.5))) + 1);
+        const int px1 = std::min(width, int(std::floor(x1 + r - Real(0.5))) + 1);
+        const int py1 = std::min(height, int(std::floor(y1 + r - Real(0.5))) + 1);
+        return FilmTile(px0, py0, px1, py1, std::max(x0, 0), std::max(y0, 0), std::min(x1, width), std::min(y1, height),
+            filter, aovs);
+    }
+
+    FilmTile Film::tile(int x0, int y0, int x1, int y1) const {
+        return FilmTile::covering(x0, y0, x1, y1, m_width, m_height, &m_filter, m_aovSet != AOV::None);
+    }
+
+    void Film::mergeTile(const FilmTile& tile) {
+        const int w = tile.m_x1 - tile.m_x0;
+        for (int y = tile.m_y0; y < tile.m_y1; ++y)
+            for (int x = tile.m_x0; x < tile.m_x1; ++x) {
+                const FilmTile::Pixel& t = tile.m_pixels[size_t(y - tile.m_y0) * w + (x - tile.m_x0)];
+                Pixel& p = m_pixels[size_t(y) * m_width + x];
+                for (int c = 0; c < 3; ++c) atomicAdd(p.sum[c], t.sum[c]);
+                atomicAdd(p.weight, t.weight);
+            }
+
+        // AOV pixels are owned by this tile alone: update the running means in place
+        if (tile.m_aov.empty() || m_aovSet == AOV::None) return;
+        const int sw = tile.m_sx1 - tile.m_sx0;
+        for (int y = tile.m_sy0; y < tile.m_sy1; ++y)
+            for (int x = tile.m_sx0; x < tile.m_sx1; ++x) {
+                const FilmTile::AOVPixel& a = tile.m_aov[size_t(y - tile.m_sy0) * sw + (x - tile.m_sx0)];
+                if (a.count == 0) continue;
+                const size_t i = size_t(y) * m_width + x;
+                const uint32_t n0 = m_sampleCount[i], n = n0 + a.count;
+                const Real keep = Real(n0) / n, add = Real(1) / n;
+                auto mean = [&](std::vector<float>* planes, const Vector3& sum) {
+                    if (planes[0].empty()) return;
+                    for (int c = 0; c < 3; ++c) planes[c][i] = float(planes[c][i] * keep + sum[c] * add);
+                };
+                mean(m_albedo, a.albedo);
+                mean(m_normal, a.normal);
+                mean(m_direct, a.direct);
+                mean(m_indirect, a.indirect);
+                if (!m_depth.empty()) m_depth[i] = std::min(m_depth[i], float(a.depth));
+                if (!m_materialId.empty() && n0 == 0) m_materialId[i] = a.materialId;
+                if (!m_variance.empty()) {
+                    // Chan et al.'s pairwise update of (mean, M2)
+                    const double delta = a.lumMean - m_lumMean[i];
+                    m_lumMean[i] += delta * a.count / n;
+                    m_lumM2[i] += a.lumM2 + delta * delta * (double(n0) * a.count / n);
+                    m_variance[i] = n > 1 ? float(m_lumM2[i] / (double(n - 1) * n)) : 0.0f;
+                }
+                m_sampleCount[i] = n;
+            }
+    }
+
+    void Film::enableAOVs(AOV set) {
+        m_aovSet = set;
+        const size_t n = set == AOV::None ? 0 : size_t(m_width) * m_height;
+        auto planes = [&](std::vector<float>* p, AOV a) {
+            for (int c = 0; c < 3; ++c) p[c].assign(hasAOV(set, a) ? n : 0, 0.0f);
+        };
+        planes(m_albedo, AOV::Albedo);
+        planes(m_normal, AOV::Normal);
+        planes(m_direct, AOV::Direct);
+        planes(m_indirect, AOV::Indirect);
+        m_depth.assign(hasAOV(set, AOV::Depth) ? n : 0, std::numeric_limits<float>::infinity());
+        m_materialId.assign(hasAOV(set, AOV::MaterialId) ? n : 0, ~uint32_t(0));
+        m_sampleCount.assign(n, 0); // the running means need it even when it is not written out
+        m_variance.assign(hasAOV(set, AOV::Variance) ? n : 0, 0.0f);
+        m_lumMean.assign(m_variance.size(), 0.0);
+        m_lumM2.assign(m_variance.size(), 0.0);
+    }
+
+    const float* Film::aovPlane(AOV aov, int channel) const {
+        const std::vector<float>* p = nullptr;
+        switch (aov) {
+        case AOV::Albedo:   p = &m_albedo[channel]; break;
+        case AOV::Normal:   p = &m_normal[channel]; break;
+        case AOV::Direct:   p = &m_direct[channel]; break;
+        case AOV::Indirect: p = &m_indirect[channel]; break;
+        case AOV::Depth:    p = &m_depth; break;
+        case AOV::Variance: p = &m_variance; break;
+        default: break;
+        }
+        return p && !p->empty() ? p->data() : nullptr;
+    }
+
+    void Film::saveEXR(const std::string& filename, const FilmExrOptions& options) const {
+        using io::ExrChannel;
+        using io::ExrPixelType;
+
+        std::vector<io::ExrPart> parts;
+        auto layer = [&](const std::string& name) -> std::vector<ExrChannel>& {
+            if (parts.empty() || options.multiPart) {
+                parts.emplace_back();
+                parts.back().name = name;
+                parts.back().compression = options.compression;
+                parts.back().tileSize = options.tileSize;
+            }
+            return parts.back().channels;
+        };
+        auto plane = [](std::string name, ExrPixelType type, ExrPixelType source, const void* data) {
+            ExrChannel c;
+            c.name = std::move(name);
+            c.type = type;
+            c.sourceType = source;
+            c.data = data;
+            return c;
+        };
+        auto rgb = [&](const std::string& name, const std::vector<float>* p, const char* suffixes) {
+            if (p[0].empty()) return;
+            std::vector<ExrChannel>& channels = layer(name);
+            for (int c = 0; c < 3; ++c)
+                channels.push_back(plane(name + "." + suffixes[c], options.colorType, ExrPixelType::Float, p[c].data()));
+        };
+
+        // Beauty: sum / weight has to be resolved, one row at a time
+        std::vector<ExrChannel>& beauty = layer("beauty");
+        for (int c = 0; c < 3; ++c) {
+            ExrChannel ch;
+            ch.name = std::string(1, "RGB"[c]);
+            ch.type = options.colorType;
+            ch.rows = [this, c](int y, float* out) {
+                for (int x = 0; x < m_width; ++x) out[x] = float(resolve(m_pixels[size_t(y) * m_width + x])[c]);
+            };
+            beauty.push_back(std::move(ch));
+        }
+        rgb("albedo", m_albedo, "RGB");
+        rgb("normal", m_normal, "XYZ");
+        if (!m_depth.empty()) layer("depth").push_back(plane("depth.Z", ExrPixelType::Float, ExrPixelType::Float, m_depth.data()));
+        if (!m_materialId.empty())
+            layer("materialId").push_back(plane("materialId.ID", ExrPixelType::UInt, ExrPixelType::UInt, m_materialId.data()));
+        rgb("direct", m_direct, "RGB");
+        rgb("indirect", m_indirect, "RGB");
+        if (hasAOV(m_aovSet, AOV::SampleCount))
+            layer("sampleCount").push_back(plane("sampleCount.N", ExrPixelType::UInt, ExrPixelType::UInt, m_sampleCount.data()));
+        if (!m_variance.empty())
+            layer("variance").push_back(plane("variance.Y", ExrPixelType::Float, ExrPixelType::Float, m_variance.data()));
+
+        io::writeEXR(filename, m_width, m_height, parts);
+    }
+
+    void Film::addSplat(const Point2& pFilm, const Spectrum& L) {
+        const Real norm = Real(1) / m_filter.integral();
+        m_filter.forEachPixel(pFilm, 0, 0, m_width, m_height, [&](int x, int y, Real w) {
+            Pixel& p = m_pixels[size_t(y) * m_width + x];
+            for (int c = 0; c < 3; ++c) atomicAdd(p.splat[c], L[c] * (w * norm));
+            });
     }
 
     void Film::save(const std::string& filename) const {
@@ -33,58 +220,115 @@ namespace rayt {
         // Convert to lowercase for comparison
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
-        if (ext == "hdr") {
+        if (ext == "exr") {
+            try {
+                saveEXR(filename);
+                std::cout << "[Film] Saved EXR image: " << filename << std::endl;
+            }
+            catch (const std::exception& e) {
+                std::cerr << "[Film] Error: " << e.what() << std::endl;
+            }
+        }
+        else if (ext == "hdr") {
             // --- HDR Output ---
             // Save raw linear float data. Best for research and analysis.
             // stbi_write_hdr expects contiguous float array (3 floats per pixel).
-            // Since Spectrum is glm::vec3 (3 floats), we can cast the pointer safely.
-            stbi_write_hdr(filename.c_str(), m_width, m_height, 3, reinterpret_cast<const float*>(m_pixels.data()));
+            std::vector<float> data(size_t(m_width) * m_height * 3);
+            for (size_t i = 0; i < m_pixels.size(); ++i) {
+                const Spectrum pixel = resolve(m_pixels[i]);
+                data[i * 3 + 0] = float(pixel.r);
+                data[i * 3 + 1] = float(pixel.g);
+                data[i * 3 + 2] = float(pixel.b);
+            }
+            stbi_write_hdr(filename.c_str(), m_width, m_height, 3, data.data());
 
             std::cout << "[Film] Saved HDR image: " << filename << std::endl;
         }
         else {
             // --- LDR Output (PNG, BMP, JPG) ---
             // Requires Tone Mapping and Gamma Correction.
+            if (saveLDR(filename)) std::cout << "[Film] Saved LDR image: " << filename << std::endl;
+        }
+    }
 
-            std::vector<unsigned char> outputData(m_width * m_height * 3);
-
-            for (int i = 0; i < m_width * m_height; ++i) {
-                Spectrum pixel = m_pixels[i];
-
-                // 1. Tone Mapping (Optional but recommended)
-                // Simple Reinhard tone mapping: L_d = L / (1 + L)
-                // This prevents high-intensity values (e.g., > 1.0) from being clamped to white instantly.
-                // You can comment this out if you want to see raw clipping.
-                pixel = pixel / (pixel + Spectrum(1.0));
+    std::vector<uint8_t> Film::toLDR(const ToneMapSettings& settings) const {
+        std::vector<uint8_t> rgb8(size_t(m_width) * m_height * 3);
+        parallelFor(m_height, 16, [&](int y0, int y1) {
+            // Planar float rows, padded to whole SIMD groups
+            std::vector<float> planes(3 * simd::roundUpToLanes(size_t(m_width)), 0.0f);
+            float* r = planes.data();
+            float* g = r + simd::roundUpToLanes(size_t(m_width));
+            float* b = g + simd::roundUpToLanes(size_t(m_width));
+            for (int y = y0; y < y1; ++y) {
+                const Pixel* row = &m_pixels[size_t(y) * m_width];
+                for (int x = 0; x < m_width; ++x) {
+                    const Spectrum c = resolve(row[x]);
+                    r[x] = float(c.r);
+                    g[x] = float(c.g);
+                    b[x] = float(c.b);
+                }
+                toneMapRow(r, g, b, m_width, y, settings, &rgb8[size_t(y) * m_width * 3]);
+            }
+            });
+        return rgb8;
+    }
 
-                // 2. Gamma Correction (Linear -> sRGB)
-                // Monitors expect sRGB data (approx. gamma 2.2).
-                pixel.r = renderer::linearToGamma(pixel.r);
-                pixel.g = renderer::linearToGamma(pixel.g);
-                pixel.b = renderer::linearToGamma(pixel.b);
+    namespace {
 
-                // 3. Quantization (0.0-1.0 -> 0-255)
-                outputData[i * 3 + 0] = static_cast<unsigned char>(255.99 * rayt::math::saturate(pixel.r));
-                outputData[i * 3 + 1] = static_cast<unsigned char>(255.99 * rayt::math::saturate(pixel.g));
-                outputData[i * 3 + 2] = static_cast<unsigned char>(255.99 * rayt::math::saturate(pixel.b));
+        /// Lower-case extension if it is one saveLDR writes, empty (with a message) otherwise.
+        std::string ldrExtension(const std::string& filename) {
+            std::string ext = filename.substr(filename.find_last_of(".") + 1);
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext != "png" && ext != "bmp" && ext != "jpg") {
+                std::cerr << "[Film] Error: Unsupported file extension: " << ext << std::endl;
+                return {};
             }
+            return ext;
+        }
 
+        bool writeLDR(const std::string& filename, const std::string& ext, int width, int height,
+            const std::vector<uint8_t>& rgb8, const io::PngOptions& pngOptions) {
+            int ok = 0;
             if (ext == "png") {
-                stbi_write_png(filename.c_str(), m_width, m_height, 3, outputData.data(), m_width * 3);
+                try {
+                    io::writePNG(filename, width, height, 3, rgb8.data(), size_t(width) * 3, pngOptions);
+                    ok = 1;
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "[Film] Error: " << e.what() << std::endl;
+                }
             }
             else if (ext == "bmp") {
-                stbi_write_bmp(filename.c_str(), m_width, m_height, 3, outputData.data());
-            }
-            else if (ext == "jpg") {
-                stbi_write_jpg(filename.c_str(), m_width, m_height, 3, outputData.data(), 90); // Quality 90
+                ok = stbi_write_bmp(filename.c_str(), width, height, 3, rgb8.data());
             }
             else {
-                std::cerr << "[Film] Error: Unsupported file extension: " << ext << std::endl;
-                return;
+                ok = stbi_write_jpg(filename.c_str(), width, height, 3, rgb8.data(), 90); // Quality 90
             }
+            if (!ok) std::cerr << "[Film] Error: Could not write " << filename << std::endl;
+            return ok != 0;
+        }
+
+    } // namespace
+
+    bool Film::saveLDR(const std::string& filename, const ToneMapSettings& settings,
+        const io::PngOptions& pngOptions) const {
+        const std::string ext = ldrExtension(filename);
+        if (ext.empty()) return false;
+        return writeLDR(filename, ext, m_width, m_height, toLDR(settings), pngOptions);
+    }
 
-            std::cout << "[Film] Saved LDR image: " << filename << std::endl;
+    std::future<bool> Film::saveLDRAsync(const std::string& filename, const ToneMapSettings& settings,
+        const io::PngOptions& pngOptions) const {
+        const std::string ext = ldrExtension(filename);
+        if (ext.empty()) {
+            std::promise<bool> failed;
+            failed.set_value(false);
+            return failed.get_future();
         }
+        return std::async(std::launch::async,
+            [filename, ext, width = m_width, height = m_height, rgb8 = toLDR(settings), pngOptions] {
+                return writeLDR(filename, ext, width, height, rgb8, pngOptions);
+            });
     }
 
 } // namespace rayt
\ No newline at end of file
@@ -2,12 +2,19 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <array>
 #include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <utility>
 #include <cmath>
+#include <vector>
 
 #include "Core/Types.hpp"
+#include "Core/Parallel.hpp"
 #include "IO/ImageLoader.hpp"
+#include "IO/MappedFile.hpp"
 #include "Core/Image.hpp"
 
 // Define STB_IMAGE_IMPLEMENTATION in only one source file (usually pch.cpp or here if not in pch)
@@ -54,80 +61,239 @@ namespace rayt::io {
         return std::pow((c + 0.055f) / 1.055f, 2.4f);
     }
 
+    /// Rows one parallelFor chunk of a loader decodes.
+    static constexpr int ROWS_PER_CHUNK = 16;
+
+    /**
+     * @brief Maps a whole image file read-only.
+     * @throws std::runtime_error If the file cannot be opened or is empty.
+     */
+    static MappedFile mapImage(const std::string& filename, const char* kind) {
+        MappedFile file;
+        if (!file.open(filename))
+            throw std::runtime_error(std::string("Failed to load ") + kind + ": " + filename + " (cannot open file)");
+        return file;
+    }
+
+    /**
+     * @brief Finds where each scanline of a Radiance (.hdr) file starts, without decoding it.
+     * * Only files whose every scanline uses the "new" run-length encoding
+     * (2, 2, width, then the four channels one after the other) qualify: runs
+     * are skipped by their counts, so this pass reads a byte or two per run of
+     * up to 128 pixels, and the scanlines can then be decoded independently.
+     * Anything else (flat or old-style RLE pixels, another orientation, damaged
+     * data) returns false and is left to stb_image, which also reports the errors.
+     *
+     * @param bytes The whole file.
+     * @param size Its size in bytes.
+     * @param width Receives the image width.
+     * @param height Receives the image height.
+     * @param offsets Receives the offset of each scanline, top row first.
+     * @return True if the file can be decoded by decodeRadianceScanline().
+     */
+    static bool indexRadianceScanlines(const uint8_t* bytes, size_t size, int& width, int& height, std::vector<size_t>& offsets) {
+        size_t p = 0;
+        auto readLine = [&](std::string& line) {
+            const size_t end = size_t(std::find(bytes + p, bytes + size, uint8_t('\n')) - bytes);
+            if (end == size) return false;
+            line.assign(reinterpret_cast<const char*>(bytes + p), end - p);
+            p = end + 1;
+            return true;
+        };
+
+        std::string line;
+        if (!readLine(line) || (line != "#?RADIANCE" && line != "#?RGBE")) return false;
+        bool rgbe = false;
+        while (true) {
+            if (!readLine(line)) return false;
+            if (line.empty()) break;
+            if (line == "FORMAT=32-bit_rle_rgbe") rgbe = true;
+        }
+        if (!rgbe || !readLine(line)) return false;
+        // Top-down rows of left-to-right pixels, the only orientation stb_image reads as well
+        if (std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2) return false;
+        if (width < 8 || width >= 32768 || height <= 0 || height > (1 << 24)) return false;
+
+        offsets.resize(size_t(height));
+        for (int y = 0; y < height; ++y) {
+            if (size - p < 4 || bytes[p] != 2 || bytes[p + 1] != 2 || (bytes[p + 2] & 0x80)) return false;
+            if (((int(bytes[p + 2]) << 8) | bytes[p + 3]) != width) return false;
+            offsets[y] = p;
+            p += 4;
+            for (int c = 0; c < 4; ++c)
+                for (int x = 0; x < width; ) {
+                    if (p >= size) return false;
+                    int count = bytes[p++];
+                    if (count > 128) {
+                        count -= 128; // run: one value repeated
+                        p += 1;
+                    }
+                    else {
+                        p += count;   // literal values
+                    }
+                    if (count == 0 || x + count > width || p > size) return false;
+                    x += count;
+                }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Decodes one scanline validated by indexRadianceScanlines() into interleaved RGBE pixels.
+     *
+     * @param src The scanline, starting at its (2, 2, width) marker.
+     * @param width The image width.
+     * @param rgbe Receives width pixels of 4 bytes.
+     */
+    static void decodeRadianceScanline(const uint8_t* src, int width, uint8_t* rgbe) {
+        src += 4;
+        for (int c = 0; c < 4; ++c)
+            for (int x = 0; x < width; ) {
+                int count = *src++;
+                if (count > 128) {
+                    count -= 128;
+                    const uint8_t value = *src++;
+                    for (int i = 0; i < count; ++i) rgbe[4 * (x + i) + c] = value;
+                }
+                else {
+                    for (int i = 0; i < count; ++i) rgbe[4 * (x + i) + c] = *src++;
+                }
+                x += count;
+            }
+    }
+
+    /**
+     * @brief Converts width RGBE pixels into the storage format.
+     * * The floats are exactly what stb_image produces (mantissa * 2^(e - 136)
+     * in float), with the 256 possible scales looked up instead of computed.
+     */
+    static void convertRGBE(const uint8_t* rgbe, int width, PixelFormat format, uint8_t* dst) {
+        static const std::array<float, 256> scales = [] {
+            std::array<float, 256> table{};
+            for (int e = 1; e < 256; ++e) table[e] = std::ldexp(1.0f, e - (128 + 8));
+            return table;
+        }();
+        const size_t bpp = bytesPerPixel(format);
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* p = rgbe + 4 * x;
+            const float f = scales[p[3]];
+            const float v[3] = { p[0] * f, p[1] * f, p[2] * f };
+            if (format == PixelFormat::Float3) std::memcpy(dst + x * bpp, v, sizeof(v));
+            else pixel::encode(format, Vector3(v[0], v[1], v[2]), dst + x * bpp);
+        }
+    }
+
     /**
      * @brief Loads a High Dynamic Range (HDR) image.
      * * Reads the image as floating point data. No color space conversion
      * is applied as HDR images are assumed to be in linear space.
+     * * The file is memory-mapped. Run-length encoded Radiance files (what
+     * every common tool writes) are indexed in one sequential pass over the run
+     * headers, then their scanlines are decoded on all threads straight into
+     * the image storage: RGBE images receive the file's pixels as they are.
+     * Other files are decoded by stb_image from the mapping.
      *
      * @param filename The path to the HDR file.
+     * @param format The storage format the pixels are encoded into.
      * @return A constructed Image object containing the pixel data.
      * @throws std::runtime_error If the file cannot be loaded.
      */
-    Image loadHDR(const std::string& filename) {
-        int w = 0, h = 0, n = 0;
+    Image loadHDR(const std::string& filename, PixelFormat format) {
+        const MappedFile file = mapImage(filename, "HDR");
+        const uint8_t* bytes = static_cast<const uint8_t*>(file.data());
+        const size_t bpp = bytesPerPixel(format);
+
+        int w = 0, h = 0;
+        std::vector<size_t> offsets;
+        if (indexRadianceScanlines(bytes, file.size(), w, h, offsets)) {
+            Image image(w, h, format);
+            const size_t rowBytes = static_cast<size_t>(w) * bpp;
+            parallelFor(h, ROWS_PER_CHUNK, [&](int y0, int y1) {
+                std::vector<uint8_t> rgbe(format == PixelFormat::RGBE ? 0 : static_cast<size_t>(4) * w);
+                for (int y = y0; y < y1; ++y) {
+                    uint8_t* row = image.data() + y * rowBytes;
+                    if (format == PixelFormat::RGBE) {
+                        decodeRadianceScanline(bytes + offsets[y], w, row);
+                        continue;
+                    }
+                    decodeRadianceScanline(bytes + offsets[y], w, rgbe.data());
+                    convertRGBE(rgbe.data(), w, format, row);
+                }
+                });
+            return image;
+        }
 
         // Load as float RGB
-        float* data = stbi_loadf(filename.c_str(), &w, &h, &n, 3);
+        if (file.size() > size_t(INT_MAX))
+            throw std::runtime_error("Failed to load HDR: " + filename + " (file too large)");
+        int n = 0;
+        float* data = stbi_loadf_from_memory(bytes, static_cast<int>(file.size()), &w, &h, &n, 3);
         if (!data) {
             throw std::runtime_error(
                 "Failed to load HDR: " + filename + " (" + stbi_failure_reason() + ")"
             );
         }
 
-        std::vector<Vector3> pixels;
-        pixels.resize(static_cast<size_t>(w) * h);
-
-        for (int i = 0; i < w * h; ++i) {
-            pixels[i] = Vector3(
-                data[3 * i + 0],
-                data[3 * i + 1],
-                data[3 * i + 2]
-            );
-        }
+        // Encode directly from the float buffer (no intermediate Vector3 copy)
+        Image image(w, h, format);
+        parallelFor(h, ROWS_PER_CHUNK, [&](int y0, int y1) {
+            for (size_t i = static_cast<size_t>(y0) * w; i < static_cast<size_t>(y1) * w; ++i) {
+                const float* p = data + 3 * i;
+                pixel::encode(format, Vector3(p[0], p[1], p[2]), image.data() + i * bpp);
+            }
+            });
 
         stbi_image_free(data);
 
-        return Image(w, h, std::move(pixels));
+        return image;
     }
 
     /**
      * @brief Loads a Low Dynamic Range (LDR) image (png, jpg, etc.).
      * * Reads the image as 8-bit data, normalizes it to [0, 1], and converts
      * it from sRGB to linear space.
+     * * The file is decoded by stb_image from a memory mapping. An 8-bit channel
+     * has 256 possible values, so each is converted once into a table, and the
+     * rows are expanded through it on all threads straight into the Float3
+     * storage (the same values the per-channel conversion gives).
      *
      * @param filename The path to the image file.
+     * @param encoding sRGB (convert to linear) or Linear (normalize only).
      * @return A constructed Image object with linear color data.
      * @throws std::runtime_error If the file cannot be loaded.
      */
-    Image loadLDR(const std::string& filename) {
+    Image loadLDR(const std::string& filename, ColorEncoding encoding) {
+        const MappedFile file = mapImage(filename, "LDR");
+        if (file.size() > size_t(INT_MAX))
+            throw std::runtime_error("Failed to load LDR: " + filename + " (file too large)");
+
         int w = 0, h = 0, n = 0;
 
         // Force load as RGB (3 channels)
-        unsigned char* data = stbi_load(filename.c_str(), &w, &h, &n, 3);
+        unsigned char* data = stbi_load_from_memory(static_cast<const stbi_uc*>(file.data()),
+            static_cast<int>(file.size()), &w, &h, &n, 3);
         if (!data) {
             throw std::runtime_error(
                 "Failed to load LDR: " + filename + " (" + stbi_failure_reason() + ")"
             );
         }
 
-        std::vector<Vector3> pixels;
-        pixels.resize(static_cast<size_t>(w) * h);
-
-        for (int i = 0; i < w * h; ++i) {
-            float r = data[3 * i + 0] / 255.0f;
-            float g = data[3 * i + 1] / 255.0f;
-            float b = data[3 * i + 2] / 255.0f;
-
-            // Convert sRGB to Linear
-            pixels[i] = Vector3(
-                srgbToLinear(r),
-                srgbToLinear(g),
-                srgbToLinear(b)
-            );
+        std::array<float, 256> toLinear;
+        for (int i = 0; i < 256; ++i) {
+            const float c = i / 255.0f;
+            toLinear[i] = encoding == ColorEncoding::Linear ? c : srgbToLinear(c);
         }
 
+        Image image(w, h, PixelFormat::Float3);
+        parallelFor(h, ROWS_PER_CHUNK, [&](int y0, int y1) {
+            const size_t begin = 3 * static_cast<size_t>(y0) * w, end = 3 * static_cast<size_t>(y1) * w;
+            uint8_t* dst = image.data();
+            for (size_t i = begin; i < end; ++i)
+                std::memcpy(dst + 4 * i, &toLinear[data[i]], sizeof(float));
+            });
+
         stbi_image_free(data);
-        return Image(w, h, std::move(pixels));
+        return image;
     }
 
     /**
@@ -137,10 +303,11 @@ namespace rayt::io {
      * Supported LDR formats: .png, .jpg, .jpeg, .bmp, .tga
      *
      * @param filename The path to the image file.
+     * @param encoding How LDR values are interpreted (ignored for HDR).
      * @return The loaded Image.
      * @throws std::runtime_error If the format is unsupported or loading fails.
      */
-    Image loadImage(const std::string& filename) {
+    Image loadImage(const std::string& filename, ColorEncoding encoding) {
         const std::string ext = getExt(filename);
 
         if (ext == "hdr") {
@@ -149,7 +316,7 @@ namespace rayt::io {
 
         if (ext == "png" || ext == "jpg" || ext == "jpeg" ||
             ext == "bmp" || ext == "tga") {
-            return loadLDR(filename);
+            return loadLDR(filename, encoding);
         }
 
         throw std::runtime_error("Unsupported image format: " + ext);
@@ -0,0 +1,403 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include "Core/Types.hpp"
+#include "Core/Math.hpp"
+#include "Textures/MIPMap.hpp"
+
+namespace rayt {
+
+    namespace {
+
+        constexpr uint32_t CACHE_VERSION = 1;
+
+        /**
+         * @brief First section of a "mip-tiles" io::AssetCache entry. The second holds `levels`
+         * (width, height) pairs, the third every tile of every level (level-major, row-major),
+         * TILE_SIZE^2 RGB floats each.
+         */
+        struct TilesInfo {
+            uint32_t tileSize;
+            uint32_t levels;
+            uint32_t encoding;
+            uint32_t reserved;
+        };
+
+        constexpr size_t TILE_TEXELS = size_t(MIPMap::TILE_SIZE) * MIPMap::TILE_SIZE;
+
+        int wrapCoord(int c, int size, WrapMode wrap) {
+            if (wrap == WrapMode::Clamp) return std::clamp(c, 0, size - 1);
+            c %= size;
+            return c < 0 ? c + size : c;
+        }
+
+        // Gaussian falloff for EWA, indexed by squared ellipse radius in [0, 1)
+        constexpr int EWA_LUT_SIZE = 128;
+
+        const std::array<Real, EWA_LUT_SIZE>& ewaWeights() {
+            static const std::array<Real, EWA_LUT_SIZE> lut = [] {
+                std::array<Real, EWA_LUT_SIZE> w{};
+                const Real alpha = 2;
+                for (int i = 0; i < EWA_LUT_SIZE; ++i) {
+                    Real r2 = Real(i) / Real(EWA_LUT_SIZE - 1);
+                    w[i] = std::exp(-alpha * r2) - std::exp(-alpha);
+                }
+                return w;
+                }();
+            return lut;
+        }
+
+    } // namespace
+
+    // -------------------------------------------------------------------------
+    // Construction / loading
+    // -------------------------------------------------------------------------
+
+    MIPMap::MIPMap(std::string filename, io::ColorEncoding encoding, WrapMode wrap, TileCache& cache, io::AssetCache assets)
+        : m_filename(std::move(filename)), m_encoding(encoding), m_wrap(wrap),
+        m_cache(cache), m_assets(std::move(assets)), m_textureId(TileCache::newTextureId()) {}
+
+    MIPMap::MIPMap(const Image& image, WrapMode wrap, TileCache& cache)
+        : m_encoding(io::ColorEncoding::Linear), m_wrap(wrap),
+        m_cache(cache), m_textureId(TileCache::newTextureId()) {
+        std::call_once(m_loaded, [&] { buildPyramid(image); });
+    }
+
+    void MIPMap::ensureLoaded() const {
+        std::call_once(m_loaded, [this] { loadFromFile(); });
+    }
+
+    void MIPMap::loadFromFile() const {
+        io::CacheKey key;
+        const bool cacheable = key.addFile(m_filename);
+        const uint64_t hash = key.add(uint32_t(m_encoding)).add(int32_t(TILE_SIZE)).value();
+        if (cacheable && mapTiles(hash)) return;
+
+        try {
+            buildPyramid(io::loadImage(m_filename, m_encoding));
+        }
+        catch (const std::exception& e) {
+            // A missing texture should not abort a long render: show it as magenta
+            std::cerr << "[MIPMap] " << e.what() << " -- using a placeholder texel." << std::endl;
+            buildPyramid(Image(1, 1, { Vector3(1.0, 0.0, 1.0) }));
+            return;
+        }
+
+        if (cacheable && storeTiles(hash) && mapTiles(hash)) {
+            std::vector<std::vector<glm::vec3>>().swap(m_resident);
+        }
+        else {
+            std::cerr << "[MIPMap] Could not write " << m_filename << "'s tiles to " << m_assets.directory()
+                << "; keeping the pyramid resident." << std::endl;
+        }
+    }
+
+    void MIPMap::setupLevels(const std::vector<std::pair<int, int>>& sizes) const {
+        m_levels.clear();
+        size_t firstTile = 0;
+        for (const auto& [w, h] : sizes) {
+            LevelInfo L;
+            L.width = w;
+            L.height = h;
+            L.tilesX = (w + TILE_SIZE - 1) / TILE_SIZE;
+            L.tilesY = (h + TILE_SIZE - 1) / TILE_SIZE;
+            L.firstTile = firstTile;
+            firstTile += size_t(L.tilesX) * L.tilesY;
+            m_levels.push_back(L);
+        }
+    }
+
+    void MIPMap::buildPyramid(const Image& image) const {
+        if (!image.isValid()) throw std::runtime_error("MIPMap: invalid image");
+
+        std::vector<std::pair<int, int>> sizes;
+        int w = image.width(), h = image.height();
+        sizes.emplace_back(w, h);
+
+        m_resident.clear();
+        m_resident.emplace_back(size_t(w) * h);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x)
+                m_resident[0][size_t(y) * w + x] = glm::vec3(image.at(x, y));
+        }
+
+        // 2x2 box downsampling; the odd last row/column is clamped (repeated)
+        while (w > 1 || h > 1) {
+            const int nw = std::max(1, (w + 1) / 2);
+            const int nh = std::max(1, (h + 1) / 2);
+            const std::vector<glm::vec3>& src = m_resident.back();
+            std::vector<glm::vec3> dst(size_t(nw) * nh);
+
+            for (int y = 0; y < nh; ++y) {
+                const int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+                for (int x = 0; x < nw; ++x) {
+                    const int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+                    dst[size_t(y) * nw + x] = 0.25f * (
+                        src[size_t(y0) * w + x0] + src[size_t(y0) * w + x1] +
+                        src[size_t(y1) * w + x0] + src[size_t(y1) * w + x1]);
+                }
+            }
+
+            m_resident.push_back(std::move(dst));
+            w = nw;
+            h = nh;
+            sizes.emplace_back(w, h);
+        }
+
+        setupLevels(sizes);
+        m_fileBacked = false;
+    }
+
+    // -------------------------------------------------------------------------
+    // Cache entry
+    // -------------------------------------------------------------------------
+
+    bool MIPMap::mapTiles(uint64_t key) const {
+        io::CacheEntry entry;
+        if (!m_assets.load("mip-tiles", CACHE_VERSION, key, entry)) return false;
+
+        const TilesInfo* info = entry.sectionAs<TilesInfo>(0, 1);
+        if (!info || info->tileSize != uint32_t(TILE_SIZE) || info->encoding != uint32_t(m_encoding) ||
+            info->levels == 0 || info->levels > 32) {
+            return false;
+        }
+        const int32_t* wh = entry.sectionAs<int32_t>(1, size_t(info->levels) * 2);
+        if (!wh) return false;
+
+        std::vector<std::pair<int, int>> sizes(info->levels);
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            if (wh[2 * i] <= 0 || wh[2 * i + 1] <= 0) return false;
+            sizes[i] = { wh[2 * i], wh[2 * i + 1] };
+        }
+        setupLevels(sizes);
+
+        const LevelInfo& last = m_levels.back();
+        const glm::vec3* tiles = entry.sectionAs<glm::vec3>(2, (last.firstTile + size_t(last.tilesX) * last.tilesY) * TILE_TEXELS);
+        if (!tiles) return false;
+
+        m_entry = std::move(entry);
+        m_tiles = tiles;
+        m_fileBacked = true;
+        return true;
+    }
+
+    bool MIPMap::storeTiles(uint64_t key) const {
+        const TilesInfo info{ uint32_t(TILE_SIZE), uint32_t(m_levels.size()), uint32_t(m_encoding), 0 };
+        std::vector<int32_t> wh;
+        for (const LevelInfo& L : m_levels) wh.insert(wh.end(), { L.width, L.height });
+
+        const LevelInfo& last = m_levels.back();
+        std::vector<glm::vec3> tiles((last.firstTile + size_t(last.tilesX) * last.tilesY) * TILE_TEXELS);
+        for (size_t level = 0; level < m_levels.size(); ++level) {
+            const LevelInfo& L = m_levels[level];
+            const std::vector<glm::vec3>& src = m_resident[level];
+            for (int ty = 0; ty < L.tilesY; ++ty) {
+                for (int tx = 0; tx < L.tilesX; ++tx) {
+                    glm::vec3* block = tiles.data() + (L.firstTile + size_t(ty) * L.tilesX + tx) * TILE_TEXELS;
+                    for (int y = 0; y < TILE_SIZE; ++y) {
+                        const int sy = std::min(ty * TILE_SIZE + y, L.height - 1);
+                        for (int x = 0; x < TILE_SIZE; ++x) {
+                            const int sx = std::min(tx * TILE_SIZE + x, L.width - 1);
+                            block[size_t(y) * TILE_SIZE + x] = src[size_t(sy) * L.width + sx];
+                        }
+                    }
+                }
+            }
+        }
+
+        return m_assets.store("mip-tiles", CACHE_VERSION, key, { { &info, sizeof(info) },
+            { wh.data(), wh.size() * sizeof(int32_t) }, { tiles.data(), tiles.size() * sizeof(glm::vec3) } });
+    }
+
+    // -------------------------------------------------------------------------
+    // Tile access
+    // -------------------------------------------------------------------------
+
+    TilePtr MIPMap::loadTile(int level, int tx, int ty) const {
+        auto tile = std::make_shared<TextureTile>(TILE_SIZE);
+        const LevelInfo& L = m_levels[level];
+
+        if (m_fileBacked) {
+            const glm::vec3* texels = m_tiles + (L.firstTile + size_t(ty) * L.tilesX + tx) * TILE_TEXELS;
+            std::copy(texels, texels + TILE_TEXELS, tile->texels.begin());
+            return tile;
+        }
+
+        const std::vector<glm::vec3>& src = m_resident[level];
+        for (int y = 0; y < TILE_SIZE; ++y) {
+            const int sy = std::min(ty * TILE_SIZE + y, L.height - 1);
+            for (int x = 0; x < TILE_SIZE; ++x) {
+                const int sx = std::min(tx * TILE_SIZE + x, L.width - 1);
+                tile->texels[size_t(y) * TILE_SIZE + x] = src[size_t(sy) * L.width + sx];
+            }
+        }
+        return tile;
+    }
+
+    /**
+     * A small per-thread, direct-mapped memo in front of the shared cache keeps
+     * neighbouring texel fetches (bilinear taps, EWA rows) off the cache locks.
+     * Its references keep at most MEMO_SLOTS tiles per thread alive past eviction.
+     */
+    const TextureTile& MIPMap::tile(int level, int tx, int ty) const {
+        constexpr size_t MEMO_SLOTS = 16;
+        struct Memo {
+            TileKey key;
+            TilePtr tile;
+        };
+        thread_local std::array<Memo, MEMO_SLOTS> memo;
+
+        const TileKey key{ m_textureId, uint32_t(level), uint32_t(tx), uint32_t(ty) };
+        Memo& slot = memo[key.hash() % MEMO_SLOTS];
+        if (!slot.tile || !(slot.key == key)) {
+            slot.key = key;
+            slot.tile = m_cache.get(key, [&] { return loadTile(level, tx, ty); });
+        }
+        return *slot.tile;
+    }
+
+    // -------------------------------------------------------------------------
+    // Lookups
+    // -------------------------------------------------------------------------
+
+    int MIPMap::levels() const {
+        ensureLoaded();
+        return int(m_levels.size());
+    }
+
+    int MIPMap::width(int level) const {
+        ensureLoaded();
+        return m_levels[level].width;
+    }
+
+    int MIPMap::height(int level) const {
+        ensureLoaded();
+        return m_levels[level].height;
+    }
+
+    bool MIPMap::isFileBacked() const {
+        ensureLoaded();
+        return m_fileBacked;
+    }
+
+    Vector3 MIPMap::texel(int level, int x, int y) const {
+        const LevelInfo& L = m_levels[level];
+        x = wrapCoord(x, L.width, m_wrap);
+        y = wrapCoord(y, L.height, m_wrap);
+        const glm::vec3 c = tile(level, x / TILE_SIZE, y / TILE_SIZE).at(x % TILE_SIZE, y % TILE_SIZE);
+        return Vector3(c);
+    }
+
+    Vector3 MIPMap::bilerp(int level, const UV& st) const {
+        const LevelInfo& L = m_levels[level];
+        const Real x = st.x * L.width - Real(0.5);
+        const Real y = st.y * L.height - Real(0.5);
+        const int x0 = int(std::floor(x)), y0 = int(std::floor(y));
+        const Real dx = x - x0, dy = y - y0;
+
+        return (1 - dx) * (1 - dy) * texel(level, x0, y0) +
+            dx * (1 - dy) * texel(level, x0 + 1, y0) +
+            (1 - dx) * dy * texel(level, x0, y0 + 1) +
+            dx * dy * texel(level, x0 + 1, y0 + 1);
+    }
+
+    Vector3 MIPMap::trilinear(const UV& st, Real width) const {
+        // Level whose texel spacing matches the footprint width
+        const Real maxDim = Real(std::max(m_levels[0].width, m_levels[0].height));
+        const Real level = std::log2(std::max(width * maxDim, Real(1e-8)));
+        const int nLevels = int(m_levels.size());
+
+        if (level <= 0) return bilerp(0, st);
+        if (level >= nLevels - 1) return texel(nLevels - 1, 0, 0);
+
+        const int i = int(std::floor(level));
+        const Real delta = level - i;
+        return (1 - delta) * bilerp(i, st) + delta * bilerp(i + 1, st);
+    }
+
+    Vector3 MIPMap::ewa(int level, UV st, UV dst0, UV dst1) const {
+        const int nLevels = int(m_levels.size());
+        if (level >= nLevels) return texel(nLevels - 1, 0, 0);
+
+        // Ellipse in this level's texel space
+        const LevelInfo& L = m_levels[level];
+        st.x = st.x * L.width - Real(0.5);
+        st.y = st.y * L.height - Real(0.5);
+        dst0.x *= L.width;  dst0.y *= L.height;
+        dst1.x *= L.width;  dst1.y *= L.height;
+
+        // Implicit ellipse A s^2 + B s t + C t^2 < 1 (+1 keeps at least one texel of support)
+        Real A = dst0.y * dst0.y + dst1.y * dst1.y + 1;
+        Real B = -2 * (dst0.x * dst0.y + dst1.x * dst1.y);
+        Real C = dst0.x * dst0.x + dst1.x * dst1.x + 1;
+        const Real invF = 1 / (A * C - B * B * Real(0.25));
+        A *= invF;
+        B *= invF;
+        C *= invF;
+
+        // Bounding box of the ellipse
+        const Real det = -B * B + 4 * A * C;
+        const Real invDet = 1 / det;
+        const Real uSqrt = std::sqrt(det * C), vSqrt = std::sqrt(A * det);
+        const int s0 = int(std::ceil(st.x - 2 * invDet * uSqrt));
+        const int s1 = int(std::floor(st.x + 2 * invDet * uSqrt));
+        const int t0 = int(std::ceil(st.y - 2 * invDet * vSqrt));
+        const int t1 = int(std::floor(st.y + 2 * invDet * vSqrt));
+
+        const auto& lut = ewaWeights();
+        Vector3 sum(0.0);
+        Real sumWts = 0;
+        for (int it = t0; it <= t1; ++it) {
+            const Real tt = it - st.y;
+            for (int is = s0; is <= s1; ++is) {
+                const Real ss = is - st.x;
+                const Real r2 = A * ss * ss + B * ss * tt + C * tt * tt;
+                if (r2 < 1) {
+                    const int index = std::min(int(r2 * EWA_LUT_SIZE), EWA_LUT_SIZE - 1);
+                    const Real weight = lut[index];
+                    sum += weight * texel(level, is, it);
+                    sumWts += weight;
+                }
+            }
+        }
+        return sumWts > 0 ? sum / sumWts : texel(level, int(std::round(st.x)), int(std::round(st.y)));
+    }
+
+    Vector3 MIPMap::lookup(const UV& st, const UV& dst0, const UV& dst1, TextureFilter filter) const {
+        ensureLoaded();
+
+        if (filter == TextureFilter::Bilinear) return bilerp(0, st);
+
+        if (filter == TextureFilter::Trilinear) {
+            const Real width = 2 * std::max({ std::abs(dst0.x), std::abs(dst0.y),
+                                              std::abs(dst1.x), std::abs(dst1.y) });
+            return trilinear(st, width);
+        }
+
+        // EWA: major axis first, then clamp eccentricity by widening the minor axis
+        UV major = dst0, minor = dst1;
+        if (glm::dot(major, major) < glm::dot(minor, minor)) std::swap(major, minor);
+        const Real majorLength = glm::length(major);
+        Real minorLength = glm::length(minor);
+
+        if (minorLength * MAX_ANISOTROPY < majorLength && minorLength > 0) {
+            const Real scale = majorLength / (minorLength * MAX_ANISOTROPY);
+            minor *= scale;
+            minorLength *= scale;
+        }
+        if (minorLength == 0) return bilerp(0, st);
+
+        const Real maxDim = Real(std::max(m_levels[0].width, m_levels[0].height));
+        const Real lod = std::max(Real(0), std::log2(minorLength * maxDim));
+        const int ilod = int(std::floor(lod));
+        const Real delta = lod - ilod;
+        return (1 - delta) * ewa(ilod, st, major, minor) + delta * ewa(ilod + 1, st, major, minor);
+    }
+
+} // namespace rayt
@@ -0,0 +1,106 @@
+#include "pch.h"
+
+#include "IO/MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rayt::io {
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+            m_file = std::exchange(other.m_file, nullptr);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::open(const std::string& path) {
+        close();
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_mapping = mapping;
+        m_data = view;
+        m_size = size_t(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file) CloseHandle(m_file);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = nullptr;
+        m_size = 0;
+    }
+
+#else
+
+    bool MappedFile::open(const std::string& path) {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (view == MAP_FAILED) return false;
+
+        m_data = view;
+        m_size = size_t(st.st_size);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (m_data) munmap(const_cast<void*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+#endif
+
+} // namespace rayt::io
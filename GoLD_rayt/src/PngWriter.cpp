@@ -0,0 +1,637 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+
+#include "Core/Parallel.hpp"
+#include "IO/PngWriter.hpp"
+
+namespace rayt::io {
+
+    namespace {
+
+        // --- Checksums ---
+
+        struct CrcTable {
+            uint32_t t[256];
+            CrcTable() {
+                for (uint32_t n = 0; n < 256; ++n) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    t[n] = c;
+                }
+            }
+        };
+        const CrcTable CRC_TABLE;
+
+        uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n) {
+            crc = ~crc;
+            while (n--) crc = CRC_TABLE.t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        constexpr uint32_t ADLER_BASE = 65521;
+
+        uint32_t adler32(uint32_t adler, const uint8_t* p, size_t n) {
+            uint32_t a = adler & 0xFFFF, b = adler >> 16;
+            while (n) {
+                // 5552 bytes is the most that cannot overflow b before the modulo
+                size_t k = std::min<size_t>(n, 5552);
+                n -= k;
+                while (k--) {
+                    a += *p++;
+                    b += a;
+                }
+                a %= ADLER_BASE;
+                b %= ADLER_BASE;
+            }
+            return a | (b << 16);
+        }
+
+        /// Adler-32 of A + B from those of A and B (zlib's adler32_combine).
+        uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2) {
+            const uint32_t rem = uint32_t(length2 % ADLER_BASE);
+            uint32_t sum1 = adler1 & 0xFFFF;
+            uint32_t sum2 = uint32_t((uint64_t(rem) * sum1) % ADLER_BASE);
+            sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+            sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + ADLER_BASE - rem;
+            if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+            if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+            if (sum2 >= 2 * ADLER_BASE) sum2 -= 2 * ADLER_BASE;
+            if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+            return sum1 | (sum2 << 16);
+        }
+
+        // --- Deflate (RFC 1951) ---
+
+        constexpr int WINDOW = 32768;
+        constexpr int MIN_MATCH = 3, MAX_MATCH = 258;
+        constexpr int HASH_BITS = 15;
+        constexpr int HASH_BYTES = 4; // 3-byte matches are rare gains on filtered pixels, and 3-byte hashes crowd the chains
+        constexpr size_t BLOCK_SYMBOLS = size_t(1) << 16; // symbols per Huffman block
+        constexpr int LITLEN_CODES = 286, DIST_CODES = 30, CODELEN_CODES = 19;
+
+        constexpr int LEN_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        constexpr int LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        constexpr int DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+            2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        constexpr int DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        constexpr int CODELEN_ORDER[CODELEN_CODES] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        constexpr int CODELEN_EXTRA[3] = { 2, 3, 7 }; // codes 16, 17, 18
+
+        struct CodeTables {
+            uint8_t lengthCode[MAX_MATCH + 1]; // match length -> code - 257
+            uint8_t distLow[256];              // distance 1-256 -> code
+            uint8_t distHigh[256];             // (distance - 1) >> 7 for longer ones
+            CodeTables() {
+                for (int c = 0; c < 29; ++c)
+                    for (int l = LEN_BASE[c]; l < LEN_BASE[c] + (1 << LEN_EXTRA[c]) && l <= MAX_MATCH; ++l) lengthCode[l] = uint8_t(c);
+                for (int c = 0; c < 30; ++c)
+                    for (int d = DIST_BASE[c]; d < DIST_BASE[c] + (1 << DIST_EXTRA[c]); ++d) {
+                        if (d <= 256) distLow[d - 1] = uint8_t(c);
+                        else distHigh[(d - 1) >> 7] = uint8_t(c);
+                    }
+            }
+            int distCode(int d) const { return d <= 256 ? distLow[d - 1] : distHigh[(d - 1) >> 7]; }
+        };
+        const CodeTables CODES;
+
+        /// zlib's per-level matcher settings.
+        struct LevelParams { int good, lazy, nice, chain; };
+        constexpr LevelParams LEVELS[10] = {
+            { 0, 0, 0, 0 },       // stored
+            { 4, 4, 8, 4 },       // greedy; `lazy` caps the matches whose positions are all hashed
+            { 4, 5, 16, 8 },
+            { 4, 6, 32, 32 },
+            { 4, 4, 16, 16 },     // lazy
+            { 8, 16, 32, 32 },
+            { 8, 16, 128, 128 },
+            { 8, 32, 128, 256 },
+            { 32, 128, 258, 1024 },
+            { 32, 258, 258, 4096 },
+        };
+
+        struct BitWriter {
+            std::vector<uint8_t>& out;
+            uint64_t bits = 0;
+            int count = 0;
+
+            void put(uint32_t value, int n) {
+                bits |= uint64_t(value) << count;
+                count += n;
+                while (count >= 8) {
+                    out.push_back(uint8_t(bits));
+                    bits >>= 8;
+                    count -= 8;
+                }
+            }
+            void align() {
+                if (count > 0) out.push_back(uint8_t(bits));
+                bits = 0;
+                count = 0;
+            }
+        };
+
+        /**
+         * Huffman code lengths of at most maxBits for `freq`. The tree is built as
+         * usual; deeper leaves are then folded into maxBits and the Kraft sum
+         * repaired (as in miniz). At least two symbols get a code, so every tree
+         * is complete even for a block with a single literal or no distances.
+         */
+        void huffmanLengths(const uint32_t* freq, int n, int maxBits, uint8_t* lengths) {
+            std::fill(lengths, lengths + n, uint8_t(0));
+            std::vector<int> used;
+            for (int s = 0; s < n; ++s)
+                if (freq[s]) used.push_back(s);
+            if (used.size() < 2) {
+                const int a = used.empty() ? 0 : used[0];
+                lengths[a] = lengths[a == 0 ? 1 : 0] = 1;
+                return;
+            }
+
+            struct Node { uint64_t freq; int left, right; };
+            std::vector<Node> nodes;
+            nodes.reserve(2 * used.size());
+            using Item = std::pair<uint64_t, int>;
+            std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+            for (int s : used) {
+                heap.push({ freq[s], int(nodes.size()) });
+                nodes.push_back({ freq[s], -1, -1 });
+            }
+            while (heap.size() > 1) {
+                const Item a = heap.top(); heap.pop();
+                const Item b = heap.top(); heap.pop();
+                heap.push({ a.first + b.first, int(nodes.size()) });
+                nodes.push_back({ a.first + b.first, a.second, b.second });
+            }
+
+            // Children always precede their parent, so one backward pass sets every depth
+            std::vector<int> depth(nodes.size(), 0);
+            std::vector<int> count(std::max<size_t>(nodes.size(), size_t(maxBits)) + 1, 0);
+            for (int i = int(nodes.size()) - 1; i >= 0; --i) {
+                if (nodes[i].left < 0) {
+                    ++count[depth[i]];
+                    continue;
+                }
+                depth[nodes[i].left] = depth[nodes[i].right] = depth[i] + 1;
+            }
+
+            for (size_t d = maxBits + 1; d < count.size(); ++d) {
+                count[maxBits] += count[d];
+                count[d] = 0;
+            }
+            uint64_t total = 0;
+            for (int d = maxBits; d > 0; --d) total += uint64_t(count[d]) << (maxBits - d);
+            while (total != (uint64_t(1) << maxBits)) {
+                --count[maxBits];
+                for (int d = maxBits - 1; d > 0; --d)
+                    if (count[d]) {
+                        --count[d];
+                        count[d + 1] += 2;
+                        break;
+                    }
+                --total;
+            }
+
+            // Rarest symbols get the longest codes
+            std::stable_sort(used.begin(), used.end(), [&](int a, int b) { return freq[a] < freq[b]; });
+            size_t k = 0;
+            for (int d = maxBits; d > 0; --d)
+                for (int j = 0; j < count[d]; ++j) lengths[used[k++]] = uint8_t(d);
+        }
+
+        /// Canonical codes for the lengths, bit-reversed for the LSB-first bit writer.
+        void canonicalCodes(const uint8_t* lengths, int n, uint16_t* codes) {
+            int blCount[16] = {};
+            for (int s = 0; s < n; ++s) ++blCount[lengths[s]];
+            blCount[0] = 0;
+            int next[16] = {};
+            for (int bits = 1, code = 0; bits < 16; ++bits) {
+                code = (code + blCount[bits - 1]) << 1;
+                next[bits] = code;
+            }
+            for (int s = 0; s < n; ++s) {
+                const int len = lengths[s];
+                if (!len) continue;
+                const int code = next[len]++;
+                int reversed = 0;
+                for (int i = 0; i < len; ++i) reversed |= ((code >> i) & 1) << (len - 1 - i);
+                codes[s] = uint16_t(reversed);
+            }
+        }
+
+        /**
+         * Deflates data[begin, end) with data[dictStart, begin) as the preceding
+         * window. A non-final chunk ends with an empty stored block (a "sync
+         * flush"), which leaves the stream byte-aligned and open.
+         */
+        class ChunkDeflater {
+        public:
+            ChunkDeflater(const uint8_t* data, size_t dictStart, size_t begin, size_t end, int level, bool last,
+                std::vector<uint8_t>& out)
+                : m_data(data), m_dictStart(dictStart), m_begin(begin), m_end(end), m_level(level),
+                m_params(LEVELS[level]), m_last(last), m_bits{ out }, m_blockStart(begin) {}
+
+            void run() {
+                if (m_level == 0) {
+                    writeStored(m_begin, m_end - m_begin, m_last);
+                    return;
+                }
+                m_head.assign(size_t(1) << HASH_BITS, -1);
+                m_prev.assign(m_end - m_dictStart, -1);
+                for (size_t p = m_dictStart; p < m_begin; ++p) insert(p);
+                if (m_level <= 3) greedy();
+                else lazy();
+                flushBlock(m_last);
+                if (!m_last) {
+                    m_bits.put(0, 3);
+                    m_bits.align();
+                    for (uint8_t b : { 0x00, 0x00, 0xFF, 0xFF }) m_bits.out.push_back(b);
+                }
+                m_bits.align();
+            }
+
+        private:
+            struct Symbol { uint16_t litLen; uint16_t dist; }; // dist 0: literal byte; otherwise a match of length litLen
+
+            const uint8_t* m_data;
+            size_t m_dictStart, m_begin, m_end;
+            int m_level;
+            LevelParams m_params;
+            bool m_last;
+            BitWriter m_bits;
+
+            std::vector<int32_t> m_head, m_prev; // hash chains, positions relative to m_dictStart
+            std::vector<Symbol> m_symbols;
+            uint32_t m_litFreq[LITLEN_CODES] = {}, m_distFreq[DIST_CODES] = {};
+            size_t m_blockStart, m_blockBytes = 0;
+
+            uint32_t hash(size_t p) const {
+                uint32_t v;
+                std::memcpy(&v, m_data + p, HASH_BYTES);
+                return (v * 2654435761u) >> (32 - HASH_BITS);
+            }
+
+            void insert(size_t p) {
+                if (p + HASH_BYTES > m_end) return;
+                const uint32_t h = hash(p);
+                m_prev[p - m_dictStart] = m_head[h];
+                m_head[h] = int32_t(p - m_dictStart);
+            }
+
+            /// Common prefix of s and t up to maxLen, eight bytes at a time.
+            static int matchLength(const uint8_t* s, const uint8_t* t, int maxLen) {
+                int len = 0;
+                for (; len + 8 <= maxLen; len += 8) {
+                    uint64_t a, b;
+                    std::memcpy(&a, s + len, 8);
+                    std::memcpy(&b, t + len, 8);
+                    if (a != b) return len + std::countr_zero(a ^ b) / 8; // little-endian
+                }
+                while (len < maxLen && s[len] == t[len]) ++len;
+                return len;
+            }
+
+            /// Longest match at p longer than `atLeast` (0 if none); call before insert(p).
+            int findMatch(size_t p, int atLeast, int& dist) const {
+                const int maxLen = int(std::min<size_t>(MAX_MATCH, m_end - p));
+                if (maxLen < HASH_BYTES) return 0;
+                int chain = atLeast >= m_params.good ? m_params.chain >> 2 : m_params.chain;
+                int best = std::max(atLeast, MIN_MATCH - 1);
+                if (best >= maxLen) return 0;
+                const uint8_t* s = m_data + p;
+                for (int32_t c = m_head[hash(p)]; c >= 0 && chain-- > 0; c = m_prev[c]) {
+                    const size_t cp = m_dictStart + size_t(c);
+                    if (p - cp > size_t(WINDOW)) break;
+                    const uint8_t* t = m_data + cp;
+                    if (t[best] != s[best] || t[0] != s[0] || t[1] != s[1]) continue;
+                    const int len = matchLength(s, t, maxLen);
+                    if (len > best) {
+                        best = len;
+                        dist = int(p - cp);
+                        if (len >= m_params.nice || len == maxLen) break;
+                    }
+                }
+                return best >= MIN_MATCH && best > atLeast ? best : 0;
+            }
+
+            void literal(size_t p) {
+                m_symbols.push_back({ m_data[p], 0 });
+                ++m_litFreq[m_data[p]];
+                ++m_blockBytes;
+                if (m_symbols.size() >= BLOCK_SYMBOLS) flushBlock(false);
+            }
+
+            void match(int len, int dist) {
+                m_symbols.push_back({ uint16_t(len), uint16_t(dist) });
+                ++m_litFreq[257 + CODES.lengthCode[len]];
+                ++m_distFreq[CODES.distCode(dist)];
+                m_blockBytes += len;
+                if (m_symbols.size() >= BLOCK_SYMBOLS) flushBlock(false);
+            }
+
+            void greedy() {
+                for (size_t p = m_begin; p < m_end; ) {
+                    int dist = 0;
+                    const int len = findMatch(p, 0, dist);
+                    if (!len) {
+                        insert(p);
+                        literal(p++);
+                        continue;
+                    }
+                    match(len, dist);
+                    // Long matches only hash their first position (zlib's max_insert_length)
+                    const size_t hashed = len <= m_params.lazy ? p + len : p + 1;
+                    for (size_t q = p; q < hashed; ++q) insert(q);
+                    p += len;
+                }
+            }
+
+            void lazy() {
+                int prevLen = 0, prevDist = 0;
+                for (size_t p = m_begin; p < m_end; ) {
+                    int dist = 0, len = 0;
+                    if (prevLen < m_params.lazy) len = findMatch(p, prevLen, dist);
+                    insert(p);
+                    if (prevLen) {
+                        if (len) {
+                            // The match one byte later is longer: the byte before it goes out as a literal
+                            literal(p - 1);
+                            prevLen = len;
+                            prevDist = dist;
+                            ++p;
+                            continue;
+                        }
+                        match(prevLen, prevDist);
+                        const size_t next = p - 1 + prevLen;
+                        for (size_t q = p + 1; q < next; ++q) insert(q);
+                        p = next;
+                        prevLen = 0;
+                        continue;
+                    }
+                    if (len) {
+                        prevLen = len;
+                        prevDist = dist;
+                    }
+                    else {
+                        literal(p);
+                    }
+                    ++p;
+                }
+                if (prevLen) match(prevLen, prevDist);
+            }
+
+            void writeStored(size_t start, size_t length, bool final) {
+                do {
+                    const size_t n = std::min<size_t>(length, 65535);
+                    length -= n;
+                    m_bits.put(final && length == 0 ? 1 : 0, 1);
+                    m_bits.put(0, 2);
+                    m_bits.align();
+                    const uint16_t len = uint16_t(n), nlen = uint16_t(~len);
+                    for (uint8_t b : { uint8_t(len), uint8_t(len >> 8), uint8_t(nlen), uint8_t(nlen >> 8) }) m_bits.out.push_back(b);
+                    m_bits.out.insert(m_bits.out.end(), m_data + start, m_data + start + n);
+                    start += n;
+                } while (length > 0);
+            }
+
+            /// Writes the pending symbols as a dynamic Huffman block, or as stored blocks when that is smaller.
+            void flushBlock(bool final) {
+                ++m_litFreq[256];
+                uint8_t litLen[LITLEN_CODES], distLen[DIST_CODES];
+                huffmanLengths(m_litFreq, LITLEN_CODES, 15, litLen);
+                huffmanLengths(m_distFreq, DIST_CODES, 15, distLen);
+                int hlit = LITLEN_CODES, hdist = DIST_CODES;
+                while (hlit > 257 && litLen[hlit - 1] == 0) --hlit;
+                while (hdist > 1 && distLen[hdist - 1] == 0) --hdist;
+
+                // Run-length code the two length tables as one sequence
+                uint8_t lengths[LITLEN_CODES + DIST_CODES];
+                std::memcpy(lengths, litLen, hlit);
+                std::memcpy(lengths + hlit, distLen, hdist);
+                const int total = hlit + hdist;
+                std::vector<std::pair<uint8_t, uint8_t>> runs; // (code-length symbol, extra bits)
+                uint32_t clFreq[CODELEN_CODES] = {};
+                for (int i = 0; i < total; ) {
+                    const uint8_t v = lengths[i];
+                    int run = 1;
+                    while (i + run < total && lengths[i + run] == v) ++run;
+                    i += run;
+                    if (v == 0) {
+                        while (run >= 11) { const int r = std::min(run, 138); runs.push_back({ 18, uint8_t(r - 11) }); run -= r; }
+                        if (run >= 3) { runs.push_back({ 17, uint8_t(run - 3) }); run = 0; }
+                    }
+                    else {
+                        runs.push_back({ v, 0 });
+                        --run;
+                        while (run >= 3) { const int r = std::min(run, 6); runs.push_back({ 16, uint8_t(r - 3) }); run -= r; }
+                    }
+                    while (run-- > 0) runs.push_back({ v, 0 });
+                }
+                for (const auto& r : runs) ++clFreq[r.first];
+                uint8_t clLen[CODELEN_CODES];
+                huffmanLengths(clFreq, CODELEN_CODES, 7, clLen);
+                int hclen = CODELEN_CODES;
+                while (hclen > 4 && clLen[CODELEN_ORDER[hclen - 1]] == 0) --hclen;
+
+                uint64_t dynamicBits = 3 + 14 + 3 * uint64_t(hclen);
+                for (int s = 0; s < CODELEN_CODES; ++s)
+                    dynamicBits += uint64_t(clFreq[s]) * (clLen[s] + (s >= 16 ? CODELEN_EXTRA[s - 16] : 0));
+                for (int s = 0; s < LITLEN_CODES; ++s)
+                    dynamicBits += uint64_t(m_litFreq[s]) * (litLen[s] + (s > 256 ? LEN_EXTRA[s - 257] : 0));
+                for (int s = 0; s < DIST_CODES; ++s)
+                    dynamicBits += uint64_t(m_distFreq[s]) * (distLen[s] + DIST_EXTRA[s]);
+                const uint64_t storedBlocks = std::max<uint64_t>(1, (m_blockBytes + 65534) / 65535);
+                const uint64_t storedBits = 8 * (uint64_t(m_blockBytes) + 5 * storedBlocks) + 7;
+
+                if (storedBits <= dynamicBits) {
+                    writeStored(m_blockStart, m_blockBytes, final);
+                }
+                else {
+                    uint16_t litCode[LITLEN_CODES] = {}, distCode[DIST_CODES] = {}, clCode[CODELEN_CODES] = {};
+                    canonicalCodes(litLen, LITLEN_CODES, litCode);
+                    canonicalCodes(distLen, DIST_CODES, distCode);
+                    canonicalCodes(clLen, CODELEN_CODES, clCode);
+
+                    m_bits.put(final ? 1 : 0, 1);
+                    m_bits.put(2, 2);
+                    m_bits.put(hlit - 257, 5);
+                    m_bits.put(hdist - 1, 5);
+                    m_bits.put(hclen - 4, 4);
+                    for (int i = 0; i < hclen; ++i) m_bits.put(clLen[CODELEN_ORDER[i]], 3);
+                    for (const auto& r : runs) {
+                        m_bits.put(clCode[r.first], clLen[r.first]);
+                        if (r.first >= 16) m_bits.put(r.second, CODELEN_EXTRA[r.first - 16]);
+                    }
+                    for (const Symbol& s : m_symbols) {
+                        if (s.dist == 0) {
+                            m_bits.put(litCode[s.litLen], litLen[s.litLen]);
+                            continue;
+                        }
+                        const int lc = CODES.lengthCode[s.litLen];
+                        m_bits.put(litCode[257 + lc], litLen[257 + lc]);
+                        m_bits.put(s.litLen - LEN_BASE[lc], LEN_EXTRA[lc]);
+                        const int dc = CODES.distCode(s.dist);
+                        m_bits.put(distCode[dc], distLen[dc]);
+                        m_bits.put(s.dist - DIST_BASE[dc], DIST_EXTRA[dc]);
+                    }
+                    m_bits.put(litCode[256], litLen[256]);
+                }
+
+                m_symbols.clear();
+                std::fill(std::begin(m_litFreq), std::end(m_litFreq), 0u);
+                std::fill(std::begin(m_distFreq), std::end(m_distFreq), 0u);
+                m_blockStart += m_blockBytes;
+                m_blockBytes = 0;
+            }
+        };
+
+        // --- PNG ---
+
+        constexpr uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+        void putU32BE(std::vector<uint8_t>& out, uint32_t v) {
+            for (int i = 3; i >= 0; --i) out.push_back(uint8_t(v >> (8 * i)));
+        }
+
+        /// Length, type, data and CRC of one PNG chunk.
+        std::vector<uint8_t> pngChunk(const char type[4], const uint8_t* data, size_t size) {
+            std::vector<uint8_t> out;
+            out.reserve(size + 12);
+            putU32BE(out, uint32_t(size));
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data, data + size);
+            putU32BE(out, crc32(0, out.data() + 4, size + 4));
+            return out;
+        }
+
+        int paeth(int a, int b, int c) {
+            const int p = a + b - c;
+            const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+        }
+
+        /// Filters one row with the type whose output has the smallest sum of |signed bytes|.
+        void filterRow(const uint8_t* row, const uint8_t* above, size_t bytes, int bpp, bool adaptive, uint8_t* out) {
+            auto predict = [&](int type, size_t i) -> int {
+                const int a = i >= size_t(bpp) ? row[i - bpp] : 0;
+                const int b = above ? above[i] : 0;
+                const int c = above && i >= size_t(bpp) ? above[i - bpp] : 0;
+                switch (type) {
+                case 1: return a;
+                case 2: return b;
+                case 3: return (a + b) >> 1;
+                case 4: return paeth(a, b, c);
+                default: return 0;
+                }
+            };
+
+            int bestType = 0;
+            if (adaptive) {
+                uint64_t bestCost = ~uint64_t(0);
+                for (int type = 0; type < 5; ++type) {
+                    uint64_t cost = 0;
+                    for (size_t i = 0; i < bytes; ++i) cost += std::abs(int(int8_t(uint8_t(row[i] - predict(type, i)))));
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestType = type;
+                    }
+                }
+            }
+            out[0] = uint8_t(bestType);
+            for (size_t i = 0; i < bytes; ++i) out[1 + i] = uint8_t(row[i] - predict(bestType, i));
+        }
+
+        /// The file as a list of byte blocks (signature + IHDR, one per IDAT, the rest).
+        std::vector<std::vector<uint8_t>> encodeParts(int width, int height, int channels, const uint8_t* pixels,
+            size_t stride, const PngOptions& options) {
+            if (width <= 0 || height <= 0 || channels < 1 || channels > 4)
+                throw std::invalid_argument("encodePNG: invalid size or channel count");
+            const int level = std::clamp(options.level, 0, 9);
+            const size_t rowBytes = size_t(width) * channels;
+            if (stride == 0) stride = rowBytes;
+
+            // Filter all rows (1 filter byte + row each)
+            std::vector<uint8_t> filtered((rowBytes + 1) * height);
+            parallelFor(height, 64, [&](int y0, int y1) {
+                for (int y = y0; y < y1; ++y)
+                    filterRow(pixels + stride * y, y > 0 ? pixels + stride * (y - 1) : nullptr, rowBytes, channels, level > 0,
+                        &filtered[(rowBytes + 1) * y]);
+                });
+
+            // Deflate the chunks independently; each becomes one IDAT
+            const size_t chunkBytes = std::max<size_t>(options.chunkBytes, 64 * 1024);
+            const int chunks = int((filtered.size() + chunkBytes - 1) / chunkBytes);
+            std::vector<std::vector<uint8_t>> parts(chunks + 2);
+            std::vector<uint32_t> adler(chunks);
+            parallelFor(chunks, 1, [&](int c0, int c1) {
+                for (int c = c0; c < c1; ++c) {
+                    const size_t begin = size_t(c) * chunkBytes, end = std::min(filtered.size(), begin + chunkBytes);
+                    std::vector<uint8_t> stream;
+                    stream.reserve((end - begin) / 2 + 64);
+                    if (c == 0) {
+                        // zlib header: deflate, 32 KiB window, FLEVEL from the level, FCHECK
+                        const uint8_t cmf = 0x78;
+                        const uint8_t flevel = level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3;
+                        uint8_t flg = uint8_t(flevel << 6);
+                        flg = uint8_t(flg + (31 - (cmf * 256 + flg) % 31) % 31);
+                        stream.push_back(cmf);
+                        stream.push_back(flg);
+                    }
+                    ChunkDeflater(filtered.data(), begin - std::min<size_t>(begin, WINDOW), begin, end, level, c == chunks - 1, stream).run();
+                    adler[c] = adler32(1, filtered.data() + begin, end - begin);
+                    parts[1 + c] = pngChunk("IDAT", stream.data(), stream.size());
+                }
+                });
+
+            uint32_t total = adler[0];
+            for (int c = 1; c < chunks; ++c)
+                total = adler32Combine(total, adler[c], std::min(filtered.size(), size_t(c + 1) * chunkBytes) - size_t(c) * chunkBytes);
+
+            std::vector<uint8_t> header(SIGNATURE, SIGNATURE + 8);
+            std::vector<uint8_t> ihdr;
+            putU32BE(ihdr, uint32_t(width));
+            putU32BE(ihdr, uint32_t(height));
+            const uint8_t colorType[5] = { 0, 0, 4, 2, 6 };
+            for (uint8_t b : { uint8_t(8), colorType[channels], uint8_t(0), uint8_t(0), uint8_t(0) }) ihdr.push_back(b);
+            const std::vector<uint8_t> ihdrChunk = pngChunk("IHDR", ihdr.data(), ihdr.size());
+            header.insert(header.end(), ihdrChunk.begin(), ihdrChunk.end());
+            parts[0] = std::move(header);
+
+            // The Adler-32 trailer closes the zlib stream in an IDAT of its own
+            std::vector<uint8_t> trailer;
+            putU32BE(trailer, total);
+            parts[chunks + 1] = pngChunk("IDAT", trailer.data(), trailer.size());
+            const std::vector<uint8_t> iend = pngChunk("IEND", nullptr, 0);
+            parts[chunks + 1].insert(parts[chunks + 1].end(), iend.begin(), iend.end());
+            return parts;
+        }
+
+    } // namespace
+
+    std::vector<uint8_t> encodePNG(int width, int height, int channels, const uint8_t* pixels, size_t stride,
+        const PngOptions& options) {
+        std::vector<std::vector<uint8_t>> parts = encodeParts(width, height, channels, pixels, stride, options);
+        size_t size = 0;
+        for (const auto& p : parts) size += p.size();
+        std::vector<uint8_t> out;
+        out.reserve(size);
+        for (const auto& p : parts) out.insert(out.end(), p.begin(), p.end());
+        return out;
+    }
+
+    void writePNG(const std::string& filename, int width, int height, int channels, const uint8_t* pixels, size_t stride,
+        const PngOptions& options) {
+        const std::vector<std::vector<uint8_t>> parts = encodeParts(width, height, channels, pixels, stride, options);
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) throw std::runtime_error("writePNG: cannot open " + filename);
+        for (const auto& p : parts) file.write(reinterpret_cast<const char*>(p.data()), std::streamsize(p.size()));
+        if (!file) throw std::runtime_error("writePNG: write failed for " + filename);
+    }
+
+} // namespace rayt::io
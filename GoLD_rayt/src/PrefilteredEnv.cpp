@@ -0,0 +1,227 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Core/Constants.hpp"
+#include "Core/Parallel.hpp"
+#include "Core/Sampling.hpp"
+#include "Geometry/Frame.hpp"
+#include "Microfacet/GGX.hpp"
+#include "Renderer/PrefilteredEnv.hpp"
+
+namespace rayt {
+
+    namespace {
+
+        constexpr uint32_t CACHE_VERSION = 1;
+
+        constexpr int PYRAMID_BASE = 512;    // side of the finest source level
+        constexpr int PYRAMID_LEVELS = 7;    // 512^2 .. 8^2
+        constexpr int IRRADIANCE_SOURCE = 3; // 64^2 pyramid level
+        constexpr int IRRADIANCE_SIZE = 32;
+
+        TiledImage makeOctahedral(int n, const std::vector<Vector3>& pixels) {
+            return TiledImage(Image(n, n, pixels), [n](int& x, int& y) { equalAreaWrapTexel(n, x, y); });
+        }
+
+        Vector3 texelDirection(int x, int y, int n) {
+            return equalAreaSquareToSphere((x + Real(0.5)) / n, (y + Real(0.5)) / n);
+        }
+
+        /// Box-filtered octahedral mip pyramid of the environment; equal-area texels make 2x2 averages exact.
+        struct SourcePyramid {
+            std::vector<std::vector<Vector3>> pixels;
+            std::vector<TiledImage> levels;
+
+            explicit SourcePyramid(const EnvMap& env) {
+                pixels.resize(PYRAMID_LEVELS);
+                pixels[0].resize(size_t(PYRAMID_BASE) * PYRAMID_BASE);
+                parallelFor(PYRAMID_BASE, 16, [&](int begin, int end) {
+                    for (int y = begin; y < end; ++y)
+                        for (int x = 0; x < PYRAMID_BASE; ++x) {
+                            Vector3 sum(0.0);
+                            for (int s = 0; s < 4; ++s)
+                                sum += env.eval(equalAreaSquareToSphere((x + Real(0.25) + Real(0.5) * (s & 1)) / PYRAMID_BASE,
+                                    (y + Real(0.25) + Real(0.5) * (s >> 1)) / PYRAMID_BASE));
+                            pixels[0][size_t(y) * PYRAMID_BASE + x] = sum * Real(0.25);
+                        }
+                    });
+
+                for (int l = 1; l < PYRAMID_LEVELS; ++l) {
+                    const int n = PYRAMID_BASE >> l;
+                    const std::vector<Vector3>& fine = pixels[l - 1];
+                    pixels[l].resize(size_t(n) * n);
+                    for (int y = 0; y < n; ++y)
+                        for (int x = 0; x < n; ++x) {
+                            const size_t i = size_t(2 * y) * (2 * n) + 2 * x;
+                            pixels[l][size_t(y) * n + x] = (fine[i] + fine[i + 1] + fine[i + 2 * n] + fine[i + 2 * n + 1]) * Real(0.25);
+                        }
+                }
+
+                for (int l = 0; l < PYRAMID_LEVELS; ++l)
+                    levels.push_back(makeOctahedral(PYRAMID_BASE >> l, pixels[l]));
+            }
+
+            /// Trilinear lookup; lod 0 is the base level.
+            Vector3 eval(const Vector3& d, Real lod) const {
+                lod = std::clamp(lod, Real(0), Real(PYRAMID_LEVELS - 1));
+                const int l0 = std::min(int(lod), PYRAMID_LEVELS - 2);
+                Real u, v;
+                equalAreaSphereToSquare(d, u, v);
+                auto at = [&](int l) {
+                    const int n = levels[l].width();
+                    return levels[l].bilinear(static_cast<float>(u) * n - 0.5f, static_cast<float>(v) * n - 0.5f);
+                };
+                return glm::mix(at(l0), at(l0 + 1), lod - l0);
+            }
+        };
+
+        /// One GGX sample around the local +Z axis, shared by every texel of a level.
+        struct FilterSample {
+            Vector3 l;   // light direction, local
+            Real weight; // n.l
+            Real lod;    // pyramid level matching the sample's solid angle
+        };
+
+        std::vector<FilterSample> filterSamples(Real alpha) {
+            const GGXDistribution ggx(alpha, alpha);
+            const Vector3 n(0, 0, 1);
+            const Real texelSolidAngle = constants::FOUR_PI / (Real(PYRAMID_BASE) * PYRAMID_BASE);
+
+            std::vector<FilterSample> samples;
+            for (int i = 0; i < PrefilteredEnv::FILTER_SAMPLES; ++i) {
+                // With v = n, VNDF sampling is D(h) cos(h) and the reflected pdf is D(h) / 4
+                const Vector3 h = ggx.sample_wh(n, sampling::Hammersley(uint32_t(i), uint32_t(PrefilteredEnv::FILTER_SAMPLES)));
+                const Vector3 l = Real(2) * h.z * h - n;
+                if (l.z <= 0) continue;
+                const Real pdf = ggx.D(h) / Real(4);
+                const Real sampleSolidAngle = Real(1) / (PrefilteredEnv::FILTER_SAMPLES * pdf);
+                // +1 level: the 64 samples are sparse, overlapping footprints hide the gaps
+                const Real lod = Real(0.5) * std::log2(sampleSolidAngle / texelSolidAngle) + Real(1);
+                samples.push_back({ l, l.z, lod });
+            }
+            return samples;
+        }
+
+    } // namespace
+
+    PrefilteredEnv::PrefilteredEnv(std::shared_ptr<const EnvMap> env) : m_env(std::move(env)) {
+        if (!m_env) return;
+        const SourcePyramid pyramid(*m_env);
+
+        for (int L = 1; L <= LEVELS; ++L) {
+            const Real roughness = Real(L) / LEVELS;
+            const std::vector<FilterSample> samples = filterSamples(roughness * roughness);
+            const int n = resolution(L);
+            std::vector<Vector3> pixels(size_t(n) * n);
+
+            parallelFor(n, 4, [&](int begin, int end) {
+                for (int y = begin; y < end; ++y)
+                    for (int x = 0; x < n; ++x) {
+                        const frame::Frame f(texelDirection(x, y, n));
+                        Vector3 sum(0.0);
+                        Real weight = 0;
+                        for (const FilterSample& s : samples) {
+                            sum += s.weight * pyramid.eval(f.localToWorld(s.l), s.lod);
+                            weight += s.weight;
+                        }
+                        pixels[size_t(y) * n + x] = weight > 0 ? sum / weight : Vector3(0.0);
+                    }
+                });
+            m_levels[L - 1] = makeOctahedral(n, pixels);
+        }
+
+        // Irradiance: exact sum over the 64^2 level (every texel subtends 4 pi / 64^2)
+        const int sourceSize = PYRAMID_BASE >> IRRADIANCE_SOURCE;
+        const std::vector<Vector3>& source = pyramid.pixels[IRRADIANCE_SOURCE];
+        std::vector<Vector3> directions(source.size());
+        for (int y = 0; y < sourceSize; ++y)
+            for (int x = 0; x < sourceSize; ++x)
+                directions[size_t(y) * sourceSize + x] = texelDirection(x, y, sourceSize);
+        const Real solidAngle = constants::FOUR_PI / Real(source.size());
+
+        std::vector<Vector3> irradiance(size_t(IRRADIANCE_SIZE) * IRRADIANCE_SIZE);
+        parallelFor(IRRADIANCE_SIZE, 1, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y)
+                for (int x = 0; x < IRRADIANCE_SIZE; ++x) {
+                    const Vector3 n = texelDirection(x, y, IRRADIANCE_SIZE);
+                    Vector3 sum(0.0);
+                    for (size_t i = 0; i < source.size(); ++i)
+                        sum += std::max(Real(0), glm::dot(n, directions[i])) * source[i];
+                    irradiance[size_t(y) * IRRADIANCE_SIZE + x] = sum * solidAngle;
+                }
+            });
+        m_irradiance = makeOctahedral(IRRADIANCE_SIZE, irradiance);
+    }
+
+    std::shared_ptr<const PrefilteredEnv> PrefilteredEnv::load(std::shared_ptr<const EnvMap> env,
+        const std::string& hdrPath, const io::AssetCache* cache) {
+        io::CacheKey key;
+        const bool cacheable = cache && key.addFile(hdrPath);
+        const uint64_t hash = key.add(LEVELS).add(FILTER_SAMPLES).add(IRRADIANCE_SIZE).value();
+        if (cacheable) {
+            std::shared_ptr<PrefilteredEnv> cached(new PrefilteredEnv());
+            cached->m_env = env;
+            if (cached->loadCache(*cache, hash)) return cached;
+        }
+
+        auto built = std::make_shared<PrefilteredEnv>(std::move(env));
+        if (cacheable && !built->storeCache(*cache, hash))
+            std::cerr << "[PrefilteredEnv] Could not write to " << cache->directory() << "; it will be filtered again next run.\n";
+        return built;
+    }
+
+    // -------------------------------------------------------------------------
+    // io::AssetCache entry: levels 1..LEVELS, then the irradiance map, n^2 rows of 3 floats each
+    // -------------------------------------------------------------------------
+
+    bool PrefilteredEnv::loadCache(const io::AssetCache& cache, uint64_t key) {
+        io::CacheEntry entry;
+        if (!cache.load("prefiltered-env", CACHE_VERSION, key, entry)) return false;
+
+        auto readMap = [&](size_t section, int n, TiledImage& map) {
+            const float* data = entry.sectionAs<float>(section, size_t(n) * n * 3);
+            if (!data) return false;
+            std::vector<Vector3> pixels(size_t(n) * n);
+            for (size_t i = 0; i < pixels.size(); ++i)
+                pixels[i] = Vector3(data[3 * i], data[3 * i + 1], data[3 * i + 2]);
+            map = makeOctahedral(n, pixels);
+            return true;
+        };
+        std::array<TiledImage, LEVELS> levels;
+        TiledImage irradiance;
+        for (int L = 1; L <= LEVELS; ++L)
+            if (!readMap(size_t(L - 1), resolution(L), levels[L - 1])) return false;
+        if (!readMap(LEVELS, IRRADIANCE_SIZE, irradiance)) return false;
+
+        m_levels = std::move(levels);
+        m_irradiance = std::move(irradiance);
+        return true;
+    }
+
+    bool PrefilteredEnv::storeCache(const io::AssetCache& cache, uint64_t key) const {
+        // Texels are Float3, so the floats round-trip exactly
+        auto flatten = [](const TiledImage& map) {
+            const int n = map.width();
+            std::vector<float> data;
+            data.reserve(size_t(n) * n * 3);
+            for (int y = 0; y < n; ++y)
+                for (int x = 0; x < n; ++x) {
+                    const Vector3 c = map.at(x, y);
+                    data.insert(data.end(), { float(c.x), float(c.y), float(c.z) });
+                }
+            return data;
+        };
+        std::vector<std::vector<float>> maps;
+        for (const TiledImage& l : m_levels) maps.push_back(flatten(l));
+        maps.push_back(flatten(m_irradiance));
+
+        std::vector<io::CacheSection> sections;
+        for (const std::vector<float>& m : maps) sections.push_back({ m.data(), m.size() * sizeof(float) });
+        return cache.store("prefiltered-env", CACHE_VERSION, key, sections);
+    }
+
+} // namespace rayt
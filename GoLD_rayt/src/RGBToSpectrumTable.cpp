@@ -0,0 +1,256 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "Core/Parallel.hpp"
+#include "Core/RGBToSpectrumTable.hpp"
+#include "Core/SampledSpectrum.hpp"
+#include "IO/AtomicWrite.hpp"
+
+namespace rayt {
+
+    namespace {
+
+        constexpr char TABLE_MAGIC[8] = { 'R', 'A', 'Y', 'T', 'R', 'G', 'B', 'S' };
+        constexpr uint32_t TABLE_VERSION = 1;
+
+        /**
+         * @brief Fixed-size header of a table file, followed by res z nodes and the coefficient grid.
+         * * The wavelength range is stored so a table fitted for another range is rejected.
+         */
+        struct TableHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t res;
+            double lambdaMin;
+            double lambdaMax;
+        };
+
+        constexpr int MAX_RES = 256;
+
+        /// z nodes, coefficients and the padding float that lets the last corner load four lanes.
+        size_t floatCount(int res) {
+            return size_t(res) + size_t(3) * res * res * res * 3 + 1;
+        }
+
+        // -------------------------------------------------------------------------
+        // Fit
+        // -------------------------------------------------------------------------
+
+        /// Fit quadrature: 5 nm midpoints over the sampled range.
+        constexpr int FIT_SAMPLES = int(LAMBDA_MAX - LAMBDA_MIN) / 5;
+
+        /**
+         * @brief What a spectrum's linear sRGB is, as a weighted sum of its values.
+         * * Same projection as spectral::toRGB, on a coarser grid. The weights are
+         * normalized so the constant spectrum 1 is exactly RGB (1, 1, 1); the fit
+         * runs on wavelengths normalized to [0, 1] to keep it well conditioned.
+         */
+        struct FitBasis {
+            double t[FIT_SAMPLES];
+            Vector3 w[FIT_SAMPLES];
+            spectral::Matrix3 rgbToXYZ;
+            Vector3 whiteXYZ;
+
+            FitBasis() {
+                const spectral::detail::ColorTables& tables = spectral::detail::tables();
+                Vector3 sum(0.0);
+                for (int i = 0; i < FIT_SAMPLES; ++i) {
+                    t[i] = (i + 0.5) / FIT_SAMPLES;
+                    w[i] = tables.xyzToRGB * tables.cmfAt(LAMBDA_MIN + t[i] * (LAMBDA_MAX - LAMBDA_MIN));
+                    sum += w[i];
+                }
+                for (Vector3& wi : w) wi /= sum;
+                rgbToXYZ = glm::inverse(tables.xyzToRGB);
+                whiteXYZ = rgbToXYZ * Vector3(1.0);
+            }
+
+            /// RGB of the spectrum S(c0 t^2 + c1 t + c2).
+            Vector3 rgb(const Vector3& c) const {
+                Vector3 sum(0.0);
+                for (int i = 0; i < FIT_SAMPLES; ++i) {
+                    const double x = (c[0] * t[i] + c[1]) * t[i] + c[2];
+                    sum += (0.5 + 0.5 * x / std::sqrt(1.0 + x * x)) * w[i];
+                }
+                return sum;
+            }
+
+            /// CIE L*a*b* of a linear RGB color (relative to RGB white).
+            Vector3 lab(const Vector3& rgb) const {
+                auto f = [](double v) { return v > 216.0 / 24389.0 ? std::cbrt(v) : (24389.0 / 27.0 * v + 16.0) / 116.0; };
+                const Vector3 xyz = rgbToXYZ * rgb / whiteXYZ;
+                const double fx = f(xyz.x), fy = f(xyz.y), fz = f(xyz.z);
+                return Vector3(116.0 * fy - 16.0, 500.0 * (fx - fy), 200.0 * (fy - fz));
+            }
+        };
+
+        /**
+         * @brief Gauss-Newton on c so that S(c0 t^2 + c1 t + c2) has the color `target`.
+         * * As in the paper, the residual is the CIELAB difference: the cube root
+         * keeps dark colors as well conditioned as bright ones. Starts from c (the
+         * neighbouring grid point's solution) and leaves the best iterate in it;
+         * steps are halved until they reduce the error, so colors the sigmoid cannot
+         * reach exactly (saturated primaries, black) settle instead of overshooting.
+         */
+        void gaussNewton(const FitBasis& basis, const Vector3& target, Vector3& c) {
+            const Vector3 targetLab = basis.lab(target);
+            auto residual = [&](const Vector3& cc) { return basis.lab(basis.rgb(cc)) - targetLab; };
+
+            Vector3 r = residual(c);
+            for (int iteration = 0; iteration < 30 && glm::length(r) > 1e-6; ++iteration) {
+                // Central-difference Jacobian, column k: d residual / d c_k
+                spectral::Matrix3 J;
+                for (int k = 0; k < 3; ++k) {
+                    Vector3 lo = c, hi = c;
+                    lo[k] -= 1e-5;
+                    hi[k] += 1e-5;
+                    J[k] = (residual(hi) - residual(lo)) / 2e-5;
+                }
+                const Real det = glm::determinant(J);
+                if (!std::isfinite(det) || std::abs(det) < 1e-15) return;
+                const Vector3 delta = glm::inverse(J) * r;
+
+                Real step = 1.0;
+                for (; step > 1e-3; step *= 0.5) {
+                    const Vector3 next = c - step * delta;
+                    const Vector3 nextR = residual(next);
+                    if (glm::length(nextR) < glm::length(r)) {
+                        c = next;
+                        r = nextR;
+                        break;
+                    }
+                }
+                if (step <= 1e-3) return;
+            }
+        }
+
+        double smoothstep(double x) { return x * x * (3.0 - 2.0 * x); }
+
+    } // namespace
+
+    RGBToSpectrumTable RGBToSpectrumTable::fit(int res) {
+        const FitBasis basis;
+
+        std::vector<float> data(floatCount(res));
+        float* scale = data.data();
+        float* coeffs = scale + res;
+
+        // Dense near z = 0 (dark colors) and z = 1 (where the sigmoid saturates)
+        std::vector<double> z(res);
+        for (int k = 0; k < res; ++k) {
+            z[k] = smoothstep(smoothstep(double(k) / (res - 1)));
+            scale[k] = float(z[k]);
+        }
+
+        // Coefficients in t = (lambda - LAMBDA_MIN) * A, rewritten as a polynomial in lambda [nm]
+        const double A = 1.0 / (LAMBDA_MAX - LAMBDA_MIN);
+        const double m = LAMBDA_MIN;
+        auto store = [&](int l, int k, int j, int i, const Vector3& c) {
+            float* out = coeffs + ((size_t(l) * res + k) * res + j) * res * 3 + size_t(i) * 3;
+            out[0] = float(c[0] * A * A);
+            out[1] = float(c[1] * A - 2.0 * c[0] * A * A * m);
+            out[2] = float(c[0] * A * A * m * m - c[1] * A * m + c[2]);
+        };
+
+        // Walk each z column outwards from a mid-dark start so every solve begins
+        // next to a converged neighbour. Columns are independent, so rows of them
+        // are handed out to all hardware threads.
+        const int start = res / 5;
+        auto fitRow = [&](int l, int j) {
+            for (int i = 0; i < res; ++i) {
+                const double x = double(i) / (res - 1), y = double(j) / (res - 1);
+                auto solve = [&](int k, Vector3& c) {
+                    Vector3 rgb;
+                    rgb[l] = z[k];
+                    rgb[(l + 1) % 3] = x * z[k];
+                    rgb[(l + 2) % 3] = y * z[k];
+                    gaussNewton(basis, rgb, c);
+                    store(l, k, j, i, c);
+                };
+
+                Vector3 c(0.0);
+                for (int k = start; k < res; ++k) solve(k, c);
+                c = Vector3(0.0);
+                for (int k = start; k >= 0; --k) solve(k, c);
+            }
+        };
+
+        parallelFor(3 * res, 1, [&](int begin, int end) {
+            for (int row = begin; row < end; ++row) fitRow(row / res, row % res);
+            });
+
+        RGBToSpectrumTable table;
+        table.m_owned = std::move(data);
+        table.bind(table.m_owned.data(), res);
+        return table;
+    }
+
+    void RGBToSpectrumTable::bind(const float* data, int res) {
+        m_res = res;
+        m_scale = data;
+        m_coeffs = data + res;
+
+        int i = 0;
+        for (int b = 0; b < Z_BUCKETS; ++b) {
+            const float z = float(b) / Z_BUCKETS;
+            while (i < res - 2 && m_scale[i + 1] <= z) ++i;
+            m_zBucket[b] = uint8_t(i);
+        }
+    }
+
+    bool RGBToSpectrumTable::load(const std::string& filename) {
+        io::MappedFile file;
+        if (!file.open(filename) || file.size() < sizeof(TableHeader)) return false;
+
+        TableHeader header{};
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0 ||
+            header.version != TABLE_VERSION ||
+            header.lambdaMin != LAMBDA_MIN || header.lambdaMax != LAMBDA_MAX ||
+            header.res < 2 || header.res > MAX_RES ||
+            file.size() != sizeof(TableHeader) + floatCount(int(header.res)) * sizeof(float)) {
+            return false;
+        }
+
+        m_owned.clear();
+        m_file = std::move(file);
+        bind(reinterpret_cast<const float*>(static_cast<const char*>(m_file.data()) + sizeof(TableHeader)), int(header.res));
+        return true;
+    }
+
+    bool RGBToSpectrumTable::save(const std::string& filename) const {
+        if (empty()) return false;
+
+        TableHeader header{};
+        std::memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+        header.version = TABLE_VERSION;
+        header.res = uint32_t(m_res);
+        header.lambdaMin = LAMBDA_MIN;
+        header.lambdaMax = LAMBDA_MAX;
+
+        return io::atomicWrite(filename, [&](std::ostream& out) {
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(m_scale), std::streamsize(m_res * sizeof(float)));
+            out.write(reinterpret_cast<const char*>(m_coeffs), std::streamsize((floatCount(m_res) - m_res) * sizeof(float)));
+            });
+    }
+
+    const RGBToSpectrumTable& RGBToSpectrumTable::sRGB() {
+        static const RGBToSpectrumTable table = [] {
+            RGBToSpectrumTable t;
+            if (t.load(DEFAULT_FILE)) return t;
+
+            std::cerr << "[RGBToSpectrumTable] " << DEFAULT_FILE
+                << " is missing or stale; fitting it now (tools/rgb2spec_opt.cpp precomputes it).\n";
+            t = fit();
+            if (!t.save(DEFAULT_FILE))
+                std::cerr << "[RGBToSpectrumTable] Could not write " << DEFAULT_FILE << "; the table will be fitted again next run.\n";
+            return t;
+        }();
+        return table;
+    }
+
+} // namespace rayt
@@ -0,0 +1,60 @@
+#include "pch.h"
+
+#include <iostream>
+
+#include "Renderer/SceneBuilder.hpp"
+#include "Renderer/Camera.hpp"
+#include "Renderer/Scene.hpp"
+
+#include "Core/FresnelTable.hpp"
+#include "Geometry/SphereInstances.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/SpectralIORTable.hpp"
+#include "Materials/MaterialTable.hpp"
+
+namespace rayt {
+
+    std::unique_ptr<Scene> buildScene(const io::SceneFile& file, [[maybe_unused]] const io::AssetCache* cache) {
+        MaterialTable materials;
+        for (size_t i = 0; i < file.materialCount(); ++i) {
+            const io::MaterialRecord& m = file.materials()[i];
+            const Spectrum color(m.color[0], m.color[1], m.color[2]);
+            const Spectrum k(m.k[0], m.k[1], m.k[2]);
+            switch (m.kind) {
+            case io::MaterialKind::Lambertian: materials.emplace<Lambertian>(color); break;
+            case io::MaterialKind::Conductor: {
+                const auto mode = fresnel::ConductorFresnelMode(m.fresnel);
+#if RAYT_SPECTRAL
+                // Measured n, k are evaluated per path wavelength; without them the RGB eta, k are used
+                if (m.measured != io::NO_STRING) {
+                    const std::string path(file.string(m.measured));
+                    auto ior = std::make_shared<SpectralIORTable>();
+                    if (cache ? ior->loadCSV(path, *cache) : ior->loadCSV(path)) {
+                        materials.emplace<RoughConductor>(std::shared_ptr<const SpectralIORTable>(std::move(ior)), m.roughness, m.anisotropy, mode);
+                        break;
+                    }
+                    std::cerr << "[Scene] Could not load " << path << ", using the RGB eta and k.\n";
+                }
+#endif
+                materials.emplace<RoughConductor>(color, k, m.roughness, m.anisotropy, mode);
+                break;
+            }
+            case io::MaterialKind::Dielectric: materials.emplace<Dielectric>(m.ior, m.roughness, m.anisotropy); break;
+            case io::MaterialKind::Light: materials.emplace<DiffuseLight>(color); break;
+            case io::MaterialKind::Mirror: materials.emplace<MirrorConductor>(color, k); break;
+            }
+        }
+
+        auto aggregate = SphereInstances::build(file);
+        return std::make_unique<Scene>(std::move(aggregate), std::move(materials));
+    }
+
+    std::shared_ptr<Camera> buildCamera(const io::SceneSettings& s) {
+        const Point3 from(s.from[0], s.from[1], s.from[2]);
+        const Point3 to(s.to[0], s.to[1], s.to[2]);
+        const Real focus = s.focusDistance > 0 ? Real(s.focusDistance) : glm::length(from - to);
+        return std::make_shared<Camera>(from, to, Vector3(s.up[0], s.up[1], s.up[2]),
+            Real(s.vfov), double(s.width) / s.height, Real(s.aperture), focus);
+    }
+
+} // namespace rayt
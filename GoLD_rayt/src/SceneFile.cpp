@@ -0,0 +1,559 @@
+#include "pch.h"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <numeric>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "IO/SceneFile.hpp"
+#include "IO/AtomicWrite.hpp"
+#include "IO/MappedFile.hpp"
+
+#include "Core/AABB.hpp"
+#include "Core/FresnelTable.hpp"
+
+namespace rayt::io {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'R', 'A', 'Y', 'T', 'S', 'C', 'N', 'B' };
+        constexpr uint32_t ENDIAN_TAG = 0x01020304u;
+        constexpr size_t SECTION_ALIGN = 64;
+
+        enum Section { SETTINGS, MATERIALS, GEOMETRY, INSTANCES, STRINGS, BVH_NODES, BVH_INDICES, SECTION_COUNT };
+
+        struct SectionRecord {
+            uint64_t offset;
+            uint64_t bytes;
+        };
+
+        /**
+         * @brief Fixed-size header of a binary scene, followed by the sections in Section order.
+         */
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t endianTag;
+            uint64_t fileSize;
+            SectionRecord sections[SECTION_COUNT];
+        };
+
+        static_assert(std::is_trivially_copyable_v<SceneSettings> && sizeof(SceneSettings) == 120);
+        static_assert(std::is_trivially_copyable_v<MaterialRecord> && sizeof(MaterialRecord) == 88);
+        static_assert(std::is_trivially_copyable_v<SphereRecord> && sizeof(SphereRecord) == 40);
+        static_assert(std::is_trivially_copyable_v<InstanceRecord> && sizeof(InstanceRecord) == 40);
+        static_assert(std::is_trivially_copyable_v<BVHNodeRecord> && sizeof(BVHNodeRecord) == 56);
+
+        /// Most instances per BVH leaf.
+        constexpr size_t BVH_LEAF_SIZE = 4;
+
+        size_t alignUp(size_t n) { return (n + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN; }
+
+        [[noreturn]] void fail(const std::string& source, const std::string& message) {
+            throw std::runtime_error(source + ": " + message);
+        }
+
+        bool allFinite(std::initializer_list<double> values) {
+            for (double v : values)
+                if (!std::isfinite(v)) return false;
+            return true;
+        }
+
+        // ---------------------------------------------------------------------
+        // Instance BVH
+        // ---------------------------------------------------------------------
+
+        /**
+         * @brief Builds the flat BVH stored with a compiled scene.
+         * * The same median split on the largest centroid extent as BVHNode, but over
+         * instance indices into one node array, so it is written once and traversed
+         * from the mapping. A median split keeps the depth at log2(n / BVH_LEAF_SIZE).
+         */
+        class InstanceBVHBuilder {
+        public:
+            explicit InstanceBVHBuilder(const SceneDescription& scene) : m_indices(scene.instances.size()) {
+                const size_t n = scene.instances.size();
+                if (n > UINT32_MAX) throw std::runtime_error("scene has too many instances for the BVH");
+                std::iota(m_indices.begin(), m_indices.end(), uint32_t(0));
+                m_boxes.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    const InstanceRecord& inst = scene.instances[i];
+                    const Point3 c = instanceCenter(scene.geometry[inst.geometry], inst);
+                    const Vector3 r(instanceRadius(scene.geometry[inst.geometry], inst));
+                    m_boxes[i] = AABB(c - r, c + r);
+                }
+                if (n) {
+                    m_nodes.reserve(2 * (n / BVH_LEAF_SIZE) + 1);
+                    build(0, n);
+                }
+            }
+
+            const std::vector<BVHNodeRecord>& nodes() const { return m_nodes; }
+            const std::vector<uint32_t>& indices() const { return m_indices; }
+
+        private:
+            uint32_t build(size_t begin, size_t end) {
+                const uint32_t index = uint32_t(m_nodes.size());
+                m_nodes.emplace_back();
+
+                AABB box, centroids;
+                for (size_t i = begin; i < end; ++i) {
+                    const AABB& b = m_boxes[m_indices[i]];
+                    box = AABB::unite(box, b);
+                    centroids = AABB::unite(centroids, AABB(b.center(), b.center()));
+                }
+
+                BVHNodeRecord node;
+                for (int a = 0; a < 3; ++a) {
+                    node.min[a] = box.min[a];
+                    node.max[a] = box.max[a];
+                }
+
+                if (end - begin <= BVH_LEAF_SIZE) {
+                    node.offset = uint32_t(begin);
+                    node.count = uint16_t(end - begin);
+                    m_nodes[index] = node;
+                    return index;
+                }
+
+                const Vector3 e = centroids.extent();
+                int axis = 0;
+                if (e.y > e.x) axis = 1;
+                if (e.z > (axis == 0 ? e.x : e.y)) axis = 2;
+
+                // Ties are broken by index so that the same tables always give the same file
+                const size_t mid = begin + (end - begin) / 2;
+                std::nth_element(m_indices.begin() + begin, m_indices.begin() + mid, m_indices.begin() + end,
+                    [&](uint32_t a, uint32_t b) {
+                        const Real ca = m_boxes[a].center()[axis], cb = m_boxes[b].center()[axis];
+                        return ca < cb || (ca == cb && a < b);
+                    });
+
+                build(begin, mid);
+                node.offset = build(mid, end);
+                node.axis = uint16_t(axis);
+                m_nodes[index] = node;
+                return index;
+            }
+
+            std::vector<AABB> m_boxes;
+            std::vector<uint32_t> m_indices;
+            std::vector<BVHNodeRecord> m_nodes;
+        };
+
+        // ---------------------------------------------------------------------
+        // Text form
+        // ---------------------------------------------------------------------
+
+        /// One line of the text form, split into tokens ('#' starts a comment, "..." quotes a token).
+        class LineParser {
+        public:
+            LineParser(const std::string& line, const std::string& source, int lineNumber)
+                : m_where(source + ":" + std::to_string(lineNumber)) {
+                for (size_t i = 0; i < line.size();) {
+                    const char c = line[i];
+                    if (c == '#') break;
+                    if (std::isspace(static_cast<unsigned char>(c))) { ++i; continue; }
+                    if (c == '"') {
+                        const size_t close = line.find('"', i + 1);
+                        if (close == std::string::npos) error("unterminated string");
+                        m_tokens.push_back(line.substr(i + 1, close - i - 1));
+                        i = close + 1;
+                        continue;
+                    }
+                    size_t j = i;
+                    while (j < line.size() && !std::isspace(static_cast<unsigned char>(line[j])) && line[j] != '#') ++j;
+                    m_tokens.push_back(line.substr(i, j - i));
+                    i = j;
+                }
+            }
+
+            bool done() const { return m_pos == m_tokens.size(); }
+
+            const std::string& next(const char* what) {
+                if (done()) error(std::string("expected ") + what);
+                return m_tokens[m_pos++];
+            }
+
+            double number(const char* what) {
+                const std::string& t = next(what);
+                double value = 0;
+                const auto [end, ec] = std::from_chars(t.data(), t.data() + t.size(), value);
+                if (ec != std::errc() || end != t.data() + t.size() || !std::isfinite(value))
+                    error(std::string("bad number for ") + what + ": '" + t + "'");
+                return value;
+            }
+
+            int32_t integer(const char* what, int32_t min) {
+                const std::string& t = next(what);
+                int32_t value = 0;
+                const auto [end, ec] = std::from_chars(t.data(), t.data() + t.size(), value);
+                if (ec != std::errc() || end != t.data() + t.size() || value < min)
+                    error(std::string("bad value for ") + what + ": '" + t + "'");
+                return value;
+            }
+
+            void vec3(double out[3], const char* what) {
+                for (int i = 0; i < 3; ++i) out[i] = number(what);
+            }
+
+            [[noreturn]] void error(const std::string& message) const { fail(m_where, message); }
+
+        private:
+            std::vector<std::string> m_tokens;
+            size_t m_pos = 0;
+            std::string m_where;
+        };
+
+        void parseMaterial(LineParser& p, MaterialRecord& m, SceneDescription& scene) {
+            const std::string type = p.next("material type");
+            if (type == "lambertian") m.kind = MaterialKind::Lambertian;
+            else if (type == "conductor") m.kind = MaterialKind::Conductor;
+            else if (type == "dielectric") m.kind = MaterialKind::Dielectric;
+            else if (type == "light") m.kind = MaterialKind::Light;
+            else if (type == "mirror") m.kind = MaterialKind::Mirror;
+            else p.error("unknown material type '" + type + "'");
+
+            const bool conductor = m.kind == MaterialKind::Conductor || m.kind == MaterialKind::Mirror;
+            while (!p.done()) {
+                const std::string key = p.next("parameter");
+                if (key == "albedo" && m.kind == MaterialKind::Lambertian) p.vec3(m.color, "albedo");
+                else if (key == "emission" && m.kind == MaterialKind::Light) p.vec3(m.color, "emission");
+                else if (key == "eta" && conductor) p.vec3(m.color, "eta");
+                else if (key == "k" && conductor) p.vec3(m.k, "k");
+                else if (key == "ior" && m.kind == MaterialKind::Dielectric) m.ior = p.number("ior");
+                else if (key == "roughness" && (m.kind == MaterialKind::Conductor || m.kind == MaterialKind::Dielectric))
+                    m.roughness = p.number("roughness");
+                else if (key == "anisotropy" && (m.kind == MaterialKind::Conductor || m.kind == MaterialKind::Dielectric))
+                    m.anisotropy = p.number("anisotropy");
+                else if (key == "fresnel" && m.kind == MaterialKind::Conductor) {
+                    const std::string mode = p.next("fresnel mode");
+                    if (mode == "exact") m.fresnel = uint32_t(fresnel::ConductorFresnelMode::Exact);
+                    else if (mode == "tabulated") m.fresnel = uint32_t(fresnel::ConductorFresnelMode::Tabulated);
+                    else p.error("fresnel must be exact or tabulated");
+                }
+                else if (key == "measured" && m.kind == MaterialKind::Conductor) m.measured = scene.addString(p.next("measured n,k file"));
+                else p.error("'" + key + "' is not a parameter of " + type);
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Number formatting for writeText (shortest round-trip form)
+        // ---------------------------------------------------------------------
+
+        std::string num(double v) {
+            char buf[32];
+            const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            return std::string(buf, end);
+        }
+
+        std::string vec(const double v[3]) { return num(v[0]) + " " + num(v[1]) + " " + num(v[2]); }
+
+        std::string quoted(std::string_view s) {
+            const bool plain = !s.empty() && s.find_first_of(" \t#\"") == std::string_view::npos;
+            return plain ? std::string(s) : "\"" + std::string(s) + "\"";
+        }
+
+    } // namespace
+
+    StringRef SceneDescription::addString(std::string_view s) {
+        const StringRef ref = StringRef(strings.size());
+        strings.append(s);
+        strings.push_back('\0');
+        return ref;
+    }
+
+    SceneDescription parseSceneText(std::istream& in, const std::string& sourceName) {
+        SceneDescription scene;
+        std::unordered_map<std::string, uint32_t> materialIds, geometryIds;
+
+        std::string line;
+        for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+            LineParser p(line, sourceName, lineNumber);
+            if (p.done()) continue;
+            const std::string directive = p.next("directive");
+            SceneSettings& s = scene.settings;
+
+            if (directive == "image") {
+                s.width = p.integer("width", 1);
+                s.height = p.integer("height", 1);
+            }
+            else if (directive == "samples") s.samplesPerPixel = p.integer("samples", 1);
+            else if (directive == "maxdepth") s.maxDepth = p.integer("maxdepth", 1);
+            else if (directive == "environment") {
+                const std::string path = p.next("environment path");
+                s.environment = path == "none" ? NO_STRING : scene.addString(path);
+            }
+            else if (directive == "camera") {
+                while (!p.done()) {
+                    const std::string key = p.next("camera parameter");
+                    if (key == "from") p.vec3(s.from, "from");
+                    else if (key == "to") p.vec3(s.to, "to");
+                    else if (key == "up") p.vec3(s.up, "up");
+                    else if (key == "fov") s.vfov = p.number("fov");
+                    else if (key == "aperture") s.aperture = p.number("aperture");
+                    else if (key == "focus") s.focusDistance = p.number("focus");
+                    else p.error("'" + key + "' is not a camera parameter");
+                }
+            }
+            else if (directive == "material") {
+                const std::string name = p.next("material name");
+                if (materialIds.count(name)) p.error("material '" + name + "' is defined twice");
+                MaterialRecord m;
+                parseMaterial(p, m, scene);
+                m.name = scene.addString(name);
+                materialIds.emplace(name, uint32_t(scene.materials.size()));
+                scene.materials.push_back(m);
+            }
+            else if (directive == "geometry") {
+                const std::string name = p.next("geometry name");
+                if (geometryIds.count(name)) p.error("geometry '" + name + "' is defined twice");
+                if (const std::string type = p.next("geometry type"); type != "sphere")
+                    p.error("unknown geometry type '" + type + "' (only sphere)");
+                SphereRecord g;
+                while (!p.done()) {
+                    const std::string key = p.next("sphere parameter");
+                    if (key == "center") p.vec3(g.center, "center");
+                    else if (key == "radius") g.radius = p.number("radius");
+                    else p.error("'" + key + "' is not a sphere parameter");
+                }
+                if (!(g.radius > 0)) p.error("radius must be positive");
+                g.name = scene.addString(name);
+                geometryIds.emplace(name, uint32_t(scene.geometry.size()));
+                scene.geometry.push_back(g);
+            }
+            else if (directive == "instance") {
+                InstanceRecord inst;
+                const std::string geometry = p.next("geometry name");
+                const std::string material = p.next("material name");
+                const auto g = geometryIds.find(geometry);
+                const auto m = materialIds.find(material);
+                if (g == geometryIds.end()) p.error("unknown geometry '" + geometry + "'");
+                if (m == materialIds.end()) p.error("unknown material '" + material + "'");
+                inst.geometry = g->second;
+                inst.material = m->second;
+                while (!p.done()) {
+                    const std::string key = p.next("instance parameter");
+                    if (key == "translate") p.vec3(inst.translation, "translate");
+                    else if (key == "scale") inst.scale = p.number("scale");
+                    else p.error("'" + key + "' is not an instance parameter");
+                }
+                if (!(inst.scale > 0)) p.error("scale must be positive");
+                scene.instances.push_back(inst);
+            }
+            else p.error("unknown directive '" + directive + "'");
+        }
+
+        return scene;
+    }
+
+    std::vector<char> SceneDescription::compile() const {
+        const InstanceBVHBuilder bvh(*this);
+        const std::pair<const void*, size_t> data[SECTION_COUNT] = {
+            { &settings, sizeof(settings) },
+            { materials.data(), materials.size() * sizeof(MaterialRecord) },
+            { geometry.data(), geometry.size() * sizeof(SphereRecord) },
+            { instances.data(), instances.size() * sizeof(InstanceRecord) },
+            { strings.data(), strings.size() },
+            { bvh.nodes().data(), bvh.nodes().size() * sizeof(BVHNodeRecord) },
+            { bvh.indices().data(), bvh.indices().size() * sizeof(uint32_t) },
+        };
+
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = SceneFile::FORMAT_VERSION;
+        header.endianTag = ENDIAN_TAG;
+        size_t offset = alignUp(sizeof(FileHeader));
+        for (int i = 0; i < SECTION_COUNT; ++i) {
+            header.sections[i] = { uint64_t(offset), uint64_t(data[i].second) };
+            offset = alignUp(offset + data[i].second);
+        }
+        header.fileSize = offset;
+
+        std::vector<char> bytes(offset, 0);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        for (int i = 0; i < SECTION_COUNT; ++i)
+            if (data[i].second) std::memcpy(bytes.data() + header.sections[i].offset, data[i].first, data[i].second);
+        return bytes;
+    }
+
+    SceneFile SceneFile::load(const std::string& path) {
+        auto file = std::make_shared<MappedFile>();
+        if (!file->open(path)) fail(path, "cannot open scene");
+
+        if (file->size() >= sizeof(FILE_MAGIC) && std::memcmp(file->data(), FILE_MAGIC, sizeof(FILE_MAGIC)) == 0) {
+            const char* data = static_cast<const char*>(file->data());
+            const size_t size = file->size();
+            SceneFile scene = view(data, size, std::move(file), path);
+            scene.m_mapped = true;
+            return scene;
+        }
+
+        std::istringstream text(std::string(static_cast<const char*>(file->data()), file->size()));
+        return fromDescription(parseSceneText(text, path));
+    }
+
+    SceneFile SceneFile::fromDescription(const SceneDescription& description) {
+        auto bytes = std::make_shared<std::vector<char>>(description.compile());
+        const char* data = bytes->data();
+        const size_t size = bytes->size();
+        return view(data, size, std::move(bytes), "<scene>");
+    }
+
+    SceneFile SceneFile::view(const char* data, size_t size, std::shared_ptr<const void> backing, const std::string& sourceName) {
+        // Magic, version and byte order come first, so files of other versions are named as such
+        FileHeader header{};
+        constexpr size_t prefix = offsetof(FileHeader, fileSize);
+        if (size < prefix) fail(sourceName, "truncated scene header");
+        std::memcpy(&header, data, prefix);
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) fail(sourceName, "not a binary scene");
+        if (header.endianTag != ENDIAN_TAG) fail(sourceName, "scene was written with another byte order");
+        if (header.version != FORMAT_VERSION)
+            fail(sourceName, "scene format version " + std::to_string(header.version) + ", expected " + std::to_string(FORMAT_VERSION) + " (recompile it with scenec)");
+        if (size < sizeof(header)) fail(sourceName, "truncated scene header");
+        std::memcpy(&header, data, sizeof(header));
+        if (header.fileSize != size) fail(sourceName, "truncated scene");
+
+        const size_t recordSize[SECTION_COUNT] = { sizeof(SceneSettings), sizeof(MaterialRecord), sizeof(SphereRecord), sizeof(InstanceRecord), 1,
+            sizeof(BVHNodeRecord), sizeof(uint32_t) };
+        for (int i = 0; i < SECTION_COUNT; ++i) {
+            const SectionRecord& s = header.sections[i];
+            if (s.offset % SECTION_ALIGN != 0 || s.offset > size || s.bytes > size - s.offset || s.bytes % recordSize[i] != 0)
+                fail(sourceName, "corrupt section table");
+        }
+        if (header.sections[SETTINGS].bytes != sizeof(SceneSettings)) fail(sourceName, "corrupt settings");
+
+        SceneFile scene;
+        auto at = [&](Section s) { return data + header.sections[s].offset; };
+        scene.m_backing = std::move(backing);
+        scene.m_data = data;
+        scene.m_size = size;
+        scene.m_settings = reinterpret_cast<const SceneSettings*>(at(SETTINGS));
+        scene.m_materials = reinterpret_cast<const MaterialRecord*>(at(MATERIALS));
+        scene.m_materialCount = header.sections[MATERIALS].bytes / sizeof(MaterialRecord);
+        scene.m_geometry = reinterpret_cast<const SphereRecord*>(at(GEOMETRY));
+        scene.m_geometryCount = header.sections[GEOMETRY].bytes / sizeof(SphereRecord);
+        scene.m_instances = reinterpret_cast<const InstanceRecord*>(at(INSTANCES));
+        scene.m_instanceCount = header.sections[INSTANCES].bytes / sizeof(InstanceRecord);
+        scene.m_strings = at(STRINGS);
+        scene.m_stringBytes = header.sections[STRINGS].bytes;
+        scene.m_bvhNodes = reinterpret_cast<const BVHNodeRecord*>(at(BVH_NODES));
+        scene.m_bvhNodeCount = header.sections[BVH_NODES].bytes / sizeof(BVHNodeRecord);
+        scene.m_bvhIndices = reinterpret_cast<const uint32_t*>(at(BVH_INDICES));
+
+        // The renderer indexes with these without further checks, and hands the values to Film and
+        // the camera; one pass holding them to parseSceneText's rules is the only per-record work on load
+        if (scene.m_stringBytes && scene.m_strings[scene.m_stringBytes - 1] != '\0') fail(sourceName, "corrupt string table");
+        auto validString = [&](StringRef r) { return r == NO_STRING || r < scene.m_stringBytes; };
+        const SceneSettings& s = scene.settings();
+        if (!validString(s.environment)) fail(sourceName, "corrupt environment path");
+        if (s.width < 1 || s.height < 1 || s.samplesPerPixel < 1 || s.maxDepth < 1
+            || !allFinite({ s.from[0], s.from[1], s.from[2], s.to[0], s.to[1], s.to[2], s.up[0], s.up[1], s.up[2],
+                s.vfov, s.aperture, s.focusDistance }))
+            fail(sourceName, "corrupt settings");
+        for (size_t i = 0; i < scene.m_materialCount; ++i) {
+            const MaterialRecord& m = scene.m_materials[i];
+            if (uint32_t(m.kind) > uint32_t(MaterialKind::Mirror) || m.fresnel > 1 || !validString(m.name) || !validString(m.measured)
+                || !allFinite({ m.color[0], m.color[1], m.color[2], m.k[0], m.k[1], m.k[2], m.roughness, m.anisotropy, m.ior }))
+                fail(sourceName, "corrupt material " + std::to_string(i));
+        }
+        for (size_t i = 0; i < scene.m_geometryCount; ++i) {
+            const SphereRecord& g = scene.m_geometry[i];
+            if (!validString(g.name) || !allFinite({ g.center[0], g.center[1], g.center[2] }) || !(g.radius > 0 && std::isfinite(g.radius)))
+                fail(sourceName, "corrupt geometry " + std::to_string(i));
+        }
+        for (size_t i = 0; i < scene.m_instanceCount; ++i) {
+            const InstanceRecord& inst = scene.m_instances[i];
+            if (inst.geometry >= scene.m_geometryCount || inst.material >= scene.m_materialCount)
+                fail(sourceName, "instance " + std::to_string(i) + " refers to a missing geometry or material");
+            if (!allFinite({ inst.translation[0], inst.translation[1], inst.translation[2] }) || !(inst.scale > 0 && std::isfinite(inst.scale)))
+                fail(sourceName, "corrupt instance " + std::to_string(i));
+        }
+
+        // The BVH is traversed with a fixed stack and no range checks: every child must come after its
+        // parent (so traversal ends), stay within MAX_BVH_DEPTH, and every leaf must index real instances
+        const size_t nodeCount = scene.m_bvhNodeCount;
+        if ((scene.m_instanceCount > 0) != (nodeCount > 0) || header.sections[BVH_INDICES].bytes / sizeof(uint32_t) != scene.m_instanceCount)
+            fail(sourceName, "corrupt BVH");
+        for (size_t i = 0; i < scene.m_instanceCount; ++i)
+            if (scene.m_bvhIndices[i] >= scene.m_instanceCount) fail(sourceName, "corrupt BVH index " + std::to_string(i));
+        std::vector<uint8_t> depth(nodeCount, 0);
+        for (size_t i = 0; i < nodeCount; ++i) {
+            const BVHNodeRecord& n = scene.m_bvhNodes[i];
+            const bool ok = n.count > 0
+                ? size_t(n.offset) + n.count <= scene.m_instanceCount
+                : n.axis < 3 && i + 1 < nodeCount && n.offset > i + 1 && n.offset < nodeCount && depth[i] + 1 < MAX_BVH_DEPTH;
+            if (!ok) fail(sourceName, "corrupt BVH node " + std::to_string(i));
+            if (n.count == 0)
+                for (size_t child : { i + 1, size_t(n.offset) })
+                    depth[child] = std::max(depth[child], uint8_t(depth[i] + 1));
+        }
+        return scene;
+    }
+
+    std::string_view SceneFile::string(StringRef ref) const {
+        if (ref == NO_STRING) return {};
+        return std::string_view(m_strings + ref);
+    }
+
+    void SceneFile::writeBinary(const std::string& path) const {
+        if (!atomicWrite(path, [&](std::ostream& out) { out.write(m_data, std::streamsize(m_size)); }))
+            fail(path, "could not write scene");
+    }
+
+    void SceneFile::writeText(std::ostream& out) const {
+        const SceneSettings& s = settings();
+        auto nameOf = [&](StringRef ref, const char* prefix, size_t i) {
+            return ref != NO_STRING ? quoted(string(ref)) : prefix + std::to_string(i);
+        };
+
+        out << "image " << s.width << " " << s.height << "\n"
+            << "samples " << s.samplesPerPixel << "\n"
+            << "maxdepth " << s.maxDepth << "\n"
+            << "environment " << (s.environment != NO_STRING ? quoted(string(s.environment)) : "none") << "\n"
+            << "camera from " << vec(s.from) << " to " << vec(s.to) << " up " << vec(s.up)
+            << " fov " << num(s.vfov) << " aperture " << num(s.aperture);
+        if (s.focusDistance > 0) out << " focus " << num(s.focusDistance);
+        out << "\n\n";
+
+        for (size_t i = 0; i < materialCount(); ++i) {
+            const MaterialRecord& m = m_materials[i];
+            out << "material " << nameOf(m.name, "material", i);
+            switch (m.kind) {
+            case MaterialKind::Lambertian: out << " lambertian albedo " << vec(m.color); break;
+            case MaterialKind::Conductor:
+                out << " conductor eta " << vec(m.color) << " k " << vec(m.k) << " roughness " << num(m.roughness)
+                    << " anisotropy " << num(m.anisotropy)
+                    << " fresnel " << (m.fresnel == uint32_t(fresnel::ConductorFresnelMode::Tabulated) ? "tabulated" : "exact");
+                if (m.measured != NO_STRING) out << " measured " << quoted(string(m.measured));
+                break;
+            case MaterialKind::Dielectric:
+                out << " dielectric ior " << num(m.ior) << " roughness " << num(m.roughness) << " anisotropy " << num(m.anisotropy);
+                break;
+            case MaterialKind::Light: out << " light emission " << vec(m.color); break;
+            case MaterialKind::Mirror: out << " mirror eta " << vec(m.color) << " k " << vec(m.k); break;
+            }
+            out << "\n";
+        }
+        out << "\n";
+        for (size_t i = 0; i < geometryCount(); ++i) {
+            const SphereRecord& g = m_geometry[i];
+            out << "geometry " << nameOf(g.name, "geometry", i) << " sphere center " << vec(g.center) << " radius " << num(g.radius) << "\n";
+        }
+        out << "\n";
+        for (size_t i = 0; i < instanceCount(); ++i) {
+            const InstanceRecord& inst = m_instances[i];
+            out << "instance " << nameOf(m_geometry[inst.geometry].name, "geometry", inst.geometry) << " "
+                << nameOf(m_materials[inst.material].name, "material", inst.material)
+                << " translate " << vec(inst.translation) << " scale " << num(inst.scale) << "\n";
+        }
+    }
+
+} // namespace rayt::io
@@ -0,0 +1,106 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+
+#include "IO/SpectralIORTable.hpp"
+
+namespace rayt {
+
+    namespace {
+
+        constexpr uint32_t MAX_GRID_SIZE = 1u << 20;
+
+        /// io::AssetCache entry: this, then `size` n floats, then `size` k floats.
+        struct GridInfo {
+            double lambdaMin;
+            double step;
+            uint64_t size;
+        };
+
+        constexpr uint32_t ASSET_CACHE_VERSION = 1;
+
+    } // namespace
+
+    SpectralIORTable::SpectralIORTable(const IORInterpolator& data, Real lambdaMin, Real lambdaMax, Real step) {
+        const size_t size = size_t(std::floor((lambdaMax - lambdaMin) / step + 1e-9)) + 1;
+        setGrid(lambdaMin, step, size);
+        for (size_t i = 0; i < size; ++i) {
+            const std::complex<double> c = data.evaluate(lambdaMin + Real(i) * step);
+            m_n[i] = float(c.real());
+            m_k[i] = float(c.imag());
+        }
+        m_n[size] = m_n[size - 1];
+        m_k[size] = m_k[size - 1];
+    }
+
+    void SpectralIORTable::setGrid(Real lambdaMin, Real step, size_t size) {
+        m_lambda0 = lambdaMin;
+        m_step = step;
+        m_invStep = float(Real(1.0) / step);
+        m_size = size;
+        m_maxX = float(size - 1);
+        m_n.assign(size + 1, 0.0f);
+        m_k.assign(size + 1, 0.0f);
+    }
+
+    bool SpectralIORTable::loadCSV(const std::string& filename, bool useCache) {
+        if (useCache) return loadCSV(filename, io::AssetCache());
+
+        IORInterpolator data;
+        if (!data.loadCSV(filename)) return false;
+        *this = SpectralIORTable(data);
+        return true;
+    }
+
+    bool SpectralIORTable::loadCSV(const std::string& filename, const io::AssetCache& cache) {
+        io::CacheKey key;
+        if (!key.addFile(filename)) return false;
+        const uint64_t hash = key.add(LAMBDA_MIN).add(LAMBDA_MAX).add(DEFAULT_STEP).value();
+
+        if (io::CacheEntry entry; cache.load("ior-table", ASSET_CACHE_VERSION, hash, entry)) {
+            const GridInfo* info = entry.sectionAs<GridInfo>(0, 1);
+            if (info && info->size >= 2 && info->size <= MAX_GRID_SIZE && info->step > 0) {
+                const float* nData = entry.sectionAs<float>(1, info->size);
+                const float* kData = entry.sectionAs<float>(2, info->size);
+                if (nData && kData) {
+                    // A few kB: copied rather than viewed, so the table stays a plain value type
+                    setGrid(info->lambdaMin, info->step, info->size);
+                    std::copy(nData, nData + info->size, m_n.begin());
+                    std::copy(kData, kData + info->size, m_k.begin());
+                    m_n[m_size] = m_n[m_size - 1];
+                    m_k[m_size] = m_k[m_size - 1];
+                    return true;
+                }
+            }
+        }
+
+        IORInterpolator data;
+        if (!data.loadCSV(filename)) return false;
+        *this = SpectralIORTable(data);
+
+        const GridInfo info{ m_lambda0, m_step, m_size };
+        if (!cache.store("ior-table", ASSET_CACHE_VERSION, hash, { { &info, sizeof(info) },
+            { m_n.data(), m_size * sizeof(float) }, { m_k.data(), m_size * sizeof(float) } }))
+            std::cerr << "[SpectralIORTable] Could not write to " << cache.directory() << "; the CSV will be parsed again next run.\n";
+        return true;
+    }
+
+    void SpectralIORTable::evaluate(const float* wavelength_nm, size_t count, float* n, float* k) const {
+        size_t i = 0;
+        for (; i + simd::LANES <= count; i += simd::LANES) {
+            simd::Float4 n4, k4;
+            evaluate4(simd::Float4::load(wavelength_nm + i), n4, k4);
+            n4.store(n + i);
+            k4.store(k + i);
+        }
+        for (; i < count; ++i) {
+            const std::complex<double> c = evaluate(double(wavelength_nm[i]));
+            n[i] = float(c.real());
+            k[i] = float(c.imag());
+        }
+    }
+
+} // namespace rayt
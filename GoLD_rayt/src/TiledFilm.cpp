@@ -0,0 +1,265 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "Renderer/TiledFilm.hpp"
+#include "IO/AtomicWrite.hpp"
+
+namespace rayt {
+
+    TiledFilm::TiledFilm(int width, int height, const std::string& exrPath, const Filter& filter, const TiledFilmOptions& options)
+        : m_width(width), m_height(height), m_filter(filter), m_options(options) {
+        if (m_options.scratchPath.empty()) m_options.scratchPath = exrPath + ".scratch";
+        io::ExrPart layout;
+        layout.compression = options.compression;
+        layout.tileSize = options.tileSize;
+        for (const char* name : { "R", "G", "B" }) {
+            io::ExrChannel c;
+            c.name = name;
+            c.type = options.pixelType;
+            layout.channels.push_back(std::move(c));
+        }
+        m_writer = std::make_unique<io::ExrTileWriter>(exrPath, width, height, layout);
+        m_sink = [this](int x0, int y0, int, int, const float* const* rgb) {
+            m_writer->writeTile(x0 / m_options.tileSize, y0 / m_options.tileSize, rgb);
+        };
+        init();
+    }
+
+    TiledFilm::TiledFilm(int width, int height, TileSink sink, const Filter& filter, const TiledFilmOptions& options)
+        : m_width(width), m_height(height), m_filter(filter), m_options(options), m_sink(std::move(sink)) {
+        if (m_options.scratchPath.empty()) m_options.scratchPath = (std::filesystem::temp_directory_path() / ("rayt_tiled_film_" + io::uniqueFileTag() + ".scratch")).string();
+        init();
+    }
+
+    TiledFilm::~TiledFilm() {
+        try {
+            finish();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[TiledFilm] Error: " << e.what() << std::endl;
+        }
+    }
+
+    void TiledFilm::init() {
+        if (m_width <= 0 || m_height <= 0 || m_options.tileSize <= 0)
+            throw std::invalid_argument("TiledFilm: empty image or tile size");
+        const int ts = m_options.tileSize;
+        m_tilesX = (m_width + ts - 1) / ts;
+        m_tilesY = (m_height + ts - 1) / ts;
+        m_tiles.resize(size_t(m_tilesX) * m_tilesY);
+
+        // Sample columns s with [s, s + 1) within the filter radius of a pixel center in [x0, x1)
+        const Real r = m_filter.radius();
+        for (int t = 0; t < int(m_tiles.size()); ++t) {
+            int x0, y0, x1, y1;
+            tileRect(t, x0, y0, x1, y1);
+            const int sx0 = std::max(0, int(std::floor(x0 - r - Real(0.5))) + 1);
+            const int sy0 = std::max(0, int(std::floor(y0 - r - Real(0.5))) + 1);
+            const int sx1 = std::min(m_width, int(std::ceil(x1 + r - Real(0.5))));
+            const int sy1 = std::min(m_height, int(std::ceil(y1 + r - Real(0.5))));
+            m_tiles[t].pending = int64_t(sx1 - sx0) * (sy1 - sy0);
+        }
+    }
+
+    void TiledFilm::tileRect(int t, int& x0, int& y0, int& x1, int& y1) const {
+        const int ts = m_options.tileSize;
+        x0 = (t % m_tilesX) * ts;
+        y0 = (t / m_tilesX) * ts;
+        x1 = std::min(x0 + ts, m_width);
+        y1 = std::min(y0 + ts, m_height);
+    }
+
+    FilmTile TiledFilm::tile(int x0, int y0, int x1, int y1) const {
+        return FilmTile::covering(x0, y0, x1, y1, m_width, m_height, &m_filter, false);
+    }
+
+    void TiledFilm::mergeTile(const FilmTile& tile) {
+        const int ts = m_options.tileSize;
+        std::vector<std::pair<int, std::vector<Accum>>> completed;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_finished) return;
+            ++m_stamp;
+
+            // Accumulate into every storage tile the tile's pixels overlap
+            if (tile.m_x1 > tile.m_x0 && tile.m_y1 > tile.m_y0) {
+                const int w = tile.m_x1 - tile.m_x0;
+                for (int ty = tile.m_y0 / ts; ty <= (tile.m_y1 - 1) / ts; ++ty)
+                    for (int tx = tile.m_x0 / ts; tx <= (tile.m_x1 - 1) / ts; ++tx) {
+                        const int t = ty * m_tilesX + tx;
+                        // Completed tiles cannot be reached any more (one pass over disjoint sample rectangles)
+                        if (m_tiles[t].state == TileState::Done) continue;
+                        makeResident(t);
+                        int x0, y0, x1, y1;
+                        tileRect(t, x0, y0, x1, y1);
+                        std::vector<Accum>& pixels = m_tiles[t].pixels;
+                        for (int y = std::max(y0, tile.m_y0); y < std::min(y1, tile.m_y1); ++y)
+                            for (int x = std::max(x0, tile.m_x0); x < std::min(x1, tile.m_x1); ++x) {
+                                const FilmTile::Pixel& p = tile.m_pixels[size_t(y - tile.m_y0) * w + (x - tile.m_x0)];
+                                Accum& a = pixels[size_t(y - y0) * (x1 - x0) + (x - x0)];
+                                a.sum += p.sum;
+                                a.weight += p.weight;
+                            }
+                    }
+            }
+
+            // Count the sample rectangle off every storage tile it can reach
+            const int reach = int(std::ceil(m_filter.radius())) + 1;
+            const int tx0 = std::max(0, (tile.m_sx0 - reach) / ts), tx1 = std::min(m_tilesX - 1, (tile.m_sx1 + reach) / ts);
+            const int ty0 = std::max(0, (tile.m_sy0 - reach) / ts), ty1 = std::min(m_tilesY - 1, (tile.m_sy1 + reach) / ts);
+            const Real r = m_filter.radius();
+            for (int ty = ty0; ty <= ty1; ++ty)
+                for (int tx = tx0; tx <= tx1; ++tx) {
+                    const int t = ty * m_tilesX + tx;
+                    StorageTile& st = m_tiles[t];
+                    if (st.state == TileState::Done) continue;
+                    int x0, y0, x1, y1;
+                    tileRect(t, x0, y0, x1, y1);
+                    const int sx0 = std::max(tile.m_sx0, int(std::floor(x0 - r - Real(0.5))) + 1);
+                    const int sy0 = std::max(tile.m_sy0, int(std::floor(y0 - r - Real(0.5))) + 1);
+                    const int sx1 = std::min(tile.m_sx1, int(std::ceil(x1 + r - Real(0.5))));
+                    const int sy1 = std::min(tile.m_sy1, int(std::ceil(y1 + r - Real(0.5))));
+                    if (sx1 <= sx0 || sy1 <= sy0) continue;
+                    st.pending -= int64_t(sx1 - sx0) * (sy1 - sy0);
+                    if (st.pending > 0) continue;
+
+                    if (st.state == TileState::Paged) makeResident(t);
+                    if (st.state == TileState::Resident) {
+                        m_lru.erase(st.lru);
+                        m_stats.residentBytes -= st.pixels.size() * sizeof(Accum);
+                    }
+                    completed.emplace_back(t, std::move(st.pixels));
+                    st.pixels = {};
+                    st.state = TileState::Done;
+                    ++m_stats.tilesWritten;
+                }
+
+            evict();
+        }
+
+        // Resolving and writing does not need the lock
+        for (const auto& [t, pixels] : completed) emit(t, pixels);
+    }
+
+    void TiledFilm::finish() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_finished) return;
+            m_finished = true;
+        }
+        // No merges run any more: one tile at a time, so the budget still holds
+        for (int t = 0; t < int(m_tiles.size()); ++t) {
+            std::vector<Accum> pixels;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                StorageTile& st = m_tiles[t];
+                if (st.state == TileState::Done) continue;
+                if (st.state == TileState::Paged) makeResident(t);
+                if (st.state == TileState::Resident) {
+                    m_lru.erase(st.lru);
+                    m_stats.residentBytes -= st.pixels.size() * sizeof(Accum);
+                    pixels = std::move(st.pixels);
+                    st.pixels = {};
+                }
+                st.state = TileState::Done;
+                ++m_stats.tilesWritten;
+            }
+            emit(t, pixels);
+        }
+
+        if (m_scratch.is_open()) {
+            m_scratch.close();
+            std::error_code ec;
+            std::filesystem::remove(m_options.scratchPath, ec);
+        }
+        if (m_writer) m_writer->finish();
+    }
+
+    TiledFilm::Stats TiledFilm::stats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    void TiledFilm::makeResident(int t) {
+        StorageTile& st = m_tiles[t];
+        st.stamp = m_stamp;
+        if (st.state == TileState::Resident) {
+            m_lru.splice(m_lru.begin(), m_lru, st.lru);
+            return;
+        }
+
+        int x0, y0, x1, y1;
+        tileRect(t, x0, y0, x1, y1);
+        st.pixels.assign(size_t(x1 - x0) * (y1 - y0), Accum{});
+        if (st.state == TileState::Paged) {
+            const size_t slotBytes = size_t(m_options.tileSize) * m_options.tileSize * sizeof(Accum);
+            m_scratch.seekg(std::streamoff(uint64_t(st.slot) * slotBytes));
+            m_scratch.read(reinterpret_cast<char*>(st.pixels.data()), std::streamsize(st.pixels.size() * sizeof(Accum)));
+            if (!m_scratch) throw std::runtime_error("TiledFilm: cannot read back " + m_options.scratchPath);
+            m_freeSlots.push_back(st.slot);
+            ++m_stats.pageIns;
+        }
+
+        st.state = TileState::Resident;
+        m_lru.push_front(t);
+        st.lru = m_lru.begin();
+        m_stats.residentBytes += st.pixels.size() * sizeof(Accum);
+        m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+    }
+
+    void TiledFilm::pageOut(int t) {
+        if (!m_scratch.is_open()) {
+            m_scratch.open(m_options.scratchPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!m_scratch) throw std::runtime_error("TiledFilm: cannot create " + m_options.scratchPath);
+        }
+        StorageTile& st = m_tiles[t];
+        if (m_freeSlots.empty()) {
+            st.slot = m_slotCount++;
+        }
+        else {
+            st.slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        const size_t slotBytes = size_t(m_options.tileSize) * m_options.tileSize * sizeof(Accum);
+        m_scratch.seekp(std::streamoff(uint64_t(st.slot) * slotBytes));
+        m_scratch.write(reinterpret_cast<const char*>(st.pixels.data()), std::streamsize(st.pixels.size() * sizeof(Accum)));
+        if (!m_scratch) throw std::runtime_error("TiledFilm: cannot write " + m_options.scratchPath);
+
+        m_stats.residentBytes -= st.pixels.size() * sizeof(Accum);
+        st.pixels = {};
+        m_lru.erase(st.lru);
+        st.state = TileState::Paged;
+        ++m_stats.pageOuts;
+    }
+
+    // Least recently used first; tiles of the merge in progress stay
+    void TiledFilm::evict() {
+        while (m_stats.residentBytes > m_options.memoryBudget && !m_lru.empty()) {
+            const int victim = m_lru.back();
+            if (m_tiles[victim].stamp == m_stamp) break;
+            pageOut(victim);
+        }
+    }
+
+    void TiledFilm::emit(int t, const std::vector<Accum>& pixels) const {
+        int x0, y0, x1, y1;
+        tileRect(t, x0, y0, x1, y1);
+        const size_t n = size_t(x1 - x0) * (y1 - y0);
+        std::vector<float> planes(3 * n, 0.0f);
+        // Pixels no sample has reached keep a zero weight (and untouched tiles no pixels at all)
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            if (pixels[i].weight == 0) continue;
+            const Spectrum c = pixels[i].sum / pixels[i].weight;
+            for (int k = 0; k < 3; ++k) planes[k * n + i] = float(c[k]);
+        }
+        const float* rgb[3] = { planes.data(), planes.data() + n, planes.data() + 2 * n };
+        m_sink(x0, y0, x1, y1, rgb);
+    }
+
+} // namespace rayt
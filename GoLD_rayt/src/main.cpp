@@ -19,6 +19,7 @@
 #include "Core/AABB.hpp"
 #include "Core/Assert.hpp"
 #include "Core/Image.hpp"
+#include "Core/TaskGraph.hpp"
 
 // Geometry
 #include "Geometry/Hittable.hpp"
@@ -28,13 +29,20 @@
 
 // IO
 #include "IO/IORInterpolator.hpp"
+#include "IO/SpectralIORTable.hpp"
+#include "IO/AssetCache.hpp"
+#include "IO/SceneFile.hpp"
 
 // Renderer
 #include "Renderer/Film.hpp"
 #include "Renderer/Camera.hpp"
 #include "Renderer/Scene.hpp"
 #include "Renderer/Integrator.hpp"
+#include "Renderer/PrefilteredEnv.hpp"
+#include "Renderer/PreviewIntegrator.hpp"
+#include "Renderer/Denoiser.hpp"
 #include "Renderer/BVH.hpp"
+#include "Renderer/SceneBuilder.hpp"
 
 // Materials
 #include "Materials/Material.hpp"
@@ -46,6 +54,7 @@
 //#include "Materials/Mirror.hpp"
 #include "Materials/RoughConductor.hpp"
 #include "Materials/Dielectric.hpp"
+#include "Materials/MaterialTable.hpp"
 // Note: "Lambertian" or other materials can be added here in the future.
 
 // Microfacet
@@ -56,9 +65,21 @@
 #include "IO/ImageLoader.hpp"
 #include "IO/EnvMap.hpp"
 
+#include <chrono>
 #include <filesystem>
+#include <optional>
 
 #include "DebugTools/FrameDebug.hpp"
+#include "DebugTools/GGXBatchDebug.hpp"
+#include "DebugTools/FresnelDebug.hpp"
+#include "DebugTools/MaterialDebug.hpp"
+#include "DebugTools/TextureDebug.hpp"
+#include "DebugTools/SpectralDebug.hpp"
+#include "DebugTools/EnvDebug.hpp"
+#include "DebugTools/PreviewDebug.hpp"
+#include "DebugTools/FilmDebug.hpp"
+#include "DebugTools/DenoiseDebug.hpp"
+#include "DebugTools/SceneDebug.hpp"
 
 
 // 画像生成のためのヘッダー
@@ -68,43 +89,148 @@
 using namespace rayt;
 
 // -----------------------------------------------------------------------------
-// Scene Configuration
+// Scene Configuration（シーンファイルを渡さなかったときの組み込みシーン用）
 // -----------------------------------------------------------------------------
 const int IMAGE_WIDTH = 800;
 const int IMAGE_HEIGHT = 450;      // 16:9 Aspect Ratio
 const int SAMPLES_PER_PIXEL = 100; // Higher = less noise, slower
 const int MAX_DEPTH = 50;          // Max recursion depth for rays
 
+// true: 事前積分した IBL でプレビュー。対話用パス（800x450・1 スレッドで 0.5 秒前後）を保存してから
+// 仕上げパス（2x2 サンプル・8 レイ、約 7 倍）で出力を描く（パストレースとの差は PreviewDebug.hpp 参照）
+const bool IBL_PREVIEW = false;
+
+// true: 環境マップのサンプリング表ができる前に IBL プレビューを先に描いて保存し、その後パストレース
+const bool EARLY_PREVIEW = false;
+
+// true: パストレース後にアルベド・法線・深度・分散の AOV を手がかりにデノイズ（低 spp 向け、精度と速度は DenoiseDebug.hpp 参照）
+const bool DENOISE = false;
+
 // env path
 const std::string ENV_HDR_PATH = "assets/env/grace-new.hdr";
 
 // -----------------------------------------------------------------------------
 // Main Entry Point
 // -----------------------------------------------------------------------------
-int main() {
+int main(int argc, char** argv) {
 
     // debug frame 
     // rayt::debug::TestFrameRoundTrip();
 
+    // GGX batch kernels: accuracy vs scalar + samples/sec
+    // rayt::debug::TestGGXBatch();
+    // rayt::debug::TestFresnelTable();
+    // rayt::debug::TestMaterialDispatch();
+    // rayt::debug::TestTextureFiltering();
+
+    // RGB <-> spectrum round trip, 3-wavelength vs spectral gold (build with RAYT_SPECTRAL=1 to render spectrally)
+    // rayt::debug::TestSpectralSampling();
+    // rayt::debug::TestSpectralIORTable();
+    // rayt::debug::TestRGBToSpectrumTable();
+    // rayt::debug::TestEnvSampling();
+    // rayt::debug::TestDistributionLayout();
+    // rayt::debug::TestEnvLayout();
+    // rayt::debug::TestEnvProductSampling();
+    // rayt::debug::TestEnvProductEqualTime();
+    // rayt::debug::TestImageFormats();
+    // rayt::debug::TestImageLayout();
+    // rayt::debug::TestImageIngest();
+    // rayt::debug::TestAssetCache();
+    // rayt::debug::TestPreviewIntegrator();
+    // rayt::debug::TestFilmAccumulation();
+    // rayt::debug::TestEXRWriter();
+    // rayt::debug::TestToneMapping();
+    // rayt::debug::TestPngWriter();
+    // rayt::debug::TestTiledFilm();
+    // rayt::debug::TestDenoiser();
+    // rayt::debug::TestSceneFile();
+
 
 // -------------------------------------------------------------------------
 // EnvMap (HDRI) 読み込み
 // -------------------------------------------------------------------------
-    const std::string envPath = "assets/env/grace-new.hdr";
+    // シーンファイル（テキスト .rscn、または tools/scenec で変換したバイナリ .rsb）を渡すとそのシーンを描く
+    // 例: GoLD_rayt assets/scenes/glass.rscn （再コンパイル不要。引数なしなら下の組み込みシーン）
+    std::optional<rayt::io::SceneFile> sceneFile;
+    if (argc > 1) {
+        try {
+            sceneFile = rayt::io::SceneFile::load(argv[1]);
+            std::cout << "[Scene] Loaded: " << argv[1] << (sceneFile->isMapped() ? " (binary)" : " (text)") << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[Scene] " << e.what() << "\n";
+            return 1;
+        }
+    }
+    const int imageWidth = sceneFile ? sceneFile->settings().width : IMAGE_WIDTH;
+    const int imageHeight = sceneFile ? sceneFile->settings().height : IMAGE_HEIGHT;
+    const int samplesPerPixel = sceneFile ? sceneFile->settings().samplesPerPixel : SAMPLES_PER_PIXEL;
+    const int maxDepth = sceneFile ? sceneFile->settings().maxDepth : MAX_DEPTH;
+    const std::string envPath = sceneFile ? std::string(sceneFile->string(sceneFile->settings().environment)) : ENV_HDR_PATH;
 
     std::cout << "CWD = " << std::filesystem::current_path() << std::endl;
 
+    // 重要度サンプリング表・IOR テーブルなど、アセットから作る派生データは内容ハッシュで .rayt_cache/ にキャッシュ
+    // （同じアセットなら 2 回目以降は mmap するだけ。古い・壊れたエントリは作り直す）
+    const rayt::io::AssetCache assetCache;
+
+    // 起動処理は依存関係つきのタスクとして並行に走らせる（HDR デコード・CSV 解析・サンプリング表・シーン構築）
+    // レンダリングは必要な入力がそろった時点で始め、最後にタイムラインを表示する
+    TaskGraph startup;
+
+    rayt::Image envImage;
     std::shared_ptr<rayt::EnvMap> env = nullptr;
-    try {
-        auto envImg = rayt::io::loadHDR(envPath);
-        env = std::make_shared<rayt::EnvMap>(std::move(envImg));
-        std::cout << "[EnvMap] Loaded: " << envPath << std::endl;
+    const auto taskDecodeEnv = startup.add("decode HDR", {}, [&] {
+        if (envPath.empty()) return;
+        try {
+            // .hdr は RGBE で保持すれば無損失（float3 の 1/3 のメモリ、精度は PixelFormat.hpp 参照）
+            envImage = rayt::io::loadHDR(envPath, rayt::PixelFormat::RGBE);
+            std::cout << "[EnvMap] Loaded: " << envPath << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[EnvMap] Failed: " << e.what() << "\n";
+            std::cerr << "[EnvMap] Fallback to black background.\n";
+        }
+        });
+    // テクセルだけ先に用意し、重要度サンプリング表は別タスク（プレビューや前処理は表を使わない）
+    const auto taskEnv = startup.add("env texels", { taskDecodeEnv }, [&] {
+        if (!envImage.isValid()) return;
+        try {
+            env = std::make_shared<rayt::EnvMap>(std::move(envImage), rayt::EnvSampling::Alias, rayt::EnvLayout::Equirect, &assetCache, false);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[EnvMap] Failed: " << e.what() << "\n";
+            std::cerr << "[EnvMap] Fallback to black background.\n";
+        }
+        });
+    // 使わないタスクは登録しない（IBL プレビューだけならサンプリング表を作らない。-1 = 登録なし）
+    TaskGraph::TaskId taskEnvTables = -1, taskPrefiltered = -1;
+    if (!IBL_PREVIEW) {
+        taskEnvTables = startup.add("env sampling tables", { taskEnv }, [&] {
+            if (env) env->buildSampling();
+            });
     }
-    catch (const std::exception& e) {
-        std::cerr << "[EnvMap] Failed: " << e.what() << "\n";
-        std::cerr << "[EnvMap] Fallback to black background.\n";
+    // 環境 × ローブの積サンプリング（EnvProductSampler）は使わない：粗さ 0.2〜0.5 の金では
+    // 同じ時間で環境だけの NEE に勝たない（debug::TestEnvProductEqualTime で測れる）
+    // 前処理した環境マップも .rayt_cache/ にキャッシュし、2 回目以降は読み込むだけ
+    std::shared_ptr<const PrefilteredEnv> prefiltered;
+    if (IBL_PREVIEW || EARLY_PREVIEW) {
+        taskPrefiltered = startup.add("prefiltered env", { taskEnv }, [&] {
+            if (env) prefiltered = PrefilteredEnv::load(env, envPath, &assetCache);
+            });
     }
 
+    // スペクトルモード（RAYT_SPECTRAL=1）では Johnson の実測 n, k をパスの波長ごとに評価する
+    // （読み込めなければ RGB 値を使う）
+    std::shared_ptr<const SpectralIORTable> goldIOR;
+    const auto taskGoldIOR = startup.add("IOR CSV", {}, [&] {
+#if RAYT_SPECTRAL
+        if (sceneFile) return; // シーンファイルの実測 n, k は buildScene が読む
+        if (auto ior = std::make_shared<SpectralIORTable>(); ior->loadCSV("Johnson.csv", assetCache))
+            goldIOR = std::move(ior);
+#endif
+        });
+
     std::cout << "[System] Initializing..." << std::endl;
 
     // -------------------------------------------------------------------------
@@ -154,49 +280,71 @@ int main() {
     // 1. マテリアルの作成 (Roughness Test)
     // -------------------------------------------------------------------------
 
-    // 床用
-    auto matFloor = std::make_shared<Lambertian>(Spectrum(0.5, 0.5, 0.5)); // 少し暗くして反射を目立たせる
+    std::unique_ptr<Scene> scene;
+    const auto taskScene = startup.add("materials + scene", { taskGoldIOR }, [&] {
+        // シーンファイルのジオメトリ・インスタンス表はマップしたまま使う（マテリアルだけ作る）
+        if (sceneFile) {
+            scene = buildScene(*sceneFile, &assetCache);
+            return;
+        }
 
-    // 金の光学定数 (Au)
-    Spectrum n_Au(0.16, 0.42, 1.45);
-    Spectrum k_Au(3.48, 2.45, 1.77);
+        // 組み込みマテリアルはシーンのテーブルに値で格納し、ID で参照する
+        MaterialTable materials;
 
-    // ★比較用: 3段階の粗さを作成
-    // 0.01: ほぼ鏡 (MirrorConductorと比較用)
-    // 0.20: 少しぼやけた金属
-    // 0.50: マットな金属（ブラスト仕上げ風）
-    auto matGoldSmooth = std::make_shared<RoughConductor>(n_Au, k_Au, 0.01);
-    auto matGoldMedium = std::make_shared<RoughConductor>(n_Au, k_Au, 0.20);
-    auto matGoldRough = std::make_shared<RoughConductor>(n_Au, k_Au, 0.50);
+        // 床用
+        MaterialId matFloor = materials.emplace<Lambertian>(Spectrum(0.5, 0.5, 0.5)); // 少し暗くして反射を目立たせる
 
-    //auto matGlass = std::make_shared<Dielectric>(1.5, 0.0); // 粗さ0 = 完全透明
-    //auto matFrosted = std::make_shared<Dielectric>(1.5, 0.2); // 粗さ0.2 = すりガラス
+        // 金の光学定数 (Au)
+        Spectrum n_Au(0.16, 0.42, 1.45);
+        Spectrum k_Au(3.48, 2.45, 1.77);
 
-    // -------------------------------------------------------------------------
-    // 2. 物体の配置 (Scene)
-    // -------------------------------------------------------------------------
-    auto worldObjects = std::make_shared<HittableList>();
+        // ★比較用: 3段階の粗さを作成
+        // 0.01: ほぼ鏡 (MirrorConductorと比較用)
+        // 0.20: 少しぼやけた金属
+        // 0.50: マットな金属（ブラスト仕上げ風）
+        // Fresnel は (n, k) 固定なのでテーブル参照（誤差は FresnelTable.hpp 参照、Exact で厳密計算）
+        const auto goldFresnel = fresnel::ConductorFresnelMode::Tabulated;
 
-    // 床
-    worldObjects->add(std::make_shared<Sphere>(Point3(0, -100.5, -1), 100.0, matFloor));
+        // goldIOR は "IOR CSV" タスクが用意する（スペクトルモードのみ）
+        auto makeGold = [&](Real roughness) {
+            return goldIOR ? materials.emplace<RoughConductor>(goldIOR, roughness)
+                : materials.emplace<RoughConductor>(n_Au, k_Au, roughness, 0.0, goldFresnel);
+        };
+
+        MaterialId matGoldSmooth = makeGold(0.01);
+        MaterialId matGoldMedium = makeGold(0.20);
+        MaterialId matGoldRough = makeGold(0.50);
+
+        //MaterialId matGlass = materials.emplace<Dielectric>(1.5, 0.0); // 粗さ0 = 完全透明
+        //MaterialId matFrosted = materials.emplace<Dielectric>(1.5, 0.2); // 粗さ0.2 = すりガラス
+
+        // -------------------------------------------------------------------------
+        // 2. 物体の配置 (Scene)
+        // -------------------------------------------------------------------------
+        auto worldObjects = std::make_shared<HittableList>();
 
-    // 球を横に3つ並べる
-    // 左: ツルツル
-    worldObjects->add(std::make_shared<Sphere>(Point3(-1.2, 0, -1), 0.5, matGoldSmooth));
+        // 床
+        worldObjects->add(std::make_shared<Sphere>(Point3(0, -100.5, -1), 100.0, matFloor));
 
-    // 中央: 少し粗い
-    worldObjects->add(std::make_shared<Sphere>(Point3(0.0, 0, -1), 0.5, matGoldMedium));
+        // 球を横に3つ並べる
+        // 左: ツルツル
+        worldObjects->add(std::make_shared<Sphere>(Point3(-1.2, 0, -1), 0.5, matGoldSmooth));
 
-    // 右: かなり粗い
-    worldObjects->add(std::make_shared<Sphere>(Point3(1.2, 0, -1), 0.5, matGoldRough));
+        // 中央: 少し粗い
+        worldObjects->add(std::make_shared<Sphere>(Point3(0.0, 0, -1), 0.5, matGoldMedium));
 
-    // ガラス
-    //worldObjects->add(std::make_shared<Sphere>(Point3(0.7, 0, -1), 0.5, matGlass));
+        // 右: かなり粗い
+        worldObjects->add(std::make_shared<Sphere>(Point3(1.2, 0, -1), 0.5, matGoldRough));
 
-    // すりガラス
-    //worldObjects->add(std::make_shared<Sphere>(Point3(-0.7, 0, -1), 0.5, matFrosted));
+        // ガラス
+        //worldObjects->add(std::make_shared<Sphere>(Point3(0.7, 0, -1), 0.5, matGlass));
 
-    Scene scene(worldObjects);
+        // すりガラス
+        //worldObjects->add(std::make_shared<Sphere>(Point3(-0.7, 0, -1), 0.5, matFrosted));
+
+        scene = std::make_unique<Scene>(worldObjects, std::move(materials));
+        });
+    startup.start();
 
     // -------------------------------------------------------------------------
     // 3. カメラ設定
@@ -208,10 +356,10 @@ int main() {
     Real distToFocus = glm::length(lookFrom - lookAt);
     Real aperture = 0.0; // ピンホールカメラ（ボケなし）でテスト
 
-    auto camera = std::make_shared<Camera>(
+    auto camera = sceneFile ? buildCamera(sceneFile->settings()) : std::make_shared<Camera>(
         lookFrom, lookAt, vUp,
         35.0, // FOV
-        double(IMAGE_WIDTH) / IMAGE_HEIGHT,
+        double(imageWidth) / imageHeight,
         aperture,
         distToFocus
     );
@@ -219,26 +367,69 @@ int main() {
     // -------------------------------------------------------------------------
     // 4. レンダリング準備
     // -------------------------------------------------------------------------
-    Film film(IMAGE_WIDTH, IMAGE_HEIGHT);
+    // 再構成フィルタは Film(w, h, Filter::mitchell()) などで指定（既定はボックス = ピクセル内の単純平均）
+    Film film(imageWidth, imageHeight);
+    // 合成・デノイズ用の AOV（アルベド・法線・深度・ID・直接/間接光など）は .exr に一緒に書き出される
+    // film.enableAOVs(AOV::All);
+    if (DENOISE) film.enableAOVs(film.aovs() | AOV::Albedo | AOV::Normal | AOV::Depth | AOV::MaterialId | AOV::Variance);
 
     // 新しいIntegratorを使用
     // max_depth, spp を渡す
     //auto integrator = std::make_unique<PathIntegrator>(camera, MAX_DEPTH, SAMPLES_PER_PIXEL);
-    auto integrator = std::make_unique<PathIntegrator>(camera, env, MAX_DEPTH, SAMPLES_PER_PIXEL);
+    startup.wait(taskEnv);
+    auto integrator = std::make_unique<PathIntegrator>(camera, env, maxDepth, samplesPerPixel);
 
     // -------------------------------------------------------------------------
     // 5. レンダリング実行
     // -------------------------------------------------------------------------
-    std::cout << "[Render] Start PBR rendering..." << std::endl;
-    integrator->render(scene, film);
+    // プレビューはシーンと前処理済み環境マップだけを待つ（サンプリング表の構築と重なる）
+    startup.wait(taskScene);
+    if (taskPrefiltered >= 0 && env) startup.wait(taskPrefiltered);
+    if ((EARLY_PREVIEW || IBL_PREVIEW) && env) {
+        Film preview(imageWidth, imageHeight);
+        std::cout << "[Render] Start early IBL preview..." << std::endl;
+        startup.runInline("IBL preview", [&] { PreviewIntegrator(camera, prefiltered).render(*scene, preview); });
+        preview.save("result_gold_preview.png");
+    }
+
+    if (IBL_PREVIEW && env) {
+        std::cout << "[Render] Start IBL preview refine pass..." << std::endl;
+        startup.runInline("IBL refine", [&] { PreviewIntegrator::refinePass(camera, prefiltered).render(*scene, film); });
+    }
+    else {
+        if (taskEnvTables >= 0) startup.wait(taskEnvTables);
+        std::cout << "[Render] Start PBR rendering..." << std::endl;
+        startup.runInline("PBR render", [&] { integrator->render(*scene, film); });
+        // ポスター用の巨大解像度は TiledFilm に描く：完成したタイルから順に .exr へ流し、フィルムのメモリは予算内
+        // （カメラの縦横比は合わせること。AOV・デノイズ・スプラットは非対応）
+        // TiledFilm poster(40000, 30000, "result_gold_pbr_poster.exr");
+        // integrator->render(*scene, poster);
+        // poster.finish();
+
+        if (DENOISE) {
+            auto t0 = std::chrono::steady_clock::now();
+            startup.runInline("denoise", [&] { denoise(film); });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "[Denoise] " << seconds << " s ("
+                << seconds * 1e6 / (double(imageWidth) * imageHeight) << " s / megapixel)" << std::endl;
+        }
+    }
 
     // -------------------------------------------------------------------------
     // 6. 保存
     // -------------------------------------------------------------------------
     std::cout << "[Output] Saving images..." << std::endl;
     film.save("result_gold_pbr.png");
+    // トーンカーブと sRGB 変換・ディザは選択可（既定は Reinhard + ガンマ 2.2、各設定の誤差と速度は ToneMap.hpp 参照）
+    // film.saveLDR("result_gold_pbr_aces.png", { ToneMapOperator::ACES, OutputTransfer::SRGB, 1.0f, true });
+    // PNG はチャンク単位の並列 deflate（圧縮レベル 0-9）。途中経過の保存は saveLDRAsync で裏スレッドに回せる
+    // （トーンマップ済みのコピーを取ってすぐ戻るので、film への蓄積はそのまま続けてよい）
+    // auto pendingSave = film.saveLDRAsync("result_gold_pbr_progress.png", {}, { 1 });
     // film.save("result_gold_pbr.hdr");
+    // film.save("result_gold_pbr.exr");
 
+    startup.waitAll();
+    startup.printTimeline(std::cout);
     std::cout << "[System] Finished." << std::endl;
     
 
@@ -0,0 +1,45 @@
+/**
+ * @file rgb2spec_opt.cpp
+ * @brief Build-time generator for the RGB -> spectrum coefficient table.
+ * * Fits the sigmoid-polynomial grid described in Core/RGBToSpectrumTable.hpp
+ * and writes it where the renderer memory maps it from. The Visual Studio
+ * project builds and runs it as a custom build step, again whenever the table
+ * code changes (wavelength range, color matching functions, white balance);
+ * the renderer fits the table itself when the file is missing, but that costs
+ * seconds at startup.
+ *
+ * Build and run by hand from the GoLD_rayt directory:
+ *
+ *     g++ -std=c++20 -O2 -I include -I external tools/rgb2spec_opt.cpp \
+ *         src/RGBToSpectrumTable.cpp src/MappedFile.cpp src/AtomicWrite.cpp -o rgb2spec_opt
+ *     ./rgb2spec_opt [resolution=64] [output=rgbspectrum_srgb.coeff]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "Core/RGBToSpectrumTable.hpp"
+
+int main(int argc, char** argv) {
+    const int res = argc > 1 ? std::atoi(argv[1]) : rayt::RGBToSpectrumTable::DEFAULT_RES;
+    const std::string output = argc > 2 ? argv[2] : rayt::RGBToSpectrumTable::DEFAULT_FILE;
+    if (res < 2 || res > 256) {
+        std::cerr << "resolution must be in [2, 256]\n";
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const rayt::RGBToSpectrumTable table = rayt::RGBToSpectrumTable::fit(res);
+    const auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Fitted " << res << "^3 x 3 grid in "
+        << std::chrono::duration<double>(t1 - t0).count() << " s\n";
+
+    if (!table.save(output)) {
+        std::cerr << "Could not write " << output << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << output << "\n";
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file scenec.cpp
+ * @brief Scene converter: compiles the text scene form (.rscn) to the mapped binary form (.rsb), and back.
+ * * The renderer reads either form (see IO/SceneFile.hpp); the binary one is
+ * mapped and used in place, so large scenes load at the speed of the disk.
+ * Compiling also builds the flat BVH over the instances and stores it in the
+ * .rsb, so the renderer traverses it from the mapping instead of building one
+ * on every load. Convert once after editing the text, or decompile a binary
+ * scene to edit it.
+ *
+ * Build and run from the GoLD_rayt directory (MSVC: add the .cpp files to a
+ * console project with include/ and external/ on the include path):
+ *
+ *     g++ -std=c++20 -O2 -I include -I external tools/scenec.cpp src/SceneFile.cpp \
+ *         src/MappedFile.cpp src/AtomicWrite.cpp -o scenec
+ *     ./scenec scene.rscn scene.rsb      # text (or binary) -> binary
+ *     ./scenec -t scene.rsb [scene.rscn] # binary (or text) -> text, stdout by default
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "IO/SceneFile.hpp"
+
+int main(int argc, char** argv) {
+    const bool toText = argc > 1 && std::string(argv[1]) == "-t";
+    const int first = toText ? 2 : 1;
+    if (argc - first < (toText ? 1 : 2) || argc - first > 2) {
+        std::cerr << "usage: scenec <input> <output.rsb>\n"
+            "       scenec -t <input> [output.rscn]\n";
+        return 1;
+    }
+    const std::string input = argv[first];
+    const std::string output = argc - first > 1 ? argv[first + 1] : "";
+
+    try {
+        const auto t0 = std::chrono::steady_clock::now();
+        const rayt::io::SceneFile scene = rayt::io::SceneFile::load(input);
+        const auto t1 = std::chrono::steady_clock::now();
+        std::cerr << "Read " << input << " (" << (scene.isMapped() ? "binary" : "text") << "): "
+            << scene.materialCount() << " materials, " << scene.geometryCount() << " geometries, "
+            << scene.instanceCount() << " instances, " << scene.bvhNodeCount() << " BVH nodes in "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms"
+            << (scene.isMapped() ? "" : " (parse, compile and BVH build)") << "\n";
+
+        if (toText) {
+            if (output.empty()) {
+                scene.writeText(std::cout);
+                return 0;
+            }
+            std::ofstream out(output);
+            scene.writeText(out);
+            if (!out) throw std::runtime_error("could not write " + output);
+        }
+        else {
+            scene.writeBinary(output);
+        }
+        std::cerr << "Wrote " << output << "\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}